@@ -30,6 +30,19 @@
 namespace PokemonAutomation{
 
 
+namespace{
+
+//  A full window is "queue_limit" commands plus as many requests. Keep the
+//  retransmit timeout at several times what it takes to send all of them
+//  at the baud rate. (10 bits per byte on the wire)
+RetransmitTimeout::Duration min_retransmit_timeout(size_t queue_limit){
+    uint64_t bits = (uint64_t)2 * queue_limit * PABB_MAX_PACKET_SIZE * 10;
+    return 4 * RetransmitTimeout::Duration(bits * 1000000 / PABB_BAUD_RATE);
+}
+
+}
+
+
 
 PABotBase::PABotBase(
     Logger& logger,
@@ -41,13 +54,16 @@ PABotBase::PABotBase(
     , m_logger(logger)
     , m_max_pending_requests(PABB_DEVICE_QUEUE_SIZE)
     , m_send_seq(1)
-    , m_retransmit_delay(retransmit_delay)
+    , m_retransmit_timeout(retransmit_delay, false)
     , m_last_ack(current_time())
     , m_state(State::RUNNING)
     , m_error(false)
-    , m_retransmit_thread(run_with_catch, "PABotBase::retransmit_thread()", [this]{ retransmit_thread(); })
 {
     set_sniffer(message_logger);
+    m_retransmit_timeout.set_min_timeout(min_retransmit_timeout(PABB_DEVICE_QUEUE_SIZE));
+
+    //  Start this last. "m_sanitizer" is declared after it.
+    m_retransmit_thread = std::thread(run_with_catch, "PABotBase::retransmit_thread()", [this]{ retransmit_thread(); });
 }
 PABotBase::~PABotBase(){
     stop();
@@ -119,6 +135,12 @@ void PABotBase::stop(){
 }
 void PABotBase::set_queue_limit(size_t queue_limit){
     m_max_pending_requests.store(queue_limit, std::memory_order_relaxed);
+    SpinLockGuard lg(m_state_lock, "PABotBase::set_queue_limit()");
+    m_retransmit_timeout.set_min_timeout(min_retransmit_timeout(queue_limit));
+}
+void PABotBase::set_adaptive_retransmits(bool enabled){
+    SpinLockGuard lg(m_state_lock, "PABotBase::set_adaptive_retransmits()");
+    m_retransmit_timeout.set_adaptive(enabled);
 }
 
 void PABotBase::wait_for_all_requests(const Cancellable* cancelled){
@@ -317,6 +339,7 @@ void PABotBase::process_ack_request(BotBaseMessage message){
 
         state = iter->second.state;
         if (state == AckState::NOT_ACKED){
+            on_first_ack(full_seqnum, iter->second);
             if (iter->second.silent_remove){
                 m_pending_requests.erase(iter);
             }else{
@@ -374,6 +397,7 @@ void PABotBase::process_ack_command(BotBaseMessage message){
     switch (iter->second.state){
     case AckState::NOT_ACKED:
 //        std::cout << "acked: " << full_seqnum << std::endl;
+        on_first_ack(full_seqnum, iter->second);
         iter->second.state = AckState::ACKED;
         iter->second.ack = std::move(message);
         return;
@@ -494,51 +518,115 @@ void PABotBase::on_recv_message(BotBaseMessage message){
     }
 }
 
+template <typename Lambda>
+void PABotBase::for_each_not_acked(Lambda&& lambda){
+    //  Must call under state lock.
+    auto request = m_pending_requests.begin();
+    auto command = m_pending_commands.begin();
+    while (request != m_pending_requests.end() || command != m_pending_commands.end()){
+        if (command == m_pending_commands.end() ||
+            (request != m_pending_requests.end() && request->first < command->first)
+        ){
+            request->second.sanitizer.check_usage();
+            if (request->second.state == AckState::NOT_ACKED){
+                lambda(request->first, request->second);
+            }
+            ++request;
+        }else{
+            command->second.sanitizer.check_usage();
+            if (command->second.state == AckState::NOT_ACKED){
+                lambda(command->first, command->second);
+            }
+            ++command;
+        }
+    }
+}
+template <typename Pending>
+void PABotBase::retransmit(Pending& handle, WallClock now){
+    //  Must call under state lock.
+    send_message(handle.request, true);
+    handle.last_sent = now;
+    handle.retransmits++;
+}
+template <typename Pending>
+void PABotBase::on_first_ack(uint64_t seqnum, const Pending& handle){
+    m_sanitizer.check_usage();
+
+    //  Must call under state lock.
+    WallClock now = current_time();
+    if (handle.retransmits == 0){
+        m_retransmit_timeout.add_sample(
+            std::chrono::duration_cast<RetransmitTimeout::Duration>(now - handle.first_sent)
+        );
+    }
+
+    if (!m_retransmit_timeout.adaptive()){
+        return;
+    }
+
+    //  The device drops anything that's ahead of what it expects. So if this
+    //  is acked, everything before it that was sent before it has reached
+    //  the device. If any of those are still not acked, their acks were lost.
+    //  Resend them now to get the acks instead of waiting for the timer.
+    WallClock sent = handle.last_sent;
+    for_each_not_acked([&](uint64_t item_seqnum, auto& item){
+        if (item_seqnum < seqnum && item.last_sent <= sent){
+            retransmit(item, now);
+        }
+    });
+}
 void PABotBase::retransmit_thread(){
     m_sanitizer.check_usage();
 
 //    cout << "retransmit_thread()" << endl;
-    auto last_sent = current_time();
     while (m_state.load(std::memory_order_acquire) == State::RUNNING){
-        auto now = current_time();
-
-        if (now - last_sent < m_retransmit_delay){
-            std::unique_lock<std::mutex> lg(m_sleep_lock);
-            if (m_state.load(std::memory_order_acquire) != State::RUNNING){
-                break;
-            }
-            if (m_error.load(std::memory_order_acquire)){
-                break;
+        //  Process retransmits.
+        WallClock next_check;
+        {
+            SpinLockGuard lg(m_state_lock, "PABotBase::retransmit_thread()");
+
+            WallClock now = current_time();
+            RetransmitTimeout::Duration timeout = m_retransmit_timeout.timeout();
+
+            if (m_retransmit_timeout.adaptive()){
+                //  If anything has timed out, the device has dropped everything
+                //  that was sent after it. So retransmit everything in order.
+                //  Then back off once for the whole window.
+                bool expired = false;
+                for_each_not_acked([&](uint64_t, auto& item){
+                    expired |= item.last_sent + timeout <= now;
+                });
+                if (expired){
+                    for_each_not_acked([&](uint64_t, auto& item){
+                        retransmit(item, now);
+                    });
+                    m_retransmit_timeout.on_timeout();
+                    timeout = m_retransmit_timeout.timeout();
+                }
+            }else{
+                //  Retransmit each one that has timed out.
+                for_each_not_acked([&](uint64_t, auto& item){
+                    if (item.last_sent + timeout <= now){
+                        retransmit(item, now);
+                    }
+                });
             }
-            m_cv.wait_for(lg, m_retransmit_delay);
-            continue;
+
+            //  Sleep until the next one times out.
+            next_check = now + timeout;
+            for_each_not_acked([&](uint64_t, auto& item){
+                next_check = std::min(next_check, item.last_sent + timeout);
+            });
         }
 
-        //  Process retransmits.
-        SpinLockGuard lg(m_state_lock, "PABotBase::retransmit_thread()");
-//        std::cout << "retransmit_thread - m_pending_messages.size(): " << m_pending_messages.size() << std::endl;
-//        cout << "m_pending_messages.size()" << endl;
-
-        //  Retransmit
-        //      Iterate through all pending requests and retransmit them in
-        //  chronological order. Skip the ones that are new.
-        for (auto& item : m_pending_requests){
-            item.second.sanitizer.check_usage();
-            if (item.second.state == AckState::NOT_ACKED &&
-                current_time() - item.second.first_sent >= m_retransmit_delay
-            ){
-                send_message(item.second.request, true);
-            }
+        std::unique_lock<std::mutex> lg(m_sleep_lock);
+        if (m_state.load(std::memory_order_acquire) != State::RUNNING){
+            break;
         }
-        for (auto& item : m_pending_commands){
-            item.second.sanitizer.check_usage();
-            if (item.second.state == AckState::NOT_ACKED &&
-                current_time() - item.second.first_sent >= m_retransmit_delay
-            ){
-                send_message(item.second.request, true);
-            }
+        if (m_error.load(std::memory_order_acquire)){
+            break;
         }
-        last_sent = current_time();
+        m_cv.wait_until(lg, next_check);
     }
 //    cout << "retransmit_thread() - exit" << endl;
 }
@@ -606,6 +694,7 @@ uint64_t PABotBase::try_issue_request(
     handle.silent_remove = silent_remove;
     handle.request = std::move(message);
     handle.first_sent = current_time();
+    handle.last_sent = handle.first_sent;
 
     send_message(handle.request, false);
 
@@ -677,6 +766,7 @@ uint64_t PABotBase::try_issue_command(
     handle.silent_remove = silent_remove;
     handle.request = std::move(message);
     handle.first_sent = current_time();
+    handle.last_sent = handle.first_sent;
 
     send_message(handle.request, false);
 
@@ -33,6 +33,7 @@
 #include "Common/Cpp/Concurrency/SpinLock.h"
 #include "ClientSource/Connection/MessageLogger.h"
 #include "ClientSource/Connection/PABotBaseConnection.h"
+#include "ClientSource/Connection/RetransmitTimeout.h"
 #include "BotBase.h"
 #include "BotBaseMessage.h"
 
@@ -74,6 +75,13 @@ public:
     }
     void set_queue_limit(size_t queue_limit);
 
+    //  If enabled, the retransmit timeout follows the measured round trip
+    //  time of the link and lost acks are detected from the acks that come
+    //  after them. Otherwise (the default), everything that isn't acked after
+    //  the retransmit delay from the constructor is retransmitted.
+    //  The adaptive mode has not been measured on real hardware yet.
+    void set_adaptive_retransmits(bool enabled);
+
 public:
     //  Basic Requests
 
@@ -106,6 +114,8 @@ private:
         BotBaseMessage request;
         BotBaseMessage ack;
         WallClock first_sent;
+        WallClock last_sent;
+        size_t retransmits = 0;
         LifetimeSanitizer sanitizer;
     };
     struct PendingCommand{
@@ -114,6 +124,8 @@ private:
         BotBaseMessage request;
         BotBaseMessage ack;
         WallClock first_sent;
+        WallClock last_sent;
+        size_t retransmits = 0;
         LifetimeSanitizer sanitizer;
     };
 
@@ -130,6 +142,18 @@ private:
 
     void clear_all_active_commands(uint64_t seqnum);
 
+    //  Run "lambda(seqnum, handle)" on all requests and commands that are
+    //  not acked in seqnum order.
+    template <typename Lambda>
+    void for_each_not_acked(Lambda&& lambda);
+
+    template <typename Pending>
+    void retransmit(Pending& handle, WallClock now);
+
+    //  Called when the message "seqnum" is acked for the first time.
+    template <typename Pending>
+    void on_first_ack(uint64_t seqnum, const Pending& handle);
+
     void retransmit_thread();
 
 private:
@@ -176,7 +200,7 @@ private:
     std::atomic<size_t> m_max_pending_requests;
 
     uint64_t m_send_seq;
-    std::chrono::milliseconds m_retransmit_delay;
+    RetransmitTimeout m_retransmit_timeout;
     std::atomic<std::chrono::time_point<std::chrono::system_clock>> m_last_ack;
 
     std::map<uint64_t, PendingRequest> m_pending_requests;
@@ -4,6 +4,8 @@
  * 
  */
 
+#include <string.h>
+#include <algorithm>
 #include "Common/CRC32.h"
 #include "Common/Microcontroller/MessageProtocol.h"
 #include "ClientSource/Libraries/Logging.h"
@@ -71,78 +73,98 @@ void PABotBaseConnection::send_message(const BotBaseMessage& message, bool is_re
         throw InternalProgramError(&m_logger, PA_CURRENT_FUNCTION, "Message is too long.");
     }
 
-    std::string buffer;
-    buffer += ~(uint8_t)total_bytes;
-    buffer += message.type;
-    buffer += message.body;
-    buffer += std::string(sizeof(uint32_t), 0);
-    pabb_crc32_write_to_message(&buffer[0], buffer.size());
+    char buffer[PABB_MAX_PACKET_SIZE];
+    buffer[0] = ~(uint8_t)total_bytes;
+    buffer[1] = message.type;
+    memcpy(buffer + 2, message.body.data(), message.body.size());
+    pabb_crc32_write_to_message(buffer, total_bytes);
 
-    m_connection->send(&buffer[0], buffer.size());
+    m_connection->send(buffer, total_bytes);
 }
 
 
 void PABotBaseConnection::on_recv(const void* data, size_t bytes){
-    //  Push into receive buffer.
-    for (size_t c = 0; c < bytes; c++){
-        m_recv_buffer.emplace_back(((const char*)data)[c]);
+    const char* ptr = (const char*)data;
+    while (bytes > 0){
+        //  Push as much as will fit into the receive buffer. After parsing,
+        //  less than a full message is left. So there is always room.
+        size_t block = std::min(bytes, RECV_BUFFER_SIZE - m_recv_size);
+        size_t end = (m_recv_begin + m_recv_size) & (RECV_BUFFER_SIZE - 1);
+        size_t first = std::min(block, RECV_BUFFER_SIZE - end);
+        memcpy(m_recv_buffer + end, ptr, first);
+        memcpy(m_recv_buffer, ptr + first, block - first);
+
+        //  Update the mirror if the front of the buffer was written.
+        if (end < PABB_MAX_PACKET_SIZE || first < block){
+            memcpy(m_recv_buffer + RECV_BUFFER_SIZE, m_recv_buffer, PABB_MAX_PACKET_SIZE);
+        }
+
+        m_recv_size += block;
+        ptr += block;
+        bytes -= block;
+
+        process_recv_buffer();
     }
+}
+void PABotBaseConnection::process_recv_buffer(){
+    auto pop_front = [this](size_t bytes){
+        m_recv_begin = (m_recv_begin + bytes) & (RECV_BUFFER_SIZE - 1);
+        m_recv_size -= bytes;
+    };
 
-    while (!m_recv_buffer.empty()){
-        uint8_t length = ~m_recv_buffer[0];
+    while (m_recv_size > 0){
+        const char* message = m_recv_buffer + m_recv_begin;
+        uint8_t length = ~message[0];
 
-        if (m_recv_buffer[0] == 0){
+        if (message[0] == 0){
             m_sniffer->log("Skipping zero byte.");
-            m_recv_buffer.pop_front();
+            pop_front(1);
             continue;
         }
 
         //  Message is too short.
         if (length < PABB_PROTOCOL_OVERHEAD){
             m_sniffer->log("Message is too short: bytes = " + std::to_string(length));
-            m_recv_buffer.pop_front();
+            pop_front(1);
             continue;
         }
 
         //  Message is too long.
         if (length > PABB_MAX_PACKET_SIZE){
             m_sniffer->log("Message is too long: bytes = " + std::to_string(length));
-            m_recv_buffer.pop_front();
+            pop_front(1);
             continue;
         }
 
         //  Message is incomplete.
-        if (length > m_recv_buffer.size()){
+        if (length > m_recv_size){
             return;
         }
 
-        std::string message(m_recv_buffer.begin(), m_recv_buffer.begin() + length);
-
         //  Verify checksum
         {
             //  Calculate checksum.
-            uint32_t checksumA = pabb_crc32(0xffffffff, &message[0], length - sizeof(uint32_t));
+            uint32_t checksumA = pabb_crc32(0xffffffff, message, length - sizeof(uint32_t));
 
             //  Read the checksum from the message.
-            uint32_t checksumE = ((uint32_t*)(&message[0] + length))[-1];
+            uint32_t checksumE;
+            memcpy(&checksumE, message + length - sizeof(uint32_t), sizeof(uint32_t));
 
             //  Compare
-//            std::cout << checksumA << " / " << checksumE << std::endl;
             if (checksumA != checksumE){
                 m_sniffer->log("Invalid Checksum: bytes = " + std::to_string(length));
-//                std::cout << checksumA << " / " << checksumE << std::endl;
-//                log(message_to_string(message[1], &message[2], length - PABB_PROTOCOL_OVERHEAD));
-                m_recv_buffer.pop_front();
+                pop_front(1);
                 continue;
             }
         }
-        m_recv_buffer.erase(m_recv_buffer.begin(), m_recv_buffer.begin() + length);
 
-        BotBaseMessage msg(message[1], std::string(&message[2], length - PABB_PROTOCOL_OVERHEAD));
+        //  The body is at most PABB_MAX_MESSAGE_SIZE bytes. So this fits in
+        //  the small string buffer and doesn't allocate.
+        BotBaseMessage msg(message[1], std::string(message + 2, length - PABB_PROTOCOL_OVERHEAD));
+        pop_front(length);
         m_sniffer->on_recv(msg);
         on_recv_message(std::move(msg));
     }
 }
 
-
 }
@@ -16,7 +16,6 @@
 
 #include <memory>
 #include <string>
-#include <deque>
 #include "Common/Compiler.h"
 #include "Common/Microcontroller/MessageProtocol.h"
 #include "BotBase.h"
@@ -47,9 +46,21 @@ private:
     virtual void on_recv(const void* data, size_t bytes) override;
     virtual void on_recv_message(BotBaseMessage message) = 0;
 
+    //  Parse as many messages as possible from the front of the receive buffer.
+    void process_recv_buffer();
+
 private:
     std::unique_ptr<StreamConnection> m_connection;
-    std::deque<char> m_recv_buffer;
+
+    //  Receive ring buffer. The first PABB_MAX_PACKET_SIZE bytes are mirrored
+    //  past the end. So any message that starts in the buffer is contiguous
+    //  and can be checked in place.
+    static constexpr size_t RECV_BUFFER_SIZE = 256;
+    static_assert((RECV_BUFFER_SIZE & (RECV_BUFFER_SIZE - 1)) == 0, "Must be a power of two.");
+    static_assert(RECV_BUFFER_SIZE >= PABB_MAX_PACKET_SIZE);
+    char m_recv_buffer[RECV_BUFFER_SIZE + PABB_MAX_PACKET_SIZE];
+    size_t m_recv_begin = 0;
+    size_t m_recv_size = 0;
 
 protected:
     Logger& m_logger;
@@ -0,0 +1,118 @@
+/*  Retransmit Timeout
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Estimate the round trip time of a link and derive the retransmit
+ *  timeout from it. This is the same as TCP. (RFC 6298)
+ *
+ *      SRTT    = 7/8 SRTT + 1/8 R
+ *      RTTVAR  = 3/4 RTTVAR + 1/4 |SRTT - R|
+ *      RTO     = SRTT + max(G, 4 RTTVAR)
+ *
+ *  The caller must only add samples of messages that were never retransmitted.
+ *  Otherwise it doesn't know which of the transmissions the ack is for.
+ *  (Karn's algorithm)
+ *
+ *  None of this is thread-safe.
+ *
+ */
+
+#ifndef PokemonAutomation_RetransmitTimeout_H
+#define PokemonAutomation_RetransmitTimeout_H
+
+#include <chrono>
+#include <algorithm>
+
+namespace PokemonAutomation{
+
+
+class RetransmitTimeout{
+public:
+    using Duration = std::chrono::microseconds;
+
+    //  The timeout is never allowed below MIN_TIMEOUT or "min_timeout()".
+    //  The owner should set the latter well above the time it takes to send
+    //  a full window of messages. The whole window is resent when the timer
+    //  expires. So a floor that is too low turns a busy link into a burst of
+    //  retransmits.
+    static constexpr Duration MIN_TIMEOUT = std::chrono::milliseconds(50);
+    static constexpr Duration MAX_TIMEOUT = std::chrono::milliseconds(1000);
+    static constexpr Duration GRANULARITY = std::chrono::milliseconds(1);
+
+public:
+    //  "initial" is used until the first sample. If "adaptive" is false, it
+    //  is always used. (the fixed timer)
+    RetransmitTimeout(Duration initial, bool adaptive = false)
+        : m_initial(initial)
+        , m_adaptive(adaptive)
+        , m_timeout(initial)
+    {}
+
+    bool adaptive() const{ return m_adaptive; }
+    void set_adaptive(bool adaptive){
+        m_adaptive = adaptive;
+        reset();
+    }
+
+    void reset(){
+        m_has_sample = false;
+        m_timeout = m_initial;
+    }
+
+    Duration min_timeout() const{ return m_min_timeout; }
+    void set_min_timeout(Duration min_timeout){
+        m_min_timeout = std::max(min_timeout, MIN_TIMEOUT);
+        if (m_has_sample){
+            m_timeout = clamp(m_timeout);
+        }
+    }
+
+    Duration timeout() const{ return m_timeout; }
+    Duration smoothed_rtt() const{ return m_srtt; }
+    Duration rtt_variance() const{ return m_rttvar; }
+
+    void add_sample(Duration rtt){
+        if (!m_adaptive){
+            return;
+        }
+        if (!m_has_sample){
+            m_has_sample = true;
+            m_srtt = rtt;
+            m_rttvar = rtt / 2;
+        }else{
+            Duration error = m_srtt > rtt ? m_srtt - rtt : rtt - m_srtt;
+            m_rttvar = (3 * m_rttvar + error) / 4;
+            m_srtt = (7 * m_srtt + rtt) / 8;
+        }
+        m_timeout = clamp(m_srtt + std::max(GRANULARITY, 4 * m_rttvar));
+    }
+
+    //  A retransmit timer expired. Back off until the next sample.
+    void on_timeout(){
+        if (!m_adaptive){
+            return;
+        }
+        m_timeout = clamp(2 * m_timeout);
+    }
+
+
+private:
+    Duration clamp(Duration timeout) const{
+        return std::min(std::max(timeout, m_min_timeout), MAX_TIMEOUT);
+    }
+
+private:
+    Duration m_initial;
+    bool m_adaptive;
+    Duration m_min_timeout = MIN_TIMEOUT;
+
+    bool m_has_sample = false;
+    Duration m_srtt = Duration::zero();
+    Duration m_rttvar = Duration::zero();
+    Duration m_timeout;
+};
+
+
+
+}
+#endif
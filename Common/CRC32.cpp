@@ -1,2 +1,80 @@
+/*  CRC32
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      The firmware builds CRC32.c directly. This adds the implementations
+ *  that only the C++ build has.
+ *
+ */
 
 #include "CRC32.c"
+
+#include <string.h>
+#include <array>
+#include "Common/Cpp/CpuId/CpuId.h"
+
+
+namespace{
+
+using SliceTables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr SliceTables make_slice_tables(){
+    SliceTables tables{};
+    for (uint32_t c = 0; c < 256; c++){
+        uint32_t crc = c;
+        for (int bit = 0; bit < 8; bit++){
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+        }
+        tables[0][c] = crc;
+    }
+    for (size_t t = 1; t < 8; t++){
+        for (size_t c = 0; c < 256; c++){
+            uint32_t crc = tables[t - 1][c];
+            tables[t][c] = (crc >> 8) ^ tables[0][crc & 0xff];
+        }
+    }
+    return tables;
+}
+constexpr SliceTables CRC32_SLICE_TABLES = make_slice_tables();
+
+}
+
+
+uint32_t pabb_crc32_slice8(uint32_t crc, const void* data, size_t length){
+    const SliceTables& T = CRC32_SLICE_TABLES;
+    const char* ptr = (const char*)data;
+
+    //  Assumes little-endian.
+    for (; length >= 8; length -= 8){
+        uint32_t lo, hi;
+        memcpy(&lo, ptr + 0, sizeof(uint32_t));
+        memcpy(&hi, ptr + 4, sizeof(uint32_t));
+        lo ^= crc;
+        crc =
+            T[7][(lo >>  0) & 0xff] ^ T[6][(lo >>  8) & 0xff] ^
+            T[5][(lo >> 16) & 0xff] ^ T[4][(lo >> 24)       ] ^
+            T[3][(hi >>  0) & 0xff] ^ T[2][(hi >>  8) & 0xff] ^
+            T[1][(hi >> 16) & 0xff] ^ T[0][(hi >> 24)       ];
+        ptr += 8;
+    }
+    for (; length > 0; length--){
+        crc = T[0][(uint8_t)crc ^ (uint8_t)*ptr++] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+
+uint32_t pabb_crc32_dispatch(uint32_t crc, const void* data, size_t length){
+    using namespace PokemonAutomation;
+#ifdef PA_AutoDispatch_x64_08_Nehalem
+    if (CPU_CAPABILITY_CURRENT.OK_08_Nehalem){
+        return pabb_crc32_x64_SSE42(crc, data, length);
+    }
+#endif
+#if defined PA_AutoDispatch_arm64_20_M1 && defined __ARM_FEATURE_CRC32
+    if (CPU_CAPABILITY_CURRENT.OK_M1){
+        return pabb_crc32_arm64_CRC(crc, data, length);
+    }
+#endif
+    return pabb_crc32_slice8(crc, data, length);
+}
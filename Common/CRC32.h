@@ -17,24 +17,26 @@ uint32_t pabb_crc32_basic(uint32_t crc, const void* data, size_t length);
 //  Table Implementation
 uint32_t pabb_crc32_table(uint32_t crc, const void* data, size_t length);
 
-//  SSE4.2
-#if _M_IX86 || _M_X64
-#include <nmmintrin.h>
-#include "Common/Compiler.h"
-PA_FORCE_INLINE uint32_t pabb_crc32_SSE42(uint32_t crc, const void* data, size_t length){
-    const char* ptr = (const char*)data;
-    for (size_t c = 0; c < length; c++){
-        crc = _mm_crc32_u8(crc, ptr[c]);
-    }
-    return crc;
-}
+#ifdef __cplusplus
+//  The rest are only in the C++ build (CRC32.cpp). They are not in the
+//  firmware.
+
+//  Slicing-by-8: 8 tables of 256 entries. 8 bytes per iteration.
+uint32_t pabb_crc32_slice8(uint32_t crc, const void* data, size_t length);
+
+//  Hardware CRC32C instructions.
+uint32_t pabb_crc32_x64_SSE42(uint32_t crc, const void* data, size_t length);
+uint32_t pabb_crc32_arm64_CRC(uint32_t crc, const void* data, size_t length);
+
+//  The fastest of the above that the CPU supports.
+uint32_t pabb_crc32_dispatch(uint32_t crc, const void* data, size_t length);
 #endif
 
 
-#if _M_IX86 || _M_X64
-#define pabb_crc32      pabb_crc32_SSE42
-#elif __AVR__
+#if __AVR__
 #define pabb_crc32      pabb_crc32_table
+#elif __cplusplus
+#define pabb_crc32      pabb_crc32_dispatch
 #else
 #define pabb_crc32      pabb_crc32_basic
 #endif
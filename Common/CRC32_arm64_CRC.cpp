@@ -0,0 +1,39 @@
+/*  CRC32 (arm64 CRC)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#if defined PA_AutoDispatch_arm64_20_M1 && defined __ARM_FEATURE_CRC32
+
+#include <string.h>
+#include <arm_acle.h>
+#include "CRC32.h"
+
+
+//  The polynomial (0x82f63b78) is CRC32C. The CRC extension is mandatory
+//  since ARMv8.1. So every M1 has it.
+uint32_t pabb_crc32_arm64_CRC(uint32_t crc, const void* data, size_t length){
+    const char* ptr = (const char*)data;
+
+    for (; length >= 8; length -= 8){
+        uint64_t block;
+        memcpy(&block, ptr, sizeof(uint64_t));
+        crc = __crc32cd(crc, block);
+        ptr += 8;
+    }
+    if (length >= 4){
+        uint32_t block;
+        memcpy(&block, ptr, sizeof(uint32_t));
+        crc = __crc32cw(crc, block);
+        ptr += 4;
+        length -= 4;
+    }
+    for (; length > 0; length--){
+        crc = __crc32cb(crc, (uint8_t)*ptr++);
+    }
+    return crc;
+}
+
+
+#endif
@@ -0,0 +1,42 @@
+/*  CRC32 (x64 SSE4.2)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_x64_08_Nehalem
+
+#include <string.h>
+#include <nmmintrin.h>
+#include "CRC32.h"
+
+
+//  The polynomial (0x82f63b78) is CRC32C. So this is exactly what the
+//  "crc32" instruction does.
+uint32_t pabb_crc32_x64_SSE42(uint32_t crc, const void* data, size_t length){
+    const char* ptr = (const char*)data;
+
+    uint64_t crc64 = crc;
+    for (; length >= 8; length -= 8){
+        uint64_t block;
+        memcpy(&block, ptr, sizeof(uint64_t));
+        crc64 = _mm_crc32_u64(crc64, block);
+        ptr += 8;
+    }
+    crc = (uint32_t)crc64;
+
+    if (length >= 4){
+        uint32_t block;
+        memcpy(&block, ptr, sizeof(uint32_t));
+        crc = _mm_crc32_u32(crc, block);
+        ptr += 4;
+        length -= 4;
+    }
+    for (; length > 0; length--){
+        crc = _mm_crc32_u8(crc, (uint8_t)*ptr++);
+    }
+    return crc;
+}
+
+
+#endif
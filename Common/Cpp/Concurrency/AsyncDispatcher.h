@@ -50,6 +50,7 @@ private:
     friend class FireForgetDispatcher;
     friend class AsyncDispatcher;
     friend class ParallelTaskRunner;
+    friend class WorkStealingPool;
 
     std::function<void()> m_task;
     bool m_finished;
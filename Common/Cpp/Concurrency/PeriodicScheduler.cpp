@@ -4,6 +4,7 @@
  *
  */
 
+#include <algorithm>
 #include "PeriodicScheduler.h"
 
 #include <iostream>
@@ -17,65 +18,51 @@ size_t PeriodicScheduler::events() const{
     return m_events.size();
 }
 bool PeriodicScheduler::add_event(void* event, std::chrono::milliseconds period, WallClock start){
-    auto ret = m_events.emplace(event, PeriodicEvent{m_callback_id, period});
+    auto ret = m_events.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(event),
+        std::forward_as_tuple(event, period, start)
+    );
     if (!ret.second){
         //  Already exists. Do nothing.
         return false;
     }
-
-    //  Now add to schedule. Need to ensure strong exception safety.
-    try{
-        m_schedule.emplace(start, SingleEvent{m_callback_id, event});
-    }catch (...){
-        m_events.erase(ret.first);
-        throw;
-    }
-
-    m_callback_id++;
+    m_schedule.add(ret.first->second, start);
     return true;
 }
 void PeriodicScheduler::remove_event(void* event){
-    //  No need to remove from scheduler since it will be skipped over automatically.
-    m_events.erase(event);
+    auto iter = m_events.find(event);
+    if (iter == m_events.end()){
+        return;
+    }
+    m_schedule.cancel(iter->second);
+    m_events.erase(iter);
 }
 WallClock PeriodicScheduler::next_event() const{
-    auto iter = m_schedule.begin();
-    if (iter == m_schedule.end()){
-        return WallClock::max();
-    }
-    return iter->first;
+    return m_schedule.next_expiration();
 }
 void* PeriodicScheduler::request_next_event(WallClock timestamp){
-    while (true){
-        auto iter0 = m_schedule.begin();
-
-        //  Schedule is empty.
-        if (iter0 == m_schedule.end()){
-            return nullptr;
-        }
-
-        //  Next event isn't due.
-        if (timestamp < iter0->first){
-            return nullptr;
-        }
-
-        //  Current SingleEvent refers to a no longer existing PeriodicEvent.
-        SingleEvent event = iter0->second;
-        auto iter1 = m_events.find(event.event);
-        if (iter1 == m_events.end() || event.id != iter1->second.id){
-            m_schedule.erase(iter0);
-            continue;
-        }
-
-        //  Schedule the next event first so that we retain strong exception safety if it throws.
-        WallClock next = std::max(iter0->first + iter1->second.period, timestamp);
-        m_schedule.emplace(next, iter0->second);
+    TimerWheelNode* node = m_schedule.pop_expired(timestamp);
+    if (node == nullptr){
+        return nullptr;
+    }
 
-        //  Now remove the current event.
-        m_schedule.erase(iter0);
+    //  Reschedule for the next period. The wheel can't fail so this is nothrow.
+    PeriodicEvent& event = static_cast<PeriodicEvent&>(*node);
+    event.last = event.next;
+    event.next = std::max(event.next + event.period, timestamp);
+    m_schedule.add(event, event.next);
 
-        return event.event;
+    return event.event;
+}
+void PeriodicScheduler::return_event(void* event){
+    auto iter = m_events.find(event);
+    if (iter == m_events.end()){
+        return;
     }
+    PeriodicEvent& periodic = iter->second;
+    periodic.next = periodic.last;
+    m_schedule.add(periodic, periodic.next);
 }
 
 
@@ -171,9 +158,21 @@ void PeriodicRunner::thread_loop(){
 
         void* event = m_scheduler.request_next_event(now);
 
-        //  Event is available now. Run it.
+        //  Events are available now. Gather everything that is due and run them.
         if (event != nullptr){
-            run(event, is_back_to_back);
+            m_batch.clear();
+            do{
+                //  An event that is behind (or has a zero period) will
+                //  immediately come due again. Hand that occurrence back so
+                //  it runs in the next batch instead of being dropped.
+                if (std::find(m_batch.begin(), m_batch.end(), event) != m_batch.end()){
+                    m_scheduler.return_event(event);
+                    break;
+                }
+                m_batch.emplace_back(event);
+                event = m_scheduler.request_next_event(now);
+            }while (event != nullptr);
+            run_batch(m_batch, is_back_to_back);
             is_back_to_back = true;
             continue;
         }
@@ -196,6 +195,12 @@ void PeriodicRunner::thread_loop(){
         idle_since_last_check += end - start;
     }
 }
+void PeriodicRunner::run_batch(const std::vector<void*>& events, bool is_back_to_back) noexcept{
+    for (void* event : events){
+        run(event, is_back_to_back);
+        is_back_to_back = true;
+    }
+}
 void PeriodicRunner::stop_thread(){
     PeriodicRunner::cancel(nullptr);
     m_runner.reset();
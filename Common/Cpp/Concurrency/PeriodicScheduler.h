@@ -10,6 +10,7 @@
 #define PokemonAutomation_PeriodicScheduler_H
 
 #include <chrono>
+#include <vector>
 #include <map>
 #include <mutex>
 #include <condition_variable>
@@ -17,6 +18,7 @@
 #include "Common/Cpp/EventRateTracker.h"
 #include "Common/Cpp/CancellableScope.h"
 #include "Common/Cpp/Concurrency/SpinLock.h"
+#include "TimerWheel.h"
 #include "AsyncDispatcher.h"
 
 namespace PokemonAutomation{
@@ -34,28 +36,34 @@ public:
     bool add_event(void* event, std::chrono::milliseconds period, WallClock start = current_time());
     void remove_event(void* event);
 
-    //  Returns the next scheduled event. If no events are scheduled, returns WallClock::max().
+    //  Returns when the next event is due. This may be early, but never late.
+    //  If no events are scheduled, returns WallClock::max().
     WallClock next_event() const;
 
     //  If an event is before the current timestamp, return it and reschedule for next period.
     //  If nothing is before the current timestamp, return nullptr.
     void* request_next_event(WallClock timestamp = current_time());
 
+    //  Undo the last request_next_event() that returned "event". The
+    //  occurrence it returned is due again and will be returned again.
+    void return_event(void* event);
+
 private:
-    //  "id" is needed to solve the ABA problem if the same pointer is removed/re-added.
-    struct PeriodicEvent{
-        uint64_t id;
-        std::chrono::milliseconds period;
-    };
-    struct SingleEvent{
-        uint64_t id;
+    //  The timer node is embedded so that rescheduling never allocates.
+    struct PeriodicEvent : public TimerWheelNode{
         void* event;
+        std::chrono::milliseconds period;
+        WallClock next;
+        WallClock last;     //  The occurrence that was last returned.
+
+        PeriodicEvent(void* p_event, std::chrono::milliseconds p_period, WallClock p_next)
+            : event(p_event), period(p_period), next(p_next), last(p_next)
+        {}
     };
 
 private:
-    uint64_t m_callback_id = 0;
     std::map<void*, PeriodicEvent> m_events;
-    std::multimap<WallClock, SingleEvent> m_schedule;
+    TimerWheel m_schedule;
 };
 
 
@@ -84,6 +92,11 @@ protected:
     //  is too slow to keep up.
     virtual void run(void* event, bool is_back_to_back) noexcept = 0;
 
+    //  Run all the events that are due at the same time. The default
+    //  implementation runs them one-by-one in schedule order.
+    //  Override this to process the batch together. (e.g. in parallel)
+    virtual void run_batch(const std::vector<void*>& events, bool is_back_to_back) noexcept;
+
 private:
     void thread_loop();
 protected:
@@ -101,6 +114,9 @@ private:
 
     PeriodicScheduler m_scheduler;
 
+    //  Reused across ticks to avoid allocating.
+    std::vector<void*> m_batch;
+
     std::unique_ptr<AsyncTask> m_runner;
 };
 
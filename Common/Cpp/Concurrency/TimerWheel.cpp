@@ -0,0 +1,228 @@
+/*  Timer Wheel
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include "Kernels/Kernels_BitScan.h"
+#include "TimerWheel.h"
+
+//#include <iostream>
+//using std::cout;
+//using std::endl;
+
+namespace PokemonAutomation{
+
+
+TimerWheel::TimerWheel(WallClock origin)
+    : m_origin(origin)
+    , m_current(0)
+    , m_size(0)
+{
+    for (size_t c = 0; c < LEVELS; c++){
+        m_occupied[c] = 0;
+    }
+    for (TimerWheelNode& head : m_slots){
+        head.m_prev = &head;
+        head.m_next = &head;
+    }
+}
+
+
+uint64_t TimerWheel::to_tick_ceil(WallClock time) const{
+    if (time <= m_origin){
+        return 0;
+    }
+    if (time == WallClock::max()){
+        return MAX_TICK;
+    }
+    uint64_t tick = std::chrono::ceil<std::chrono::milliseconds>(time - m_origin).count();
+    return tick < MAX_TICK ? tick : MAX_TICK;
+}
+uint64_t TimerWheel::to_tick_floor(WallClock time) const{
+    if (time <= m_origin){
+        return 0;
+    }
+    if (time == WallClock::max()){
+        return MAX_TICK;
+    }
+    uint64_t tick = std::chrono::floor<std::chrono::milliseconds>(time - m_origin).count();
+    return tick < MAX_TICK ? tick : MAX_TICK;
+}
+WallClock TimerWheel::to_time(uint64_t tick) const{
+    if (tick >= MAX_TICK){
+        return WallClock::max();
+    }
+    return m_origin + std::chrono::milliseconds(tick);
+}
+
+
+void TimerWheel::link_tail(TimerWheelNode& head, TimerWheelNode& node){
+    TimerWheelNode* tail = head.m_prev;
+    node.m_prev = tail;
+    node.m_next = &head;
+    tail->m_next = &node;
+    head.m_prev = &node;
+}
+void TimerWheel::unlink(TimerWheelNode& node){
+    node.m_prev->m_next = node.m_next;
+    node.m_next->m_prev = node.m_prev;
+    node.m_prev = nullptr;
+    node.m_next = nullptr;
+}
+
+
+void TimerWheel::insert(TimerWheelNode& node){
+    uint64_t tick = node.m_tick;
+    if (tick < m_current){
+        node.m_slot = EXPIRED_SLOT;
+        link_tail(m_slots[EXPIRED_SLOT], node);
+        return;
+    }
+
+    //  The level is determined by the highest digit that differs from now.
+    size_t bits = Kernels::bitlength(tick ^ m_current);
+    size_t level = bits == 0 ? 0 : (bits - 1) / LEVEL_BITS;
+    size_t index = (size_t)(tick >> (level * LEVEL_BITS)) & (SLOTS - 1);
+
+    node.m_slot = level * SLOTS + index;
+    link_tail(m_slots[node.m_slot], node);
+    m_occupied[level] |= (uint64_t)1 << index;
+}
+void TimerWheel::add(TimerWheelNode& node, WallClock expiration){
+    if (node.scheduled()){
+        cancel(node);
+    }
+    node.m_tick = to_tick_ceil(expiration);
+    insert(node);
+    m_size++;
+}
+void TimerWheel::cancel(TimerWheelNode& node){
+    if (!node.scheduled()){
+        return;
+    }
+    bool last_in_slot = node.m_prev == node.m_next;
+    unlink(node);
+    if (last_in_slot && node.m_slot != EXPIRED_SLOT){
+        m_occupied[node.m_slot / SLOTS] &= ~((uint64_t)1 << (node.m_slot % SLOTS));
+    }
+    m_size--;
+}
+
+
+uint64_t TimerWheel::next_work_tick() const{
+    //  Anything in level N expires before anything in level N + 1.
+    for (size_t level = 0; level < LEVELS; level++){
+        size_t shift = level * LEVEL_BITS;
+        size_t digit = (size_t)(m_current >> shift) & (SLOTS - 1);
+
+        //  Level 0 includes the current slot. For the higher levels, the
+        //  current slot is always empty since it gets cascaded on arrival.
+        uint64_t bits = m_occupied[level];
+        if (level == 0){
+            bits &= ~(uint64_t)0 << digit;
+        }else{
+            bits = digit == SLOTS - 1 ? 0 : bits & (~(uint64_t)0 << (digit + 1));
+        }
+
+        size_t index;
+        if (bits != 0 && Kernels::trailing_zeros(index, bits)){
+            uint64_t base = (m_current >> (shift + LEVEL_BITS)) << (shift + LEVEL_BITS);
+            return base + ((uint64_t)index << shift);
+        }
+    }
+    return ~(uint64_t)0;
+}
+void TimerWheel::cascade(size_t level){
+    size_t index = (size_t)(m_current >> (level * LEVEL_BITS)) & (SLOTS - 1);
+    uint64_t bit = (uint64_t)1 << index;
+    if ((m_occupied[level] & bit) == 0){
+        return;
+    }
+    m_occupied[level] &= ~bit;
+
+    //  Detach the list first since nodes may be re-inserted into this level.
+    TimerWheelNode& head = m_slots[level * SLOTS + index];
+    TimerWheelNode* node = head.m_next;
+    head.m_prev->m_next = nullptr;
+    head.m_prev = &head;
+    head.m_next = &head;
+    while (node != nullptr){
+        TimerWheelNode* next = node->m_next;
+        insert(*node);
+        node = next;
+    }
+}
+void TimerWheel::set_current(uint64_t tick){
+    m_current = tick;
+
+    //  Top-down so that timers can fall through multiple levels at once.
+    for (size_t level = LEVELS - 1; level > 0; level--){
+        uint64_t mask = ((uint64_t)1 << (level * LEVEL_BITS)) - 1;
+        if ((tick & mask) == 0){
+            cascade(level);
+        }
+    }
+}
+void TimerWheel::advance(uint64_t tick){
+    while (true){
+        uint64_t next = next_work_tick();
+        if (next > tick){
+            break;
+        }
+        if (next != m_current){
+            set_current(next);
+        }
+
+        //  Everything in the current level 0 slot expires now.
+        size_t index = (size_t)m_current & (SLOTS - 1);
+        uint64_t bit = (uint64_t)1 << index;
+        if (m_occupied[0] & bit){
+            m_occupied[0] &= ~bit;
+            TimerWheelNode& head = m_slots[index];
+            TimerWheelNode& expired = m_slots[EXPIRED_SLOT];
+            for (TimerWheelNode* node = head.m_next; node != &head; node = node->m_next){
+                node->m_slot = EXPIRED_SLOT;
+            }
+            head.m_next->m_prev = expired.m_prev;
+            expired.m_prev->m_next = head.m_next;
+            head.m_prev->m_next = &expired;
+            expired.m_prev = head.m_prev;
+            head.m_prev = &head;
+            head.m_next = &head;
+        }
+
+        set_current(m_current + 1);
+    }
+    if (m_current <= tick){
+        set_current(tick + 1);
+    }
+}
+
+
+WallClock TimerWheel::next_expiration() const{
+    const TimerWheelNode& expired = m_slots[EXPIRED_SLOT];
+    if (expired.m_next != &expired){
+        return WallClock::min();
+    }
+    uint64_t tick = next_work_tick();
+    return tick == ~(uint64_t)0 ? WallClock::max() : to_time(tick);
+}
+TimerWheelNode* TimerWheel::pop_expired(WallClock now){
+    TimerWheelNode& expired = m_slots[EXPIRED_SLOT];
+    if (expired.m_next == &expired){
+        advance(to_tick_floor(now));
+    }
+    if (expired.m_next == &expired){
+        return nullptr;
+    }
+    TimerWheelNode* node = expired.m_next;
+    unlink(*node);
+    m_size--;
+    return node;
+}
+
+
+
+
+}
@@ -0,0 +1,130 @@
+/*  Timer Wheel
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Hierarchical timing wheel with 1ms resolution.
+ *  (Varghese and Lauck - "Hashed and Hierarchical Timing Wheels")
+ *
+ *  Timers are intrusive nodes that the user embeds in their own objects.
+ *  Adding, cancelling and rescheduling are O(1) and never allocate.
+ *
+ *  There are 7 levels of 64 slots. Level N holds the timers that expire
+ *  within 64^(N+1) ms of the current time. As time advances, the slots of
+ *  the higher levels are cascaded down into the lower ones. This covers
+ *  2^42 ms (about 139 years). Anything further out is clamped to that.
+ *
+ *  Expirations are rounded up to the next millisecond. So a timer never
+ *  fires early, but may fire up to 1ms late.
+ *
+ *  Like PeriodicScheduler, this is the raw (unprotected) data structure.
+ *  The caller is responsible for locking.
+ *
+ */
+
+#ifndef PokemonAutomation_TimerWheel_H
+#define PokemonAutomation_TimerWheel_H
+
+#include <stdint.h>
+#include <cstddef>
+#include "Common/Cpp/Time.h"
+
+namespace PokemonAutomation{
+
+
+class TimerWheelNode{
+public:
+    TimerWheelNode() = default;
+    TimerWheelNode(const TimerWheelNode&) = delete;
+    void operator=(const TimerWheelNode&) = delete;
+
+    bool scheduled() const{ return m_prev != nullptr; }
+
+private:
+    friend class TimerWheel;
+    TimerWheelNode* m_prev = nullptr;
+    TimerWheelNode* m_next = nullptr;
+    uint64_t m_tick = 0;
+    size_t m_slot = 0;
+};
+
+
+
+class TimerWheel{
+public:
+    static constexpr size_t LEVEL_BITS = 6;
+    static constexpr size_t SLOTS = (size_t)1 << LEVEL_BITS;
+    static constexpr size_t LEVELS = 7;
+    static constexpr uint64_t MAX_TICK = ((uint64_t)1 << (LEVEL_BITS * LEVELS)) - 1;
+
+public:
+    TimerWheel(WallClock origin = current_time());
+    TimerWheel(const TimerWheel&) = delete;
+    void operator=(const TimerWheel&) = delete;
+
+    //  # of timers that are scheduled. (including expired ones not yet popped)
+    size_t size() const{ return m_size; }
+    bool empty() const{ return m_size == 0; }
+
+    //  Schedule "node" to expire at "expiration". If it is already scheduled,
+    //  it is moved to the new time.
+    void add(TimerWheelNode& node, WallClock expiration);
+
+    //  Unschedule "node". Does nothing if it isn't scheduled.
+    void cancel(TimerWheelNode& node);
+
+    //  Returns a lower bound on when the next timer expires. This is exact if
+    //  the next timer is within 64ms. Otherwise it is when the slot holding it
+    //  needs to be cascaded. Returns WallClock::max() if nothing is scheduled.
+    WallClock next_expiration() const;
+
+    //  Returns a timer that has expired by "now" and unschedules it.
+    //  Returns nullptr if nothing has expired. Timers that expire on earlier
+    //  ticks are returned first. (except ones that were already expired when
+    //  they were added)
+    TimerWheelNode* pop_expired(WallClock now = current_time());
+
+
+private:
+    uint64_t to_tick_ceil(WallClock time) const;
+    uint64_t to_tick_floor(WallClock time) const;
+    WallClock to_time(uint64_t tick) const;
+
+    static void link_tail(TimerWheelNode& head, TimerWheelNode& node);
+    static void unlink(TimerWheelNode& node);
+
+    //  Place a node in the slot for its tick relative to "m_current".
+    void insert(TimerWheelNode& node);
+
+    //  Returns the first tick at which there is something to do.
+    uint64_t next_work_tick() const;
+
+    //  Move the current time forward and cascade any slots that become current.
+    void set_current(uint64_t tick);
+    void cascade(size_t level);
+
+    //  Move everything that expires by "tick" into the expired list.
+    void advance(uint64_t tick);
+
+
+private:
+    static constexpr size_t EXPIRED_SLOT = LEVELS * SLOTS;
+
+    WallClock m_origin;
+
+    //  All ticks before this have been processed.
+    uint64_t m_current;
+
+    size_t m_size;
+
+    //  Bit N of level L is set if slot N of level L is non-empty.
+    uint64_t m_occupied[LEVELS];
+
+    //  Circular lists with sentinel heads. The last one holds the expired timers.
+    TimerWheelNode m_slots[LEVELS * SLOTS + 1];
+};
+
+
+
+
+}
+#endif
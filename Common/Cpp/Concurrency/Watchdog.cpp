@@ -39,21 +39,16 @@ void Watchdog::add(WatchdogCallback& callback, std::chrono::milliseconds period)
         auto iter = m_callbacks.find(&callback);
         if (iter == m_callbacks.end()){
             //  Callback doesn't exist. Add it.
-            auto iter1 = m_schedule.emplace(now + period, callback);
-            try{
-                m_callbacks.emplace(
-                    std::piecewise_construct,
-                    std::forward_as_tuple(&callback),
-                    std::forward_as_tuple(callback, period, iter1)
-                );
-            }catch (...){
-                m_schedule.erase(iter1);
-                throw;
-            }
+            iter = m_callbacks.emplace(
+                std::piecewise_construct,
+                std::forward_as_tuple(&callback),
+                std::forward_as_tuple(callback, period, now + period)
+            ).first;
+            m_schedule.add(iter->second, now + period);
         }else{
             //  Callback already exists. Update the period.
             iter->second.period = period;
-            signal = update_unprotected(iter, now + period);
+            signal = update_unprotected(iter->second, now + period);
         }
     }
 
@@ -74,8 +69,7 @@ void Watchdog::remove(WatchdogCallback& callback){
             std::mutex& entry_lock = iter_c->second.lock;
             if (entry_lock.try_lock()){
                 //  Remove from the schedule first.
-                auto iter_s = iter_c->second.iter;
-                m_schedule.erase(iter_s);
+                m_schedule.cancel(iter_c->second);
 
                 //  Unlock and remove from callback set.
                 entry_lock.unlock();
@@ -89,23 +83,21 @@ void Watchdog::remove(WatchdogCallback& callback){
 
 
 
-bool Watchdog::update_unprotected(CallbackMap::iterator iter, WallClock next_call){
+bool Watchdog::update_unprotected(Entry& entry, WallClock next_call){
     //  Must be called under the "m_state_lock".
 
-    if (next_call == iter->second.iter->first){
+    if (entry.scheduled() && next_call == entry.next_call){
         //  No change in time.
         return false;
     }
 
-    WallClock current_wake_time = m_schedule.begin()->first;
+    WallClock current_wake_time = m_schedule.next_expiration();
 
-    //  Add the new time first. Then remove the old one. This ensures strong
-    //  exception safety.
-    auto new_iter = m_schedule.emplace(next_call, *iter->first);
-    m_schedule.erase(iter->second.iter);
-    iter->second.iter = new_iter;
+    //  Moving a node in the wheel is O(1) and cannot fail.
+    entry.next_call = next_call;
+    m_schedule.add(entry, next_call);
 
-    WallClock new_wake_time = m_schedule.begin()->first;
+    WallClock new_wake_time = m_schedule.next_expiration();
     return new_wake_time < current_wake_time;
 }
 void Watchdog::delay(WatchdogCallback& callback, WallClock next_call){
@@ -119,7 +111,7 @@ void Watchdog::delay(WatchdogCallback& callback, WallClock next_call){
             return;
         }
         signal = update_unprotected(
-            iter,
+            iter->second,
             next_call == WallClock::min()
                 ? now + iter->second.period
                 : next_call
@@ -163,7 +155,6 @@ void Watchdog::thread_body(){
 
         std::unique_lock<std::mutex> elg;
         Entry* entry;
-        CallbackMap::iterator iter_c;
         {
             SpinLockGuard slg(m_state_lock);
 
@@ -176,16 +167,15 @@ void Watchdog::thread_body(){
 
             //  Check if the next scheduled thing is ready to run.
 
-            Schedule::iterator iter_s = m_schedule.begin();
-            iter_c = m_callbacks.find(&iter_s->second);
-            if (now < iter_s->first){
+            TimerWheelNode* node = m_schedule.pop_expired(now);
+            if (node == nullptr){
                 //  Not ready to run yet.
 //                cout << "Not ready to run yet..." << endl;
-                wake_time = iter_s->first;
+                wake_time = m_schedule.next_expiration();
                 continue;
             }else{
                 //  Ready to run.
-                entry = &iter_c->second;
+                entry = static_cast<Entry*>(node);
                 elg = std::unique_lock<std::mutex>(entry->lock);
             }
         }
@@ -203,7 +193,7 @@ void Watchdog::thread_body(){
         }
 
         SpinLockGuard slg(m_state_lock);
-        update_unprotected(iter_c, current_time() + entry->period);
+        update_unprotected(*entry, current_time() + entry->period);
 //        entry->lock.unlock();
 
         wake_time = WallClock::min();
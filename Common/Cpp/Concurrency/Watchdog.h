@@ -20,6 +20,7 @@
 #include <condition_variable>
 #include "Common/Cpp/Time.h"
 #include "Common/Cpp/Concurrency/SpinLock.h"
+#include "TimerWheel.h"
 
 namespace PokemonAutomation{
 
@@ -52,7 +53,7 @@ public:
     //
     //  The above methods add() and delay(), are fast and will return quickly.
     //  So it is safe to call them in semi-performance critical places.
-    //  (The critical section involves one spin-lock acquisition and 3 map lookups.)
+    //  (The critical section involves one spin-lock acquisition and 1 map lookup.)
     //
     //  remove() will also return quickly unless the callback being removed
     //  is currently running. In that case, it will block until it is done
@@ -60,32 +61,30 @@ public:
     //
 
 private:
-    using Schedule = std::multimap<WallClock, WatchdogCallback&>;
-
-    struct Entry{
+    struct Entry : public TimerWheelNode{
         WatchdogCallback& callback;
         std::chrono::milliseconds period;
-        Schedule::iterator iter;
+        WallClock next_call;
         std::mutex lock;
 
         Entry(
             WatchdogCallback& p_callback,
             std::chrono::milliseconds p_period,
-            Schedule::iterator p_iter
+            WallClock p_next_call
         )
-            : callback(p_callback), period(p_period), iter(p_iter)
+            : callback(p_callback), period(p_period), next_call(p_next_call)
         {}
     };
     using CallbackMap = std::map<WatchdogCallback*, Entry>;
 
     //  Return true if the next call has moved up and we should signal.
-    bool update_unprotected(CallbackMap::iterator iter, WallClock next_call);
+    bool update_unprotected(Entry& entry, WallClock next_call);
     void thread_body();
 
 private:
     bool m_stopped = false;
     CallbackMap m_callbacks;
-    Schedule m_schedule;
+    TimerWheel m_schedule;
 
     //  Nothing should ever acquire both locks at once.
     SpinLock m_state_lock;
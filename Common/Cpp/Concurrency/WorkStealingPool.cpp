@@ -0,0 +1,370 @@
+/*  Work Stealing Pool
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include <algorithm>
+#include "Common/Cpp/PanicDump.h"
+#include "WorkStealingPool.h"
+
+//#include <iostream>
+//using std::cout;
+//using std::endl;
+
+namespace PokemonAutomation{
+
+
+//
+//  Chase-Lev deque with a fixed capacity.
+//  (Lê, Pop, Cohen, Zappa Nardelli - "Correct and Efficient Work-Stealing for Weak Memory Models")
+//
+//  Only the owning worker may call "push()" and "pop()".
+//  Any thread may call "steal()".
+//
+class WorkStealingPool::WorkDeque{
+public:
+    WorkDeque(size_t capacity)
+        : m_top(0)
+        , m_bottom(0)
+        , m_mask(capacity - 1)
+        , m_buffer(new std::atomic<AsyncTask*>[capacity])
+    {}
+
+    //  Returns false if the deque is full.
+    bool push(AsyncTask* task){
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        if ((size_t)(b - t) > m_mask){
+            return false;
+        }
+        m_buffer[b & m_mask].store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+    AsyncTask* pop(){
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        //  Empty
+        if (t > b){
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        AsyncTask* task = m_buffer[b & m_mask].load(std::memory_order_relaxed);
+        if (t == b){
+            //  Last item. Race against the stealers for it.
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)){
+                task = nullptr;
+            }
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+    AsyncTask* steal(){
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b){
+            return nullptr;
+        }
+        AsyncTask* task = m_buffer[t & m_mask].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)){
+            return nullptr;
+        }
+        return task;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+    size_t m_mask;
+    std::unique_ptr<std::atomic<AsyncTask*>[]> m_buffer;
+};
+
+struct WorkStealingPool::Worker{
+    static constexpr size_t DEQUE_CAPACITY = 1024;
+
+    WorkStealingPool& pool;
+    size_t index;
+    WorkDeque deque;
+    std::thread thread;
+
+    Worker(WorkStealingPool& p_pool, size_t p_index)
+        : pool(p_pool)
+        , index(p_index)
+        , deque(DEQUE_CAPACITY)
+    {}
+};
+
+struct WorkStealingPool::ParallelRange{
+    const std::function<void(size_t index)>& func;
+    const size_t end;
+    const size_t block_size;
+    std::atomic<size_t> next;
+
+    std::mutex lock;
+    std::exception_ptr exception;
+
+    ParallelRange(
+        const std::function<void(size_t index)>& p_func,
+        size_t s, size_t e, size_t p_block_size
+    )
+        : func(p_func)
+        , end(e)
+        , block_size(p_block_size)
+        , next(s)
+    {}
+
+    //  Claim and run the next block. Returns false if there is nothing left.
+    bool run_block(){
+        size_t s = next.fetch_add(block_size, std::memory_order_relaxed);
+        if (s >= end){
+            return false;
+        }
+        size_t e = std::min(s + block_size, end);
+        try{
+            for (size_t index = s; index < e; index++){
+                func(index);
+            }
+        }catch (...){
+            std::lock_guard<std::mutex> lg(lock);
+            if (!exception){
+                exception = std::current_exception();
+            }
+        }
+        return true;
+    }
+};
+
+
+
+namespace{
+    //  The worker (if any) that the current thread belongs to.
+    thread_local void* current_worker = nullptr;
+}
+
+
+
+WorkStealingPool::WorkStealingPool(std::function<void()>&& new_thread_callback, size_t threads)
+    : m_new_thread_callback(std::move(new_thread_callback))
+    , m_pending(0)
+    , m_sleepers(0)
+    , m_stopping(false)
+{
+    if (threads == 0){
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    //  Build all the workers before starting any of them since they will
+    //  immediately start looking at each other's deques.
+    for (size_t c = 0; c < threads; c++){
+        m_workers.emplace_back(std::make_unique<Worker>(*this, c));
+    }
+    for (std::unique_ptr<Worker>& worker : m_workers){
+        size_t index = worker->index;
+        worker->thread = std::thread(run_with_catch, "WorkStealingPool::thread_loop()", [this, index]{ thread_loop(index); });
+    }
+}
+WorkStealingPool::~WorkStealingPool(){
+    {
+        std::lock_guard<std::mutex> lg(m_sleep_lock);
+        m_stopping = true;
+        m_cv.notify_all();
+    }
+    for (std::unique_ptr<Worker>& worker : m_workers){
+        worker->thread.join();
+    }
+
+    //  Release anyone waiting on a task that will never run.
+    for (std::unique_ptr<Worker>& worker : m_workers){
+        while (AsyncTask* task = worker->deque.pop()){
+            task->signal();
+        }
+    }
+    for (AsyncTask* task : m_injection_queue){
+        task->signal();
+    }
+}
+
+
+void WorkStealingPool::push(AsyncTask& task){
+    //  Count it before it becomes visible so that the count never underflows.
+    m_pending.fetch_add(1, std::memory_order_seq_cst);
+
+    Worker* self = (Worker*)current_worker;
+    if (self == nullptr || &self->pool != this || !self->deque.push(&task)){
+        std::lock_guard<std::mutex> lg(m_injection_lock);
+        m_injection_queue.emplace_back(&task);
+    }
+
+    if (m_sleepers.load(std::memory_order_seq_cst) != 0){
+        std::lock_guard<std::mutex> lg(m_sleep_lock);
+        m_cv.notify_one();
+    }
+}
+AsyncTask* WorkStealingPool::try_pop_injected(){
+    std::lock_guard<std::mutex> lg(m_injection_lock);
+    if (m_injection_queue.empty()){
+        return nullptr;
+    }
+    AsyncTask* task = m_injection_queue.front();
+    m_injection_queue.pop_front();
+    return task;
+}
+AsyncTask* WorkStealingPool::try_get(Worker* self){
+    if (m_pending.load(std::memory_order_acquire) == 0){
+        return nullptr;
+    }
+
+    AsyncTask* task = nullptr;
+    if (self != nullptr){
+        task = self->deque.pop();
+    }
+    if (task == nullptr){
+        task = try_pop_injected();
+    }
+    if (task == nullptr){
+        //  Steal starting from the neighbor so that thieves spread out.
+        size_t workers = m_workers.size();
+        size_t start = self == nullptr ? 0 : self->index + 1;
+        for (size_t c = 0; c < workers && task == nullptr; c++){
+            Worker& victim = *m_workers[(start + c) % workers];
+            if (&victim != self){
+                task = victim.deque.steal();
+            }
+        }
+    }
+    if (task != nullptr){
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    return task;
+}
+void WorkStealingPool::run_task(AsyncTask& task){
+    try{
+        task.m_task();
+    }catch (...){
+        task.m_exception = std::current_exception();
+        task.m_stopped_with_error.store(true, std::memory_order_release);
+    }
+    task.signal();
+}
+
+
+std::unique_ptr<AsyncTask> WorkStealingPool::dispatch(std::function<void()>&& func){
+    std::unique_ptr<AsyncTask> task(new AsyncTask(std::move(func)));
+    push(*task);
+    return task;
+}
+void WorkStealingPool::wait_and_help(AsyncTask& task){
+    Worker* self = (Worker*)current_worker;
+    if (self != nullptr && &self->pool != this){
+        self = nullptr;
+    }
+
+    while (true){
+        {
+            std::lock_guard<std::mutex> lg(task.m_lock);
+            if (task.m_finished){
+                return;
+            }
+        }
+
+        AsyncTask* next = try_get(self);
+        if (next != nullptr){
+            run_task(*next);
+            continue;
+        }
+
+        //  Nothing left to help with. The task is running on another thread.
+        //  A worker can't block here since that could starve the pool.
+        if (self == nullptr){
+            std::unique_lock<std::mutex> lg(task.m_lock);
+            task.m_cv.wait(lg, [&]{ return task.m_finished; });
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+void WorkStealingPool::run_in_parallel(
+    size_t s, size_t e,
+    const std::function<void(size_t index)>& func,
+    size_t block_size
+){
+    if (s >= e){
+        return;
+    }
+
+    size_t total = e - s;
+    if (block_size == 0){
+        size_t target_blocks = m_workers.size() * 4;
+        block_size = (total + target_blocks - 1) / target_blocks;
+    }
+    size_t blocks = (total + block_size - 1) / block_size;
+
+    ParallelRange range(func, s, e, block_size);
+
+    //  One helper per thread that can be kept busy. The caller is one of them.
+    size_t helpers = std::min(blocks, m_workers.size() + 1) - 1;
+    std::vector<std::unique_ptr<AsyncTask>> tasks;
+    tasks.reserve(helpers);
+    try{
+        for (size_t c = 0; c < helpers; c++){
+            tasks.emplace_back(dispatch([&range]{
+                while (range.run_block());
+            }));
+        }
+    }catch (...){
+        //  Couldn't dispatch everything. The caller will pick up the slack.
+    }
+
+    while (range.run_block());
+
+    for (std::unique_ptr<AsyncTask>& task : tasks){
+        wait_and_help(*task);
+    }
+
+    if (range.exception){
+        std::rethrow_exception(range.exception);
+    }
+}
+
+
+void WorkStealingPool::thread_loop(size_t index){
+    Worker& self = *m_workers[index];
+    current_worker = &self;
+
+    if (m_new_thread_callback){
+        m_new_thread_callback();
+    }
+
+    while (true){
+        AsyncTask* task = try_get(&self);
+        if (task != nullptr){
+            run_task(*task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lg(m_sleep_lock);
+        if (m_stopping){
+            return;
+        }
+
+        //  Announce that we're going to sleep before the final check so that
+        //  a concurrent "push()" either sees us or we see its task.
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        m_cv.wait(lg, [this]{
+            return m_stopping || m_pending.load(std::memory_order_seq_cst) != 0;
+        });
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+
+
+
+}
@@ -0,0 +1,95 @@
+/*  Work Stealing Pool
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      A fixed-size thread pool for short compute tasks.
+ *
+ *  Each worker owns a Chase-Lev deque. Tasks dispatched from a worker go onto
+ *  its own deque. Tasks dispatched from outside the pool go onto a shared
+ *  injection queue. Idle workers steal from each other before parking.
+ *
+ *  Unlike AsyncDispatcher, this pool never grows. Tasks must not block on
+ *  other tasks or on external events. Otherwise the pool can starve.
+ *  Only use it for short compute kernels. (e.g. "run_in_parallel()" over
+ *  the rows of an image) Inference callbacks, OCR and anything else that
+ *  is long-running or blocking goes on an AsyncDispatcher.
+ *
+ *  Waiting inside "run_in_parallel()" is safe even from a worker thread. The
+ *  waiting thread keeps running queued tasks until its range is finished.
+ *
+ */
+
+#ifndef PokemonAutomation_WorkStealingPool_H
+#define PokemonAutomation_WorkStealingPool_H
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "AsyncDispatcher.h"
+
+namespace PokemonAutomation{
+
+
+class WorkStealingPool{
+public:
+    //  If "threads" is zero, use the # of hardware threads.
+    WorkStealingPool(std::function<void()>&& new_thread_callback, size_t threads);
+    ~WorkStealingPool();
+
+    size_t threads() const{ return m_workers.size(); }
+
+    //  Dispatch the specified task and return a handle to it.
+    std::unique_ptr<AsyncTask> dispatch(std::function<void()>&& func);
+
+    //  Run the specified lambda for indices [s, e) in parallel.
+    //  The range is split into blocks of "block_size" indices.
+    //  If "block_size" is zero, pick one that gives each thread a few blocks.
+    void run_in_parallel(
+        size_t s, size_t e,
+        const std::function<void(size_t index)>& func,
+        size_t block_size = 0
+    );
+
+
+private:
+    class WorkDeque;
+    struct Worker;
+    struct ParallelRange;
+
+    void push(AsyncTask& task);
+    AsyncTask* try_pop_injected();
+    AsyncTask* try_get(Worker* self);
+    static void run_task(AsyncTask& task);
+
+    //  Run queued tasks until "task" is finished.
+    void wait_and_help(AsyncTask& task);
+
+    void thread_loop(size_t index);
+
+private:
+    std::function<void()> m_new_thread_callback;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    //  Tasks that are queued, but not yet picked up by anyone.
+    std::atomic<size_t> m_pending;
+
+    std::mutex m_injection_lock;
+    std::deque<AsyncTask*> m_injection_queue;
+
+    //  Parking. A worker only sleeps if "m_pending" is zero.
+    std::atomic<size_t> m_sleepers;
+    bool m_stopping;
+    std::mutex m_sleep_lock;
+    std::condition_variable m_cv;
+};
+
+
+
+
+}
+#endif
@@ -80,6 +80,8 @@ SOURCES += \
     ../ClientSource/Libraries/Logging.cpp \
     ../ClientSource/Libraries/MessageConverter.cpp \
     ../Common/CRC32.cpp \
+    ../Common/CRC32_arm64_CRC.cpp \
+    ../Common/CRC32_x64_SSE42.cpp \
     ../Common/Cpp/CancellableScope.cpp \
     ../Common/Cpp/Color.cpp \
     ../Common/Cpp/Concurrency/AsyncDispatcher.cpp \
@@ -88,7 +90,9 @@ SOURCES += \
     ../Common/Cpp/Concurrency/PeriodicScheduler.cpp \
     ../Common/Cpp/Concurrency/ScheduledTaskRunner.cpp \
     ../Common/Cpp/Concurrency/SpinLock.cpp \
+    ../Common/Cpp/Concurrency/TimerWheel.cpp \
     ../Common/Cpp/Concurrency/Watchdog.cpp \
+    ../Common/Cpp/Concurrency/WorkStealingPool.cpp \
     ../Common/Cpp/Containers/AlignedMalloc.cpp \
     ../Common/Cpp/CpuId/CpuId.cpp \
     ../Common/Cpp/EnumDatabase.cpp \
@@ -227,6 +231,7 @@ SOURCES += \
     Source/CommonFramework/InferenceInfra/VisualInferenceCallback.cpp \
     Source/CommonFramework/InferenceInfra/VisualInferencePivot.cpp \
     Source/CommonFramework/Language.cpp \
+    Source/CommonFramework/Logging/AsyncLogWriter.cpp \
     Source/CommonFramework/Logging/FileWindowLogger.cpp \
     Source/CommonFramework/Logging/Logger.cpp \
     Source/CommonFramework/Logging/OutputRedirector.cpp \
@@ -242,6 +247,7 @@ SOURCES += \
     Source/CommonFramework/OCR/OCR_DictionaryOCR.cpp \
     Source/CommonFramework/OCR/OCR_LargeDictionaryMatcher.cpp \
     Source/CommonFramework/OCR/OCR_NumberReader.cpp \
+    Source/CommonFramework/OCR/OCR_QGramIndex.cpp \
     Source/CommonFramework/OCR/OCR_RawOCR.cpp \
     Source/CommonFramework/OCR/OCR_Routines.cpp \
     Source/CommonFramework/OCR/OCR_SmallDictionaryMatcher.cpp \
@@ -271,6 +277,7 @@ SOURCES += \
     Source/CommonFramework/PersistentSettings.cpp \
     Source/CommonFramework/ProgramSession.cpp \
     Source/CommonFramework/Resources/SpriteDatabase.cpp \
+    Source/CommonFramework/Resources/SpritePack.cpp \
     Source/CommonFramework/SetupSettings.cpp \
     Source/CommonFramework/Tools/BlackBorderCheck.cpp \
     Source/CommonFramework/Tools/BotBaseHandle.cpp \
@@ -278,6 +285,7 @@ SOURCES += \
     Source/CommonFramework/Tools/DebugDumper.cpp \
     Source/CommonFramework/Tools/ErrorDumper.cpp \
     Source/CommonFramework/Tools/FileDownloader.cpp \
+    Source/CommonFramework/Tools/ImageEncodeService.cpp \
     Source/CommonFramework/Tools/InterruptableCommands.cpp \
     Source/CommonFramework/Tools/MultiConsoleErrors.cpp \
     Source/CommonFramework/Tools/ProgramEnvironment.cpp \
@@ -348,7 +356,17 @@ SOURCES += \
     Source/Kernels/ImageFilters/Kernels_ImageFilter_Basic_x64_AVX2.cpp \
     Source/Kernels/ImageFilters/Kernels_ImageFilter_Basic_x64_AVX512.cpp \
     Source/Kernels/ImageFilters/Kernels_ImageFilter_Basic_x64_SSE42.cpp \
+    Source/Kernels/ImageResample/Kernels_ImageResample.cpp \
+    Source/Kernels/ImageResample/Kernels_ImageResample_Default.cpp \
+    Source/Kernels/ImageResample/Kernels_ImageResample_arm64_NEON.cpp \
+    Source/Kernels/ImageResample/Kernels_ImageResample_x64_AVX2.cpp \
+    Source/Kernels/ImageResample/Kernels_ImageResample_x64_AVX512.cpp \
     Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightness.cpp \
+    Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightnessRMSD.cpp \
+    Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightnessRMSD_Default.cpp \
+    Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightnessRMSD_x64_AVX2.cpp \
+    Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightnessRMSD_x64_AVX512.cpp \
+    Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightnessRMSD_x64_SSE41.cpp \
     Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightness_Default.cpp \
     Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightness_arm64_NEON.cpp \
     Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightness_x64_AVX2.cpp \
@@ -384,12 +402,17 @@ SOURCES += \
     Source/Kernels/Waterfill/Kernels_Waterfill_Core_64x8_x64_SSE42.cpp \
     Source/Kernels/Waterfill/Kernels_Waterfill_Core_64xH_Default.cpp \
     Source/Kernels/Waterfill/Kernels_Waterfill_Session.cpp \
+    Source/Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes.cpp \
+    Source/Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes_Default.cpp \
+    Source/Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes_x64_AVX2.cpp \
+    Source/Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes_x64_AVX512.cpp \
     Source/NintendoSwitch/Commands/NintendoSwitch_Commands_Device.cpp \
     Source/NintendoSwitch/Commands/NintendoSwitch_Commands_DigitEntry.cpp \
     Source/NintendoSwitch/Commands/NintendoSwitch_Commands_PushButtons.cpp \
     Source/NintendoSwitch/Commands/NintendoSwitch_Commands_Routines.cpp \
     Source/NintendoSwitch/Commands/NintendoSwitch_Commands_Superscalar.cpp \
     Source/NintendoSwitch/DevPrograms/BoxDraw.cpp \
+    Source/NintendoSwitch/DevPrograms/BuildSpritePacks.cpp \
     Source/NintendoSwitch/DevPrograms/TestProgramComputer.cpp \
     Source/NintendoSwitch/DevPrograms/TestProgramSwitch.cpp \
     Source/NintendoSwitch/Framework/NintendoSwitch_MultiSwitchProgramOption.cpp \
@@ -966,7 +989,9 @@ SOURCES += \
     Source/PokemonSwSh/ShinyHuntTracker.cpp \
     Source/Tests/CommandLineTests.cpp \
     Source/Tests/CommonFramework_Tests.cpp \
+    Source/Tests/Common_Tests.cpp \
     Source/Tests/Kernels_Tests.cpp \
+    Source/Tests/LoopbackDevice.cpp \
     Source/Tests/NintendoSwitch_Tests.cpp \
     Source/Tests/PokemonLA_Tests.cpp \
     Source/Tests/PokemonSV_Tests.cpp \
@@ -1057,6 +1082,7 @@ HEADERS += \
     ../ClientSource/Connection/MessageSniffer.h \
     ../ClientSource/Connection/PABotBase.h \
     ../ClientSource/Connection/PABotBaseConnection.h \
+    ../ClientSource/Connection/RetransmitTimeout.h \
     ../ClientSource/Connection/SerialConnection.h \
     ../ClientSource/Connection/SerialConnectionPOSIX.h \
     ../ClientSource/Connection/SerialConnectionWinAPI.h \
@@ -1075,7 +1101,9 @@ HEADERS += \
     ../Common/Cpp/Concurrency/ScheduledTaskRunner.h \
     ../Common/Cpp/Concurrency/SpinLock.h \
     ../Common/Cpp/Concurrency/SpinPause.h \
+    ../Common/Cpp/Concurrency/TimerWheel.h \
     ../Common/Cpp/Concurrency/Watchdog.h \
+    ../Common/Cpp/Concurrency/WorkStealingPool.h \
     ../Common/Cpp/Containers/AlignedMalloc.h \
     ../Common/Cpp/Containers/AlignedVector.h \
     ../Common/Cpp/Containers/AlignedVector.tpp \
@@ -1267,6 +1295,7 @@ HEADERS += \
     Source/CommonFramework/InferenceInfra/VisualInferenceCallback.h \
     Source/CommonFramework/InferenceInfra/VisualInferencePivot.h \
     Source/CommonFramework/Language.h \
+    Source/CommonFramework/Logging/AsyncLogWriter.h \
     Source/CommonFramework/Logging/FileWindowLogger.h \
     Source/CommonFramework/Logging/Logger.h \
     Source/CommonFramework/Logging/OutputRedirector.h \
@@ -1282,6 +1311,7 @@ HEADERS += \
     Source/CommonFramework/OCR/OCR_DictionaryOCR.h \
     Source/CommonFramework/OCR/OCR_LargeDictionaryMatcher.h \
     Source/CommonFramework/OCR/OCR_NumberReader.h \
+    Source/CommonFramework/OCR/OCR_QGramIndex.h \
     Source/CommonFramework/OCR/OCR_RawOCR.h \
     Source/CommonFramework/OCR/OCR_Routines.h \
     Source/CommonFramework/OCR/OCR_SmallDictionaryMatcher.h \
@@ -1313,6 +1343,7 @@ HEADERS += \
     Source/CommonFramework/PersistentSettings.h \
     Source/CommonFramework/ProgramSession.h \
     Source/CommonFramework/Resources/SpriteDatabase.h \
+    Source/CommonFramework/Resources/SpritePack.h \
     Source/CommonFramework/SetupSettings.h \
     Source/CommonFramework/Tools/BlackBorderCheck.h \
     Source/CommonFramework/Tools/BotBaseHandle.h \
@@ -1320,6 +1351,7 @@ HEADERS += \
     Source/CommonFramework/Tools/DebugDumper.h \
     Source/CommonFramework/Tools/ErrorDumper.h \
     Source/CommonFramework/Tools/FileDownloader.h \
+    Source/CommonFramework/Tools/ImageEncodeService.h \
     Source/CommonFramework/Tools/InterruptableCommands.h \
     Source/CommonFramework/Tools/MultiConsoleErrors.h \
     Source/CommonFramework/Tools/ProgramEnvironment.h \
@@ -1413,7 +1445,9 @@ HEADERS += \
     Source/Kernels/BinaryMatrix/Kernels_SparseBinaryMatrixCore.h \
     Source/Kernels/BinaryMatrix/Kernels_SparseBinaryMatrixCore.tpp \
     Source/Kernels/ImageFilters/Kernels_ImageFilter_Basic.h \
+    Source/Kernels/ImageResample/Kernels_ImageResample.h \
     Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightness.h \
+    Source/Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightnessRMSD.h \
     Source/Kernels/ImageStats/Kernels_ImagePixelSumSqr.h \
     Source/Kernels/ImageStats/Kernels_ImagePixelSumSqrDev.h \
     Source/Kernels/Kernels_Alignment.h \
@@ -1446,6 +1480,7 @@ HEADERS += \
     Source/Kernels/Waterfill/Kernels_Waterfill_Session.h \
     Source/Kernels/Waterfill/Kernels_Waterfill_Session.tpp \
     Source/Kernels/Waterfill/Kernels_Waterfill_Types.h \
+    Source/Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes.h \
     Source/NintendoSwitch/Commands/NintendoSwitch_Commands_Device.h \
     Source/NintendoSwitch/Commands/NintendoSwitch_Commands_DigitEntry.h \
     Source/NintendoSwitch/Commands/NintendoSwitch_Commands_PushButtons.h \
@@ -1455,6 +1490,7 @@ HEADERS += \
     Source/NintendoSwitch/Commands/NintendoSwitch_Messages_PushButtons.h \
     Source/NintendoSwitch/Commands/NintendoSwitch_Messages_Superscalar.h \
     Source/NintendoSwitch/DevPrograms/BoxDraw.h \
+    Source/NintendoSwitch/DevPrograms/BuildSpritePacks.h \
     Source/NintendoSwitch/DevPrograms/TestProgramComputer.h \
     Source/NintendoSwitch/DevPrograms/TestProgramSwitch.h \
     Source/NintendoSwitch/FixedInterval.h \
@@ -2044,7 +2080,9 @@ HEADERS += \
     Source/PokemonSwSh/ShinyHuntTracker.h \
     Source/Tests/CommandLineTests.h \
     Source/Tests/CommonFramework_Tests.h \
+    Source/Tests/Common_Tests.h \
     Source/Tests/Kernels_Tests.h \
+    Source/Tests/LoopbackDevice.h \
     Source/Tests/NintendoSwitch_Tests.h \
     Source/Tests/PokemonLA_Tests.h \
     Source/Tests/PokemonSV_Tests.h \
@@ -7,6 +7,7 @@
 #ifndef PokemonAutomation_Environment_H
 #define PokemonAutomation_Environment_H
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include <QThread>
@@ -45,6 +46,10 @@ struct ProcessorSpecs{
 ProcessorSpecs get_processor_specs();
 
 
+//  Peak resident memory of this process in bytes. Returns 0 if unavailable.
+uint64_t peak_process_memory();
+
+
 
 
 
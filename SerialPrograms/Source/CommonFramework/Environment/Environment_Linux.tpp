@@ -136,6 +136,20 @@ size_t SystemCpuTime::read_cores(){
 
 
 
+uint64_t peak_process_memory(){
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == -1){
+        return 0;
+    }
+#if defined(__APPLE__)
+    return (uint64_t)ru.ru_maxrss;          //  Bytes
+#else
+    return (uint64_t)ru.ru_maxrss * 1024;   //  Kilobytes
+#endif
+}
+
+
+
 
 
 
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <thread>
 #include <Windows.h>
+#include <Psapi.h>
 #include "Common/Cpp/Exceptions.h"
 #include "CommonFramework/Logging/Logger.h"
 #include "Environment.h"
@@ -179,6 +180,16 @@ size_t SystemCpuTime::read_cores(){
 
 
 
+uint64_t peak_process_memory(){
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))){
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+}
+
+
+
 
 
 
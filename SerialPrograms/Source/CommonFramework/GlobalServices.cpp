@@ -5,7 +5,10 @@
  */
 
 //#include "Common/Cpp/Concurrency/ScheduledTaskRunner.h"
+#include "Common/Cpp/Concurrency/AsyncDispatcher.h"
 #include "Common/Cpp/Concurrency/Watchdog.h"
+#include "Common/Cpp/Concurrency/WorkStealingPool.h"
+#include "CommonFramework/GlobalSettingsPanel.h"
 #include "GlobalServices.h"
 
 namespace PokemonAutomation{
@@ -25,6 +28,24 @@ Watchdog& global_watchdog(){
     static Watchdog watchdog;
     return watchdog;
 }
+WorkStealingPool& global_compute_pool(){
+    static WorkStealingPool pool(
+        [](){
+            GlobalSettings::instance().INFERENCE_PRIORITY0.set_on_this_thread();
+        },
+        0
+    );
+    return pool;
+}
+AsyncDispatcher& global_inference_dispatcher(){
+    static AsyncDispatcher dispatcher(
+        [](){
+            GlobalSettings::instance().INFERENCE_PRIORITY0.set_on_this_thread();
+        },
+        0
+    );
+    return dispatcher;
+}
 
 
 
@@ -12,12 +12,22 @@ namespace PokemonAutomation{
 class AsyncDispatcher;
 class ScheduledTaskRunner;
 class Watchdog;
+class WorkStealingPool;
 
 
 //AsyncDispatcher& global_async_dispatcher();
 //ScheduledTaskRunner& global_scheduled_task_runner();
 Watchdog& global_watchdog();
 
+//  Fixed-size pool for short, non-blocking compute tasks. This is shared by
+//  all running programs. The threads are started on first use.
+WorkStealingPool& global_compute_pool();
+
+//  For inference work that may block. (e.g. OCR, which waits for a free
+//  instance) Threads are added as needed. This is shared by all running
+//  programs.
+AsyncDispatcher& global_inference_dispatcher();
+
 
 
 }
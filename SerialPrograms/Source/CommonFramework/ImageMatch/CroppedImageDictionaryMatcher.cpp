@@ -50,6 +50,23 @@ void CroppedImageDictionaryMatcher::add(const std::string& slug, const ImageView
     ).first;
 //    cout << iter->first << ": " << iter->second.stats().stddev.sum() << endl;
 }
+void CroppedImageDictionaryMatcher::add_cropped(
+    const std::string& slug,
+    const ImageViewRGB32& cropped, const ImageStats& cropped_stats
+){
+    if (!cropped){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Null image.");
+    }
+    auto iter = m_database.find(slug);
+    if (iter != m_database.end()){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Duplicate slug: " + slug);
+    }
+    m_database.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(slug),
+        std::forward_as_tuple(cropped.copy(), cropped_stats, m_weight)
+    );
+}
 
 
 
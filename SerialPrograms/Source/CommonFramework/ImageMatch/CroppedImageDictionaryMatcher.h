@@ -24,6 +24,10 @@ public:
 
     void add(const std::string& slug, const ImageViewRGB32& image);
 
+    //  Same as above, but "cropped" is already trimmed with "trim_image_alpha()"
+    //  and "cropped_stats" is its "image_stats()". (see SpriteDatabase::Sprite)
+    void add_cropped(const std::string& slug, const ImageViewRGB32& cropped, const ImageStats& cropped_stats);
+
     ImageMatchResult match(const ImageViewRGB32& image, double alpha_spread) const;
 
 
@@ -6,6 +6,7 @@
 
 #include <cmath>
 #include <vector>
+#include <algorithm>
 #include "Common/Cpp/Exceptions.h"
 #include "CommonFramework/ImageTypes/ImageViewRGB32.h"
 #include "CommonFramework/ImageTools/ImageBoxes.h"
@@ -64,6 +65,42 @@ std::vector<ImageRGB32> make_image_set(
 
 
 
+ExactImageDictionaryMatcher::Thumbnail::Thumbnail(const ImageViewRGB32& image, size_t size, bool use_alpha)
+    : average(size * size)
+    , weight(size * size)
+{
+    size_t width = image.width();
+    size_t height = image.height();
+    for (size_t cy = 0; cy < size; cy++){
+        size_t y0 = cy * height / size;
+        size_t y1 = (cy + 1) * height / size;
+        for (size_t cx = 0; cx < size; cx++){
+            size_t x0 = cx * width / size;
+            size_t x1 = (cx + 1) * width / size;
+            FloatPixel sum;
+            size_t opaque = 0;
+            for (size_t y = y0; y < y1; y++){
+                for (size_t x = x0; x < x1; x++){
+                    uint32_t pixel = image.pixel(x, y);
+                    if (use_alpha && (pixel >> 31) == 0){
+                        continue;
+                    }
+                    sum += FloatPixel(pixel);
+                    opaque++;
+                }
+            }
+            size_t total = (x1 - x0) * (y1 - y0);
+            size_t index = cy * size + cx;
+            if (opaque != 0){
+                average[index] = sum / (double)opaque;
+                weight[index] = (float)opaque / total;
+            }
+        }
+    }
+}
+
+
+
 ExactImageDictionaryMatcher::ExactImageDictionaryMatcher(const WeightedExactImageMatcher::InverseStddevWeight& weight)
     : m_weight(weight)
 {}
@@ -84,11 +121,24 @@ void ExactImageDictionaryMatcher::add(const std::string& slug, ImageRGB32 image)
         throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Duplicate slug: " + slug);
     }
 
-    m_database.emplace(
+    auto inserted = m_database.emplace(
         std::piecewise_construct,
         std::forward_as_tuple(slug),
         std::forward_as_tuple(std::move(image), m_weight)
+    ).first;
+    const ImageRGB32& image_template = inserted->second.image_template();
+
+    //  Keep these in the same order as the map.
+    auto position = std::lower_bound(
+        m_entries.begin(), m_entries.end(), slug,
+        [](const Entry& entry, const std::string& key){ return *entry.slug < key; }
     );
+    m_entries.insert(position, Entry{
+        &inserted->first,
+        &inserted->second,
+        Thumbnail(image_template, Thumbnail::COARSE, true),
+        Thumbnail(image_template, Thumbnail::FINE, true),
+    });
 //    if (slug == "linoone-galar" || slug == "coalossal"){
 //        cout << slug << " = " << m_database.find(slug)->second.stats().stddev.sum() << endl;
 //    }
@@ -107,14 +157,16 @@ void ExactImageDictionaryMatcher::scale_to_dimensions(ImageRGB32& image) const{
 
 double ExactImageDictionaryMatcher::compare(
     const WeightedExactImageMatcher& sprite,
-    const std::vector<ImageRGB32>& images
+    const std::vector<ImageRGB32>& images,
+    double max_alpha
 ){
 //    sprite.m_image.save("sprite.png");
 //    images[0].save("image.png");
 
     double best = 10000;
     for (const ImageRGB32& image : images){
-        double rmsd_alpha = sprite.diff(image);
+        //  Anything worse than the best so far doesn't matter. So let it bail early.
+        double rmsd_alpha = sprite.diff_bounded(image, std::min(best, max_alpha));
 //        cout << rmsd_alpha << endl;
 //        if (rmsd_alpha < 0.38){
 //            sprite.m_image.save("sprite.png");
@@ -125,6 +177,44 @@ double ExactImageDictionaryMatcher::compare(
 //    cout << best << endl;
     return best;
 }
+double ExactImageDictionaryMatcher::compare(
+    const WeightedExactImageMatcher& sprite, const Thumbnail& sprite_thumbnail,
+    const std::vector<Thumbnail>& images
+){
+    //  Same as the full comparison, but on the thumbnails. The cells are
+    //  weighted by how much of them is opaque in the template.
+    double best = 10000;
+    size_t cells = sprite_thumbnail.weight.size();
+    double total_weight = 0;
+    for (size_t c = 0; c < cells; c++){
+        total_weight += sprite_thumbnail.weight[c];
+    }
+    if (total_weight == 0){
+        //  Fully transparent. There's nothing to compare so rank it last.
+        return best;
+    }
+    for (const Thumbnail& image : images){
+        FloatPixel image_brightness;
+        for (size_t c = 0; c < cells; c++){
+            double weight = sprite_thumbnail.weight[c];
+            image_brightness += image.average[c] * FloatPixel(weight, weight, weight);
+        }
+        image_brightness /= total_weight;
+        FloatPixel scale = image_brightness / sprite.stats().average;
+        if (std::isnan(scale.r)) scale.r = 1.0;
+        if (std::isnan(scale.g)) scale.g = 1.0;
+        if (std::isnan(scale.b)) scale.b = 1.0;
+        scale.bound(0.85, 1.15);
+
+        double sumsqrs = 0;
+        for (size_t c = 0; c < cells; c++){
+            FloatPixel diff = sprite_thumbnail.average[c] * scale - image.average[c];
+            sumsqrs += sprite_thumbnail.weight[c] * (diff.r*diff.r + diff.g*diff.g + diff.b*diff.b);
+        }
+        best = std::min(best, std::sqrt(sumsqrs / total_weight) * sprite.m_multiplier);
+    }
+    return best;
+}
 
 ImageMatchResult ExactImageDictionaryMatcher::match(
     const ImageViewRGB32& image, const ImageFloatBox& box,
@@ -138,12 +228,58 @@ ImageMatchResult ExactImageDictionaryMatcher::match(
 
     // Translate the input image area a bit to careate matching candidates.
     std::vector<ImageRGB32> image_set = make_image_set(image, box, m_width, m_height, tolerance);
-    for (const auto& item : m_database){
-//        if (item.first != "linoone-galar"){
+
+    //  Rank the templates by thumbnail. First on the coarse ones for everything,
+    //  then on the fine ones for whatever survives that.
+    std::vector<std::pair<double, const Entry*>> candidates;
+    candidates.reserve(m_entries.size());
+    for (const Entry& entry : m_entries){
+        candidates.emplace_back(0, &entry);
+    }
+    if (m_pruning.top_k < m_entries.size()){
+        auto prune = [&](size_t keep, std::vector<Thumbnail> thumbnails, Thumbnail Entry::*thumbnail){
+            for (auto& item : candidates){
+                item.first = compare(*item.second->matcher, item.second->*thumbnail, thumbnails);
+            }
+            std::sort(
+                candidates.begin(), candidates.end(),
+                [](const auto& x, const auto& y){ return x.first < y.first; }
+            );
+            double bound = candidates[0].first + m_pruning.thumbnail_bound;
+            while (candidates.size() > keep && candidates.back().first > bound){
+                candidates.pop_back();
+            }
+        };
+        std::vector<Thumbnail> coarse;
+        std::vector<Thumbnail> fine;
+        for (const ImageRGB32& item : image_set){
+            coarse.emplace_back(item, Thumbnail::COARSE, false);
+            fine.emplace_back(item, Thumbnail::FINE, false);
+        }
+        prune(std::min(m_pruning.top_k * 4, m_entries.size()), std::move(coarse), &Entry::coarse);
+        prune(m_pruning.top_k, std::move(fine), &Entry::fine);
+    }
+
+    //  Go in order of thumbnail score so the best match is found early. That
+    //  lets the rest bail out sooner. Anything that bails is beyond the spread
+    //  of the best match and would have been cleared anyway.
+    double best = 10000;
+    for (auto& item : candidates){
+//        if (*item.second->slug != "linoone-galar"){
 //            continue;
 //        }
-        double alpha = compare(item.second, image_set);
-        results.add(alpha, item.first);
+        item.first = compare(*item.second->matcher, image_set, best + alpha_spread);
+        best = std::min(best, item.first);
+    }
+
+    //  Add them in dictionary order so that ties resolve the same as without
+    //  the pruning.
+    std::sort(
+        candidates.begin(), candidates.end(),
+        [](const auto& x, const auto& y){ return x.second < y.second; }
+    );
+    for (const auto& item : candidates){
+        results.add(item.first, *item.second->slug);
         results.clear_beyond_spread(alpha_spread);
     }
 
@@ -163,9 +299,11 @@ ImageMatchResult ExactImageDictionaryMatcher::subset_match(
 
     // Translate the input image area a bit to careate matching candidates.
     std::vector<ImageRGB32> image_set = make_image_set(image, box,  m_width, m_height, tolerance);
+    double best = 10000;
     for (const auto& slug : subset){
         const auto& matcher = image_matcher(slug);
-        double alpha = compare(matcher, image_set);
+        double alpha = compare(matcher, image_set, best + alpha_spread);
+        best = std::min(best, alpha);
         results.add(alpha, slug);
         results.clear_beyond_spread(alpha_spread);
     }
@@ -7,6 +7,7 @@
 #ifndef PokemonAutomation_CommonFramework_ExactImageDictionaryMatcher_H
 #define PokemonAutomation_CommonFramework_ExactImageDictionaryMatcher_H
 
+#include <stdint.h>
 #include <string>
 #include <map>
 #include <vector>
@@ -23,9 +24,26 @@ namespace ImageMatch{
 // Build a dictionary of image templates and use them to match against images.
 // All the image templates must have the same image shape.
 class ExactImageDictionaryMatcher{
+public:
+    // match() can first rank all the templates using small thumbnails. Then it
+    // only does the full resolution comparison on the most promising ones.
+    // This is lossy. Pruned templates are left out of the result entirely.
+    // Callers only read the top 2-3 results, so the default keeps a few times
+    // that many plus anything close to the best thumbnail score.
+    struct PruningSettings{
+        // Always do the full comparison on this many of the best templates by
+        // thumbnail score. SIZE_MAX disables the pruning.
+        size_t top_k = 8;
+        // Also do the full comparison on any template whose thumbnail score is
+        // within this much of the best thumbnail score.
+        double thumbnail_bound = 0.10;
+    };
+
 public:
     ExactImageDictionaryMatcher(const WeightedExactImageMatcher::InverseStddevWeight& weight);
 
+    void set_pruning(const PruningSettings& settings){ m_pruning = settings; }
+
     // Add an image template.
     // Do not allow one slug to have more than one template.
     void add(const std::string& slug, ImageRGB32 image_template);
@@ -66,20 +84,44 @@ public:
 
 
 private:
+    // Downscaled image. Each cell holds the average of the opaque pixels in it
+    // and the fraction of the cell that is opaque.
+    struct Thumbnail{
+        std::vector<FloatPixel> average;
+        std::vector<float> weight;
+
+        static constexpr size_t COARSE = 8;
+        static constexpr size_t FINE = 16;
+        Thumbnail(const ImageViewRGB32& image, size_t size, bool use_alpha);
+    };
+    struct Entry{
+        const std::string* slug;
+        const WeightedExactImageMatcher* matcher;
+        Thumbnail coarse;
+        Thumbnail fine;
+    };
+
     static double compare(
         const WeightedExactImageMatcher& sprite,
-        const std::vector<ImageRGB32>& images
+        const std::vector<ImageRGB32>& images,
+        double max_alpha
+    );
+    static double compare(
+        const WeightedExactImageMatcher& sprite, const Thumbnail& sprite_thumbnail,
+        const std::vector<Thumbnail>& images
     );
 
 
 private:
     WeightedExactImageMatcher::InverseStddevWeight m_weight;
+    PruningSettings m_pruning;
     // The size of the image templates.
     // Each template must have the same size.
 //    QSize m_dimensions;
     size_t m_width = 0;
     size_t m_height = 0;
     std::map<std::string, WeightedExactImageMatcher> m_database;
+    std::vector<Entry> m_entries;
 };
 
 
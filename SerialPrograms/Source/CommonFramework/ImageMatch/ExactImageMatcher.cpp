@@ -5,7 +5,10 @@
  */
 
 #include <cmath>
+#include <limits>
 #include "Common/Cpp/Exceptions.h"
+#include "Kernels/ImageResample/Kernels_ImageResample.h"
+#include "Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightnessRMSD.h"
 #include "ImageDiff.h"
 #include "ExactImageMatcher.h"
 
@@ -26,69 +29,141 @@ ExactImageMatcher::ExactImageMatcher(ImageRGB32 image)
     }
 //    cout << m_stats.stddev.sum() << endl;
 }
+ExactImageMatcher::ExactImageMatcher(ImageRGB32 image, const ImageStats& stats)
+    : m_image(std::move(image))
+    , m_stats(stats)
+{
+    if (!m_image){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Image is null.");
+    }
+}
+
+namespace{
+
+//  Resize "image" to the template shape, scale the template brightness to
+//  match, then compute the RMSD. Same result as doing these one at a time
+//  with "scale_to()", "scale_brightness()" and "pixel_RMSD()", but without
+//  making any copies of either image.
+//
+//  If "max_rmsd" is finite, stop as soon as the partial sum shows that the
+//  result will exceed it. The return value is then a lower bound that is
+//  already greater than "max_rmsd".
+double brightness_scaled_rmsd(
+    const ImageRGB32& reference, const FloatPixel& reference_average,
+    const ImageViewRGB32& image,
+    Kernels::SumSquareMode mode, uint32_t background = 0,
+    double max_rmsd = std::numeric_limits<double>::infinity()
+){
+    size_t width = reference.width();
+    size_t height = reference.height();
+
+    //  Same sampling as "scale_to()".
+    Kernels::SampledImage sampled;
+    sampled.image = image.data();
+    sampled.bytes_per_row = image.bytes_per_row();
+    std::shared_ptr<const Kernels::ResampleAxis> cols;
+    std::shared_ptr<const Kernels::ResampleAxis> rows;
+    if (image.width() != width || image.height() != height){
+        cols = Kernels::resample_axis(Kernels::ResampleFilter::NEAREST, image.width(), width);
+        rows = Kernels::resample_axis(Kernels::ResampleFilter::NEAREST, image.height(), height);
+        sampled.cols = cols->start.data();
+        sampled.rows = rows->start.data();
+    }
 
-ImageRGB32 ExactImageMatcher::scale_template_brightness(const ImageViewRGB32& image) const{
-    FloatPixel image_brightness = pixel_average(image, m_image);
-    FloatPixel scale = image_brightness / m_stats.average;
+    Kernels::PixelSums sums;
+    Kernels::pixel_sum_sampled(
+        sums, width, height,
+        sampled,
+        reference.data(), reference.bytes_per_row()
+    );
+    FloatPixel image_brightness((double)sums.sumR, (double)sums.sumG, (double)sums.sumB);
+    image_brightness /= (double)sums.count;
+    FloatPixel scale = image_brightness / reference_average;
 
     if (std::isnan(scale.r)) scale.r = 1.0;
     if (std::isnan(scale.g)) scale.g = 1.0;
     if (std::isnan(scale.b)) scale.b = 1.0;
     scale.bound(0.85, 1.15);
 
-    ImageRGB32 ret = m_image.copy();
-    scale_brightness(ret, scale);
-//    ret.save("test.png");
-    return ret;
+    uint64_t count = 0;
+    uint64_t sumsqrs = 0;
+    if (std::isinf(max_rmsd) || sums.count == 0){
+        Kernels::sum_sqr_deviation_scaled_brightness(
+            count, sumsqrs,
+            width, height,
+            reference.data(), reference.bytes_per_row(),
+            (float)scale.r, (float)scale.g, (float)scale.b,
+            sampled,
+            mode, background
+        );
+        return std::sqrt((double)sumsqrs / (double)count);
+    }
+
+    //  The final count is the # of opaque template pixels. That is already
+    //  known from the brightness pass. So the sum can be checked against the
+    //  limit after every row.
+    double max_sumsqrs = max_rmsd * max_rmsd * (double)sums.count;
+    const uint32_t* ref = reference.data();
+    for (size_t r = 0; r < height; r++){
+        Kernels::SampledImage row = sampled;
+        row.image = sampled.row(r);
+        row.rows = nullptr;
+        Kernels::sum_sqr_deviation_scaled_brightness(
+            count, sumsqrs,
+            width, 1,
+            ref, reference.bytes_per_row(),
+            (float)scale.r, (float)scale.g, (float)scale.b,
+            row,
+            mode, background
+        );
+        if ((double)sumsqrs > max_sumsqrs){
+            return std::sqrt((double)sumsqrs / (double)sums.count);
+        }
+        ref = (const uint32_t*)((const char*)ref + reference.bytes_per_row());
+    }
+    return std::sqrt((double)sumsqrs / (double)count);
 }
 
+}
+
+
 
 double ExactImageMatcher::rmsd(const ImageViewRGB32& image) const{
     if (!image){
         return 1000.;
     }
-
-//    image.save("test.png");
-
-//    cout << "ExactImageMatcher::rmsd(): image = " << image.width() << " x " << image.height() << endl;
-    ImageRGB32 scaled = image.scale_to(m_image.width(), m_image.height());
-//    cout << "ExactImageMatcher::rmsd(): scaled = " << scaled.width() << " x " << scaled.height() << endl;
-    ImageRGB32 reference = scale_template_brightness(scaled);
-
-#if 0
-    static int c = 0;
-    image.save("test-" + std::to_string(c) + "-image.png");
-    reference.save("test-" + std::to_string(c) + "-sprite.png");
-    c++;
-#endif
-
-    double rmsd = pixel_RMSD(reference, scaled);
-//    cout << "rmsd = " << rmsd << endl;
-    return rmsd;
+    return brightness_scaled_rmsd(
+        m_image, m_stats.average, image,
+        Kernels::SumSquareMode::REFERENCE_ALPHA
+    );
+}
+double ExactImageMatcher::rmsd_bounded(const ImageViewRGB32& image, double max_rmsd) const{
+    if (!image){
+        return 1000.;
+    }
+    return brightness_scaled_rmsd(
+        m_image, m_stats.average, image,
+        Kernels::SumSquareMode::REFERENCE_ALPHA, 0,
+        max_rmsd
+    );
 }
 double ExactImageMatcher::rmsd(const ImageViewRGB32& image, Color background) const{
     if (!image){
         return 1000.;
     }
-    ImageRGB32 scaled = image.scale_to(m_image.width(), m_image.height());
-    ImageRGB32 reference = scale_template_brightness(scaled);
-
-#if 0
-    static int c = 0;
-    scaled.save("test-" + std::to_string(c) + "-image.png");
-    reference.save("test-" + std::to_string(c) + "-sprite.png");
-    c++;
-#endif
-
-    return pixel_RMSD(reference, scaled, background);
+    return brightness_scaled_rmsd(
+        m_image, m_stats.average, image,
+        Kernels::SumSquareMode::USE_BACKGROUND, (uint32_t)background
+    );
 }
 double ExactImageMatcher::rmsd_masked(const ImageViewRGB32& image) const{
     if (!image){
         return 1000.;
     }
-    ImageRGB32 scaled = image.scale_to(m_image.width(), m_image.height());
-    ImageRGB32 reference = scale_template_brightness(scaled);
-    return pixel_RMSD_masked(reference, scaled);
+    return brightness_scaled_rmsd(
+        m_image, m_stats.average, image,
+        Kernels::SumSquareMode::ARBITRATE_ALPHAS
+    );
 }
 
 
@@ -98,6 +173,10 @@ WeightedExactImageMatcher::WeightedExactImageMatcher(ImageRGB32 image, const Inv
     : ExactImageMatcher(std::move(image))
     , m_multiplier(1. / (m_stats.stddev.sum() * weight.stddev_coefficient + weight.offset))
 {}
+WeightedExactImageMatcher::WeightedExactImageMatcher(ImageRGB32 image, const ImageStats& stats, const InverseStddevWeight& weight)
+    : ExactImageMatcher(std::move(image), stats)
+    , m_multiplier(1. / (m_stats.stddev.sum() * weight.stddev_coefficient + weight.offset))
+{}
 
 
 double WeightedExactImageMatcher::diff(const ImageViewRGB32& image) const{
@@ -106,6 +185,12 @@ double WeightedExactImageMatcher::diff(const ImageViewRGB32& image) const{
     }
     return rmsd(image) * m_multiplier;
 }
+double WeightedExactImageMatcher::diff_bounded(const ImageViewRGB32& image, double max_diff) const{
+    if (!image){
+        return 1000.;
+    }
+    return rmsd_bounded(image, max_diff / m_multiplier) * m_multiplier;
+}
 double WeightedExactImageMatcher::diff(const ImageViewRGB32& image, Color background) const{
     if (!image){
         return 1000.;
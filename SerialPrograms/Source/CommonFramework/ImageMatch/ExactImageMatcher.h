@@ -27,6 +27,9 @@ class ExactImageMatcher{
 
 public:
     ExactImageMatcher(ImageRGB32 image_template);
+
+    //  Same as above, but with "image_stats(image_template)" already computed.
+    ExactImageMatcher(ImageRGB32 image_template, const ImageStats& stats);
     
     const ImageStats& stats() const{ return m_stats; }
 
@@ -35,6 +38,9 @@ public:
     // The part of the image template where alpha is 0 is not used to compare with the corresponding
     // part in the input image.
     double rmsd(const ImageViewRGB32& image) const;
+    // Same as rmsd(image), but stops early once the result is known to be larger than `max_rmsd`.
+    // In that case, the returned value is somewhere between `max_rmsd` and the real RMSD.
+    double rmsd_bounded(const ImageViewRGB32& image, double max_rmsd) const;
     // Resize image to match the shape of the image template, scale the template brightness to match
     // the input image, then compute their RMSD (root mean square deviation).
     // The part of the image template where alpha is 0 is replace with `background` color when comparing
@@ -50,11 +56,6 @@ public:
 
     const ImageRGB32& image_template() const { return m_image; }
 
-private:
-    // scale stored image template according to the brightness of `image`, assign
-    // the scaled template to `reference`.
-    ImageRGB32 scale_template_brightness(const ImageViewRGB32& image) const;
-
 protected:
     ImageRGB32 m_image;
     ImageStats m_stats;
@@ -80,9 +81,12 @@ public:
     };
 
     WeightedExactImageMatcher(ImageRGB32 image_template, const InverseStddevWeight& weight);
+    WeightedExactImageMatcher(ImageRGB32 image_template, const ImageStats& stats, const InverseStddevWeight& weight);
 
     // Like ExactImageMatcher::rmsd(image) but scale based on template stddev.
     double diff(const ImageViewRGB32& image) const;
+    // Like ExactImageMatcher::rmsd_bounded(image, max_rmsd) but scale based on template stddev.
+    double diff_bounded(const ImageViewRGB32& image, double max_diff) const;
     // Like ExactImageMatcher::rmsd(image, background) but scale based on template stddev.
     double diff(const ImageViewRGB32& image, Color background) const;
     // Like ExactImageMatcher::rmsd_masked(image) but scale based on template stddev.
@@ -39,12 +39,13 @@ bool is_background_col(const ImageViewRGB32& image, size_t col, const std::funct
 }
 
 ImageViewRGB32 trim_image_alpha(const ImageViewRGB32& image, uint8_t alpha_threshold){
+    return extract_box_reference(image, trim_image_alpha_box(image, alpha_threshold));
+}
+ImagePixelBox trim_image_alpha_box(const ImageViewRGB32& image, uint8_t alpha_threshold){
     auto is_foreground = [=](Color pixel){
         return pixel.alpha() >= alpha_threshold;
     };
-    const auto box = enclosing_rectangle_with_pixel_filter(image, is_foreground);
-
-    return extract_box_reference(image, box);
+    return enclosing_rectangle_with_pixel_filter(image, is_foreground);
 }
 
 ImagePixelBox enclosing_rectangle_with_pixel_filter(const ImageViewRGB32& image, const std::function<bool(Color)>& is_foreground){
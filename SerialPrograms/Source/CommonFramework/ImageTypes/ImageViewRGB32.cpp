@@ -26,8 +26,20 @@ ImageRGB32 ImageViewRGB32::copy() const{
 bool ImageViewRGB32::save(const std::string& path) const{
     return to_QImage_ref().save(QString::fromStdString(path));
 }
-ImageRGB32 ImageViewRGB32::scale_to(size_t width, size_t height) const{
-    return scaled_to_QImage(width, height);
+ImageRGB32 ImageViewRGB32::scale_to(size_t width, size_t height, Kernels::ResampleFilter filter) const{
+    if (m_ptr == nullptr || width == 0 || height == 0){
+        return ImageRGB32();
+    }
+    if (m_width == width && m_height == height){
+        return copy();
+    }
+    ImageRGB32 ret(width, height);
+    Kernels::resample(
+        m_ptr, m_bytes_per_row, m_width, m_height,
+        ret.data(), ret.bytes_per_row(), width, height,
+        filter
+    );
+    return ret;
 }
 
 
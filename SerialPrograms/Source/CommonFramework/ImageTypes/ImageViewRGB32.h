@@ -8,6 +8,7 @@
 #define PokemonAutomation_CommonFramework_ImageViewRGB32_H
 
 #include <string>
+#include "Kernels/ImageResample/Kernels_ImageResample.h"
 #include "ImageViewPlanar32.h"
 
 class QImage;
@@ -46,7 +47,10 @@ public:
 public:
     ImageRGB32 copy() const;
     bool save(const std::string& path) const;
-    ImageRGB32 scale_to(size_t width, size_t height) const;
+    ImageRGB32 scale_to(
+        size_t width, size_t height,
+        Kernels::ResampleFilter filter = Kernels::ResampleFilter::NEAREST
+    ) const;
 
 public:
     //  QImage
@@ -2,6 +2,7 @@
 
 #include <cfloat>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 //#include "Common/Cpp/Exceptions.h"
@@ -145,13 +146,31 @@ SpectrogramMatcher::SpectrogramMatcher(
 //    cout << "m_numSpectrumsNeeded = " << m_numSpectrumsNeeded << endl;
 
     m_templateNorm = buildTemplateNorm();
+
+    // Every sub-template has the same number of windows. They are all matched
+    // against the start of the template.
+    const size_t windows = m_numSpectrumsNeeded;
+    m_templateRows.resize(windows);
+    for (size_t i = 0; i < windows; i++){
+        m_templateRows[i] = m_freqStart + m_template.getWindow(windows - 1 - i);
+        for (size_t j = 0; j < m_freqEnd - m_freqStart; j++){
+            const double v = m_templateRows[i][j];
+            m_templateSumSqr += v * v;
+        }
+    }
+
+    m_filtered = AlignedVector<float>(m_template.bufferSize());
+    m_dots.resize(windows);
+    m_stamps.resize(windows);
+    m_spectrumNormSqrs.resize(windows);
+    m_pendingDotSums.resize(windows);
 }
 
 uint64_t SpectrogramMatcher::latestTimestamp() const{
-    if (m_spectrums.size() == 0){
+    if (m_spectrumsAdded == 0){
         return SIZE_MAX;
     }
-    return m_spectrums.front().stamp;
+    return m_stamps[(m_spectrumsAdded - 1) % m_numSpectrumsNeeded];
 }
 
 void SpectrogramMatcher::conv(const float* src, size_t num, float* dst){
@@ -194,51 +213,70 @@ std::vector<float> SpectrogramMatcher::buildTemplateNorm() const{
     return ret;
 }
 
-bool SpectrogramMatcher::update_to_new_spectrum(AudioSpectrum spectrum){
+bool SpectrogramMatcher::update_to_new_spectrum(const AudioSpectrum& spectrum){
     if (m_numOriginalFrequencies != spectrum.magnitudes->size()){
         std::cout << "Error: number of frequencies don't match in SpectrogramMatcher::match() " << 
             m_numOriginalFrequencies << " " << spectrum.magnitudes->size() << std::endl;
         return false;
     }
 
+    const size_t windows = m_numSpectrumsNeeded;
+    if (windows == 0){
+        return true;
+    }
+
+    const float* magnitudes = spectrum.magnitudes->data();
     switch(m_mode){
     case Mode::SPIKE_CONV:
     {
         // Do the conv on new spectrum too.
-        AlignedVector<float> convedSpectrum(m_template.bufferSize());
-        conv(spectrum.magnitudes->data() + m_originalFreqStart,
-            m_originalFreqEnd - m_originalFreqStart, convedSpectrum.data());
-        
-        spectrum.magnitudes = std::make_unique<AlignedVector<float>>(std::move(convedSpectrum));
+        conv(magnitudes + m_originalFreqStart, m_originalFreqEnd - m_originalFreqStart, m_filtered.data());
+        magnitudes = m_filtered.data();
         break;
     }
     case Mode::AVERAGE_5:
     {
-        AlignedVector<float> avgedSpectrum(m_template.bufferSize());
         for(size_t j = 0; j < m_template.numFrequencies(); j++){
-            const float * rawFreqMag = spectrum.magnitudes->data() + m_originalFreqStart + j*5;
+            const float * rawFreqMag = magnitudes + m_originalFreqStart + j*5;
             const float newMag = (rawFreqMag[0] + rawFreqMag[1] + rawFreqMag[2] + rawFreqMag[3] + rawFreqMag[4]) / 5.0f;
-            avgedSpectrum[j] = newMag;
+            m_filtered[j] = newMag;
         }
-        spectrum.magnitudes = std::make_unique<AlignedVector<float>>(std::move(avgedSpectrum));
+        magnitudes = m_filtered.data();
         break;
     }
     case Mode::RAW:
         break;
     }
 
-    // Compute the norm square (= sum squares) of the spectrum, used for matching:
-    // TODO: if there will be multiple SpectrogramMatcher running on the same audio stream, can
-    // move this per-spectrum computation to a shared struct for those matchers to save computation.
-    float spectrumNormSqr = 0.0f;
-    for (size_t i = m_freqStart; i < m_freqEnd; i++){
-        float mag = (*spectrum.magnitudes)[i];
-        spectrumNormSqr += mag * mag;
+    const size_t slot = (size_t)(m_spectrumsAdded % windows);
+    if (m_spectrumsAdded > 0 && spectrum.stamp == m_stamps[(slot + windows - 1) % windows] + 1){
+        m_numContiguous++;
+    }else{
+        m_numContiguous = 1;
     }
-    m_spectrumNormSqrs.push_front(spectrumNormSqr);
+    m_stamps[slot] = spectrum.stamp;
 
-    m_spectrums.emplace_front(std::move(spectrum));
+    m_spectrumNormSqrs[slot] = Kernels::ScaleInvariantMatrixMatch::compute_dot_products(
+        m_freqEnd - m_freqStart, windows,
+        magnitudes + m_freqStart, m_templateRows.data(),
+        m_dots.data()
+    );
 
+    // This spectrum is the i'th newest in the match that ends i spectrums from now.
+    for (size_t i = 0; i < windows; i++){
+        size_t index = slot + i;
+        if (index >= windows){
+            index -= windows;
+        }
+        m_pendingDotSums[index] += m_dots[i];
+    }
+
+    // The match that ends at this spectrum is complete. Free up its slot for
+    // the match that ends `windows` spectrums from now.
+    m_lastDotSum = m_pendingDotSums[slot];
+    m_pendingDotSums[slot] = 0;
+
+    m_spectrumsAdded++;
     return true;
 }
 
@@ -248,82 +286,22 @@ bool SpectrogramMatcher::update_to_new_spectrums(const std::vector<AudioSpectrum
             return false;
         }
     }
-
-    // pop out too old spectrums
-    while (m_spectrums.size() > m_numSpectrumsNeeded){
-        m_spectrums.pop_back();
-        m_spectrumNormSqrs.pop_back();
-    }
-
     return true;
 }
 
-std::pair<float, float> SpectrogramMatcher::match_sub_template(size_t sub_index) const{
-#if 0
-    auto iter = m_spectrums.begin();
-    auto iter2 = m_spectrumNormSqrs.begin();
-    float streamSumSqr = 0.0f;
-    float sumMulti = 0.0f;
-
-    const size_t template_start = m_templateRange[sub_index].first;
-    const size_t template_end = m_templateRange[sub_index].second;
-    for(size_t i = template_start; i < template_end; i++, iter++, iter2++){
-        // match in order from latest window to oldest
-        const float* templateData = m_template.getWindow(template_end-1-i);
-        const float* streamData = iter->magnitudes->data();
-        streamSumSqr += *iter2;
-        for(size_t j = m_freqStart; j < m_freqEnd; j++){
-            sumMulti += templateData[j] * streamData[j];
-        }
-    }
-//    cout << "sumMulti = " << sumMulti << ", streamSumSqr = " << streamSumSqr << endl;
-    const float scale = (streamSumSqr < 1e-6f ? 1.0f : sumMulti / streamSumSqr);
-
-    iter = m_spectrums.begin();
-    float sum = 0.0f;
-    for(size_t i = template_start; i < template_end; i++, iter++){
-        // match in order from latest window to oldest
-        const float* templateData = m_template.getWindow(template_end-1-i);
-        const float* streamData = iter->magnitudes->data();
-        for(size_t j = m_freqStart; j < m_freqEnd; j++){
-            float d = templateData[j] - scale * streamData[j];
-            sum += d * d;
-        }
-    }
-#else
-    //  Build matrix.
-    auto iter = m_spectrums.begin();
-    const size_t template_start = m_templateRange[sub_index].first;
-    const size_t template_end = m_templateRange[sub_index].second;
-    size_t windows = template_end - template_start;
-//    cout << windows << endl;
-//    cout << m_spectrums.size() << " / " << windows << endl;
-    size_t freqs = m_freqEnd - m_freqStart;
-    std::vector<const float*> matrixA(windows);
-    std::vector<const float*> matrixT(windows);
-    for (size_t i = 0; i < windows; i++, iter++){
-//        cout << "Template: " << ((size_t)m_template.getWindow(template_end - 1 - i) % 64) << endl;
-//        cout << "Samples:  " << ((size_t)iter->magnitudes->data() % 64) << endl;
-        matrixT[i] = m_freqStart + m_template.getWindow(windows - 1 - i);
-        matrixA[i] = m_freqStart + iter->magnitudes->data();
-//        cout << matrixT[i] << " : " << matrixA[i] << endl;
+std::pair<float, float> SpectrogramMatcher::match_newest() const{
+    double sumA2 = 0;
+    for (float normSqr : m_spectrumNormSqrs){
+        sumA2 += normSqr;
     }
 
     //  Compute scale.
-    float scale = Kernels::ScaleInvariantMatrixMatch::compute_scale(
-        freqs, windows,
-        matrixA.data(), matrixT.data()
-    );
+    float scale = (float)(m_lastDotSum / sumA2);
     scale = std::min<float>(scale, 1000000);
 
     //  Compute error.
-    float sum = Kernels::ScaleInvariantMatrixMatch::compute_error(
-        freqs, windows,
-        scale,
-        matrixA.data(), matrixT.data()
-    );
-#endif
-
+    double error = m_templateSumSqr - 2 * (double)scale * m_lastDotSum + (double)scale * scale * sumA2;
+    float sum = (float)std::max(error, 0.0);
 
     float score = sqrt(sum) / m_templateNorm[0];
 //    cout << "score = " << score << endl;
@@ -337,64 +315,45 @@ float SpectrogramMatcher::match(const std::vector<AudioSpectrum>& new_spectrums)
         return FLT_MAX;
     }
 
-    if (m_spectrums.size() < m_numSpectrumsNeeded){
+    const size_t windows = m_numSpectrumsNeeded;
+    if (windows == 0 || m_spectrumsAdded < windows){
         return FLT_MAX;
     }
 
     // Check whether the stored spectrums' timestamps are continuous:
-    size_t curStamp = m_spectrums.front().stamp;
-    size_t lastStamp = curStamp + 1;
-    for (const auto& s : m_spectrums){
-        if (s.stamp != lastStamp - 1){
-            std::cout << "Error: SpectrogramMatcher (" + m_name + ") spectrum timestamps are not continuous:" << std::endl;
-
-            for(const auto& sp : m_spectrums){
-                std::cout << sp.stamp << ", ";
-            }
-            std::cout << std::endl;
-            return FLT_MAX;
+    if (m_numContiguous < windows){
+        std::cout << "Error: SpectrogramMatcher (" + m_name + ") spectrum timestamps are not continuous:" << std::endl;
+        for (size_t i = 0; i < windows; i++){
+            std::cout << m_stamps[(m_spectrumsAdded - 1 - i) % windows] << ", ";
         }
-        lastStamp--;
+        std::cout << std::endl;
+        return FLT_MAX;
     }
 
+    size_t curStamp = latestTimestamp();
     if (m_lastStampTested != SIZE_MAX && curStamp <= m_lastStampTested){
         return FLT_MAX;
     }
     m_lastStampTested = curStamp;
-    
-    // Do the match:
-    float score = FLT_MAX; // the lower the score, the better the match
-    if (m_templateRange.size() == 1){
-        // Match the full template
-        std::tie(score, m_lastScale) = match_sub_template(0);
-    }else{
-        // Match each indivdual sub-template
-        for (size_t sub_template = 0; sub_template < m_templateRange.size(); sub_template++){
-            float sub_template_score = FLT_MAX;
-            float sub_template_scale = 1.0f;
-            std::tie(sub_template_score, sub_template_scale) = match_sub_template(sub_template);
-            if (sub_template_score < score){
-                score = sub_template_score;
-                m_lastScale = sub_template_scale;
-            }
-        }
-    }
 
+    // Do the match:
+    // The lower the score, the better the match.
+    float score;
+    std::tie(score, m_lastScale) = match_newest();
     return score;
 }
 
 bool SpectrogramMatcher::skip(const std::vector<AudioSpectrum>& new_spectrums){
-    // Note: ideally we don't want to have any computation while skipping.
-    // But update_to_new_spectrums() may still do some filtering and vector norm computation.
-    // Since the computation is relatively small and we won't be skipping lots of frames anyway,
-    // this should be fine for now.
-    // We can improve this later.
+    // The skipped spectrums are still part of the next matches. So they still
+    // need to be filtered and multiplied with the template.
     return update_to_new_spectrums(new_spectrums);
 }
 
 void SpectrogramMatcher::clear(){
-    m_spectrums.clear();
-    m_spectrumNormSqrs.clear();
+    m_spectrumsAdded = 0;
+    m_numContiguous = 0;
+    std::fill(m_pendingDotSums.begin(), m_pendingDotSums.end(), 0.0);
+    m_lastDotSum = 0;
     m_lastStampTested = SIZE_MAX;
 }
 
@@ -11,7 +11,7 @@
 #include <array>
 #include <memory>
 #include <vector>
-#include <list>
+#include "Common/Cpp/Containers/AlignedVector.h"
 #include "CommonFramework/AudioPipeline/AudioFeed.h"
 #include "CommonFramework/AudioPipeline/AudioTemplate.h"
 
@@ -83,12 +83,12 @@ private:
     // The function to build `m_templateNorm`
     std::vector<float> buildTemplateNorm() const;
 
-    // For a given sub-template, return its match score and scaling factor
-    std::pair<float, float> match_sub_template(size_t sub_index) const;
+    // Return the match score and scaling factor of the newest spectrums.
+    std::pair<float, float> match_newest() const;
 
     // Update internal data for the next new spectrum. Called by `update_to_new_spectrums()`.
     // Return true if there is no error.
-    bool update_to_new_spectrum(AudioSpectrum newSpectrum);
+    bool update_to_new_spectrum(const AudioSpectrum& spectrum);
 
     // Update internal data for the new specttrums.
     // Return true if there is no error.
@@ -118,13 +118,40 @@ private:
 
     std::vector<float> m_convKernel;
 
-    // Spectrums from audio feed. They will be matched against the template.
-    std::list<AudioSpectrum> m_spectrums;
-    // Norm squares of each spectrum in `m_spectrums`.
-    std::list<float> m_spectrumNormSqrs;
     // How many spectrums needed to store.
     size_t m_numSpectrumsNeeded = 0;
 
+    // The template windows that are matched. Row i lines up with the i'th
+    // newest spectrum. So they are in reverse order.
+    std::vector<const float*> m_templateRows;
+    // Sum squares of `m_templateRows`.
+    double m_templateSumSqr = 0;
+
+    // The newest spectrum after filtering by `m_mode`.
+    AlignedVector<float> m_filtered;
+    // Dot products of the newest spectrum with each of `m_templateRows`.
+    std::vector<float> m_dots;
+
+    // The matrix match is:
+    //      scale = (A . T) / |A|^2
+    //      error = |T|^2 - 2 scale (A . T) + scale^2 |A|^2
+    // where A is the newest `m_numSpectrumsNeeded` spectrums. Each spectrum
+    // lines up with a different template window in each of the next matches.
+    // So its dot products are added to all of them when it comes in.
+    //
+    // These are circular buffers of `m_numSpectrumsNeeded` entries. Spectrum #n
+    // (counting from the last clear()) goes into slot (n % m_numSpectrumsNeeded).
+    uint64_t m_spectrumsAdded = 0;
+    std::vector<uint64_t> m_stamps;
+    std::vector<float> m_spectrumNormSqrs;
+    // Partial (A . T) of the match that ends at the spectrum of each slot.
+    std::vector<double> m_pendingDotSums;
+    // (A . T) of the match that ends at the newest spectrum.
+    double m_lastDotSum = 0;
+
+    // How many of the newest spectrums have consecutive timestamps.
+    size_t m_numContiguous = 0;
+
     size_t m_lastStampTested = SIZE_MAX;
     float m_lastScale = 0.0f;
 };
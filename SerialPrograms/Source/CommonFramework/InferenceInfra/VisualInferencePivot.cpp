@@ -4,6 +4,7 @@
  *
  */
 
+#include <algorithm>
 #include "Common/Cpp/Exceptions.h"
 #include "CommonFramework/VideoPipeline/VideoFeed.h"
 #include "VisualInferencePivot.h"
@@ -21,6 +22,7 @@ struct VisualInferencePivot::PeriodicCallback{
     std::atomic<InferenceCallback*>* set_when_triggered;
     VisualInferenceCallback& callback;
     std::chrono::milliseconds period;
+    uint64_t registration;
     StatAccumulatorI32 stats;
     uint64_t last_seqnum;
 
@@ -28,21 +30,30 @@ struct VisualInferencePivot::PeriodicCallback{
         Cancellable& p_scope,
         std::atomic<InferenceCallback*>* p_set_when_triggered,
         VisualInferenceCallback& p_callback,
-        std::chrono::milliseconds p_period
+        std::chrono::milliseconds p_period,
+        uint64_t p_registration
     )
         : scope(p_scope)
         , set_when_triggered(p_set_when_triggered)
         , callback(p_callback)
         , period(p_period)
+        , registration(p_registration)
         , last_seqnum(0)
     {}
 };
+struct VisualInferencePivot::CallbackResult{
+    PeriodicCallback* callback;
+    bool processed;
+    bool stop;
+    std::exception_ptr exception;
+};
 
 
 
 VisualInferencePivot::VisualInferencePivot(CancellableScope& scope, VideoFeed& feed, AsyncDispatcher& dispatcher)
     : PeriodicRunner(dispatcher)
     , m_feed(feed)
+    , m_dispatcher(dispatcher)
 {
     attach(scope);
 }
@@ -64,7 +75,7 @@ void VisualInferencePivot::add_callback(
     iter = m_map.emplace(
         std::piecewise_construct,
         std::forward_as_tuple(&callback),
-        std::forward_as_tuple(scope, set_when_triggered, callback, period)
+        std::forward_as_tuple(scope, set_when_triggered, callback, period, m_registration_count++)
     ).first;
     try{
         PeriodicRunner::add_event(&iter->second, period);
@@ -84,6 +95,33 @@ StatAccumulatorI32 VisualInferencePivot::remove_callback(VisualInferenceCallback
     m_map.erase(iter);
     return stats;
 }
+void VisualInferencePivot::process(CallbackResult& result) noexcept{
+    PeriodicCallback& callback = *result.callback;
+    result.processed = true;
+    try{
+        WallClock time0 = current_time();
+        result.stop = callback.callback.process_frame(m_last);
+        WallClock time1 = current_time();
+        callback.stats += (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(time1 - time0).count();
+        callback.last_seqnum = m_seqnum;
+    }catch (...){
+        result.exception = std::current_exception();
+    }
+}
+void VisualInferencePivot::apply(const CallbackResult& result) noexcept{
+    PeriodicCallback& callback = *result.callback;
+    if (result.exception){
+        callback.scope.cancel(result.exception);
+        return;
+    }
+    if (result.stop){
+        if (callback.set_when_triggered){
+            InferenceCallback* expected = nullptr;
+            callback.set_when_triggered->compare_exchange_strong(expected, &callback.callback);
+        }
+        callback.scope.cancel(nullptr);
+    }
+}
 void VisualInferencePivot::run(void* event, bool is_back_to_back) noexcept{
     PeriodicCallback& callback = *(PeriodicCallback*)event;
     try{
@@ -93,21 +131,71 @@ void VisualInferencePivot::run(void* event, bool is_back_to_back) noexcept{
             m_last = m_feed.snapshot();
             m_seqnum++;
         }
+    }catch (...){
+        callback.scope.cancel(std::current_exception());
+        return;
+    }
 
-        WallClock time0 = current_time();
-        bool stop = callback.callback.process_frame(m_last);
-        WallClock time1 = current_time();
-        callback.stats += (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(time1 - time0).count();
-        callback.last_seqnum = m_seqnum;
-        if (stop){
-            if (callback.set_when_triggered){
-                InferenceCallback* expected = nullptr;
-                callback.set_when_triggered->compare_exchange_strong(expected, &callback.callback);
-            }
-            callback.scope.cancel(nullptr);
+    CallbackResult result{&callback, false, false, nullptr};
+    process(result);
+    apply(result);
+}
+void VisualInferencePivot::run_batch(const std::vector<void*>& events, bool is_back_to_back) noexcept{
+    if (events.size() == 1){
+        run(events[0], is_back_to_back);
+        return;
+    }
+
+    m_results.clear();
+    bool need_snapshot = !is_back_to_back;
+    for (void* event : events){
+        PeriodicCallback& callback = *(PeriodicCallback*)event;
+        need_snapshot |= callback.last_seqnum == m_seqnum;
+        m_results.emplace_back(CallbackResult{&callback, false, false, nullptr});
+    }
+
+    //  Take one screenshot for the entire tick.
+    try{
+        if (need_snapshot){
+            m_last = m_feed.snapshot();
+            m_seqnum++;
         }
     }catch (...){
-        callback.scope.cancel(std::current_exception());
+        std::exception_ptr exception = std::current_exception();
+        for (CallbackResult& result : m_results){
+            result.callback->scope.cancel(exception);
+        }
+        return;
+    }
+
+    //  Fan out the callbacks. The latency of the tick is now the slowest
+    //  callback rather than the sum of all of them. This is the program's
+    //  inference dispatcher. It adds threads as needed, so a callback that
+    //  blocks only holds up its own tick.
+    try{
+        m_dispatcher.run_in_parallel(
+            0, m_results.size(),
+            [this](size_t index){ process(m_results[index]); }
+        );
+    }catch (...){
+        //  Failed to dispatch. Fall back to running them here.
+        for (CallbackResult& result : m_results){
+            if (!result.processed){
+                process(result);
+            }
+        }
+    }
+
+    //  Act on the results in registration order so that the triggered
+    //  callback is deterministic when multiple fire on the same frame.
+    std::sort(
+        m_results.begin(), m_results.end(),
+        [](const CallbackResult& x, const CallbackResult& y){
+            return x.callback->registration < y.callback->registration;
+        }
+    );
+    for (const CallbackResult& result : m_results){
+        apply(result);
     }
 }
 
@@ -7,6 +7,7 @@
 #ifndef PokemonAutomation_CommonFramework_VisualInferencePivot_H
 #define PokemonAutomation_CommonFramework_VisualInferencePivot_H
 
+#include <vector>
 #include "Common/Cpp/Concurrency/SpinLock.h"
 #include "Common/Cpp/Concurrency/PeriodicScheduler.h"
 #include "CommonFramework/VideoPipeline/VideoFeed.h"
@@ -22,6 +23,8 @@ class VideoFeed;
 
 class VisualInferencePivot final : public PeriodicRunner, public OverlayStat{
 public:
+    //  "dispatcher" runs the pivot thread itself and the callbacks that are
+    //  due on the same tick. The callbacks may block. (OCR, logging)
     VisualInferencePivot(CancellableScope& scope, VideoFeed& feed, AsyncDispatcher& dispatcher);
     virtual ~VisualInferencePivot();
 
@@ -41,17 +44,30 @@ public:
 
 private:
     virtual void run(void* event, bool is_back_to_back) noexcept override;
+    virtual void run_batch(const std::vector<void*>& events, bool is_back_to_back) noexcept override;
     virtual OverlayStatSnapshot get_current() override;
 
 private:
     struct PeriodicCallback;
+    struct CallbackResult;
+
+    //  Run the callback on "m_last" and time it. Does not act on the result.
+    void process(CallbackResult& result) noexcept;
+
+    //  Stop or cancel the callback's scope depending on the result.
+    static void apply(const CallbackResult& result) noexcept;
 
     VideoFeed& m_feed;
+    AsyncDispatcher& m_dispatcher;
     SpinLock m_lock;
     std::map<VisualInferenceCallback*, PeriodicCallback> m_map;
+    uint64_t m_registration_count = 0;
     VideoSnapshot m_last;
     uint64_t m_seqnum = 0;
 
+    //  Reused across ticks to avoid allocating.
+    std::vector<CallbackResult> m_results;
+
     OverlayStatUtilizationPrinter m_printer;
 };
 
@@ -0,0 +1,162 @@
+/*  Async Log Writer
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include "AsyncLogWriter.h"
+
+//#include <iostream>
+//using std::cout;
+//using std::endl;
+
+namespace PokemonAutomation{
+
+
+
+AsyncLogWriter::AsyncLogWriter(const AsyncLogWriterConfig& config)
+    : m_config(config)
+{
+    m_queue.reserve(m_config.queue_capacity);
+}
+AsyncLogWriter::~AsyncLogWriter(){
+    //  The derived class should have already done this.
+    stop();
+}
+void AsyncLogWriter::start(){
+    {
+        std::lock_guard<std::mutex> lg(m_lock);
+        m_running = true;
+    }
+    m_thread = std::thread(&AsyncLogWriter::thread_loop, this);
+}
+void AsyncLogWriter::stop(){
+    {
+        std::lock_guard<std::mutex> lg(m_lock);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    m_space_cv.notify_all();
+    if (m_thread.joinable()){
+        m_thread.join();
+    }
+}
+
+
+bool AsyncLogWriter::push(std::string&& msg, Color color){
+    std::unique_lock<std::mutex> lg(m_lock);
+    if (m_queue.size() >= m_config.queue_capacity){
+        switch (m_config.full_policy){
+        case LogQueueFullPolicy::BLOCK:
+            m_blocked_producers++;
+            m_space_cv.wait(lg, [this]{
+                return m_stopping || m_queue.size() < m_config.queue_capacity;
+            });
+            m_blocked_producers--;
+            break;
+        case LogQueueFullPolicy::DROP:
+            m_dropped++;
+            m_dropped_unreported++;
+            return false;
+        }
+    }
+    if (m_stopping && !m_running){
+        return false;
+    }
+
+    //  The writer only waits when the queue is empty.
+    bool wake = m_queue.empty();
+    m_queue.emplace_back(Entry{std::move(msg), color});
+    if (wake){
+        m_cv.notify_all();
+    }
+    return true;
+}
+void AsyncLogWriter::flush(){
+    std::unique_lock<std::mutex> lg(m_lock);
+    if (!m_running){
+        return;
+    }
+    uint64_t ticket = ++m_flush_requested;
+    m_cv.notify_all();
+    m_cv.wait(lg, [&]{
+        return m_flush_completed >= ticket || !m_running;
+    });
+}
+uint64_t AsyncLogWriter::dropped() const{
+    std::lock_guard<std::mutex> lg(m_lock);
+    return m_dropped;
+}
+
+
+void AsyncLogWriter::thread_loop(){
+    std::vector<Entry> batch;
+    batch.reserve(m_config.queue_capacity);
+    std::string buffer;
+    buffer.reserve(m_config.flush_bytes + 4096);
+    WallClock flush_deadline = WallClock::max();
+
+    std::unique_lock<std::mutex> lg(m_lock);
+    while (true){
+        auto ready = [&]{
+            return m_stopping || !m_queue.empty() || m_flush_requested > m_flush_completed;
+        };
+        if (buffer.empty()){
+            m_cv.wait(lg, ready);
+        }else{
+            m_cv.wait_until(lg, flush_deadline, ready);
+        }
+
+        batch.swap(m_queue);
+        uint64_t dropped = m_dropped_unreported;
+        m_dropped_unreported = 0;
+        uint64_t flush_ticket = m_flush_requested;
+        bool stopping = m_stopping;
+        if (m_blocked_producers > 0){
+            m_space_cv.notify_all();
+        }
+        lg.unlock();
+
+        bool flush_now = stopping || flush_ticket > m_flush_completed;
+        if (dropped > 0){
+            batch.emplace_back(Entry{
+                "Log queue is full. " + std::to_string(dropped) + " lines were dropped.",
+                COLOR_RED
+            });
+        }
+        if (!batch.empty()){
+            if (buffer.empty()){
+                flush_deadline = current_time() + m_config.flush_delay;
+            }
+            for (const Entry& entry : batch){
+                flush_now |= entry.color == COLOR_RED;
+            }
+            process_batch(buffer, batch);
+            batch.clear();
+        }
+        if (!buffer.empty() && (
+            flush_now ||
+            buffer.size() >= m_config.flush_bytes ||
+            current_time() >= flush_deadline
+        )){
+            write_file(buffer);
+            buffer.clear();
+        }
+
+        lg.lock();
+        if (flush_ticket > m_flush_completed){
+            m_flush_completed = flush_ticket;
+            m_cv.notify_all();
+        }
+        if (stopping && m_queue.empty()){
+            break;
+        }
+    }
+    m_running = false;
+    m_cv.notify_all();
+}
+
+
+
+
+}
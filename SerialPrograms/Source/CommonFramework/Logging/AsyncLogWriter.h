@@ -0,0 +1,125 @@
+/*  Async Log Writer
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Queue log lines from any number of threads and write them out from a
+ *  single writer thread in batches.
+ *
+ *  Each time the writer wakes up, it takes everything that was queued since
+ *  the last wakeup and formats it into one buffer. The buffer is written and
+ *  flushed in a single call when any of these happen:
+ *
+ *      -   It has been "flush_delay" since the oldest unwritten line.
+ *      -   The buffer is larger than "flush_bytes".
+ *      -   A line was logged in red. (errors)
+ *      -   Someone called "flush()".
+ *      -   The writer is stopping.
+ *
+ *  The queue holds at most "queue_capacity" lines. What happens when it is
+ *  full is set by "full_policy".
+ *
+ */
+
+#ifndef PokemonAutomation_Logging_AsyncLogWriter_H
+#define PokemonAutomation_Logging_AsyncLogWriter_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "Common/Cpp/Color.h"
+#include "Common/Cpp/Time.h"
+
+namespace PokemonAutomation{
+
+
+enum class LogQueueFullPolicy{
+    //  Wait for space in the queue. Nothing is lost, but a slow disk will
+    //  stall the threads that are logging.
+    BLOCK,
+
+    //  Throw the line away. The number of lines dropped is written to the
+    //  log once there is space again.
+    DROP,
+};
+
+struct AsyncLogWriterConfig{
+    size_t queue_capacity = 10000;
+    LogQueueFullPolicy full_policy = LogQueueFullPolicy::BLOCK;
+    size_t flush_bytes = 64 * 1024;
+    std::chrono::milliseconds flush_delay = std::chrono::milliseconds(100);
+};
+
+
+class AsyncLogWriter{
+public:
+    struct Entry{
+        std::string msg;
+        Color color;
+    };
+
+public:
+    AsyncLogWriter(const AsyncLogWriterConfig& config);
+    virtual ~AsyncLogWriter();
+
+    //  Queue a line. Returns false if it was dropped.
+    bool push(std::string&& msg, Color color);
+
+    //  Wait until everything queued before this call has been written out.
+    void flush();
+
+    //  Total number of lines that were dropped because the queue was full.
+    uint64_t dropped() const;
+
+
+protected:
+    //  The writer thread calls the virtual functions below. So it can't be
+    //  started until the derived class is fully constructed. And it must be
+    //  stopped before the derived class is destroyed.
+    void start();
+
+    //  Write out everything in the queue and stop the writer thread.
+    void stop();
+
+    //  Called on the writer thread with all the lines that were queued since
+    //  the last call. Append what goes into the file to "file_buffer".
+    virtual void process_batch(std::string& file_buffer, std::vector<Entry>& batch) = 0;
+
+    //  Called on the writer thread. Write the data and flush it.
+    virtual void write_file(const std::string& data) = 0;
+
+
+private:
+    void thread_loop();
+
+
+private:
+    const AsyncLogWriterConfig m_config;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::condition_variable m_space_cv;
+    bool m_stopping = false;
+    bool m_running = false;
+
+    //  The writer swaps this out for an empty one on every wakeup. So the
+    //  lock is only ever held long enough to move a string.
+    std::vector<Entry> m_queue;
+    size_t m_blocked_producers = 0;
+
+    uint64_t m_dropped = 0;
+    uint64_t m_dropped_unreported = 0;
+
+    //  "flush()" takes a ticket and waits for the writer to get to it.
+    uint64_t m_flush_requested = 0;
+    uint64_t m_flush_completed = 0;
+
+    std::thread m_thread;
+};
+
+
+
+}
+#endif
@@ -25,18 +25,11 @@ Logger& global_logger_raw(){
 
 
 FileWindowLogger::~FileWindowLogger(){
-    {
-        std::lock_guard<std::mutex> lg(m_lock);
-        m_stopping = true;
-        m_cv.notify_all();
-    }
-    m_thread.join();
+    AsyncLogWriter::stop();
 }
-FileWindowLogger::FileWindowLogger(const std::string& path)
-    : m_file(QString::fromStdString(path))
-    , m_max_queue_size(10000)
-    , m_stopping(false)
-    , m_thread(&FileWindowLogger::thread_loop, this)
+FileWindowLogger::FileWindowLogger(const std::string& path, const AsyncLogWriterConfig& config)
+    : AsyncLogWriter(config)
+    , m_file(QString::fromStdString(path))
 {
     bool exists = m_file.exists();
     m_file.open(QIODevice::WriteOnly | QIODevice::Append);
@@ -44,6 +37,7 @@ FileWindowLogger::FileWindowLogger(const std::string& path)
         std::string bom = "\xef\xbb\xbf";
         m_file.write(bom.c_str(), bom.size());
     }
+    AsyncLogWriter::start();
 }
 void FileWindowLogger::operator+=(FileWindowLoggerWindow& widget){
     std::lock_guard<std::mutex> lg(m_lock);
@@ -55,16 +49,10 @@ void FileWindowLogger::operator-=(FileWindowLoggerWindow& widget){
 }
 
 void FileWindowLogger::log(const std::string& msg, Color color){
-    std::unique_lock<std::mutex> lg(m_lock);
-    m_cv.wait(lg, [this]{ return m_queue.size() < m_max_queue_size; });
-    m_queue.emplace_back(msg, color);
-    m_cv.notify_all();
+    push(std::string(msg), color);
 }
 void FileWindowLogger::log(std::string&& msg, Color color){
-    std::unique_lock<std::mutex> lg(m_lock);
-    m_cv.wait(lg, [this]{ return m_queue.size() < m_max_queue_size; });
-    m_queue.emplace_back(std::move(msg), color);
-    m_cv.notify_all();
+    push(std::move(msg), color);
 }
 
 
@@ -90,22 +78,19 @@ std::string FileWindowLogger::normalize_newlines(const std::string& msg){
 
     return str;
 }
-std::string FileWindowLogger::to_file_str(const std::string& msg){
+void FileWindowLogger::append_file_str(std::string& buffer, const std::string& msg){
     //  Replace all newlines with:
     //      <br>    for the output window.
     //      \r\n    for the log file.
 
-    std::string str;
     for (char ch : msg){
         if (ch == '\n'){
-            str += "\r\n";
+            buffer += "\r\n";
             continue;
         }
-        str += ch;
+        buffer += ch;
     }
-    str += "\r\n";
-
-    return str;
+    buffer += "\r\n";
 }
 QString FileWindowLogger::to_window_str(const std::string& msg, Color color){
     //  Replace all newlines with:
@@ -135,43 +120,25 @@ QString FileWindowLogger::to_window_str(const std::string& msg, Color color){
 
     return QString::fromStdString(str);
 }
-void FileWindowLogger::internal_log(const std::string& msg, Color color){
-    std::string line = normalize_newlines(msg);
+void FileWindowLogger::process_batch(std::string& file_buffer, std::vector<Entry>& batch){
     {
+        std::lock_guard<std::mutex> lg(m_lock);
         if (!m_windows.empty()){
-            QString str = to_window_str(line, color);
-            for (FileWindowLoggerWindow* window : m_windows){
-                window->log(str);
+            for (const Entry& entry : batch){
+                QString str = to_window_str(normalize_newlines(entry.msg), entry.color);
+                for (FileWindowLoggerWindow* window : m_windows){
+                    window->log(str);
+                }
             }
         }
     }
-    {
-        m_file.write(to_file_str(msg).c_str());
-        m_file.flush();
+    for (const Entry& entry : batch){
+        append_file_str(file_buffer, entry.msg);
     }
 }
-void FileWindowLogger::thread_loop(){
-    std::unique_lock<std::mutex> lg(m_lock);
-    while (true){
-        m_cv.wait(lg, [&]{
-            return m_stopping || !m_queue.empty();
-        });
-        if (m_stopping){
-            break;
-        }
-        auto& item = m_queue.front();
-        std::string msg = std::move(item.first);
-        Color color = item.second;
-        m_queue.pop_front();
-
-        lg.unlock();
-        internal_log(msg, color);
-        lg.lock();
-
-        if (m_queue.size() <= m_max_queue_size / 2){
-            m_cv.notify_all();
-        }
-    }
+void FileWindowLogger::write_file(const std::string& data){
+    m_file.write(data.c_str(), data.size());
+    m_file.flush();
 }
 
 
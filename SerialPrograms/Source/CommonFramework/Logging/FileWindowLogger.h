@@ -7,25 +7,23 @@
 #ifndef PokemonAutomation_Logging_FileWindowLogger_H
 #define PokemonAutomation_Logging_FileWindowLogger_H
 
-#include <deque>
 #include <set>
 #include <mutex>
-#include <condition_variable>
-#include <thread>
 #include <QFile>
 #include <QTextEdit>
 #include <QMainWindow>
 #include "Logger.h"
+#include "AsyncLogWriter.h"
 
 namespace PokemonAutomation{
 
 class FileWindowLoggerWindow;
 
 
-class FileWindowLogger : public Logger{
+class FileWindowLogger : public Logger, private AsyncLogWriter{
 public:
     ~FileWindowLogger();
-    FileWindowLogger(const std::string& path);
+    FileWindowLogger(const std::string& path, const AsyncLogWriterConfig& config = AsyncLogWriterConfig());
 
     void operator+=(FileWindowLoggerWindow& widget);
     void operator-=(FileWindowLoggerWindow& widget);
@@ -35,21 +33,16 @@ public:
 
 private:
     static std::string normalize_newlines(const std::string& msg);
-    static std::string to_file_str(const std::string& msg);
+    static void append_file_str(std::string& buffer, const std::string& msg);
     static QString to_window_str(const std::string& msg, Color color);
 
-    void internal_log(const std::string& msg, Color color);
-    void thread_loop();
+    virtual void process_batch(std::string& file_buffer, std::vector<Entry>& batch) override;
+    virtual void write_file(const std::string& data) override;
 
 private:
     QFile m_file;
-    size_t m_max_queue_size;
     std::mutex m_lock;
-    std::condition_variable m_cv;
-    bool m_stopping;
-    std::deque<std::pair<std::string, Color>> m_queue;
     std::set<FileWindowLoggerWindow*> m_windows;
-    std::thread m_thread;
 };
 
 
@@ -14,6 +14,7 @@
 #include "Environment/HardwareValidation.h"
 #include "Logging/Logger.h"
 #include "Logging/OutputRedirector.h"
+#include "Tools/ImageEncodeService.h"
 //#include "Tools/StatsDatabase.h"
 #include "Integrations/SleepyDiscordRunner.h"
 #include "Globals.h"
@@ -83,7 +84,9 @@ int main(int argc, char *argv[]){
     }
 
     if (GlobalSettings::instance().COMMAND_LINE_TEST_MODE){
-        return run_command_line_tests();
+        int ret = run_command_line_tests(argc, argv);
+        ImageEncodeService::instance().stop();
+        return ret;
     }
 
     //  Check whether the hardware is powerful enough to run this program.
@@ -119,6 +122,9 @@ int main(int argc, char *argv[]){
         ret = application.exec();
     }
 
+    //  Finish writing screenshots while QApplication is still alive.
+    ImageEncodeService::instance().stop();
+
     // Write program settings back to the json file.
     PERSISTENT_SETTINGS().write();
 
@@ -7,7 +7,9 @@
 #include <QDir>
 #include <QFile>
 #include "Common/Cpp/PrettyPrint.h"
+#include "Common/Cpp/Json/JsonArray.h"
 #include "CommonFramework/Globals.h"
+#include "CommonFramework/Tools/ImageEncodeService.h"
 #include "MessageAttachment.h"
 
 namespace PokemonAutomation{
@@ -38,6 +40,11 @@ PendingFileSend::~PendingFileSend(){
         return;
     }
 
+    //  Don't let the encoder write the file after it's been deleted.
+    if (m_saved.valid()){
+        m_saved.wait();
+    }
+
     QFile file(QString::fromStdString(m_filepath));
     file.remove();
 }
@@ -45,6 +52,7 @@ PendingFileSend::PendingFileSend(const std::string& file, bool keep_file)
     : m_keep_file(keep_file)
     , m_extend_lifetime(false)
     , m_filepath(file)
+    , m_saved(ImageEncodeService::instance().pending(file))
 {
     QFileInfo info(QString::fromStdString(file));
     m_filename = info.fileName().toStdString();
@@ -93,13 +101,14 @@ PendingFileSend::PendingFileSend(Logger& logger, const ImageAttachment& image)
         m_filepath = "TempFiles/" + m_filename;
     }
 
-    if (image.image.save(m_filepath)){
-        logger.log("Saved image to: " + m_filepath, COLOR_BLUE);
-    }else{
-        logger.log("Unable to save screenshot to: " + m_filepath, COLOR_RED);
-        m_filename.clear();
-        m_filepath.clear();
+    logger.log("Saving image to: " + m_filepath, COLOR_BLUE);
+    m_saved = ImageEncodeService::instance().save(image.image, m_filepath);
+}
+bool PendingFileSend::wait_until_saved() const{
+    if (m_filepath.empty()){
+        return false;
     }
+    return !m_saved.valid() || m_saved.get();
 }
 void PendingFileSend::extend_lifetime(){
     m_extend_lifetime.store(true, std::memory_order_release);
@@ -107,6 +116,38 @@ void PendingFileSend::extend_lifetime(){
 
 
 
+JsonObject drop_embed_image(const JsonObject& embed){
+    JsonObject ret;
+    for (const auto& item : embed){
+        if (item.first != "image"){
+            ret[item.first] = item.second.clone();
+        }
+    }
+    return ret;
+}
+JsonObject drop_embed_images(const JsonObject& message){
+    JsonObject ret;
+    for (const auto& item : message){
+        if (item.first != "embeds" || item.second.get_array() == nullptr){
+            ret[item.first] = item.second.clone();
+            continue;
+        }
+        JsonArray embeds;
+        for (const JsonValue& embed : *item.second.get_array()){
+            const JsonObject* fields = embed.get_object();
+            if (fields == nullptr){
+                embeds.push_back(embed.clone());
+            }else{
+                embeds.push_back(drop_embed_image(*fields));
+            }
+        }
+        ret[item.first] = std::move(embeds);
+    }
+    return ret;
+}
+
+
+
 
 
 }
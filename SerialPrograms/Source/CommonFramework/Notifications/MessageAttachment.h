@@ -9,6 +9,8 @@
 
 #include <atomic>
 #include <memory>
+#include <future>
+#include "Common/Cpp/Json/JsonObject.h"
 #include "CommonFramework/Logging/Logger.h"
 #include "CommonFramework/Options/ScreenshotFormatOption.h"
 #include "CommonFramework/ImageTypes/ImageRGB32.h"
@@ -33,6 +35,11 @@ struct ImageAttachment{
 
 //  Represents a file that's in the process of being sent.
 //  If (keep_file = false), the file is automatically deleted after being sent.
+//
+//  Images are encoded in the background by ImageEncodeService. The file
+//  name and path are known right away, but the file itself isn't there until
+//  "wait_until_saved()" returns. The path stays set if the save fails. So
+//  anything that refers to the file must check "wait_until_saved()" first.
 class PendingFileSend{
 public:
     ~PendingFileSend();
@@ -45,6 +52,9 @@ public:
     const std::string& filepath() const{ return m_filepath; }
     bool keep_file() const{ return m_keep_file; }
 
+    //  Wait for the file to be written. Returns false if there is no file.
+    bool wait_until_saved() const;
+
     //  Work around bug in Sleepy that destroys file before it's not needed anymore.
     void extend_lifetime();
 
@@ -54,9 +64,18 @@ private:
 //    QFile m_file;
     std::string m_filename;
     std::string m_filepath;
+    std::shared_future<bool> m_saved;
 };
 
 
 
+//  An embed refers to the attachment with its "image". If the attachment
+//  fails to save, these copies without the image are sent instead.
+JsonObject drop_embed_image(const JsonObject& embed);
+//  Same for each of the "embeds" of a whole message.
+JsonObject drop_embed_images(const JsonObject& message);
+
+
+
 }
 #endif
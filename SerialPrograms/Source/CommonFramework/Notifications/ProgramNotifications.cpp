@@ -94,6 +94,9 @@ void send_raw_notification(
     const ImageAttachment& image
 ){
     std::shared_ptr<PendingFileSend> file(new PendingFileSend(logger, image));
+
+    //  The image is still being saved. The senders wait for it and drop the
+    //  embed image if the save fails.
     bool hasFile = !file->filepath().empty();
 
     JsonObject embed;
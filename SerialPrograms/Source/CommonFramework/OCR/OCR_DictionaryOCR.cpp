@@ -28,6 +28,7 @@ DictionaryOCR::DictionaryOCR(
     bool first_only
 )
     : m_random_match_chance(random_match_chance)
+    , m_index(random_match_chance)
 {
     for (const auto& item0 : json){
         const std::string& token = item0.first;
@@ -50,6 +51,9 @@ DictionaryOCR::DictionaryOCR(
             }
         }
     }
+    for (const auto& item : m_candidate_to_token){
+        m_index.add(item);
+    }
     global_logger_tagged().log(
         "DictionaryOCR - Tokens: " + std::to_string(m_database.size()) +
         ", Match Candidates: " + std::to_string(m_candidate_to_token.size())
@@ -91,10 +95,7 @@ StringMatchResult DictionaryOCR::match_substring(
     const std::string& text,
     double log10p_spread
 ) const{
-    return OCR::match_substring(
-        m_candidate_to_token, m_random_match_chance,
-        text, log10p_spread
-    );
+    return m_index.match_substring(m_candidate_to_token, text, log10p_spread);
 }
 void DictionaryOCR::add_candidate(std::string token, const std::u32string& candidate){
     if (candidate.size() < 2){
@@ -107,7 +108,8 @@ void DictionaryOCR::add_candidate(std::string token, const std::u32string& candi
     if (iter == m_candidate_to_token.end()){
         //  New candidate. Add it to both maps.
         m_database[token].emplace_back(to_utf8(candidate));
-        m_candidate_to_token[candidate].insert(std::move(token));
+        iter = m_candidate_to_token.emplace(candidate, std::set<std::string>{std::move(token)}).first;
+        m_index.add(*iter);
         return;
     }
 
@@ -0,0 +1,277 @@
+/*  Q-Gram Index
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "OCR_StringNormalization.h"
+#include "OCR_TextMatcher.h"
+#include "OCR_QGramIndex.h"
+
+namespace PokemonAutomation{
+namespace OCR{
+
+
+
+namespace{
+
+//  The distinct q-grams of a string and how many times each one appears.
+void count_qgrams(std::vector<std::pair<uint64_t, uint32_t>>& qgrams, const std::u32string& str){
+    static_assert(sizeof(char32_t) == 4);
+    qgrams.clear();
+    if (str.size() < 2){
+        return;
+    }
+    thread_local std::vector<uint64_t> keys;
+    keys.clear();
+    for (size_t c = 0; c + 1 < str.size(); c++){
+        keys.emplace_back(((uint64_t)str[c] << 32) | (uint64_t)str[c + 1]);
+    }
+    std::sort(keys.begin(), keys.end());
+    for (uint64_t key : keys){
+        if (qgrams.empty() || qgrams.back().first != key){
+            qgrams.emplace_back(key, 0);
+        }
+        qgrams.back().second++;
+    }
+}
+
+}
+
+
+
+QGramIndex::QGramIndex(double random_match_chance)
+    : m_random_match_chance(random_match_chance)
+{
+    static_assert(Q == 2, "count_qgrams() only does bigrams.");
+}
+
+void QGramIndex::add(const Database::value_type& entry){
+    const std::u32string& candidate = entry.first;
+    const size_t length = candidate.size();
+    const uint32_t id = (uint32_t)m_candidates.size();
+    m_candidates.emplace_back(&entry);
+
+    if (m_by_length.size() <= length){
+        m_by_length.resize(length + 1);
+    }
+    m_by_length[length].emplace_back(id);
+
+    thread_local std::vector<std::pair<uint64_t, uint32_t>> qgrams;
+    count_qgrams(qgrams, candidate);
+    for (const auto& item : qgrams){
+        m_postings[item.first].emplace_back(Posting{id, item.second});
+    }
+
+    //  Fill in the tables for this length. The bound for "matched" is the
+    //  lowest log10p of anything that matches that many or fewer. This way
+    //  it stays a lower bound even if the floating-point isn't monotonic.
+    while (m_log10p.size() <= length){
+        size_t total = m_log10p.size();
+        std::vector<double> table(total + 1, std::numeric_limits<double>::quiet_NaN());
+        std::vector<double> bounds(total + 1);
+
+        //  Nothing matched. These are never added to the results.
+        double bound = std::numeric_limits<double>::infinity();
+        bounds[0] = bound;
+
+        for (size_t matched = 1; matched <= total; matched++){
+            //  Leave out anything "random_match_probability()" can't handle.
+            //  Those are never pruned and are computed when they are scored.
+            if (total > 1000 || total - matched > 61){
+                bound = -std::numeric_limits<double>::infinity();
+            }else{
+                table[matched] = std::log10(random_match_probability(total, matched, m_random_match_chance));
+                bound = std::min(bound, table[matched]);
+            }
+            bounds[matched] = bound;
+        }
+        m_log10p.emplace_back(std::move(table));
+        m_log10p_bounds.emplace_back(std::move(bounds));
+    }
+}
+double QGramIndex::log10p(size_t length, size_t matched) const{
+    double ret = m_log10p[length][matched];
+    if (std::isnan(ret)){
+        ret = std::log10(random_match_probability(length, matched, m_random_match_chance));
+    }
+    return ret;
+}
+
+
+
+StringMatchResult QGramIndex::match_substring(
+    const Database& database,
+    const std::string& text, double log10p_spread
+) const{
+    StringMatchResult results;
+
+    std::u32string normalized = normalize_utf32(text);
+
+    //  Search for exact match of candidate.
+    auto iter = database.find(normalized);
+    if (iter != database.end()){
+        results.exact_match = true;
+        double probability = random_match_probability(normalized.size(), normalized.size(), m_random_match_chance);
+        double log10p = std::log10(probability);
+        for (const auto& target : iter->second){
+            results.add(
+                log10p,
+                StringMatchData{text, normalized, normalized, target}
+            );
+        }
+        return results;
+    }
+
+
+    //  Count the q-grams each candidate shares with the text.
+    thread_local std::vector<uint32_t> shared;
+    thread_local std::vector<uint32_t> touched;
+    if (shared.size() < m_candidates.size()){
+        shared.resize(m_candidates.size(), 0);
+    }
+    touched.clear();
+
+    thread_local std::vector<std::pair<uint64_t, uint32_t>> qgrams;
+    count_qgrams(qgrams, normalized);
+    for (const auto& item : qgrams){
+        auto postings = m_postings.find(item.first);
+        if (postings == m_postings.end()){
+            continue;
+        }
+        for (const Posting& posting : postings->second){
+            uint32_t& count = shared[posting.candidate];
+            if (count == 0){
+                touched.emplace_back(posting.candidate);
+            }
+            count += std::min(posting.count, item.second);
+        }
+    }
+
+
+    //  Everything left to score in order of their bound. This is either a
+    //  single candidate that shares q-grams with the text, or all the
+    //  candidates of a length that don't.
+    struct Pending{
+        double log10p_bound;
+        size_t min_distance;
+        uint32_t index;
+        bool group;
+    };
+    thread_local std::vector<Pending> pending;
+    pending.clear();
+
+    const size_t text_length = normalized.size();
+    auto add_pending = [&](size_t length, size_t shared_qgrams, uint32_t index, bool group){
+        size_t qgrams_in_candidate = length >= Q ? length - Q + 1 : 0;
+        size_t min_distance = (qgrams_in_candidate - shared_qgrams + Q - 1) / Q;
+        if (length > text_length){
+            min_distance = std::max(min_distance, length - text_length);
+        }
+        size_t max_matched = length - min_distance;
+        if (max_matched == 0){
+            return;
+        }
+        pending.emplace_back(Pending{log10p_bound(length, max_matched), min_distance, index, group});
+    };
+    for (uint32_t id : touched){
+        add_pending(m_candidates[id]->first.size(), shared[id], id, false);
+    }
+    for (size_t length = 0; length < m_by_length.size(); length++){
+        if (!m_by_length[length].empty()){
+            add_pending(length, 0, (uint32_t)length, true);
+        }
+    }
+    std::stable_sort(
+        pending.begin(), pending.end(),
+        [](const Pending& a, const Pending& b){ return a.log10p_bound < b.log10p_bound; }
+    );
+
+
+    //  Score candidates until the rest can't be within the spread.
+    struct Scored{
+        const Database::value_type* entry;
+        double log10p;
+    };
+    thread_local std::vector<Scored> scored;
+    scored.clear();
+
+    LevenshteinText<char32_t> normalized_text(normalized.data(), normalized.size());
+    double best = std::numeric_limits<double>::infinity();
+    auto score = [&](uint32_t id){
+        const std::u32string& candidate = m_candidates[id]->first;
+        size_t token_length = candidate.size();
+        size_t distance = normalized_text.distance_substring(candidate.data(), candidate.size());
+        size_t matched = token_length - distance;
+        if (matched == 0){
+            return;
+        }
+        if (distance == 0){
+            results.exact_match = true;
+        }
+        double value = log10p(token_length, matched);
+        best = std::min(best, value);
+        scored.emplace_back(Scored{m_candidates[id], value});
+    };
+    auto run_pending = [&](const Pending& item, auto&& func){
+        if (!item.group){
+            func(item.index);
+            return;
+        }
+        for (uint32_t id : m_by_length[item.index]){
+            if (shared[id] == 0){
+                func(id);
+            }
+        }
+    };
+
+    size_t c = 0;
+    for (; c < pending.size(); c++){
+        if (pending[c].log10p_bound > best + log10p_spread){
+            break;
+        }
+        run_pending(pending[c], score);
+    }
+
+    //  The rest can't be in the results. But any that are an exact substring
+    //  still count as an exact match.
+    for (; c < pending.size() && !results.exact_match; c++){
+        if (pending[c].min_distance != 0){
+            continue;
+        }
+        run_pending(pending[c], [&](uint32_t id){
+            const std::u32string& candidate = m_candidates[id]->first;
+            if (normalized_text.distance_substring(candidate.data(), candidate.size()) == 0){
+                results.exact_match = true;
+            }
+        });
+    }
+
+    for (uint32_t id : touched){
+        shared[id] = 0;
+    }
+
+
+    //  Add them in the same order as the brute force search. So ties come out
+    //  in the same order.
+    std::sort(
+        scored.begin(), scored.end(),
+        [](const Scored& a, const Scored& b){ return a.entry->first < b.entry->first; }
+    );
+    for (const Scored& item : scored){
+        for (const auto& slug : item.entry->second){
+            results.add(item.log10p, StringMatchData{text, normalized, item.entry->first, slug});
+            results.clear_beyond_spread(log10p_spread);
+        }
+    }
+
+    return results;
+}
+
+
+
+}
+}
@@ -0,0 +1,92 @@
+/*  Q-Gram Index
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Substring matching against a dictionary without computing the edit
+ *  distance of every candidate. The results are identical to the brute force
+ *  "match_substring()" in OCR_TextMatcher.h.
+ *
+ *  Every edit in the alignment of a candidate destroys at most Q of its
+ *  q-grams. So if the text has only "s" of the "L - Q + 1" q-grams of a
+ *  length "L" candidate, the distance is at least ceil((L - Q + 1 - s) / Q).
+ *  That gives a lower bound on the log10p of the candidate.
+ *
+ *  Candidates are scored in order of that bound. Once the bound is beyond
+ *  the spread of the best match so far, none of the remaining candidates
+ *  can make it into the results.
+ *
+ */
+
+#ifndef PokemonAutomation_OCR_QGramIndex_H
+#define PokemonAutomation_OCR_QGramIndex_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include "OCR_StringMatchResult.h"
+
+namespace PokemonAutomation{
+namespace OCR{
+
+
+class QGramIndex{
+public:
+    using Database = std::map<std::u32string, std::set<std::string>>;
+
+    QGramIndex(double random_match_chance);
+
+    //  Add a candidate. "entry" is an element of the database that is passed
+    //  to "match_substring()". It must remain valid for the life of the index.
+    //  Adding the same entry twice is not allowed.
+    void add(const Database::value_type& entry);
+
+    size_t candidates() const{ return m_candidates.size(); }
+
+    StringMatchResult match_substring(
+        const Database& database,
+        const std::string& text, double log10p_spread
+    ) const;
+
+
+private:
+    static constexpr size_t Q = 2;
+
+    struct Posting{
+        uint32_t candidate;
+        uint32_t count;
+    };
+
+    //  Same as "log10(random_match_probability())", but from a table.
+    double log10p(size_t length, size_t matched) const;
+
+    //  Lower bound of the log10p of a length "length" candidate that matches
+    //  at most "matched" characters.
+    double log10p_bound(size_t length, size_t matched) const{
+        return m_log10p_bounds[length][matched];
+    }
+
+
+private:
+    double m_random_match_chance;
+
+    std::vector<const Database::value_type*> m_candidates;
+
+    //  Candidate IDs grouped by their length.
+    std::vector<std::vector<uint32_t>> m_by_length;
+
+    //  q-gram -> all candidates that contain it.
+    std::unordered_map<uint64_t, std::vector<Posting>> m_postings;
+
+    //  [length][matched] -> see "log10p()" and "log10p_bound()".
+    std::vector<std::vector<double>> m_log10p;
+    std::vector<std::vector<double>> m_log10p_bounds;
+};
+
+
+
+}
+}
+#endif
@@ -4,6 +4,8 @@
  *
  */
 
+#include "Common/Cpp/Concurrency/AsyncDispatcher.h"
+#include "CommonFramework/GlobalServices.h"
 #include "CommonFramework/ImageTypes/ImageRGB32.h"
 #include "CommonFramework/ImageTools/ImageFilter.h"
 #include "OCR_RawOCR.h"
@@ -19,6 +21,21 @@ StringMatchResult multifiltered_OCR(
     const std::vector<TextColorRange>& text_color_ranges,
     double log10p_spread,
     double min_text_ratio, double max_text_ratio
+){
+    return multifiltered_OCR(
+        &global_inference_dispatcher(),
+        language, dictionary, image,
+        text_color_ranges,
+        log10p_spread,
+        min_text_ratio, max_text_ratio
+    );
+}
+StringMatchResult multifiltered_OCR(
+    AsyncDispatcher* dispatcher,
+    Language language, const DictionaryMatcher& dictionary, const ImageViewRGB32& image,
+    const std::vector<TextColorRange>& text_color_ranges,
+    double log10p_spread,
+    double min_text_ratio, double max_text_ratio
 ){
     if (image.width() == 0 || image.height() == 0){
         return StringMatchResult();
@@ -32,22 +49,40 @@ StringMatchResult multifiltered_OCR(
 
     double pixels_inv = 1. / (image.width() * image.height());
 
-    //  Run all the filters.
-    StringMatchResult ret;
-//    int c = 0;
+    //  Compute ratio of image that matches text color. Skip if it's out of range.
+    //  No need to OCR these.
+    std::vector<const ImageRGB32*> active;
     for (const auto& filtered : filtered_images){
-        std::string text = ocr_read(language, filtered.first);
-//        cout << text.toStdString() << endl;
-//        filtered.first.save("test" + QString::number(c++) + ".png");
-
-        //  Compute ratio of image that matches text color. Skip if it's out of range.
         double ratio = filtered.second * pixels_inv;
 //        cout << "ratio = " << ratio << endl;
         if (ratio < min_text_ratio || ratio > max_text_ratio){
             continue;
         }
+        active.emplace_back(&filtered.first);
+    }
+
+    //  Run all the filters.
+    std::vector<StringMatchResult> results(active.size());
+    auto run_filter = [&](size_t index){
+        std::string text = ocr_read(language, *active[index]);
+//        cout << text << endl;
+        results[index] = dictionary.match_substring(language, text, log10p_spread);
+    };
+    if (dispatcher == nullptr || active.size() <= 1){
+        for (size_t c = 0; c < active.size(); c++){
+            run_filter(c);
+        }
+    }else{
+        //  Each filter gets its own thread. So make sure none of them wait
+        //  for an instance another one is holding.
+        ensure_instances(language, active.size());
+        dispatcher->run_in_parallel(0, active.size(), run_filter);
+    }
 
-        StringMatchResult current = dictionary.match_substring(language, text, log10p_spread);
+    //  Merge in filter order. So ties are resolved the same way regardless of
+    //  which filters finish first.
+    StringMatchResult ret;
+    for (const StringMatchResult& current : results){
         ret.exact_match |= current.exact_match;
         ret.results.insert(current.results.begin(), current.results.end());
     }
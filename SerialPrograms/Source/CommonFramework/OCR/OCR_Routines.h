@@ -12,6 +12,7 @@
 
 namespace PokemonAutomation{
     class ImageViewRGB32;
+    class AsyncDispatcher;
 namespace OCR{
 
 struct StringMatchResult;
@@ -37,6 +38,17 @@ StringMatchResult multifiltered_OCR(
     double min_text_ratio = 0.01, double max_text_ratio = 0.50
 );
 
+//  Same as above, but run the filters in parallel on "dispatcher". If it is
+//  null, they are run one at a time on the calling thread.
+//  The version above uses global_inference_dispatcher().
+StringMatchResult multifiltered_OCR(
+    AsyncDispatcher* dispatcher,
+    Language language, const DictionaryMatcher& dictionary, const ImageViewRGB32& image,
+    const std::vector<TextColorRange>& text_color_ranges,
+    double log10p_spread,
+    double min_text_ratio, double max_text_ratio
+);
+
 
 const std::vector<TextColorRange>& BLACK_TEXT_FILTERS();
 const std::vector<TextColorRange>& WHITE_TEXT_FILTERS();
@@ -6,6 +6,8 @@
 
 #include <cmath>
 #include <vector>
+#include <algorithm>
+#include "Common/Compiler.h"
 #include "Common/Cpp/Exceptions.h"
 #include "Common/Cpp/Concurrency/SpinLock.h"
 #include "Common/Qt/StringToolsQt.h"
@@ -34,136 +36,133 @@ void print(const std::vector<size_t>& v){
 }
 
 
-size_t levenshtein_distance(const QString& x, const QString& y){
-    size_t xlen = x.size();
-    size_t ylen = y.size();
+namespace{
 
-    std::vector<size_t> v0(ylen + 1);
-    std::vector<size_t> v1(ylen + 1);
+//  Advance one block of 64 rows by one column of the text.
+//  "hin" is the horizontal delta into the top row of the block.
+//  Returns the horizontal delta out of row "out_bit".
+PA_FORCE_INLINE int levenshtein_block(
+    uint64_t& Pv, uint64_t& Mv, uint64_t Eq,
+    int hin, size_t out_bit
+){
+    uint64_t hin_neg = hin < 0 ? 1 : 0;
+    uint64_t hin_pos = hin > 0 ? 1 : 0;
+
+    uint64_t Xv = Eq | Mv;
+    Eq |= hin_neg;
+    uint64_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+    uint64_t Ph = Mv | ~(Xh | Pv);
+    uint64_t Mh = Pv & Xh;
+
+    int hout = (int)((Ph >> out_bit) & 1) - (int)((Mh >> out_bit) & 1);
+
+    Ph = (Ph << 1) | hin_pos;
+    Mh = (Mh << 1) | hin_neg;
+    Pv = Mh | ~(Xv | Ph);
+    Mv = Ph & Xv;
+    return hout;
+}
 
-    for (size_t i = 0; i <= ylen; i++){
-        v0[i] = i;
-    }
+}
 
-    for (size_t i = 0; i < xlen; i++){
-        v1[0] = i + 1;
-
-        for (size_t j = 0; j < ylen; j++){
-            size_t delete_cost = v0[j + 1] + 1;
-            size_t insert_cost = v1[j] + 1;
-            size_t sub_cost = v0[j];
-            if (x[(int)i] != y[(int)j]){
-                sub_cost += 1;
-            }
-            v1[j + 1] = std::min({delete_cost, insert_cost, sub_cost});
-        }
 
-        std::swap(v0, v1);
+template <typename CharType>
+LevenshteinText<CharType>::LevenshteinText(const CharType* text, size_t length)
+    : m_alphabet(text, text + length)
+    , m_text(length)
+{
+    std::sort(m_alphabet.begin(), m_alphabet.end());
+    m_alphabet.erase(std::unique(m_alphabet.begin(), m_alphabet.end()), m_alphabet.end());
+    for (size_t c = 0; c < length; c++){
+        m_text[c] = (uint32_t)(std::lower_bound(m_alphabet.begin(), m_alphabet.end(), text[c]) - m_alphabet.begin());
     }
-
-    return v0[ylen];
 }
-size_t levenshtein_distance_substring(const QString& substring, const QString& fullstring){
-    size_t xlen = fullstring.size();
-    size_t ylen = substring.size();
-
-    std::vector<size_t> v0(ylen + 1);
-    std::vector<size_t> v1(ylen + 1);
+template <typename CharType>
+size_t LevenshteinText<CharType>::distance(const CharType* pattern, size_t length) const{
+    return run(pattern, length, false);
+}
+template <typename CharType>
+size_t LevenshteinText<CharType>::distance_substring(const CharType* pattern, size_t length) const{
+    return run(pattern, length, true);
+}
+template <typename CharType>
+size_t LevenshteinText<CharType>::run(const CharType* pattern, size_t length, bool substring) const{
+    //  The pattern runs down the rows. The text runs across the columns.
+    //  Row 0 is 0, 1, 2, ... for the full distance and all zeros for substrings.
+    if (length == 0){
+        return substring ? 0 : m_text.size();
+    }
 
-    for (size_t i = 0; i <= ylen; i++){
-        v0[i] = i;
+    const size_t blocks = (length + 63) / 64;
+    const size_t last_bit = (length - 1) % 64;
+
+    //  The match masks of the pattern for each character in the text.
+    //  Pattern characters that aren't in the text never match anything.
+    thread_local std::vector<uint64_t> peq;
+    peq.assign(m_alphabet.size() * blocks, 0);
+    for (size_t c = 0; c < length; c++){
+        auto iter = std::lower_bound(m_alphabet.begin(), m_alphabet.end(), pattern[c]);
+        if (iter != m_alphabet.end() && *iter == pattern[c]){
+            peq[(iter - m_alphabet.begin()) * blocks + c / 64] |= (uint64_t)1 << (c % 64);
+        }
     }
-//    print(v0);
 
-    size_t min = ylen;
+    const int top = substring ? 0 : 1;
+    ptrdiff_t score = (ptrdiff_t)length;
+    ptrdiff_t best = score;
 
-    for (size_t i = 0; i < xlen; i++){
-        v1[0] = 0;
+    if (blocks == 1){
+        uint64_t Pv = ~(uint64_t)0;
+        uint64_t Mv = 0;
+        for (uint32_t ch : m_text){
+            score += levenshtein_block(Pv, Mv, peq[ch], top, last_bit);
+            best = std::min(best, score);
+        }
+        return (size_t)(substring ? best : score);
+    }
 
-        for (size_t j = 0; j < ylen; j++){
-            size_t delete_cost = v0[j + 1] + 1;
-            size_t insert_cost = v1[j] + 1;
-            size_t sub_cost = v0[j];
-            if (fullstring[(int)i] != substring[(int)j]){
-                sub_cost += 1;
-            }
-            v1[j + 1] = std::min({delete_cost, insert_cost, sub_cost});
+    thread_local std::vector<uint64_t> state;
+    state.assign(2 * blocks, 0);
+    uint64_t* Pv = state.data();
+    uint64_t* Mv = Pv + blocks;
+    std::fill(Pv, Pv + blocks, ~(uint64_t)0);
+
+    for (uint32_t ch : m_text){
+        const uint64_t* Eq = &peq[ch * blocks];
+        int h = top;
+        for (size_t b = 0; b < blocks - 1; b++){
+            h = levenshtein_block(Pv[b], Mv[b], Eq[b], h, 63);
         }
+        score += levenshtein_block(Pv[blocks - 1], Mv[blocks - 1], Eq[blocks - 1], h, last_bit);
+        best = std::min(best, score);
+    }
+    return (size_t)(substring ? best : score);
+}
+template class LevenshteinText<char16_t>;
+template class LevenshteinText<char32_t>;
 
-        std::swap(v0, v1);
 
-        min = std::min(min, v0[ylen]);
-//        print(v0);
-    }
 
-    return min;
+size_t levenshtein_distance(const QString& x, const QString& y){
+    LevenshteinText<char16_t> text((const char16_t*)x.utf16(), x.size());
+    return text.distance((const char16_t*)y.utf16(), y.size());
+}
+size_t levenshtein_distance_substring(const QString& substring, const QString& fullstring){
+    LevenshteinText<char16_t> text((const char16_t*)fullstring.utf16(), fullstring.size());
+    return text.distance_substring((const char16_t*)substring.utf16(), substring.size());
 }
 
 template <typename StringType>
 size_t levenshtein_distance(const StringType& x, const StringType& y){
-    size_t xlen = x.size();
-    size_t ylen = y.size();
-
-    std::vector<size_t> v0(ylen + 1);
-    std::vector<size_t> v1(ylen + 1);
-
-    for (size_t i = 0; i <= ylen; i++){
-        v0[i] = i;
-    }
-
-    for (size_t i = 0; i < xlen; i++){
-        v1[0] = i + 1;
-
-        for (size_t j = 0; j < ylen; j++){
-            size_t delete_cost = v0[j + 1] + 1;
-            size_t insert_cost = v1[j] + 1;
-            size_t sub_cost = v0[j];
-            if (x[i] != y[j]){
-                sub_cost += 1;
-            }
-            v1[j + 1] = std::min({delete_cost, insert_cost, sub_cost});
-        }
-
-        std::swap(v0, v1);
-    }
-
-    return v0[ylen];
+    using CharType = typename StringType::value_type;
+    LevenshteinText<CharType> text(x.data(), x.size());
+    return text.distance(y.data(), y.size());
 }
 template <typename StringType>
 size_t levenshtein_distance_substring(const StringType& substring, const StringType& fullstring){
-    size_t xlen = fullstring.size();
-    size_t ylen = substring.size();
-
-    std::vector<size_t> v0(ylen + 1);
-    std::vector<size_t> v1(ylen + 1);
-
-    for (size_t i = 0; i <= ylen; i++){
-        v0[i] = i;
-    }
-//    print(v0);
-
-    size_t min = ylen;
-
-    for (size_t i = 0; i < xlen; i++){
-        v1[0] = 0;
-
-        for (size_t j = 0; j < ylen; j++){
-            size_t delete_cost = v0[j + 1] + 1;
-            size_t insert_cost = v1[j] + 1;
-            size_t sub_cost = v0[j];
-            if (fullstring[i] != substring[j]){
-                sub_cost += 1;
-            }
-            v1[j + 1] = std::min({delete_cost, insert_cost, sub_cost});
-        }
-
-        std::swap(v0, v1);
-
-        min = std::min(min, v0[ylen]);
-//        print(v0);
-    }
-
-    return min;
+    using CharType = typename StringType::value_type;
+    LevenshteinText<CharType> text(fullstring.data(), fullstring.size());
+    return text.distance_substring(substring.data(), substring.size());
 }
 template size_t levenshtein_distance<std::u32string>(const std::u32string& x, const std::u32string& y);
 template size_t levenshtein_distance_substring<std::u32string>(const std::u32string& x, const std::u32string& y);
@@ -274,10 +273,11 @@ StringMatchResult match_substring(
     }
 
 
+    LevenshteinText<char32_t> normalized_text(normalized.data(), normalized.size());
     for (const auto& item : database){
         double token_length = item.first.size();
 
-        size_t distance = levenshtein_distance_substring(item.first, normalized);
+        size_t distance = normalized_text.distance_substring(item.first.data(), item.first.size());
         size_t matched = token_length - distance;
         if (matched == 0){
             continue;
@@ -19,6 +19,37 @@ namespace PokemonAutomation{
 namespace OCR{
 
 
+//  Edit distances using the bit-parallel algorithm from:
+//      Myers - "A Fast Bit-Vector Algorithm for Approximate String Matching
+//      Based on Dynamic Programming"
+//      Hyyro - "A Bit-Vector Algorithm for Computing Levenshtein and Damerau
+//      Edit Distances"
+//
+//  The text is preprocessed once. Then it can be matched against any # of
+//  patterns. Each pattern takes O(ceil(m / 64) * n) time.
+template <typename CharType>
+class LevenshteinText{
+public:
+    LevenshteinText(const CharType* text, size_t length);
+
+    //  Edit distance between "pattern" and the whole text.
+    size_t distance(const CharType* pattern, size_t length) const;
+
+    //  Smallest edit distance between "pattern" and any substring of the text.
+    size_t distance_substring(const CharType* pattern, size_t length) const;
+
+private:
+    size_t run(const CharType* pattern, size_t length, bool substring) const;
+
+private:
+    //  Sorted distinct characters of the text.
+    std::vector<CharType> m_alphabet;
+
+    //  The text as indices into "m_alphabet".
+    std::vector<uint32_t> m_text;
+};
+
+
 size_t levenshtein_distance(const QString& x, const QString& y);
 size_t levenshtein_distance_substring(const QString& substring, const QString& fullstring);
 
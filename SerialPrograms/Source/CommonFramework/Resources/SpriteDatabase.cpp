@@ -4,20 +4,78 @@
  *
  */
 
+#include <QFileInfo>
+#include "Common/Cpp/Exceptions.h"
 #include "Common/Cpp/Json/JsonValue.h"
 #include "Common/Cpp/Json/JsonObject.h"
 #include "CommonFramework/Globals.h"
+#include "CommonFramework/Logging/Logger.h"
 #include "CommonFramework/ImageTools/ImageBoxes.h"
 #include "CommonFramework/ImageMatch/ImageCropper.h"
+#include "SpritePack.h"
 #include "SpriteDatabase.h"
 
 namespace PokemonAutomation{
 
 
 
-SpriteDatabase::SpriteDatabase(const char* sprite_path, const char* json_path)
-    : m_backing_image(RESOURCE_PATH() + sprite_path)
-{
+SpriteDatabase::~SpriteDatabase() = default;
+SpriteDatabase::SpriteDatabase(const char* sprite_path, const char* json_path, bool allow_pack){
+    std::string path = pack_path(sprite_path);
+    if (allow_pack && QFileInfo::exists(QString::fromStdString(path))){
+        try{
+            std::unique_ptr<SpritePack> pack(new SpritePack(path));
+            if (pack->built_from(RESOURCE_PATH() + sprite_path, RESOURCE_PATH() + json_path)){
+                load_pack(std::move(pack));
+                return;
+            }
+            global_logger_tagged().log("Sprite pack is out of date: " + path, COLOR_ORANGE);
+        }catch (FileException& e){
+            global_logger_tagged().log(e.message(), COLOR_ORANGE);
+        }
+    }
+    load_sources(sprite_path, json_path);
+}
+SpriteDatabase::SpriteDatabase(const std::string& pack_path){
+    load_pack(std::unique_ptr<SpritePack>(new SpritePack(pack_path)));
+}
+
+std::string SpriteDatabase::pack_path(const char* sprite_path){
+    std::string path = RESOURCE_PATH() + sprite_path;
+    size_t dot = path.rfind('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)){
+        path.resize(dot);
+    }
+    return path + ".spritepack";
+}
+void SpriteDatabase::write_pack(const std::string& path, const char* sprite_path, const char* json_path) const{
+    std::vector<SpritePack::Entry> entries;
+    entries.reserve(m_database.size());
+    for (const auto& item : m_database){
+        const Sprite& sprite = item.second;
+        entries.emplace_back(SpritePack::Entry{
+            item.first,
+            sprite.sprite,
+            ImageMatch::trim_image_alpha_box(sprite.sprite),
+            sprite.icon_stats,
+        });
+    }
+    SpritePack::write(path, RESOURCE_PATH() + sprite_path, RESOURCE_PATH() + json_path, entries);
+}
+
+void SpriteDatabase::load_pack(std::unique_ptr<SpritePack> pack){
+    for (const SpritePack::Entry& entry : pack->entries()){
+        m_database.emplace(
+            entry.slug,
+            Sprite{entry.sprite, extract_box_reference(entry.sprite, entry.icon), entry.icon_stats}
+        );
+    }
+    m_pack = std::move(pack);
+}
+void SpriteDatabase::load_sources(const char* sprite_path, const char* json_path){
+    m_backing_image = ImageRGB32(RESOURCE_PATH() + sprite_path);
+
     std::string path = RESOURCE_PATH() + json_path;
     JsonValue json = load_json_file(path);
     JsonObject& root = json.get_object_throw(path);
@@ -39,9 +97,10 @@ SpriteDatabase::SpriteDatabase(const char* sprite_path, const char* json_path)
         int x = (int)obj.get_integer_throw("left", path);
 
         ImageViewRGB32 sprite = extract_box_reference(m_backing_image, ImagePixelBox(x, y, x + width, y + height));
+        ImageViewRGB32 icon = ImageMatch::trim_image_alpha(sprite);
         m_database.emplace(
             slug,
-            Sprite{sprite, ImageMatch::trim_image_alpha(sprite)}
+            Sprite{sprite, icon, image_stats(icon)}
         );
     }
 }
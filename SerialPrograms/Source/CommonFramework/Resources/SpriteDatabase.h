@@ -8,10 +8,14 @@
 #define PokemonAutomation_Resources_SpriteCompositeImage_H
 
 #include <map>
+#include <memory>
 #include "CommonFramework/ImageTypes/ImageRGB32.h"
+#include "CommonFramework/ImageTools/ImageStats.h"
 
 namespace PokemonAutomation{
 
+class SpritePack;
+
 
 class SpriteDatabase{
 public:
@@ -32,12 +36,27 @@ public:
     //          (next pokemon) ...
     //      }
     //  }
-    SpriteDatabase(const char* sprite_path, const char* json_path);
+    //
+    //  If there is an up-to-date sprite pack for the image, (see "pack_path()")
+    //  that is loaded instead and the image and json are never read.
+    SpriteDatabase(const char* sprite_path, const char* json_path, bool allow_pack = true);
+
+    //  Build from a sprite pack. Throws FileException if it isn't valid.
+    SpriteDatabase(const std::string& pack_path);
+
+    ~SpriteDatabase();
+
+    //  Where the sprite pack for "sprite_path" goes.
+    static std::string pack_path(const char* sprite_path);
+
+    //  Write this database out as a sprite pack built from these files.
+    void write_pack(const std::string& path, const char* sprite_path, const char* json_path) const;
 
 public:
     struct Sprite{
         ImageViewRGB32 sprite;  //  The original sprite.
         ImageViewRGB32 icon;    //  Sprite with 0-alpha boundaries cropped for better viewing.
+        ImageStats icon_stats;  //  image_stats() of the icon.
     };
     const Sprite& get_throw(const std::string& slug) const;
     const Sprite* get_nothrow(const std::string& slug) const;
@@ -57,9 +76,16 @@ public:
     const_iterator end    () const{ return m_database.end(); }
           iterator end    (){ return m_database.end(); }
 
+private:
+    void load_sources(const char* sprite_path, const char* json_path);
+    void load_pack(std::unique_ptr<SpritePack> pack);
+
 private:
     std::map<std::string, Sprite> m_database;
+
+    //  The sprites point into one of these.
     ImageRGB32 m_backing_image;
+    std::unique_ptr<SpritePack> m_pack;
 };
 
 
@@ -0,0 +1,277 @@
+/*  Sprite Pack
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include "Common/Compiler.h"
+#include "Common/CRC32.h"
+#include "Common/Cpp/Exceptions.h"
+#include "SpritePack.h"
+
+namespace PokemonAutomation{
+
+
+namespace{
+
+uint64_t align_up(uint64_t x){
+    return (x + PA_ALIGNMENT - 1) & ~(uint64_t)(PA_ALIGNMENT - 1);
+}
+uint64_t file_size(const std::string& path){
+    QFileInfo info(QString::fromStdString(path));
+    return info.exists() ? (uint64_t)info.size() : 0;
+}
+uint32_t file_crc32c(const std::string& path){
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly)){
+        return 0;
+    }
+    qint64 size = file.size();
+    if (size == 0){
+        return pabb_crc32(0xffffffff, nullptr, 0);
+    }
+    const uchar* data = file.map(0, size);
+    if (data != nullptr){
+        return pabb_crc32(0xffffffff, data, (size_t)size);
+    }
+    QByteArray bytes = file.readAll();
+    return pabb_crc32(0xffffffff, bytes.data(), (size_t)bytes.size());
+}
+
+}
+
+
+
+SpritePack::~SpritePack() = default;
+SpritePack::SpritePack(const std::string& path)
+    : m_file(new QFile(QString::fromStdString(path)))
+{
+    if (!m_file->open(QIODevice::ReadOnly)){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Unable to open sprite pack.", path);
+    }
+
+    uint64_t size = m_file->size();
+    if (size < sizeof(SpritePackHeader)){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Sprite pack is truncated.", path);
+    }
+
+    //  Private so the views can be handed out as mutable like every other
+    //  image view. Nothing writes to them, so no pages are actually copied.
+    uint8_t* base = m_file->map(0, size, QFileDevice::MapPrivateOption);
+    if (base == nullptr){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Unable to map sprite pack.", path);
+    }
+    if ((size_t)base % PA_ALIGNMENT != 0){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Sprite pack mapping is misaligned.", path);
+    }
+
+    const SpritePackHeader& header = *(const SpritePackHeader*)base;
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Not a sprite pack.", path);
+    }
+    if (header.version != VERSION){
+        throw FileException(
+            nullptr, PA_CURRENT_FUNCTION,
+            "Unsupported sprite pack version: " + std::to_string(header.version),
+            path
+        );
+    }
+    if (header.byte_order != BYTE_ORDER_MARK){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Sprite pack has the wrong byte order.", path);
+    }
+    if (header.file_size != size){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Sprite pack is truncated.", path);
+    }
+
+    //  Every section must lie within the file and the entry table must be
+    //  aligned since it is used in place. The subtractions can't underflow
+    //  since each is checked against "size" first.
+    if (header.entries_offset < sizeof(SpritePackHeader) ||
+        header.entries_offset % alignof(SpritePackEntry) != 0 ||
+        header.entries_offset > size ||
+        header.entry_count > (size - header.entries_offset) / sizeof(SpritePackEntry) ||
+        header.strings_offset > size ||
+        header.strings_size > size - header.strings_offset ||
+        header.pixels_offset > size ||
+        header.pixels_size > size - header.pixels_offset ||
+        header.pixels_offset % PA_ALIGNMENT != 0
+    ){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Sprite pack has an invalid header.", path);
+    }
+
+    m_image_file_size = header.image_file_size;
+    m_json_file_size = header.json_file_size;
+    m_image_file_crc32c = header.image_file_crc32c;
+    m_json_file_crc32c = header.json_file_crc32c;
+
+    const SpritePackEntry* entries = (const SpritePackEntry*)(base + header.entries_offset);
+    const char* strings = (const char*)(base + header.strings_offset);
+    uint64_t pixels_end = header.pixels_offset + header.pixels_size;
+
+    m_entries.reserve(header.entry_count);
+    for (uint64_t c = 0; c < header.entry_count; c++){
+        const SpritePackEntry& entry = entries[c];
+        if ((uint64_t)entry.slug_offset + entry.slug_size > header.strings_size){
+            throw FileException(nullptr, PA_CURRENT_FUNCTION, "Sprite pack has an invalid slug.", path);
+        }
+
+        uint64_t bytes = (uint64_t)entry.bytes_per_row * entry.height;
+        if (entry.width == 0 || entry.height == 0 ||
+            entry.bytes_per_row < (uint64_t)entry.width * sizeof(uint32_t) ||
+            entry.bytes_per_row % PA_ALIGNMENT != 0 ||
+            entry.pixels_offset % PA_ALIGNMENT != 0 ||
+            entry.pixels_offset < header.pixels_offset ||
+            entry.pixels_offset > pixels_end ||
+            bytes > pixels_end - entry.pixels_offset
+        ){
+            throw FileException(nullptr, PA_CURRENT_FUNCTION, "Sprite pack has an invalid sprite.", path);
+        }
+        //  The box is empty if the sprite is fully transparent.
+        if (entry.icon_min_x > entry.icon_max_x || entry.icon_max_x > entry.width ||
+            entry.icon_min_y > entry.icon_max_y || entry.icon_max_y > entry.height
+        ){
+            throw FileException(nullptr, PA_CURRENT_FUNCTION, "Sprite pack has an invalid icon box.", path);
+        }
+
+        m_entries.emplace_back(Entry{
+            std::string(strings + entry.slug_offset, entry.slug_size),
+            ImageViewRGB32(
+                (uint32_t*)(base + entry.pixels_offset),
+                entry.bytes_per_row, entry.width, entry.height
+            ),
+            ImagePixelBox(entry.icon_min_x, entry.icon_min_y, entry.icon_max_x, entry.icon_max_y),
+            ImageStats(
+                FloatPixel(entry.icon_average[0], entry.icon_average[1], entry.icon_average[2]),
+                FloatPixel(entry.icon_stddev[0], entry.icon_stddev[1], entry.icon_stddev[2]),
+                entry.icon_count
+            ),
+        });
+    }
+}
+
+bool SpritePack::built_from(const std::string& image_path, const std::string& json_path) const{
+    //  Check the sizes first. They don't need to read the files.
+    if (m_image_file_size != file_size(image_path) || m_json_file_size != file_size(json_path)){
+        return false;
+    }
+    return m_image_file_crc32c == file_crc32c(image_path) && m_json_file_crc32c == file_crc32c(json_path);
+}
+
+
+
+void SpritePack::write(
+    const std::string& path,
+    const std::string& image_path, const std::string& json_path,
+    const std::vector<Entry>& entries
+){
+    std::vector<const Entry*> sorted;
+    sorted.reserve(entries.size());
+    for (const Entry& entry : entries){
+        sorted.emplace_back(&entry);
+    }
+    std::sort(
+        sorted.begin(), sorted.end(),
+        [](const Entry* x, const Entry* y){ return x->slug < y->slug; }
+    );
+
+    //  Lay out the sections.
+    SpritePackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.image_file_size = file_size(image_path);
+    header.json_file_size = file_size(json_path);
+    header.image_file_crc32c = file_crc32c(image_path);
+    header.json_file_crc32c = file_crc32c(json_path);
+    header.entry_count = sorted.size();
+    header.entries_offset = sizeof(SpritePackHeader);
+
+    std::vector<SpritePackEntry> table(sorted.size());
+    std::string strings;
+    uint64_t pixels_size = 0;
+    for (size_t c = 0; c < sorted.size(); c++){
+        const Entry& entry = *sorted[c];
+        if (!entry.sprite){
+            throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Null sprite: " + entry.slug);
+        }
+
+        SpritePackEntry& out = table[c];
+        memset(&out, 0, sizeof(out));
+        out.slug_offset = (uint32_t)strings.size();
+        out.slug_size = (uint32_t)entry.slug.size();
+        strings += entry.slug;
+
+        out.width = (uint32_t)entry.sprite.width();
+        out.height = (uint32_t)entry.sprite.height();
+        out.bytes_per_row = (uint32_t)align_up(entry.sprite.width() * sizeof(uint32_t));
+        out.pixels_offset = pixels_size;    //  Relative for now.
+        pixels_size += (uint64_t)out.bytes_per_row * out.height;
+
+        out.icon_min_x = (uint32_t)entry.icon.min_x;
+        out.icon_min_y = (uint32_t)entry.icon.min_y;
+        out.icon_max_x = (uint32_t)entry.icon.max_x;
+        out.icon_max_y = (uint32_t)entry.icon.max_y;
+
+        out.icon_average[0] = entry.icon_stats.average.r;
+        out.icon_average[1] = entry.icon_stats.average.g;
+        out.icon_average[2] = entry.icon_stats.average.b;
+        out.icon_stddev[0] = entry.icon_stats.stddev.r;
+        out.icon_stddev[1] = entry.icon_stats.stddev.g;
+        out.icon_stddev[2] = entry.icon_stats.stddev.b;
+        out.icon_count = entry.icon_stats.count;
+    }
+
+    header.strings_offset = header.entries_offset + table.size() * sizeof(SpritePackEntry);
+    header.strings_size = strings.size();
+    header.pixels_offset = align_up(header.strings_offset + header.strings_size);
+    header.pixels_size = pixels_size;
+    header.file_size = header.pixels_offset + header.pixels_size;
+    for (SpritePackEntry& entry : table){
+        entry.pixels_offset += header.pixels_offset;
+    }
+
+    //  Build the whole file in memory, then write it at once.
+    std::string data(header.file_size, '\0');
+    memcpy(&data[0], &header, sizeof(header));
+    if (!table.empty()){
+        memcpy(&data[header.entries_offset], table.data(), table.size() * sizeof(SpritePackEntry));
+    }
+    if (!strings.empty()){
+        memcpy(&data[header.strings_offset], strings.data(), strings.size());
+    }
+    for (size_t c = 0; c < sorted.size(); c++){
+        const ImageViewRGB32& sprite = sorted[c]->sprite;
+        char* dest = &data[table[c].pixels_offset];
+        for (size_t r = 0; r < sprite.height(); r++){
+            memcpy(
+                dest + r * table[c].bytes_per_row,
+                (const char*)sprite.data() + r * sprite.bytes_per_row(),
+                sprite.width() * sizeof(uint32_t)
+            );
+        }
+    }
+
+    //  Another process may have the old pack mapped. Truncating it in place
+    //  would crash that reader. So write a new file next to it and rename it
+    //  over the old one. The old mapping keeps the old contents.
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly)){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Unable to create sprite pack.", path);
+    }
+    if (file.write(data.data(), (qint64)data.size()) != (qint64)data.size()){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Unable to write sprite pack.", path);
+    }
+    if (!file.commit()){
+        throw FileException(nullptr, PA_CURRENT_FUNCTION, "Unable to replace sprite pack.", path);
+    }
+}
+
+
+
+}
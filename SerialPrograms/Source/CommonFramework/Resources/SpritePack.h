@@ -0,0 +1,140 @@
+/*  Sprite Pack
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      A precompiled binary form of a sprite database. (composite PNG + JSON)
+ *
+ *  Loading a sprite database from its sources means decoding the PNG, parsing
+ *  the JSON, then trimming every sprite and computing its stats. A pack has
+ *  all of that done already. It is memory-mapped and the sprites are image
+ *  views straight into the mapping. So nothing is decoded or copied.
+ *
+ *  Layout: (native byte order, which is checked on load)
+ *
+ *      SpritePackHeader
+ *      SpritePackEntry[entry_count]    Sorted by slug.
+ *      String table                    The slugs, not null-terminated.
+ *      Pixels                          Raw ARGB32. Each sprite starts on a
+ *                                      64-byte boundary and each row is
+ *                                      padded to a multiple of 64 bytes.
+ *
+ *  Packs are built by the "Build Sprite Packs" developer program. A pack
+ *  records the sizes and CRC32C of the files it was built from. If they don't
+ *  match the current files, the pack is out of date and is ignored.
+ *
+ */
+
+#ifndef PokemonAutomation_Resources_SpritePack_H
+#define PokemonAutomation_Resources_SpritePack_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include "CommonFramework/ImageTypes/ImageViewRGB32.h"
+#include "CommonFramework/ImageTools/ImageBoxes.h"
+#include "CommonFramework/ImageTools/ImageStats.h"
+
+class QFile;
+
+namespace PokemonAutomation{
+
+
+struct SpritePackHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+
+    //  The files the pack was built from.
+    uint64_t image_file_size;
+    uint64_t json_file_size;
+    uint32_t image_file_crc32c;
+    uint32_t json_file_crc32c;
+
+    uint64_t entry_count;
+    uint64_t entries_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t pixels_offset;
+    uint64_t pixels_size;
+};
+static_assert(sizeof(SpritePackHeader) == 96);
+
+struct SpritePackEntry{
+    uint32_t slug_offset;   //  Into the string table.
+    uint32_t slug_size;
+    uint64_t pixels_offset; //  From the start of the file.
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytes_per_row;
+
+    //  The sprite with its transparent border trimmed. (trim_image_alpha_box())
+    uint32_t icon_min_x;
+    uint32_t icon_min_y;
+    uint32_t icon_max_x;
+    uint32_t icon_max_y;
+    uint32_t reserved;
+
+    //  image_stats() of the trimmed sprite.
+    double icon_average[3];
+    double icon_stddev[3];
+    uint64_t icon_count;
+};
+static_assert(sizeof(SpritePackEntry) == 104);
+
+
+
+class SpritePack{
+public:
+    static constexpr char MAGIC[8] = {'P', 'A', 'S', 'P', 'R', 'I', 'T', 'E'};
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    struct Entry{
+        std::string slug;
+        ImageViewRGB32 sprite;
+        ImagePixelBox icon;
+        ImageStats icon_stats;
+    };
+
+public:
+    ~SpritePack();
+    SpritePack(SpritePack&&) = delete;
+    void operator=(SpritePack&&) = delete;
+
+    //  Map the pack at "path". Throws FileException if it can't be opened or
+    //  if it isn't a valid pack.
+    SpritePack(const std::string& path);
+
+    //  Returns true if the pack was built from files with the same contents
+    //  as these. (same size and CRC32C)
+    bool built_from(const std::string& image_path, const std::string& json_path) const;
+
+    //  Sorted by slug. The sprites point into the mapping. So they are only
+    //  valid while this is alive.
+    const std::vector<Entry>& entries() const{ return m_entries; }
+
+    //  Write a pack of "entries" built from the specified files. The entries
+    //  don't need to be sorted. The old file at "path" is replaced in one
+    //  rename. So it is never seen half written.
+    static void write(
+        const std::string& path,
+        const std::string& image_path, const std::string& json_path,
+        const std::vector<Entry>& entries
+    );
+
+
+private:
+    std::unique_ptr<QFile> m_file;
+    uint64_t m_image_file_size = 0;
+    uint64_t m_json_file_size = 0;
+    uint32_t m_image_file_crc32c = 0;
+    uint32_t m_json_file_crc32c = 0;
+    std::vector<Entry> m_entries;
+};
+
+
+
+}
+#endif
@@ -0,0 +1,141 @@
+/*  Image Encode Service
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include "Common/Cpp/PanicDump.h"
+#include "CommonFramework/ImageTypes/ImageRGB32.h"
+#include "CommonFramework/Logging/Logger.h"
+#include "ImageEncodeService.h"
+
+namespace PokemonAutomation{
+
+
+struct ImageEncodeService::Job{
+    std::shared_ptr<const ImageRGB32> image;
+    std::string path;
+    std::promise<bool> promise;
+    std::shared_future<bool> future;
+};
+
+
+ImageEncodeService& ImageEncodeService::instance(){
+    //  The workers log failures. Make sure the logger outlives them.
+    global_logger_tagged();
+
+    static ImageEncodeService service(2, 16);
+    return service;
+}
+
+
+ImageEncodeService::ImageEncodeService(size_t threads, size_t max_pending)
+    : m_max_pending(max_pending == 0 ? 1 : max_pending)
+{
+    if (threads == 0){
+        threads = 1;
+    }
+    for (size_t c = 0; c < threads; c++){
+        m_threads.emplace_back(run_with_catch, "ImageEncodeService::thread_loop()", [this]{ thread_loop(); });
+    }
+}
+ImageEncodeService::~ImageEncodeService(){
+    stop();
+}
+void ImageEncodeService::stop(){
+    {
+        std::lock_guard<std::mutex> lg(m_lock);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    m_done_cv.notify_all();
+    for (std::thread& thread : m_threads){
+        if (thread.joinable()){
+            thread.join();
+        }
+    }
+}
+
+
+std::shared_future<bool> ImageEncodeService::save(std::shared_ptr<const ImageRGB32> image, std::string path){
+    std::shared_ptr<Job> job(new Job{std::move(image), std::move(path), {}, {}});
+    job->future = job->promise.get_future().share();
+
+    if (!job->image || !*job->image){
+        job->promise.set_value(false);
+        return job->future;
+    }
+
+    std::unique_lock<std::mutex> lg(m_lock);
+    m_done_cv.wait(lg, [this]{ return m_stopping || m_pending < m_max_pending; });
+    if (m_stopping){
+        lg.unlock();
+        global_logger_tagged().log("Image encoder is stopped. Not saving: " + job->path, COLOR_RED);
+        job->promise.set_value(false);
+        return job->future;
+    }
+    m_pending++;
+    m_pending_paths[job->path] = job;
+    m_queue.emplace_back(job);
+    m_cv.notify_one();
+    return job->future;
+}
+std::shared_future<bool> ImageEncodeService::save(const ImageViewRGB32& image, std::string path){
+    if (!image){
+        return save(std::shared_ptr<const ImageRGB32>(), std::move(path));
+    }
+    return save(std::make_shared<const ImageRGB32>(image.copy()), std::move(path));
+}
+std::shared_future<bool> ImageEncodeService::pending(const std::string& path) const{
+    std::lock_guard<std::mutex> lg(m_lock);
+    auto iter = m_pending_paths.find(path);
+    if (iter == m_pending_paths.end()){
+        return std::shared_future<bool>();
+    }
+    return iter->second->future;
+}
+void ImageEncodeService::wait_for_all(){
+    std::unique_lock<std::mutex> lg(m_lock);
+    m_done_cv.wait(lg, [this]{ return m_pending == 0; });
+}
+
+
+void ImageEncodeService::thread_loop(){
+    while (true){
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lg(m_lock);
+            m_cv.wait(lg, [this]{ return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()){
+                return;
+            }
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        bool ok = false;
+        try{
+            ok = job->image->save(job->path);
+        }catch (...){}
+        if (!ok){
+            global_logger_tagged().log("Unable to save image to: " + job->path, COLOR_RED);
+        }
+
+        //  Anyone who looks up the path after this will find the file already
+        //  written.
+        job->promise.set_value(ok);
+        {
+            std::lock_guard<std::mutex> lg(m_lock);
+            m_pending--;
+            auto iter = m_pending_paths.find(job->path);
+            if (iter != m_pending_paths.end() && iter->second == job){
+                m_pending_paths.erase(iter);
+            }
+        }
+        m_done_cv.notify_all();
+    }
+}
+
+
+
+}
@@ -0,0 +1,99 @@
+/*  Image Encode Service
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Save images to disk on a small pool of background threads.
+ *
+ *  Encoding a full screenshot to PNG takes 100+ ms. The error and debug
+ *  dumpers and the notification screenshots used to do it on the program
+ *  thread, which stalls inference right when something has gone wrong.
+ *
+ *  The image is passed in as a shared pointer so the caller can hand off a
+ *  video snapshot without copying it. The format is picked from the file
+ *  extension the same way as ImageViewRGB32::save().
+ *
+ */
+
+#ifndef PokemonAutomation_ImageEncodeService_H
+#define PokemonAutomation_ImageEncodeService_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <map>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace PokemonAutomation{
+
+class ImageRGB32;
+class ImageViewRGB32;
+
+
+class ImageEncodeService{
+public:
+    //  The service used by the dumpers and notifications.
+    static ImageEncodeService& instance();
+
+    //  At most "max_pending" images are queued or being encoded at once.
+    //  "save()" blocks when there are more than that.
+    ImageEncodeService(size_t threads, size_t max_pending);
+
+    //  Finishes everything that has been queued.
+    ~ImageEncodeService();
+
+    //  Queue "image" to be saved to "path". The future is true if the file
+    //  was written.
+    std::shared_future<bool> save(std::shared_ptr<const ImageRGB32> image, std::string path);
+
+    //  Same as above, but copies the image first. The copy is much cheaper
+    //  than encoding it.
+    std::shared_future<bool> save(const ImageViewRGB32& image, std::string path);
+
+    //  If "path" is queued or being written, return the future for it.
+    //  Otherwise return an empty future.
+    //
+    //  This lets code that is only given a path wait for the file.
+    std::shared_future<bool> pending(const std::string& path) const;
+
+    //  Wait until everything queued so far has been written.
+    void wait_for_all();
+
+    //  Finish everything that has been queued and join the threads. Images
+    //  saved after this are not written.
+    //
+    //  The encoders use QImage. So this must be called on the global instance
+    //  before QApplication is destroyed. The static destructor is too late.
+    void stop();
+
+
+private:
+    struct Job;
+
+    void thread_loop();
+
+
+private:
+    const size_t m_max_pending;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::condition_variable m_done_cv;
+    bool m_stopping = false;
+
+    std::deque<std::shared_ptr<Job>> m_queue;
+
+    //  Queued + being encoded.
+    size_t m_pending = 0;
+    std::map<std::string, std::shared_ptr<Job>> m_pending_paths;
+
+    std::vector<std::thread> m_threads;
+};
+
+
+
+}
+#endif
@@ -11,6 +11,7 @@
 #include "Common/Cpp/Concurrency/AsyncDispatcher.h"
 #include "ClientSource/Connection/BotBase.h"
 #include "CommonFramework/GlobalSettingsPanel.h"
+#include "CommonFramework/GlobalServices.h"
 #include "CommonFramework/Notifications/ProgramInfo.h"
 #include "CommonFramework/ProgramSession.h"
 #include "StatsTracking.h"
@@ -72,6 +73,9 @@ AsyncDispatcher& ProgramEnvironment::realtime_dispatcher(){
 AsyncDispatcher& ProgramEnvironment::inference_dispatcher(){
     return m_data->m_inference_dispatcher;
 }
+WorkStealingPool& ProgramEnvironment::compute_pool(){
+    return global_compute_pool();
+}
 
 
 void ProgramEnvironment::update_stats(){
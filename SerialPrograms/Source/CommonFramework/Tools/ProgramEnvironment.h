@@ -13,6 +13,7 @@
 namespace PokemonAutomation{
 
 class AsyncDispatcher;
+class WorkStealingPool;
 class StatsTracker;
 class ProgramSession;
 struct ProgramInfo;
@@ -42,8 +43,14 @@ public:
 public:
     //  Thread Pools
     AsyncDispatcher& realtime_dispatcher();
+
+    //  Runs the inference pivots and their callbacks. Tasks may block.
     AsyncDispatcher& inference_dispatcher();
 
+    //  Fixed-size pool for short, non-blocking compute kernels only.
+    //  This is shared with all other running programs.
+    WorkStealingPool& compute_pool();
+
 public:
     //  Stats Management
 
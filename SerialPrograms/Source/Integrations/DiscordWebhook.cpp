@@ -59,15 +59,20 @@ void DiscordWebhookSender::send_json(
     std::shared_ptr<PendingFileSend> file
 ){
     cleanup_stuck_requests();
+    QByteArray data = QByteArray::fromStdString(obj.dump());
+    QByteArray data_without_file = file
+        ? QByteArray::fromStdString(drop_embed_images(obj).dump())
+        : data;
     m_queue.add_event(
         delay,
-        [this, url, data = QByteArray::fromStdString(obj.dump()), file = std::move(file)]{
+        [this, url, data = std::move(data), data_without_file = std::move(data_without_file), file = std::move(file)]{
             throttle();
-            if (!file && !data.isEmpty()){
-                internal_send_json(url, data);
-            }else if (file && !data.isEmpty()){
+            bool has_file = file && file->wait_until_saved();
+            if (!has_file && !data_without_file.isEmpty()){
+                internal_send_json(url, data_without_file);
+            }else if (has_file && !data.isEmpty()){
                 internal_send_image_embed(url, data, file->filepath(), file->filename());
-            }else{
+            }else if (has_file){
                 internal_send_file(url, file->filepath());
             }
         }
@@ -86,7 +91,9 @@ void DiscordWebhookSender::send_file(
         delay,
         [this, url, file = std::move(file)]{
             throttle();
-            internal_send_file(url, file->filepath());
+            if (file->wait_until_saved()){
+                internal_send_file(url, file->filepath());
+            }
         }
     );
     logger.log("Scheduling Webhook Message... (queue = " + tostr_u_commas(m_queue.size()) + ")", COLOR_PURPLE);
@@ -83,12 +83,15 @@ void Client::send_embed_dpp(
     }
 
 
+    //  Handler::send_message() sets the image itself once the attachment
+    //  has been saved. So it must not come from the JSON.
+    JsonObject stripped = drop_embed_image(json_obj);
     embed embed;
     {
-        embed.set_title(*json_obj.get_string("title"));
+        embed.set_title(*stripped.get_string("title"));
         embed.set_color((int)((uint32_t)color & 0xffffff));
 
-        auto fields = json_obj.get_array("fields");
+        auto fields = stripped.get_array("fields");
         for (auto& field : *fields){
             auto obj = field.get_object();
             embed.add_field(*obj->get_string("name"), *obj->get_string("value"));
@@ -96,7 +96,7 @@ void Handler::send_message(cluster& bot, embed& embed, const std::string& channe
     Handler::m_queue.add_event(delay > std::chrono::milliseconds(10000) ? std::chrono::milliseconds(0) : delay,
     [&bot, this, embed = std::move(embed), channel = channel, msg = msg, file = std::move(file)]() mutable {
         message m;
-        if (file != nullptr && !file->filepath().empty() && !file->filename().empty()){
+        if (file != nullptr && !file->filename().empty() && file->wait_until_saved()){
             std::string data;
             std::string path = file->filepath();
             try{
@@ -125,7 +125,7 @@ void Handler::send_message(cluster& bot, embed& embed, const std::string& channe
 
 void Handler::update_response(const dpp::command_source& src, dpp::embed& embed, const std::string& msg, std::shared_ptr<PendingFileSend> file){
     message m;
-    if (file != nullptr && !file->filepath().empty() && !file->filename().empty()){
+    if (file != nullptr && !file->filename().empty() && file->wait_until_saved()){
         std::string data;
         try{
             data = utility::read_file(file->filepath());
@@ -140,8 +140,10 @@ public:
         return sender;
     }
 
+    //  "embed_without_file" is sent instead of "embed" if the file fails to save.
     void send(
         std::string embed,
+        std::string embed_without_file,
         std::string channels,
         std::chrono::milliseconds delay,
         std::string messages,
@@ -150,9 +152,9 @@ public:
 //        std::lock_guard<std::mutex> lg(m_lock);
         m_queue.add_event(
             delay > std::chrono::milliseconds(10000) ? std::chrono::milliseconds(0) : delay,
-            [embed = std::move(embed), channels = std::move(channels), messages = std::move(messages), file = std::move(file)]() mutable {
-                if (file == nullptr || file->filepath().empty()){
-                    sendMessage(&channels[0], &messages[0], &embed[0], nullptr);
+            [embed = std::move(embed), embed_without_file = std::move(embed_without_file), channels = std::move(channels), messages = std::move(messages), file = std::move(file)]() mutable {
+                if (file == nullptr || !file->wait_until_saved()){
+                    sendMessage(&channels[0], &messages[0], &embed_without_file[0], nullptr);
                 }else{
                     std::string filepath = file->filepath();
                     sendMessage(&channels[0], &messages[0], &embed[0], &filepath[0]);
@@ -228,6 +230,7 @@ public:
 public:
     void send(
         std::string embed,
+        std::string embed_without_file,
         std::string channels,
         std::chrono::milliseconds delay,
         std::string messages,
@@ -238,7 +241,7 @@ public:
 //                cout << "Sending: " << file->filepath().toStdString() << endl;
                 m_active_list.emplace(file->filepath(), file);
             }
-            SleepyDiscordSender::instance().send(embed, channels, delay, messages, std::move(file));
+            SleepyDiscordSender::instance().send(embed, embed_without_file, channels, delay, messages, std::move(file));
         }else{
             sleepy_logger().log("SleepyDiscordClient::send(): Not connected.", COLOR_RED);
         }
@@ -345,7 +348,7 @@ private:
         if ((int)request <= 11){
             program_response(request, channel, &message[0], &filename[0]);
         }else{
-            send("", channel, std::chrono::milliseconds(0), &message[0], std::move(file));
+            send("", "", channel, std::chrono::milliseconds(0), &message[0], std::move(file));
         }
     }
 
@@ -542,6 +545,13 @@ void send_embed_sleepy(
     MessageBuilder builder(tags);
     const DiscordIntegrationTable& channels = settings.integration.channels;
 
+    //  The image refers to the attachment. Leave it out if that fails to save.
+    std::string embed_json = embed.dump();
+    std::string embed_without_file = embed_json;
+    if (file){
+        embed_without_file = drop_embed_image(embed).dump();
+    }
+
     std::vector<std::unique_ptr<DiscordIntegrationChannel>> table = channels.copy_snapshot();
     for (size_t i = 0; i < table.size(); i++){
         const Integration::DiscordIntegrationChannel& channel = *table[i];
@@ -555,7 +565,8 @@ void send_embed_sleepy(
         sleepy_logger().log("send_message_sleepy(): Sending...", COLOR_PURPLE);
         std::chrono::seconds delay(channel.delay);
         m_sleepy_client->send(
-            embed.dump(),
+            embed_json,
+            embed_without_file,
             channel.channel_id,
             std::chrono::seconds(delay),
             builder.build_message(
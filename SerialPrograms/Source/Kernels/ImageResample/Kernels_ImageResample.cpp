@@ -0,0 +1,244 @@
+/*  Image Resample
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <tuple>
+#include <map>
+#include <mutex>
+#include "Common/Cpp/Exceptions.h"
+#include "Common/Cpp/CpuId/CpuId.h"
+#include "Kernels_ImageResample.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+
+ResampleAxis::ResampleAxis(ResampleFilter p_filter, size_t p_src, size_t p_dst)
+    : filter(p_filter)
+    , src(p_src)
+    , dst(p_dst)
+    , taps(0)
+{
+    if (src == 0 || dst == 0 || src > 0xffffffff){
+        throw InternalProgramError(
+            nullptr, PA_CURRENT_FUNCTION,
+            "Invalid dimensions: " + std::to_string(src) + " -> " + std::to_string(dst)
+        );
+    }
+
+    const int32_t ONE = (int32_t)1 << WEIGHT_BITS;
+    start.resize(dst);
+
+    switch (filter){
+    case ResampleFilter::NEAREST:
+        taps = 1;
+        weights.resize(dst, (int16_t)ONE);
+        for (size_t c = 0; c < dst; c++){
+            start[c] = (uint32_t)((2*c + 1) * src / (2*dst));
+        }
+        return;
+
+    case ResampleFilter::AREA:{
+        //  Work in units of 1/dst input pixels. Then output "c" covers
+        //  [c*src, (c+1)*src) and input "k" covers [k*dst, (k+1)*dst).
+        //  The widest output touches ceil(src/dst) + 1 inputs.
+        taps = (src + dst - 1) / dst + 1;
+        taps = (taps + 3) & ~(size_t)3;
+        weights.resize(dst * taps, 0);
+
+        std::vector<uint64_t> remainders(taps);
+        std::vector<size_t> order(taps);
+        for (size_t c = 0; c < dst; c++){
+            uint64_t lo = (uint64_t)c * src;
+            uint64_t hi = lo + src;
+            size_t first = (size_t)(lo / dst);
+            size_t last = (size_t)((hi - 1) / dst);
+            size_t count = last - first + 1;
+            start[c] = (uint32_t)first;
+
+            //  Round the weights so that they sum to exactly "ONE". Everything
+            //  is rounded down first. The remaining units go to the taps with
+            //  the largest remainders.
+            int16_t* w = &weights[c * taps];
+            int32_t sum = 0;
+            for (size_t t = 0; t < count; t++){
+                uint64_t k = first + t;
+                uint64_t overlap = std::min(hi, (k + 1) * dst) - std::max(lo, k * dst);
+                uint64_t scaled = overlap << WEIGHT_BITS;
+                w[t] = (int16_t)(scaled / src);
+                remainders[t] = scaled % src;
+                order[t] = t;
+                sum += w[t];
+            }
+            std::stable_sort(
+                order.begin(), order.begin() + count,
+                [&](size_t a, size_t b){ return remainders[a] > remainders[b]; }
+            );
+            for (size_t t = 0; sum < ONE; t++, sum++){
+                w[order[t]]++;
+            }
+        }
+        return;
+    }
+
+    case ResampleFilter::BILINEAR:
+        taps = 4;
+        weights.resize(dst * taps, 0);
+        for (size_t c = 0; c < dst; c++){
+            //  The center of output "c" is at input "(num / den)".
+            int64_t num = (int64_t)(2*c + 1) * (int64_t)src - (int64_t)dst;
+            int64_t den = (int64_t)2 * dst;
+            int64_t k = 0;
+            int64_t frac = 0;
+            if (num > 0){
+                k = num / den;
+                frac = num % den;
+            }
+            if (k >= (int64_t)src - 1){
+                k = (int64_t)src - 1;
+                frac = 0;
+            }
+            int32_t w1 = (int32_t)(((frac << WEIGHT_BITS) + den / 2) / den);
+            start[c] = (uint32_t)k;
+            weights[c * taps + 0] = (int16_t)(ONE - w1);
+            weights[c * taps + 1] = (int16_t)w1;
+        }
+        return;
+    }
+
+    throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Invalid filter: " + std::to_string((int)filter));
+}
+
+
+
+std::shared_ptr<const ResampleAxis> resample_axis(ResampleFilter filter, size_t src, size_t dst){
+    //  Resizing usually alternates between the same 2 axes. So remember the
+    //  last 2 per thread to avoid locking.
+    thread_local std::shared_ptr<const ResampleAxis> recent[2];
+    for (const std::shared_ptr<const ResampleAxis>& axis : recent){
+        if (axis && axis->filter == filter && axis->src == src && axis->dst == dst){
+            return axis;
+        }
+    }
+
+    static std::mutex lock;
+    static std::map<std::tuple<ResampleFilter, size_t, size_t>, std::shared_ptr<const ResampleAxis>> cache;
+
+    std::shared_ptr<const ResampleAxis> ret;
+    {
+        std::lock_guard<std::mutex> lg(lock);
+        auto iter = cache.find({filter, src, dst});
+        if (iter != cache.end()){
+            ret = iter->second;
+        }
+    }
+    if (!ret){
+        ret = std::make_shared<ResampleAxis>(filter, src, dst);
+        std::lock_guard<std::mutex> lg(lock);
+        if (cache.size() >= 1024){
+            cache.clear();
+        }
+        ret = cache.emplace(std::make_tuple(filter, src, dst), ret).first->second;
+    }
+
+    recent[1] = std::move(recent[0]);
+    recent[0] = ret;
+    return ret;
+}
+
+
+
+void resample_nearest_Default(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row
+);
+void resample_Default(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row,
+    uint16_t* buffer
+);
+void resample_x64_AVX2(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row,
+    uint16_t* buffer
+);
+void resample_x64_AVX512(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row,
+    uint16_t* buffer
+);
+void resample_arm64_NEON(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row,
+    uint16_t* buffer
+);
+
+
+
+void resample(
+    const uint32_t* in, size_t in_bytes_per_row, size_t in_width, size_t in_height,
+    uint32_t* out, size_t out_bytes_per_row, size_t out_width, size_t out_height,
+    ResampleFilter filter
+){
+    if (in_width == 0 || in_height == 0 || out_width == 0 || out_height == 0){
+        return;
+    }
+    if (in_width == out_width && in_height == out_height){
+        for (size_t r = 0; r < out_height; r++){
+            memcpy(out, in, out_width * sizeof(uint32_t));
+            in = (const uint32_t*)((const char*)in + in_bytes_per_row);
+            out = (uint32_t*)((char*)out + out_bytes_per_row);
+        }
+        return;
+    }
+
+    std::shared_ptr<const ResampleAxis> x = resample_axis(filter, in_width, out_width);
+    std::shared_ptr<const ResampleAxis> y = resample_axis(filter, in_height, out_height);
+
+    if (filter == ResampleFilter::NEAREST){
+        resample_nearest_Default(*x, *y, in, in_bytes_per_row, out, out_bytes_per_row);
+        return;
+    }
+
+    //  One row of the vertical pass. 4 channels per pixel. The horizontal taps
+    //  may read up to "x->taps" pixels past the end. Those need to be zero.
+    thread_local std::vector<uint16_t> buffer;
+    size_t used = 4 * in_width;
+    buffer.resize(used + 4 * x->taps);
+    std::fill(buffer.begin() + used, buffer.end(), (uint16_t)0);
+
+#ifdef PA_AutoDispatch_x64_17_Skylake
+    if (CPU_CAPABILITY_CURRENT.OK_17_Skylake){
+        resample_x64_AVX512(*x, *y, in, in_bytes_per_row, out, out_bytes_per_row, buffer.data());
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_13_Haswell
+    if (CPU_CAPABILITY_CURRENT.OK_13_Haswell){
+        resample_x64_AVX2(*x, *y, in, in_bytes_per_row, out, out_bytes_per_row, buffer.data());
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_arm64_20_M1
+    if (CPU_CAPABILITY_CURRENT.OK_M1){
+        resample_arm64_NEON(*x, *y, in, in_bytes_per_row, out, out_bytes_per_row, buffer.data());
+        return;
+    }
+#endif
+    resample_Default(*x, *y, in, in_bytes_per_row, out, out_bytes_per_row, buffer.data());
+}
+
+
+
+}
+}
@@ -0,0 +1,92 @@
+/*  Image Resample
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Resize an ARGB32 image into a caller-provided buffer.
+ *
+ *  The filters are separable. Each axis has a table of taps that depends only
+ *  on (source length, destination length, filter). These are computed once
+ *  and cached.
+ *
+ *  All the arithmetic is integer fixed-point. So every instruction set gives
+ *  bit-identical results. The 4 channels are filtered independently. (alpha
+ *  is not premultiplied)
+ *
+ */
+
+#ifndef PokemonAutomation_Kernels_ImageResample_H
+#define PokemonAutomation_Kernels_ImageResample_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+enum class ResampleFilter{
+    //  Nearest pixel center. This is what "QImage::scaled()" does by default.
+    NEAREST,
+
+    //  Box filter. Each output pixel is the average of the input pixels it
+    //  covers, weighted by how much of each it covers.
+    AREA,
+
+    //  Linear interpolation between the 2 nearest pixel centers.
+    //  This aliases when shrinking by more than 2x. Use AREA for that.
+    BILINEAR,
+};
+
+
+//  Filter taps for one axis.
+//
+//  Output "i" is the sum over "t" of "weights[i*taps + t]" times input
+//  "start[i] + t". The weights of each output are non-negative and sum to
+//  exactly (1 << WEIGHT_BITS).
+//
+//  For AREA and BILINEAR, "taps" is padded up to a multiple of 4 with zero
+//  weights. These padding taps may point past the end of the input.
+//
+//  For NEAREST, "taps" is 1 and "start" is the sampling map.
+//
+struct ResampleAxis{
+    static constexpr size_t WEIGHT_BITS = 14;
+
+    ResampleFilter filter;
+    size_t src;
+    size_t dst;
+    size_t taps;
+    std::vector<uint32_t> start;
+    std::vector<int16_t> weights;
+
+    ResampleAxis(ResampleFilter filter, size_t src, size_t dst);
+
+    //  # of taps of output "index" up to the last non-zero weight.
+    //  These are always inside the input.
+    size_t active_taps(size_t index) const{
+        const int16_t* w = &weights[index * taps];
+        size_t ret = taps;
+        while (ret > 0 && w[ret - 1] == 0){
+            ret--;
+        }
+        return ret;
+    }
+};
+
+//  Returns the taps for resizing an axis from "src" to "dst" pixels.
+std::shared_ptr<const ResampleAxis> resample_axis(ResampleFilter filter, size_t src, size_t dst);
+
+
+//  Resize "in" to the dimensions of "out". The buffers must not overlap.
+void resample(
+    const uint32_t* in, size_t in_bytes_per_row, size_t in_width, size_t in_height,
+    uint32_t* out, size_t out_bytes_per_row, size_t out_width, size_t out_height,
+    ResampleFilter filter
+);
+
+
+}
+}
+#endif
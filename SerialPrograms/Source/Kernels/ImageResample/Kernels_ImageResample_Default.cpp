@@ -0,0 +1,101 @@
+/*  Image Resample (Default)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *  The vertical pass is done first into a row of 16-bit channels with 7 bits
+ *  of fraction. Then the horizontal pass reduces that row to the output.
+ *  The SIMD versions must match this exactly.
+ *
+ */
+
+#include <stdint.h>
+#include "Common/Compiler.h"
+#include "Kernels_ImageResample.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+void resample_nearest_Default(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row
+){
+    const uint32_t* cols = x.start.data();
+    for (size_t r = 0; r < y.dst; r++){
+        const uint32_t* row = (const uint32_t*)((const char*)in + y.start[r] * in_bytes_per_row);
+        for (size_t c = 0; c < x.dst; c++){
+            out[c] = row[cols[c]];
+        }
+        out = (uint32_t*)((char*)out + out_bytes_per_row);
+    }
+}
+
+
+
+PA_FORCE_INLINE void resample_vertical_Default(
+    uint16_t* buffer, size_t width,
+    const ResampleAxis& y, size_t r,
+    const uint32_t* in, size_t in_bytes_per_row
+){
+    const int16_t* weights = &y.weights[r * y.taps];
+    size_t taps = y.active_taps(r);
+    const uint8_t* first = (const uint8_t*)in + y.start[r] * in_bytes_per_row;
+
+    const size_t channels = 4 * width;
+    for (size_t c = 0; c < channels; c++){
+        const uint8_t* row = first + c;
+        uint32_t sum = 0;
+        for (size_t t = 0; t < taps; t++){
+            sum += (uint32_t)row[0] * (uint32_t)weights[t];
+            row += in_bytes_per_row;
+        }
+        buffer[c] = (uint16_t)((sum + 64) >> 7);
+    }
+}
+PA_FORCE_INLINE void resample_horizontal_Default(
+    uint32_t* out,
+    const ResampleAxis& x,
+    const uint16_t* buffer
+){
+    for (size_t c = 0; c < x.dst; c++){
+        const int16_t* weights = &x.weights[c * x.taps];
+        const uint16_t* pixels = buffer + 4 * (size_t)x.start[c];
+        uint32_t sum0 = 0;
+        uint32_t sum1 = 0;
+        uint32_t sum2 = 0;
+        uint32_t sum3 = 0;
+        for (size_t t = 0; t < x.taps; t++){
+            uint32_t w = (uint32_t)weights[t];
+            sum0 += pixels[4*t + 0] * w;
+            sum1 += pixels[4*t + 1] * w;
+            sum2 += pixels[4*t + 2] * w;
+            sum3 += pixels[4*t + 3] * w;
+        }
+        const uint32_t ROUND = (uint32_t)1 << 20;
+        uint32_t pixel = 0;
+        pixel |= ((sum0 + ROUND) >> 21) <<  0;
+        pixel |= ((sum1 + ROUND) >> 21) <<  8;
+        pixel |= ((sum2 + ROUND) >> 21) << 16;
+        pixel |= ((sum3 + ROUND) >> 21) << 24;
+        out[c] = pixel;
+    }
+}
+
+void resample_Default(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row,
+    uint16_t* buffer
+){
+    for (size_t r = 0; r < y.dst; r++){
+        resample_vertical_Default(buffer, x.src, y, r, in, in_bytes_per_row);
+        resample_horizontal_Default(out, x, buffer);
+        out = (uint32_t*)((char*)out + out_bytes_per_row);
+    }
+}
+
+
+
+}
+}
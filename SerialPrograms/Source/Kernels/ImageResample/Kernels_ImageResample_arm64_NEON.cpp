@@ -0,0 +1,113 @@
+/*  Image Resample (arm64 NEON)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_arm64_20_M1
+
+#include <stdint.h>
+#include <arm_neon.h>
+#include "Common/Compiler.h"
+#include "Kernels_ImageResample.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+//  Must match "resample_vertical_Default()".
+PA_FORCE_INLINE void resample_vertical_arm64_NEON(
+    uint16_t* buffer, size_t width,
+    const ResampleAxis& y, size_t r,
+    const uint32_t* in, size_t in_bytes_per_row
+){
+    const int16_t* weights = &y.weights[r * y.taps];
+    size_t taps = y.active_taps(r);
+    const uint8_t* first = (const uint8_t*)in + y.start[r] * in_bytes_per_row;
+
+    //  16 channels (4 pixels) at a time.
+    const size_t channels = 4 * width;
+    size_t c = 0;
+    for (; c + 16 <= channels; c += 16){
+        const uint8_t* row = first + c;
+        uint32x4_t acc0 = vdupq_n_u32(0);
+        uint32x4_t acc1 = vdupq_n_u32(0);
+        uint32x4_t acc2 = vdupq_n_u32(0);
+        uint32x4_t acc3 = vdupq_n_u32(0);
+        for (size_t t = 0; t < taps; t++){
+            uint8x16_t v = vld1q_u8(row);
+            uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+            uint16x8_t hi = vmovl_high_u8(v);
+            uint16_t w = (uint16_t)weights[t];
+            acc0 = vmlal_n_u16(acc0, vget_low_u16(lo), w);
+            acc1 = vmlal_high_n_u16(acc1, lo, w);
+            acc2 = vmlal_n_u16(acc2, vget_low_u16(hi), w);
+            acc3 = vmlal_high_n_u16(acc3, hi, w);
+            row += in_bytes_per_row;
+        }
+
+        //  Rounding shift: (x + 64) >> 7
+        uint16x8_t out0 = vcombine_u16(vmovn_u32(vrshrq_n_u32(acc0, 7)), vmovn_u32(vrshrq_n_u32(acc1, 7)));
+        uint16x8_t out1 = vcombine_u16(vmovn_u32(vrshrq_n_u32(acc2, 7)), vmovn_u32(vrshrq_n_u32(acc3, 7)));
+        vst1q_u16(buffer + c + 0, out0);
+        vst1q_u16(buffer + c + 8, out1);
+    }
+    for (; c < channels; c++){
+        const uint8_t* row = first + c;
+        uint32_t sum = 0;
+        for (size_t t = 0; t < taps; t++){
+            sum += (uint32_t)row[0] * (uint32_t)weights[t];
+            row += in_bytes_per_row;
+        }
+        buffer[c] = (uint16_t)((sum + 64) >> 7);
+    }
+}
+
+
+//  Must match "resample_horizontal_Default()".
+PA_FORCE_INLINE void resample_horizontal_arm64_NEON(
+    uint32_t* out,
+    const ResampleAxis& x,
+    const uint16_t* buffer
+){
+    for (size_t c = 0; c < x.dst; c++){
+        const int16_t* weights = &x.weights[c * x.taps];
+        const uint16_t* pixels = buffer + 4 * (size_t)x.start[c];
+        uint32x4_t acc0 = vdupq_n_u32(0);
+        uint32x4_t acc1 = vdupq_n_u32(0);
+        for (size_t t = 0; t < x.taps; t += 4){
+            uint16x8_t p01 = vld1q_u16(pixels + 4*t + 0);
+            uint16x8_t p23 = vld1q_u16(pixels + 4*t + 8);
+            uint16x4_t w = vreinterpret_u16_s16(vld1_s16(weights + t));
+            acc0 = vmlal_lane_u16(acc0, vget_low_u16(p01), w, 0);
+            acc1 = vmlal_lane_u16(acc1, vget_high_u16(p01), w, 1);
+            acc0 = vmlal_lane_u16(acc0, vget_low_u16(p23), w, 2);
+            acc1 = vmlal_lane_u16(acc1, vget_high_u16(p23), w, 3);
+        }
+
+        //  Rounding shift: (x + 2^20) >> 21
+        uint32x4_t sum = vrshrq_n_u32(vaddq_u32(acc0, acc1), 21);
+        uint8x8_t pixel = vmovn_u16(vcombine_u16(vmovn_u32(sum), vdup_n_u16(0)));
+        out[c] = vget_lane_u32(vreinterpret_u32_u8(pixel), 0);
+    }
+}
+
+
+void resample_arm64_NEON(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row,
+    uint16_t* buffer
+){
+    for (size_t r = 0; r < y.dst; r++){
+        resample_vertical_arm64_NEON(buffer, x.src, y, r, in, in_bytes_per_row);
+        resample_horizontal_arm64_NEON(out, x, buffer);
+        out = (uint32_t*)((char*)out + out_bytes_per_row);
+    }
+}
+
+
+
+}
+}
+#endif
@@ -0,0 +1,133 @@
+/*  Image Resample (x64 AVX2)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_x64_13_Haswell
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "Common/Compiler.h"
+#include "Kernels_ImageResample.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+//  Must match "resample_vertical_Default()".
+PA_FORCE_INLINE void resample_vertical_x64_AVX2(
+    uint16_t* buffer, size_t width,
+    const ResampleAxis& y, size_t r,
+    const uint32_t* in, size_t in_bytes_per_row
+){
+    const int16_t* weights = &y.weights[r * y.taps];
+    size_t taps = y.active_taps(r);
+    const uint8_t* first = (const uint8_t*)in + y.start[r] * in_bytes_per_row;
+
+    const __m256i round = _mm256_set1_epi32(64);
+
+    //  16 channels (4 pixels) at a time. Rows are multiplied in pairs by
+    //  interleaving them and using "madd".
+    const size_t channels = 4 * width;
+    size_t c = 0;
+    for (; c + 16 <= channels; c += 16){
+        const uint8_t* row = first + c;
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        size_t t = 0;
+        for (; t + 1 < taps; t += 2){
+            __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)row));
+            __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row + in_bytes_per_row)));
+            __m256i w = _mm256_set1_epi32(
+                (uint32_t)(uint16_t)weights[t] | ((uint32_t)(uint16_t)weights[t + 1] << 16)
+            );
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+            row += 2 * in_bytes_per_row;
+        }
+        if (t < taps){
+            __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)row));
+            __m256i w = _mm256_set1_epi32((uint32_t)(uint16_t)weights[t]);
+            __m256i z = _mm256_setzero_si256();
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, z), w));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, z), w));
+        }
+        acc0 = _mm256_srli_epi32(_mm256_add_epi32(acc0, round), 7);
+        acc1 = _mm256_srli_epi32(_mm256_add_epi32(acc1, round), 7);
+
+        //  This undoes the interleaving from the unpacks.
+        _mm256_storeu_si256((__m256i*)(buffer + c), _mm256_packus_epi32(acc0, acc1));
+    }
+    for (; c < channels; c++){
+        const uint8_t* row = first + c;
+        uint32_t sum = 0;
+        for (size_t t = 0; t < taps; t++){
+            sum += (uint32_t)row[0] * (uint32_t)weights[t];
+            row += in_bytes_per_row;
+        }
+        buffer[c] = (uint16_t)((sum + 64) >> 7);
+    }
+}
+
+
+//  Sum of 4 taps for one output pixel. The result is split across the 2 lanes.
+PA_FORCE_INLINE __m256i resample_horizontal_4taps_x64_AVX2(
+    const uint16_t* pixels, const int16_t* weights
+){
+    //  Interleave the channels of adjacent pixels within each lane.
+    const __m256i INTERLEAVE = _mm256_setr_epi8(
+        0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15,
+        0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15
+    );
+
+    __m256i p = _mm256_loadu_si256((const __m256i*)pixels);
+    p = _mm256_shuffle_epi8(p, INTERLEAVE);
+
+    __m256i w = _mm256_castsi128_si256(_mm_loadl_epi64((const __m128i*)weights));
+    w = _mm256_permutevar8x32_epi32(w, _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1));
+
+    return _mm256_madd_epi16(p, w);
+}
+
+//  Must match "resample_horizontal_Default()".
+PA_FORCE_INLINE void resample_horizontal_x64_AVX2(
+    uint32_t* out,
+    const ResampleAxis& x,
+    const uint16_t* buffer
+){
+    const __m128i round = _mm_set1_epi32(1 << 20);
+    for (size_t c = 0; c < x.dst; c++){
+        const int16_t* weights = &x.weights[c * x.taps];
+        const uint16_t* pixels = buffer + 4 * (size_t)x.start[c];
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t t = 0; t < x.taps; t += 4){
+            acc = _mm256_add_epi32(acc, resample_horizontal_4taps_x64_AVX2(pixels + 4*t, weights + t));
+        }
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum = _mm_srli_epi32(_mm_add_epi32(sum, round), 21);
+        sum = _mm_packus_epi32(sum, sum);
+        sum = _mm_packus_epi16(sum, sum);
+        out[c] = _mm_cvtsi128_si32(sum);
+    }
+}
+
+
+void resample_x64_AVX2(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row,
+    uint16_t* buffer
+){
+    for (size_t r = 0; r < y.dst; r++){
+        resample_vertical_x64_AVX2(buffer, x.src, y, r, in, in_bytes_per_row);
+        resample_horizontal_x64_AVX2(out, x, buffer);
+        out = (uint32_t*)((char*)out + out_bytes_per_row);
+    }
+}
+
+
+
+}
+}
+#endif
@@ -0,0 +1,164 @@
+/*  Image Resample (x64 AVX512)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_x64_17_Skylake
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "Common/Compiler.h"
+#include "Kernels_ImageResample.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+//  32 channels (8 pixels) of the vertical pass. "mask" selects which of them
+//  are read and written.
+PA_FORCE_INLINE void resample_vertical_x64_AVX512(
+    uint16_t* buffer, const uint8_t* row, size_t in_bytes_per_row,
+    const int16_t* weights, size_t taps,
+    __mmask32 mask
+){
+    __m512i acc0 = _mm512_setzero_si512();
+    __m512i acc1 = _mm512_setzero_si512();
+    size_t t = 0;
+    for (; t + 1 < taps; t += 2){
+        __m512i a = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, row));
+        __m512i b = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, row + in_bytes_per_row));
+        __m512i w = _mm512_set1_epi32(
+            (uint32_t)(uint16_t)weights[t] | ((uint32_t)(uint16_t)weights[t + 1] << 16)
+        );
+        acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(_mm512_unpacklo_epi16(a, b), w));
+        acc1 = _mm512_add_epi32(acc1, _mm512_madd_epi16(_mm512_unpackhi_epi16(a, b), w));
+        row += 2 * in_bytes_per_row;
+    }
+    if (t < taps){
+        __m512i a = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, row));
+        __m512i w = _mm512_set1_epi32((uint32_t)(uint16_t)weights[t]);
+        __m512i z = _mm512_setzero_si512();
+        acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(_mm512_unpacklo_epi16(a, z), w));
+        acc1 = _mm512_add_epi32(acc1, _mm512_madd_epi16(_mm512_unpackhi_epi16(a, z), w));
+    }
+    const __m512i round = _mm512_set1_epi32(64);
+    acc0 = _mm512_srli_epi32(_mm512_add_epi32(acc0, round), 7);
+    acc1 = _mm512_srli_epi32(_mm512_add_epi32(acc1, round), 7);
+
+    //  This undoes the interleaving from the unpacks.
+    _mm512_mask_storeu_epi16(buffer, mask, _mm512_packus_epi32(acc0, acc1));
+}
+
+//  Must match "resample_vertical_Default()".
+PA_FORCE_INLINE void resample_vertical_x64_AVX512(
+    uint16_t* buffer, size_t width,
+    const ResampleAxis& y, size_t r,
+    const uint32_t* in, size_t in_bytes_per_row
+){
+    const int16_t* weights = &y.weights[r * y.taps];
+    size_t taps = y.active_taps(r);
+    const uint8_t* first = (const uint8_t*)in + y.start[r] * in_bytes_per_row;
+
+    const size_t channels = 4 * width;
+    size_t c = 0;
+    for (; c + 32 <= channels; c += 32){
+        resample_vertical_x64_AVX512(buffer + c, first + c, in_bytes_per_row, weights, taps, 0xffffffff);
+    }
+    size_t left = channels - c;
+    if (left > 0){
+        __mmask32 mask = ((uint32_t)1 << left) - 1;
+        resample_vertical_x64_AVX512(buffer + c, first + c, in_bytes_per_row, weights, taps, mask);
+    }
+}
+
+
+//  Sum of 4 taps each for 2 output pixels. The first pixel is split across
+//  lanes 0 and 1. The second is split across lanes 2 and 3.
+PA_FORCE_INLINE __m512i resample_horizontal_4taps_x64_AVX512(
+    const uint16_t* pixels0, const int16_t* weights0,
+    const uint16_t* pixels1, const int16_t* weights1
+){
+    //  Interleave the channels of adjacent pixels within each lane.
+    const __m512i INTERLEAVE = _mm512_broadcast_i32x4(_mm_setr_epi8(
+        0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15
+    ));
+
+    __m512i p = _mm512_castsi256_si512(_mm256_loadu_si256((const __m256i*)pixels0));
+    p = _mm512_inserti64x4(p, _mm256_loadu_si256((const __m256i*)pixels1), 1);
+    p = _mm512_shuffle_epi8(p, INTERLEAVE);
+
+    __m128i w4 = _mm_unpacklo_epi64(
+        _mm_loadl_epi64((const __m128i*)weights0),
+        _mm_loadl_epi64((const __m128i*)weights1)
+    );
+    __m512i w = _mm512_permutexvar_epi32(
+        _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3),
+        _mm512_castsi128_si512(w4)
+    );
+
+    return _mm512_madd_epi16(p, w);
+}
+
+//  Must match "resample_horizontal_Default()".
+PA_FORCE_INLINE void resample_horizontal_x64_AVX512(
+    uint32_t* out,
+    const ResampleAxis& x,
+    const uint16_t* buffer
+){
+    const __m256i round = _mm256_set1_epi32(1 << 20);
+
+    //  Odd # of outputs: Duplicate the last one.
+    for (size_t c = 0; c < x.dst; c += 2){
+        size_t c1 = c + 1 < x.dst ? c + 1 : c;
+        const int16_t* weights0 = &x.weights[c * x.taps];
+        const int16_t* weights1 = &x.weights[c1 * x.taps];
+        const uint16_t* pixels0 = buffer + 4 * (size_t)x.start[c];
+        const uint16_t* pixels1 = buffer + 4 * (size_t)x.start[c1];
+        __m512i acc = _mm512_setzero_si512();
+        for (size_t t = 0; t < x.taps; t += 4){
+            acc = _mm512_add_epi32(
+                acc,
+                resample_horizontal_4taps_x64_AVX512(
+                    pixels0 + 4*t, weights0 + t,
+                    pixels1 + 4*t, weights1 + t
+                )
+            );
+        }
+        //  [pixel 0 part 0, pixel 0 part 1, pixel 1 part 0, pixel 1 part 1]
+        //  ->  [pixel 0, pixel 1]
+        __m256i lo = _mm512_castsi512_si256(acc);
+        __m256i hi = _mm512_extracti64x4_epi64(acc, 1);
+        __m256i sum2 = _mm256_add_epi32(
+            _mm256_permute2x128_si256(lo, hi, 0x20),
+            _mm256_permute2x128_si256(lo, hi, 0x31)
+        );
+        sum2 = _mm256_srli_epi32(_mm256_add_epi32(sum2, round), 21);
+        __m128i sum = _mm_packus_epi32(_mm256_castsi256_si128(sum2), _mm256_extracti128_si256(sum2, 1));
+        sum = _mm_packus_epi16(sum, sum);
+        out[c] = _mm_cvtsi128_si32(sum);
+        if (c1 != c){
+            out[c1] = _mm_extract_epi32(sum, 1);
+        }
+    }
+}
+
+
+void resample_x64_AVX512(
+    const ResampleAxis& x, const ResampleAxis& y,
+    const uint32_t* in, size_t in_bytes_per_row,
+    uint32_t* out, size_t out_bytes_per_row,
+    uint16_t* buffer
+){
+    for (size_t r = 0; r < y.dst; r++){
+        resample_vertical_x64_AVX512(buffer, x.src, y, r, in, in_bytes_per_row);
+        resample_horizontal_x64_AVX512(out, x, buffer);
+        out = (uint32_t*)((char*)out + out_bytes_per_row);
+    }
+}
+
+
+
+}
+}
+#endif
@@ -0,0 +1,157 @@
+/*  Scale Brightness + RMSD
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include "Common/Cpp/CpuId/CpuId.h"
+#include "Kernels_ImageScaleBrightnessRMSD.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+void pixel_sum_sampled_Default(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+);
+void pixel_sum_sampled_x64_SSE41(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+);
+void pixel_sum_sampled_x64_AVX2(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+);
+void pixel_sum_sampled_x64_AVX512(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+);
+
+void sum_sqr_deviation_scaled_brightness_Default(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+);
+void sum_sqr_deviation_scaled_brightness_x64_SSE41(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+);
+void sum_sqr_deviation_scaled_brightness_x64_AVX2(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+);
+void sum_sqr_deviation_scaled_brightness_x64_AVX512(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+);
+
+
+
+void pixel_sum_sampled(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+){
+#ifdef PA_AutoDispatch_x64_17_Skylake
+    if (CPU_CAPABILITY_CURRENT.OK_17_Skylake){
+        pixel_sum_sampled_x64_AVX512(sums, width, height, image, alpha, alpha_bytes_per_row);
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_13_Haswell
+    if (CPU_CAPABILITY_CURRENT.OK_13_Haswell){
+        pixel_sum_sampled_x64_AVX2(sums, width, height, image, alpha, alpha_bytes_per_row);
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_08_Nehalem
+    if (CPU_CAPABILITY_CURRENT.OK_08_Nehalem){
+        pixel_sum_sampled_x64_SSE41(sums, width, height, image, alpha, alpha_bytes_per_row);
+        return;
+    }
+#endif
+    pixel_sum_sampled_Default(sums, width, height, image, alpha, alpha_bytes_per_row);
+}
+void sum_sqr_deviation_scaled_brightness(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+){
+#ifdef PA_AutoDispatch_x64_17_Skylake
+    if (CPU_CAPABILITY_CURRENT.OK_17_Skylake){
+        sum_sqr_deviation_scaled_brightness_x64_AVX512(
+            count, sumsqrs,
+            width, height,
+            ref, ref_bytes_per_row,
+            scaleR, scaleG, scaleB,
+            img, mode, background
+        );
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_13_Haswell
+    if (CPU_CAPABILITY_CURRENT.OK_13_Haswell){
+        sum_sqr_deviation_scaled_brightness_x64_AVX2(
+            count, sumsqrs,
+            width, height,
+            ref, ref_bytes_per_row,
+            scaleR, scaleG, scaleB,
+            img, mode, background
+        );
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_08_Nehalem
+    if (CPU_CAPABILITY_CURRENT.OK_08_Nehalem){
+        sum_sqr_deviation_scaled_brightness_x64_SSE41(
+            count, sumsqrs,
+            width, height,
+            ref, ref_bytes_per_row,
+            scaleR, scaleG, scaleB,
+            img, mode, background
+        );
+        return;
+    }
+#endif
+    sum_sqr_deviation_scaled_brightness_Default(
+        count, sumsqrs,
+        width, height,
+        ref, ref_bytes_per_row,
+        scaleR, scaleG, scaleB,
+        img, mode, background
+    );
+}
+
+
+
+
+}
+}
@@ -0,0 +1,72 @@
+/*  Scale Brightness + RMSD
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Fused version of:
+ *          1.  Resize the input image to the template dimensions.
+ *          2.  Scale the template brightness to match the input.
+ *          3.  Sum of squares of deviation between the two.
+ *
+ *  The resize is done by reading the input through a sampling map. The
+ *  brightness scaled template is computed on the fly. So nothing gets written
+ *  to memory.
+ *
+ */
+
+#ifndef PokemonAutomation_Kernels_ImageScaleBrightnessRMSD_H
+#define PokemonAutomation_Kernels_ImageScaleBrightnessRMSD_H
+
+#include <stdint.h>
+#include <cstddef>
+#include "Kernels/ImageStats/Kernels_ImagePixelSumSqr.h"
+#include "Kernels/ImageStats/Kernels_ImagePixelSumSqrDev.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+//  A read-only view of an image that is resampled to a different size.
+//  Pixel (x, y) of the view is pixel (cols[x], rows[y]) of "image".
+//  If "cols" and "rows" are both null, the view is the image itself.
+struct SampledImage{
+    const uint32_t* image = nullptr;
+    size_t bytes_per_row = 0;
+    const uint32_t* cols = nullptr;
+    const uint32_t* rows = nullptr;
+
+    const uint32_t* row(size_t r) const{
+        size_t index = rows == nullptr ? r : rows[r];
+        return (const uint32_t*)((const char*)image + index * bytes_per_row);
+    }
+};
+
+
+//  Same as "pixel_sum_sqr()", but reads "image" through a sampling map.
+//  Only "count" and the sums are computed. The squares are left untouched.
+void pixel_sum_sampled(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+);
+
+
+//  Same as "sum_sqr_deviation()", but "ref" is first brightness scaled
+//  exactly as "scale_brightness()" does and "img" is read through a sampling
+//  map. Neither image is modified.
+//
+//  "background" is only used in USE_BACKGROUND mode.
+//
+void sum_sqr_deviation_scaled_brightness(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background = 0
+);
+
+
+}
+}
+#endif
@@ -0,0 +1,202 @@
+/*  Scale Brightness + RMSD (Default)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include <stdint.h>
+#include <algorithm>
+#include "Common/Compiler.h"
+#include "Common/Cpp/Exceptions.h"
+#include "Kernels_ImageScaleBrightnessRMSD.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+PA_FORCE_INLINE void pixel_sum_sampled_Default(
+    PixelSums& sums,
+    uint16_t width,
+    const uint32_t* image, const uint32_t* cols,
+    const uint32_t* alpha
+){
+    uint32_t sumB = 0;
+    uint32_t sumG = 0;
+    uint32_t sumR = 0;
+    uint32_t sumA = 0;
+
+    for (size_t c = 0; c < width; c++){
+        uint32_t p = image[cols == nullptr ? c : cols[c]];
+        int32_t m = alpha[c];
+
+        m = m >> 31;
+        p &= (uint32_t)m;
+
+        sumB += p & 0x000000ff;
+        sumG += (p >>  8) & 0x000000ff;
+        sumR += (p >> 16) & 0x000000ff;
+        sumA -= m;
+    }
+
+    sums.count += sumA;
+    sums.sumR += sumR;
+    sums.sumG += sumG;
+    sums.sumB += sumB;
+}
+void pixel_sum_sampled_Default(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+){
+    if (width == 0 || height == 0){
+        return;
+    }
+    if (width > 65535){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Width limit exceeded: " + std::to_string(width));
+    }
+    for (size_t r = 0; r < height; r++){
+        pixel_sum_sampled_Default(sums, (uint16_t)width, image.row(r), image.cols, alpha);
+        alpha = (const uint32_t*)((const char*)alpha + alpha_bytes_per_row);
+    }
+}
+
+
+
+//  Must match "scale_brightness_Default()".
+PA_FORCE_INLINE uint32_t scale_brightness_Default(
+    uint32_t pixel,
+    float scaleR, float scaleG, float scaleB
+){
+    float r = (float)((pixel >> 16) & 0x000000ff);
+    float g = (float)((pixel >> 8) & 0x000000ff);
+    float b = (float)(pixel & 0x000000ff);
+    r *= scaleR;
+    g *= scaleG;
+    b *= scaleB;
+
+    uint32_t r_u32 = std::min((uint32_t)r, (uint32_t)255);
+    uint32_t g_u32 = std::min((uint32_t)g, (uint32_t)255);
+    uint32_t b_u32 = std::min((uint32_t)b, (uint32_t)255);
+
+    pixel &= 0xff000000;
+    pixel |= r_u32 << 16;
+    pixel |= g_u32 << 8;
+    pixel |= b_u32;
+    return pixel;
+}
+
+template <SumSquareMode mode>
+PA_FORCE_INLINE void sum_sqr_deviation_scaled_brightness_Default(
+    uint64_t& count, uint64_t& sumsqrs,
+    uint16_t width,
+    const uint32_t* ref,
+    float scaleR, float scaleG, float scaleB,
+    const uint32_t* img, const uint32_t* cols,
+    uint32_t background
+){
+    uint32_t total = 0;
+    uint32_t sum = 0;
+    for (size_t c = 0; c < width; c++){
+        uint32_t r = scale_brightness_Default(ref[c], scaleR, scaleG, scaleB);
+        uint32_t i = img[cols == nullptr ? c : cols[c]];
+
+        uint32_t alphaR = (int32_t)r >> 31;
+
+        if (mode == SumSquareMode::REFERENCE_ALPHA){
+            r &= alphaR;
+            i &= alphaR;
+        }
+        if (mode == SumSquareMode::USE_BACKGROUND){
+            r = alphaR ? r : background;
+        }
+        if (mode == SumSquareMode::ARBITRATE_ALPHAS){
+            uint32_t alphaI = (int32_t)i >> 31;
+            r &= alphaR;
+            i &= alphaI;
+            alphaI ^= alphaR;
+            r |= alphaI;
+            i &= ~alphaI;
+        }
+
+        uint32_t r0 = r & 0x000000ff;
+        uint32_t i0 = i & 0x000000ff;
+        uint32_t r1 = (r >> 8) & 0x000000ff;
+        uint32_t i1 = (i >> 8) & 0x000000ff;
+        uint32_t r2 = (r >> 16) & 0x000000ff;
+        uint32_t i2 = (i >> 16) & 0x000000ff;
+
+        r0 -= i0;
+        r1 -= i1;
+        r2 -= i2;
+
+        r0 *= r0;
+        r1 *= r1;
+        r2 *= r2;
+
+        total -= alphaR;
+        sum += r0 + r1 + r2;
+    }
+    count += total;
+    sumsqrs += sum;
+}
+template <SumSquareMode mode>
+void sum_sqr_deviation_scaled_brightness_Default(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    uint32_t background
+){
+    for (size_t r = 0; r < height; r++){
+        sum_sqr_deviation_scaled_brightness_Default<mode>(
+            count, sumsqrs,
+            (uint16_t)width, ref,
+            scaleR, scaleG, scaleB,
+            img.row(r), img.cols,
+            background
+        );
+        ref = (const uint32_t*)((const char*)ref + ref_bytes_per_row);
+    }
+}
+void sum_sqr_deviation_scaled_brightness_Default(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+){
+    if (width == 0 || height == 0){
+        return;
+    }
+    if (width > 22017){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Width limit exceeded: " + std::to_string(width));
+    }
+    scaleR = std::max(scaleR, 0.0f);
+    scaleG = std::max(scaleG, 0.0f);
+    scaleB = std::max(scaleB, 0.0f);
+    switch (mode){
+    case SumSquareMode::REFERENCE_ALPHA:
+        sum_sqr_deviation_scaled_brightness_Default<SumSquareMode::REFERENCE_ALPHA>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    case SumSquareMode::USE_BACKGROUND:
+        sum_sqr_deviation_scaled_brightness_Default<SumSquareMode::USE_BACKGROUND>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    case SumSquareMode::ARBITRATE_ALPHAS:
+        sum_sqr_deviation_scaled_brightness_Default<SumSquareMode::ARBITRATE_ALPHAS>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    }
+}
+
+
+
+}
+}
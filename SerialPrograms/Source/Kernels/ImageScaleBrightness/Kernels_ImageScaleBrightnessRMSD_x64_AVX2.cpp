@@ -0,0 +1,295 @@
+/*  Scale Brightness + RMSD (x64 AVX2)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_x64_13_Haswell
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "Common/Compiler.h"
+#include "Common/Cpp/Exceptions.h"
+#include "Kernels/Kernels_x64_AVX2.h"
+#include "Kernels_ImageScaleBrightnessRMSD.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+void pixel_sum_sampled_Default(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+);
+
+
+
+//  Load 8 pixels starting at "c".
+PA_FORCE_INLINE __m256i load_sampled_x64_AVX2(
+    const uint32_t* row, const uint32_t* cols, size_t c
+){
+    if (cols == nullptr){
+        return _mm256_loadu_si256((const __m256i*)(row + c));
+    }
+    __m256i index = _mm256_loadu_si256((const __m256i*)(cols + c));
+    return _mm256_i32gather_epi32((const int*)row, index, 4);
+}
+//  Same as above, but only the lanes in "mask" are loaded. The rest are zero.
+PA_FORCE_INLINE __m256i load_sampled_x64_AVX2(
+    const uint32_t* row, const uint32_t* cols, size_t c, __m256i mask
+){
+    if (cols == nullptr){
+        return _mm256_maskload_epi32((const int*)(row + c), mask);
+    }
+    __m256i index = _mm256_maskload_epi32((const int*)(cols + c), mask);
+    return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)row, index, mask, 4);
+}
+PA_FORCE_INLINE __m256i tail_mask_x64_AVX2(size_t left){
+    return _mm256_cmpgt_epi32(
+        _mm256_set1_epi32((int)left),
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+    );
+}
+
+
+
+PA_FORCE_INLINE void pixel_sum_sampled_x64_AVX2(
+    __m256i& sumB, __m256i& sumG, __m256i& sumR, __m256i& sumA,
+    __m256i p, __m256i m
+){
+    m = _mm256_srai_epi32(m, 31);
+    p = _mm256_and_si256(p, m);
+
+    __m256i r0 = _mm256_and_si256(p, _mm256_set1_epi32(0x000000ff));
+    __m256i r1 = _mm256_shuffle_epi8(p, _mm256_setr_epi8(
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1
+    ));
+    __m256i r2 = _mm256_shuffle_epi8(p, _mm256_setr_epi8(
+        2, -1, -1, -1, 6, -1, -1, -1, 10, -1, -1, -1, 14, -1, -1, -1,
+        2, -1, -1, -1, 6, -1, -1, -1, 10, -1, -1, -1, 14, -1, -1, -1
+    ));
+
+    sumB = _mm256_add_epi32(sumB, r0);
+    sumG = _mm256_add_epi32(sumG, r1);
+    sumR = _mm256_add_epi32(sumR, r2);
+    sumA = _mm256_sub_epi32(sumA, m);
+}
+PA_FORCE_INLINE void pixel_sum_sampled_x64_AVX2(
+    PixelSums& sums,
+    size_t width,
+    const uint32_t* image, const uint32_t* cols,
+    const uint32_t* alpha
+){
+    __m256i sumB = _mm256_setzero_si256();
+    __m256i sumG = _mm256_setzero_si256();
+    __m256i sumR = _mm256_setzero_si256();
+    __m256i sumA = _mm256_setzero_si256();
+
+    size_t c = 0;
+    for (; c + 8 <= width; c += 8){
+        __m256i p = load_sampled_x64_AVX2(image, cols, c);
+        __m256i m = _mm256_loadu_si256((const __m256i*)(alpha + c));
+        pixel_sum_sampled_x64_AVX2(sumB, sumG, sumR, sumA, p, m);
+    }
+    if (c < width){
+        __m256i mask = tail_mask_x64_AVX2(width - c);
+        __m256i p = load_sampled_x64_AVX2(image, cols, c, mask);
+        __m256i m = load_sampled_x64_AVX2(alpha, nullptr, c, mask);
+        pixel_sum_sampled_x64_AVX2(sumB, sumG, sumR, sumA, p, m);
+    }
+
+    sums.count += reduce_add32_x64_AVX2(sumA);
+    sums.sumR += reduce_add32_x64_AVX2(sumR);
+    sums.sumG += reduce_add32_x64_AVX2(sumG);
+    sums.sumB += reduce_add32_x64_AVX2(sumB);
+}
+void pixel_sum_sampled_x64_AVX2(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+){
+    if (width < 8){
+        pixel_sum_sampled_Default(sums, width, height, image, alpha, alpha_bytes_per_row);
+        return;
+    }
+    if (width > 65535){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Width limit exceeded: " + std::to_string(width));
+    }
+    for (size_t r = 0; r < height; r++){
+        pixel_sum_sampled_x64_AVX2(sums, width, image.row(r), image.cols, alpha);
+        alpha = (const uint32_t*)((const char*)alpha + alpha_bytes_per_row);
+    }
+}
+
+
+
+//  Must match "scale_brightness_x64_AVX2()".
+PA_FORCE_INLINE __m256i scale_brightness_x64_AVX2(__m256i pixel, __m256 scaleR, __m256 scaleG, __m256 scaleB){
+    __m256i b = _mm256_and_si256(pixel, _mm256_set1_epi32(0x000000ff));
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixel, 8), _mm256_set1_epi32(0x000000ff));
+    __m256i r = _mm256_and_si256(_mm256_srli_epi32(pixel, 16), _mm256_set1_epi32(0x000000ff));
+
+    __m256 bf = _mm256_mul_ps(_mm256_cvtepi32_ps(b), scaleB);
+    __m256 gf = _mm256_mul_ps(_mm256_cvtepi32_ps(g), scaleG);
+    __m256 rf = _mm256_mul_ps(_mm256_cvtepi32_ps(r), scaleR);
+    bf = _mm256_max_ps(_mm256_min_ps(bf, _mm256_set1_ps(255.)), _mm256_set1_ps(0.));
+    gf = _mm256_max_ps(_mm256_min_ps(gf, _mm256_set1_ps(255.)), _mm256_set1_ps(0.));
+    rf = _mm256_max_ps(_mm256_min_ps(rf, _mm256_set1_ps(255.)), _mm256_set1_ps(0.));
+    b = _mm256_cvtps_epi32(bf);
+    g = _mm256_cvtps_epi32(gf);
+    r = _mm256_cvtps_epi32(rf);
+
+    pixel = _mm256_and_si256(pixel, _mm256_set1_epi32(0xff000000));
+    pixel = _mm256_or_si256(pixel, b);
+    pixel = _mm256_or_si256(pixel, _mm256_slli_epi32(g, 8));
+    pixel = _mm256_or_si256(pixel, _mm256_slli_epi32(r, 16));
+    return pixel;
+}
+
+//  Same as in "sum_sqr_deviation_x64_AVX2()".
+template <SumSquareMode mode>
+PA_FORCE_INLINE void accumulate_sqr_deviation_x64_AVX2(
+    __m256i& total, __m256i& sum,
+    __m256i r, __m256i i,
+    __m256i background
+){
+    __m256i alphaR = _mm256_srai_epi32(r, 31);
+
+    if (mode == SumSquareMode::REFERENCE_ALPHA){
+        r = _mm256_and_si256(r, alphaR);
+        i = _mm256_and_si256(i, alphaR);
+    }
+    if (mode == SumSquareMode::USE_BACKGROUND){
+        r = _mm256_blendv_epi8(background, r, alphaR);
+    }
+    if (mode == SumSquareMode::ARBITRATE_ALPHAS){
+        __m256i alphaI = _mm256_srai_epi32(i, 31);
+        r = _mm256_and_si256(r, alphaR);
+        i = _mm256_and_si256(i, alphaI);
+        alphaI = _mm256_xor_si256(alphaI, alphaR);
+        r = _mm256_or_si256(r, alphaI);
+        i = _mm256_andnot_si256(alphaI, i);
+    }
+
+    __m256i r0 = _mm256_and_si256(r, _mm256_set1_epi32(0x00ff00ff));
+    __m256i i0 = _mm256_and_si256(i, _mm256_set1_epi32(0x00ff00ff));
+    __m256i r1 = _mm256_shuffle_epi8(r, _mm256_setr_epi8(
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1
+    ));
+    __m256i i1 = _mm256_shuffle_epi8(i, _mm256_setr_epi8(
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1
+    ));
+
+    r0 = _mm256_sub_epi16(r0, i0);
+    r1 = _mm256_sub_epi16(r1, i1);
+
+    r0 = _mm256_madd_epi16(r0, r0);
+    r1 = _mm256_madd_epi16(r1, r1);
+
+    total = _mm256_sub_epi32(total, alphaR);
+    sum = _mm256_add_epi32(sum, r0);
+    sum = _mm256_add_epi32(sum, r1);
+}
+
+template <SumSquareMode mode>
+PA_FORCE_INLINE void sum_sqr_deviation_scaled_brightness_x64_AVX2(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width,
+    const uint32_t* ref,
+    __m256 scaleR, __m256 scaleG, __m256 scaleB,
+    const uint32_t* img, const uint32_t* cols,
+    __m256i background
+){
+    __m256i total = _mm256_setzero_si256();
+    __m256i sum = _mm256_setzero_si256();
+
+    size_t c = 0;
+    for (; c + 8 <= width; c += 8){
+        __m256i r = _mm256_loadu_si256((const __m256i*)(ref + c));
+        __m256i i = load_sampled_x64_AVX2(img, cols, c);
+        r = scale_brightness_x64_AVX2(r, scaleR, scaleG, scaleB);
+        accumulate_sqr_deviation_x64_AVX2<mode>(total, sum, r, i, background);
+    }
+    if (c < width){
+        //  Zero pixels are transparent. They contribute nothing in all modes
+        //  as long as the background is also zeroed.
+        __m256i mask = tail_mask_x64_AVX2(width - c);
+        __m256i r = load_sampled_x64_AVX2(ref, nullptr, c, mask);
+        __m256i i = load_sampled_x64_AVX2(img, cols, c, mask);
+        r = scale_brightness_x64_AVX2(r, scaleR, scaleG, scaleB);
+        background = _mm256_and_si256(background, mask);
+        accumulate_sqr_deviation_x64_AVX2<mode>(total, sum, r, i, background);
+    }
+
+    count += reduce_add32_x64_AVX2(total);
+    sumsqrs += reduce_add32_x64_AVX2(sum);
+}
+template <SumSquareMode mode>
+void sum_sqr_deviation_scaled_brightness_x64_AVX2(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    uint32_t background
+){
+    __m256 vscaleR = _mm256_set1_ps(scaleR);
+    __m256 vscaleG = _mm256_set1_ps(scaleG);
+    __m256 vscaleB = _mm256_set1_ps(scaleB);
+    __m256i vbackground = _mm256_set1_epi32(background);
+    for (size_t r = 0; r < height; r++){
+        sum_sqr_deviation_scaled_brightness_x64_AVX2<mode>(
+            count, sumsqrs,
+            width, ref,
+            vscaleR, vscaleG, vscaleB,
+            img.row(r), img.cols,
+            vbackground
+        );
+        ref = (const uint32_t*)((const char*)ref + ref_bytes_per_row);
+    }
+}
+void sum_sqr_deviation_scaled_brightness_x64_AVX2(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+){
+    //  Don't fall back to the default for small widths. It rounds differently.
+    if (width == 0 || height == 0){
+        return;
+    }
+    if (width > 22017){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Width limit exceeded: " + std::to_string(width));
+    }
+    switch (mode){
+    case SumSquareMode::REFERENCE_ALPHA:
+        sum_sqr_deviation_scaled_brightness_x64_AVX2<SumSquareMode::REFERENCE_ALPHA>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    case SumSquareMode::USE_BACKGROUND:
+        sum_sqr_deviation_scaled_brightness_x64_AVX2<SumSquareMode::USE_BACKGROUND>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    case SumSquareMode::ARBITRATE_ALPHAS:
+        sum_sqr_deviation_scaled_brightness_x64_AVX2<SumSquareMode::ARBITRATE_ALPHAS>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    }
+}
+
+
+
+}
+}
+#endif
@@ -0,0 +1,290 @@
+/*  Scale Brightness + RMSD (x64 AVX512)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_x64_17_Skylake
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "Common/Compiler.h"
+#include "Common/Cpp/Exceptions.h"
+#include "Kernels/Kernels_x64_AVX512.h"
+#include "Kernels_ImageScaleBrightnessRMSD.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+void pixel_sum_sampled_Default(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+);
+
+
+
+//  Load 16 pixels starting at "c".
+PA_FORCE_INLINE __m512i load_sampled_x64_AVX512(
+    const uint32_t* row, const uint32_t* cols, size_t c
+){
+    if (cols == nullptr){
+        return _mm512_loadu_si512(row + c);
+    }
+    __m512i index = _mm512_loadu_si512(cols + c);
+    return _mm512_i32gather_epi32(index, row, 4);
+}
+//  Same as above, but only the lanes in "mask" are loaded. The rest are zero.
+PA_FORCE_INLINE __m512i load_sampled_x64_AVX512(
+    const uint32_t* row, const uint32_t* cols, size_t c, __mmask16 mask
+){
+    if (cols == nullptr){
+        return _mm512_maskz_loadu_epi32(mask, row + c);
+    }
+    __m512i index = _mm512_maskz_loadu_epi32(mask, cols + c);
+    return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, index, row, 4);
+}
+
+
+
+PA_FORCE_INLINE void pixel_sum_sampled_x64_AVX512(
+    __m512i& sumB, __m512i& sumG, __m512i& sumR, __m512i& sumA,
+    __m512i p, __m512i m
+){
+    __mmask16 active = _mm512_movepi32_mask(m);
+    p = _mm512_maskz_mov_epi32(active, p);
+
+    __m512i r0 = _mm512_and_si512(p, _mm512_set1_epi32(0x000000ff));
+    __m512i r1 = _mm512_and_si512(_mm512_srli_epi32(p, 8), _mm512_set1_epi32(0x000000ff));
+    __m512i r2 = _mm512_and_si512(_mm512_srli_epi32(p, 16), _mm512_set1_epi32(0x000000ff));
+
+    sumB = _mm512_add_epi32(sumB, r0);
+    sumG = _mm512_add_epi32(sumG, r1);
+    sumR = _mm512_add_epi32(sumR, r2);
+    sumA = _mm512_mask_sub_epi32(sumA, active, sumA, _mm512_set1_epi32(-1));
+}
+PA_FORCE_INLINE void pixel_sum_sampled_x64_AVX512(
+    PixelSums& sums,
+    size_t width,
+    const uint32_t* image, const uint32_t* cols,
+    const uint32_t* alpha
+){
+    __m512i sumB = _mm512_setzero_si512();
+    __m512i sumG = _mm512_setzero_si512();
+    __m512i sumR = _mm512_setzero_si512();
+    __m512i sumA = _mm512_setzero_si512();
+
+    size_t c = 0;
+    for (; c + 16 <= width; c += 16){
+        __m512i p = load_sampled_x64_AVX512(image, cols, c);
+        __m512i m = _mm512_loadu_si512(alpha + c);
+        pixel_sum_sampled_x64_AVX512(sumB, sumG, sumR, sumA, p, m);
+    }
+    if (c < width){
+        __mmask16 mask = ((uint32_t)1 << (width - c)) - 1;
+        __m512i p = load_sampled_x64_AVX512(image, cols, c, mask);
+        __m512i m = load_sampled_x64_AVX512(alpha, nullptr, c, mask);
+        pixel_sum_sampled_x64_AVX512(sumB, sumG, sumR, sumA, p, m);
+    }
+
+    sums.count += _mm512_reduce_add_epi32(sumA);
+    sums.sumR += _mm512_reduce_add_epi32(sumR);
+    sums.sumG += _mm512_reduce_add_epi32(sumG);
+    sums.sumB += _mm512_reduce_add_epi32(sumB);
+}
+void pixel_sum_sampled_x64_AVX512(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+){
+    if (width < 16){
+        pixel_sum_sampled_Default(sums, width, height, image, alpha, alpha_bytes_per_row);
+        return;
+    }
+    if (width > 65535){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Width limit exceeded: " + std::to_string(width));
+    }
+    for (size_t r = 0; r < height; r++){
+        pixel_sum_sampled_x64_AVX512(sums, width, image.row(r), image.cols, alpha);
+        alpha = (const uint32_t*)((const char*)alpha + alpha_bytes_per_row);
+    }
+}
+
+
+
+//  Must match "scale_brightness_x64_AVX512()".
+PA_FORCE_INLINE __m512i scale_brightness_x64_AVX512(__m512i pixel, __m512 scaleR, __m512 scaleG, __m512 scaleB){
+    __m512i b = _mm512_and_si512(pixel, _mm512_set1_epi32(0x000000ff));
+    __m512i g = _mm512_and_si512(_mm512_srli_epi32(pixel, 8), _mm512_set1_epi32(0x000000ff));
+    __m512i r = _mm512_and_si512(_mm512_srli_epi32(pixel, 16), _mm512_set1_epi32(0x000000ff));
+
+    __m512 bf = _mm512_mul_ps(_mm512_cvtepi32_ps(b), scaleB);
+    __m512 gf = _mm512_mul_ps(_mm512_cvtepi32_ps(g), scaleG);
+    __m512 rf = _mm512_mul_ps(_mm512_cvtepi32_ps(r), scaleR);
+    bf = _mm512_max_ps(_mm512_min_ps(bf, _mm512_set1_ps(255.)), _mm512_set1_ps(0.));
+    gf = _mm512_max_ps(_mm512_min_ps(gf, _mm512_set1_ps(255.)), _mm512_set1_ps(0.));
+    rf = _mm512_max_ps(_mm512_min_ps(rf, _mm512_set1_ps(255.)), _mm512_set1_ps(0.));
+    b = _mm512_cvtps_epi32(bf);
+    g = _mm512_cvtps_epi32(gf);
+    r = _mm512_cvtps_epi32(rf);
+
+    pixel = _mm512_and_si512(pixel, _mm512_set1_epi32(0xff000000));
+    pixel = _mm512_or_si512(pixel, b);
+    pixel = _mm512_or_si512(pixel, _mm512_slli_epi32(g, 8));
+    pixel = _mm512_or_si512(pixel, _mm512_slli_epi32(r, 16));
+    return pixel;
+}
+
+//  Same as in "sum_sqr_deviation_x64_AVX512()".
+template <SumSquareMode mode>
+PA_FORCE_INLINE void accumulate_sqr_deviation_x64_AVX512(
+    __m512i& total, __m512i& sum,
+    __m512i r, __m512i i,
+    __m512i background
+){
+    __mmask16 alphaR = _mm512_movepi32_mask(r);
+    __mmask16 alphaI;
+
+    if (mode == SumSquareMode::USE_BACKGROUND){
+        r = _mm512_mask_blend_epi32(alphaR, background, r);
+    }
+    if (mode == SumSquareMode::ARBITRATE_ALPHAS){
+        alphaI = _mm512_movepi32_mask(i);
+    }
+
+    __m512i r0 = _mm512_and_si512(r, _mm512_set1_epi32(0x00ff00ff));
+    __m512i i0 = _mm512_and_si512(i, _mm512_set1_epi32(0x00ff00ff));
+    __m512i r1 = _mm512_shuffle_epi8(r, _mm512_setr_epi8(
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1
+    ));
+    __m512i i1 = _mm512_shuffle_epi8(i, _mm512_setr_epi8(
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1,
+        1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1
+    ));
+
+    r0 = _mm512_sub_epi16(r0, i0);
+    r1 = _mm512_sub_epi16(r1, i1);
+
+    r0 = _mm512_madd_epi16(r0, r0);
+    r1 = _mm512_madd_epi16(r1, r1);
+
+    r0 = _mm512_add_epi32(r0, r1);
+
+    total = _mm512_mask_sub_epi32(total, alphaR, total, _mm512_set1_epi32(-1));
+
+    if (mode == SumSquareMode::REFERENCE_ALPHA){
+        sum = _mm512_mask_add_epi32(sum, alphaR, sum, r0);
+    }
+    if (mode == SumSquareMode::USE_BACKGROUND){
+        sum = _mm512_add_epi32(sum, r0);
+    }
+    if (mode == SumSquareMode::ARBITRATE_ALPHAS){
+        r0 = _mm512_mask_mov_epi32(r0, alphaR ^ alphaI, _mm512_set1_epi32(195075));
+        sum = _mm512_mask_add_epi32(sum, alphaR | alphaI, sum, r0);
+    }
+}
+
+template <SumSquareMode mode>
+PA_FORCE_INLINE void sum_sqr_deviation_scaled_brightness_x64_AVX512(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width,
+    const uint32_t* ref,
+    __m512 scaleR, __m512 scaleG, __m512 scaleB,
+    const uint32_t* img, const uint32_t* cols,
+    __m512i background
+){
+    __m512i total = _mm512_setzero_si512();
+    __m512i sum = _mm512_setzero_si512();
+
+    size_t c = 0;
+    for (; c + 16 <= width; c += 16){
+        __m512i r = _mm512_loadu_si512(ref + c);
+        __m512i i = load_sampled_x64_AVX512(img, cols, c);
+        r = scale_brightness_x64_AVX512(r, scaleR, scaleG, scaleB);
+        accumulate_sqr_deviation_x64_AVX512<mode>(total, sum, r, i, background);
+    }
+    if (c < width){
+        //  Zero pixels are transparent. They contribute nothing in all modes
+        //  as long as the background is also zeroed.
+        __mmask16 mask = ((uint32_t)1 << (width - c)) - 1;
+        __m512i r = load_sampled_x64_AVX512(ref, nullptr, c, mask);
+        __m512i i = load_sampled_x64_AVX512(img, cols, c, mask);
+        r = scale_brightness_x64_AVX512(r, scaleR, scaleG, scaleB);
+        background = _mm512_maskz_mov_epi32(mask, background);
+        accumulate_sqr_deviation_x64_AVX512<mode>(total, sum, r, i, background);
+    }
+
+    count += _mm512_reduce_add_epi32(total);
+    sumsqrs += (uint32_t)_mm512_reduce_add_epi32(sum);
+}
+template <SumSquareMode mode>
+void sum_sqr_deviation_scaled_brightness_x64_AVX512(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    uint32_t background
+){
+    __m512 vscaleR = _mm512_set1_ps(scaleR);
+    __m512 vscaleG = _mm512_set1_ps(scaleG);
+    __m512 vscaleB = _mm512_set1_ps(scaleB);
+    __m512i vbackground = _mm512_set1_epi32(background);
+    for (size_t r = 0; r < height; r++){
+        sum_sqr_deviation_scaled_brightness_x64_AVX512<mode>(
+            count, sumsqrs,
+            width, ref,
+            vscaleR, vscaleG, vscaleB,
+            img.row(r), img.cols,
+            vbackground
+        );
+        ref = (const uint32_t*)((const char*)ref + ref_bytes_per_row);
+    }
+}
+void sum_sqr_deviation_scaled_brightness_x64_AVX512(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+){
+    //  Don't fall back to the default for small widths. It rounds differently.
+    if (width == 0 || height == 0){
+        return;
+    }
+    if (width > 22017){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Width limit exceeded: " + std::to_string(width));
+    }
+    switch (mode){
+    case SumSquareMode::REFERENCE_ALPHA:
+        sum_sqr_deviation_scaled_brightness_x64_AVX512<SumSquareMode::REFERENCE_ALPHA>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    case SumSquareMode::USE_BACKGROUND:
+        sum_sqr_deviation_scaled_brightness_x64_AVX512<SumSquareMode::USE_BACKGROUND>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    case SumSquareMode::ARBITRATE_ALPHAS:
+        sum_sqr_deviation_scaled_brightness_x64_AVX512<SumSquareMode::ARBITRATE_ALPHAS>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    }
+}
+
+
+
+}
+}
+#endif
@@ -0,0 +1,276 @@
+/*  Scale Brightness + RMSD (x64 SSE4.1)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_x64_08_Nehalem
+
+#include <stdint.h>
+#include <smmintrin.h>
+#include "Common/Compiler.h"
+#include "Common/Cpp/Exceptions.h"
+#include "Kernels/Kernels_x64_SSE41.h"
+#include "Kernels_ImageScaleBrightnessRMSD.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+void pixel_sum_sampled_Default(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+);
+
+
+
+//  Load 4 pixels starting at "c".
+PA_FORCE_INLINE __m128i load_sampled_x64_SSE41(
+    const uint32_t* row, const uint32_t* cols, size_t c
+){
+    if (cols == nullptr){
+        return _mm_loadu_si128((const __m128i*)(row + c));
+    }
+    return _mm_setr_epi32(row[cols[c + 0]], row[cols[c + 1]], row[cols[c + 2]], row[cols[c + 3]]);
+}
+//  Same as above, but only the first "count" are loaded. The rest are zero.
+PA_FORCE_INLINE __m128i load_sampled_x64_SSE41(
+    const uint32_t* row, const uint32_t* cols, size_t c, size_t count
+){
+    alignas(16) uint32_t buffer[4] = {};
+    for (size_t i = 0; i < count; i++){
+        buffer[i] = row[cols == nullptr ? c + i : cols[c + i]];
+    }
+    return _mm_load_si128((const __m128i*)buffer);
+}
+
+
+
+PA_FORCE_INLINE void pixel_sum_sampled_x64_SSE41(
+    __m128i& sumB, __m128i& sumG, __m128i& sumR, __m128i& sumA,
+    __m128i p, __m128i m
+){
+    m = _mm_srai_epi32(m, 31);
+    p = _mm_and_si128(p, m);
+
+    __m128i r0 = _mm_and_si128(p, _mm_set1_epi32(0x000000ff));
+    __m128i r1 = _mm_shuffle_epi8(p, _mm_setr_epi8(1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1));
+    __m128i r2 = _mm_shuffle_epi8(p, _mm_setr_epi8(2, -1, -1, -1, 6, -1, -1, -1, 10, -1, -1, -1, 14, -1, -1, -1));
+
+    sumB = _mm_add_epi32(sumB, r0);
+    sumG = _mm_add_epi32(sumG, r1);
+    sumR = _mm_add_epi32(sumR, r2);
+    sumA = _mm_sub_epi32(sumA, m);
+}
+PA_FORCE_INLINE void pixel_sum_sampled_x64_SSE41(
+    PixelSums& sums,
+    size_t width,
+    const uint32_t* image, const uint32_t* cols,
+    const uint32_t* alpha
+){
+    __m128i sumB = _mm_setzero_si128();
+    __m128i sumG = _mm_setzero_si128();
+    __m128i sumR = _mm_setzero_si128();
+    __m128i sumA = _mm_setzero_si128();
+
+    size_t c = 0;
+    for (; c + 4 <= width; c += 4){
+        __m128i p = load_sampled_x64_SSE41(image, cols, c);
+        __m128i m = _mm_loadu_si128((const __m128i*)(alpha + c));
+        pixel_sum_sampled_x64_SSE41(sumB, sumG, sumR, sumA, p, m);
+    }
+    if (c < width){
+        __m128i p = load_sampled_x64_SSE41(image, cols, c, width - c);
+        __m128i m = load_sampled_x64_SSE41(alpha, nullptr, c, width - c);
+        pixel_sum_sampled_x64_SSE41(sumB, sumG, sumR, sumA, p, m);
+    }
+
+    sums.count += reduce32_x64_SSE41(sumA);
+    sums.sumR += reduce32_x64_SSE41(sumR);
+    sums.sumG += reduce32_x64_SSE41(sumG);
+    sums.sumB += reduce32_x64_SSE41(sumB);
+}
+void pixel_sum_sampled_x64_SSE41(
+    PixelSums& sums,
+    size_t width, size_t height,
+    const SampledImage& image,
+    const uint32_t* alpha, size_t alpha_bytes_per_row
+){
+    if (width < 4){
+        pixel_sum_sampled_Default(sums, width, height, image, alpha, alpha_bytes_per_row);
+        return;
+    }
+    if (width > 65535){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Width limit exceeded: " + std::to_string(width));
+    }
+    for (size_t r = 0; r < height; r++){
+        pixel_sum_sampled_x64_SSE41(sums, width, image.row(r), image.cols, alpha);
+        alpha = (const uint32_t*)((const char*)alpha + alpha_bytes_per_row);
+    }
+}
+
+
+
+//  Must match "scale_brightness_x64_SSE41()".
+PA_FORCE_INLINE __m128i scale_brightness_x64_SSE41(__m128i pixel, __m128 scaleR, __m128 scaleG, __m128 scaleB){
+    __m128i b = _mm_and_si128(pixel, _mm_set1_epi32(0x000000ff));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(pixel, 8), _mm_set1_epi32(0x000000ff));
+    __m128i r = _mm_and_si128(_mm_srli_epi32(pixel, 16), _mm_set1_epi32(0x000000ff));
+
+    __m128 bf = _mm_mul_ps(_mm_cvtepi32_ps(b), scaleB);
+    __m128 gf = _mm_mul_ps(_mm_cvtepi32_ps(g), scaleG);
+    __m128 rf = _mm_mul_ps(_mm_cvtepi32_ps(r), scaleR);
+    bf = _mm_max_ps(_mm_min_ps(bf, _mm_set1_ps(255.)), _mm_set1_ps(0.));
+    gf = _mm_max_ps(_mm_min_ps(gf, _mm_set1_ps(255.)), _mm_set1_ps(0.));
+    rf = _mm_max_ps(_mm_min_ps(rf, _mm_set1_ps(255.)), _mm_set1_ps(0.));
+    b = _mm_cvtps_epi32(bf);
+    g = _mm_cvtps_epi32(gf);
+    r = _mm_cvtps_epi32(rf);
+
+    pixel = _mm_and_si128(pixel, _mm_set1_epi32(0xff000000));
+    pixel = _mm_or_si128(pixel, b);
+    pixel = _mm_or_si128(pixel, _mm_slli_epi32(g, 8));
+    pixel = _mm_or_si128(pixel, _mm_slli_epi32(r, 16));
+    return pixel;
+}
+
+//  Same as in "sum_sqr_deviation_x64_SSE41()".
+template <SumSquareMode mode>
+PA_FORCE_INLINE void accumulate_sqr_deviation_x64_SSE41(
+    __m128i& total, __m128i& sum,
+    __m128i r, __m128i i,
+    __m128i background
+){
+    __m128i alphaR = _mm_srai_epi32(r, 31);
+
+    if (mode == SumSquareMode::REFERENCE_ALPHA){
+        r = _mm_and_si128(r, alphaR);
+        i = _mm_and_si128(i, alphaR);
+    }
+    if (mode == SumSquareMode::USE_BACKGROUND){
+        r = _mm_blendv_epi8(background, r, alphaR);
+    }
+    if (mode == SumSquareMode::ARBITRATE_ALPHAS){
+        __m128i alphaI = _mm_srai_epi32(i, 31);
+        r = _mm_and_si128(r, alphaR);
+        i = _mm_and_si128(i, alphaI);
+        alphaI = _mm_xor_si128(alphaI, alphaR);
+        r = _mm_or_si128(r, alphaI);
+        i = _mm_andnot_si128(alphaI, i);
+    }
+
+    __m128i r0 = _mm_and_si128(r, _mm_set1_epi32(0x00ff00ff));
+    __m128i i0 = _mm_and_si128(i, _mm_set1_epi32(0x00ff00ff));
+    __m128i r1 = _mm_shuffle_epi8(r, _mm_setr_epi8(1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1));
+    __m128i i1 = _mm_shuffle_epi8(i, _mm_setr_epi8(1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1));
+
+    r0 = _mm_sub_epi16(r0, i0);
+    r1 = _mm_sub_epi16(r1, i1);
+
+    r0 = _mm_madd_epi16(r0, r0);
+    r1 = _mm_madd_epi16(r1, r1);
+
+    total = _mm_sub_epi32(total, alphaR);
+    sum = _mm_add_epi32(sum, r0);
+    sum = _mm_add_epi32(sum, r1);
+}
+
+template <SumSquareMode mode>
+PA_FORCE_INLINE void sum_sqr_deviation_scaled_brightness_x64_SSE41(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width,
+    const uint32_t* ref,
+    __m128 scaleR, __m128 scaleG, __m128 scaleB,
+    const uint32_t* img, const uint32_t* cols,
+    __m128i background
+){
+    __m128i total = _mm_setzero_si128();
+    __m128i sum = _mm_setzero_si128();
+
+    size_t c = 0;
+    for (; c + 4 <= width; c += 4){
+        __m128i r = _mm_loadu_si128((const __m128i*)(ref + c));
+        __m128i i = load_sampled_x64_SSE41(img, cols, c);
+        r = scale_brightness_x64_SSE41(r, scaleR, scaleG, scaleB);
+        accumulate_sqr_deviation_x64_SSE41<mode>(total, sum, r, i, background);
+    }
+    if (c < width){
+        //  Zero pixels are transparent. They contribute nothing in all modes
+        //  as long as the background is also zeroed.
+        size_t left = width - c;
+        __m128i r = load_sampled_x64_SSE41(ref, nullptr, c, left);
+        __m128i i = load_sampled_x64_SSE41(img, cols, c, left);
+        __m128i mask = _mm_cmpgt_epi32(_mm_set1_epi32((int)left), _mm_setr_epi32(0, 1, 2, 3));
+        r = scale_brightness_x64_SSE41(r, scaleR, scaleG, scaleB);
+        background = _mm_and_si128(background, mask);
+        accumulate_sqr_deviation_x64_SSE41<mode>(total, sum, r, i, background);
+    }
+
+    count += reduce32_x64_SSE41(total);
+    sumsqrs += reduce32_x64_SSE41(sum);
+}
+template <SumSquareMode mode>
+void sum_sqr_deviation_scaled_brightness_x64_SSE41(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    uint32_t background
+){
+    __m128 vscaleR = _mm_set1_ps(scaleR);
+    __m128 vscaleG = _mm_set1_ps(scaleG);
+    __m128 vscaleB = _mm_set1_ps(scaleB);
+    __m128i vbackground = _mm_set1_epi32(background);
+    for (size_t r = 0; r < height; r++){
+        sum_sqr_deviation_scaled_brightness_x64_SSE41<mode>(
+            count, sumsqrs,
+            width, ref,
+            vscaleR, vscaleG, vscaleB,
+            img.row(r), img.cols,
+            vbackground
+        );
+        ref = (const uint32_t*)((const char*)ref + ref_bytes_per_row);
+    }
+}
+void sum_sqr_deviation_scaled_brightness_x64_SSE41(
+    uint64_t& count, uint64_t& sumsqrs,
+    size_t width, size_t height,
+    const uint32_t* ref, size_t ref_bytes_per_row,
+    float scaleR, float scaleG, float scaleB,
+    const SampledImage& img,
+    SumSquareMode mode, uint32_t background
+){
+    //  Don't fall back to the default for small widths. It rounds differently.
+    if (width == 0 || height == 0){
+        return;
+    }
+    if (width > 22017){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Width limit exceeded: " + std::to_string(width));
+    }
+    switch (mode){
+    case SumSquareMode::REFERENCE_ALPHA:
+        sum_sqr_deviation_scaled_brightness_x64_SSE41<SumSquareMode::REFERENCE_ALPHA>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    case SumSquareMode::USE_BACKGROUND:
+        sum_sqr_deviation_scaled_brightness_x64_SSE41<SumSquareMode::USE_BACKGROUND>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    case SumSquareMode::ARBITRATE_ALPHAS:
+        sum_sqr_deviation_scaled_brightness_x64_SSE41<SumSquareMode::ARBITRATE_ALPHAS>(
+            count, sumsqrs, width, height, ref, ref_bytes_per_row, scaleR, scaleG, scaleB, img, background
+        );
+        return;
+    }
+}
+
+
+
+}
+}
+#endif
@@ -71,6 +71,37 @@ float compute_scale(
 
 
 
+float compute_dot_products_Default         (size_t width, size_t height, const float* A, float const* const* T, float* dot);
+float compute_dot_products_min4_x86_SSE    (size_t width, size_t height, const float* A, float const* const* T, float* dot);
+float compute_dot_products_min8_x86_AVX2   (size_t width, size_t height, const float* A, float const* const* T, float* dot);
+float compute_dot_products_min16_x86_AVX512(size_t width, size_t height, const float* A, float const* const* T, float* dot);
+
+float compute_dot_products(
+    size_t width, size_t height,
+    const float* A,
+    float const* const* T,
+    float* dot
+){
+#ifdef PA_AutoDispatch_x64_17_Skylake
+    if (width >= 16 && CPU_CAPABILITY_CURRENT.OK_17_Skylake){
+        return compute_dot_products_min16_x86_AVX512(width, height, A, T, dot);
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_13_Haswell
+    if (width >= 8 && CPU_CAPABILITY_CURRENT.OK_13_Haswell){
+        return compute_dot_products_min8_x86_AVX2(width, height, A, T, dot);
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_08_Nehalem
+    if (width >= 4 && CPU_CAPABILITY_CURRENT.OK_08_Nehalem){
+        return compute_dot_products_min4_x86_SSE(width, height, A, T, dot);
+    }
+#endif
+    return compute_dot_products_Default(width, height, A, T, dot);
+}
+
+
+
 float compute_error_Default         (size_t width, size_t height, float scale, float const* const* A, float const* const* T);
 float compute_error_min4_x86_SSE    (size_t width, size_t height, float scale, float const* const* A, float const* const* T);
 float compute_error_min8_x86_AVX2   (size_t width, size_t height, float scale, float const* const* A, float const* const* T);
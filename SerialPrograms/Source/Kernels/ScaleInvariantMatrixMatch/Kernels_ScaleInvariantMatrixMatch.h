@@ -32,6 +32,18 @@ float compute_scale(
 
 
 
+//  Compute: dot[r] = A . T[r] for each row of T.
+//  Returns: |A|^2
+//      All pointers must have the same alignment.
+float compute_dot_products(
+    size_t width, size_t height,
+    const float* A,
+    float const* const* T,
+    float* dot
+);
+
+
+
 //  Compute: |s A - T|^2
 //      All pointers must have the same alignment.
 float compute_error(
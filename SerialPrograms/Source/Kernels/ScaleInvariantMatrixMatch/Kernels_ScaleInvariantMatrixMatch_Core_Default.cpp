@@ -108,6 +108,14 @@ float compute_error_Default(
 ){
     return compute_error<SumError<Context_x86_SSE41>>(width, height, scale, A, TW, W);
 }
+float compute_dot_products_Default(
+    size_t width, size_t height,
+    const float* A,
+    float const* const* T,
+    float* dot
+){
+    return compute_dot_products<SumATA2<Context_x86_SSE41>>(width, height, A, T, dot);
+}
 
 
 
@@ -123,6 +123,14 @@ float compute_error_min8_x86_AVX2(
 ){
     return compute_error<SumError<Context_x86_AVX2>>(width, height, scale, A, TW, W);
 }
+float compute_dot_products_min8_x86_AVX2(
+    size_t width, size_t height,
+    const float* A,
+    float const* const* T,
+    float* dot
+){
+    return compute_dot_products<SumATA2<Context_x86_AVX2>>(width, height, A, T, dot);
+}
 
 
 
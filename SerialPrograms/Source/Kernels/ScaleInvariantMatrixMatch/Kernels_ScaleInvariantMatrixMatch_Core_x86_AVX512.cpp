@@ -115,6 +115,14 @@ float compute_error_min16_x86_AVX512(
 ){
     return compute_error<SumError<Context_x86_AVX512>>(width, height, scale, A, TW, W);
 }
+float compute_dot_products_min16_x86_AVX512(
+    size_t width, size_t height,
+    const float* A,
+    float const* const* T,
+    float* dot
+){
+    return compute_dot_products<SumATA2<Context_x86_AVX512>>(width, height, A, T, dot);
+}
 
 
 
@@ -28,6 +28,9 @@ struct SumATA2{
     PA_FORCE_INLINE float scale() const{
         return Context::vreduce(sum_AT) / Context::vreduce(sum_A2);
     }
+    PA_FORCE_INLINE float dot() const{
+        return Context::vreduce(sum_AT);
+    }
 
     PA_FORCE_INLINE void accumulate(size_t length, const float* A, const float* T){
         vtype sum_as0 = Context::vzero();
@@ -97,7 +100,7 @@ struct SumATA2{
         }
         if (VECTOR_LENGTH > 1 && length){
             vtype a0, t0;
-            Context::load2_partial_front(length, a0, ptrT, t0, ptrA);
+            Context::load2_partial_front(length, a0, ptrA, t0, ptrT);
             sum_at0 = Context::vpma(a0, t0, sum_at0);
             sum_as0 = Context::vpma(a0, a0, sum_as0);
         }
@@ -184,7 +187,7 @@ struct SumATA2{
         }
         if (length){
             vtype a0, t0, w0;
-            Context::load3_partial_front(length, a0, A, t0, TW, w0, W);
+            Context::load3_partial_front(length, a0, ptrA, t0, ptrT, w0, ptrW);
             a0 = Context::vmul(a0, w0);
             sum_as0 = Context::vpma(a0, a0, sum_as0);
             sum_at0 = Context::vpma(a0, t0, sum_at0);
@@ -269,7 +272,7 @@ struct SumError{
         }
         if (length){
             vtype a0, t0;
-            Context::load2_partial_front(length, a0, ptrT, t0, ptrA);
+            Context::load2_partial_front(length, a0, ptrA, t0, ptrT);
             a0 = Context::vpms(scale, a0, t0);
             sum0 = Context::vpma(a0, a0, sum0);
         }
@@ -343,7 +346,7 @@ struct SumError{
         }
         if (length){
             vtype a0, t0, w0;
-            Context::load3_partial_front(length, a0, A, t0, TW, w0, W);
+            Context::load3_partial_front(length, a0, ptrA, t0, ptrT, w0, ptrW);
             a0 = Context::vmul(scale, a0);
             a0 = Context::vpms(a0, w0, t0);
             sum0 = Context::vpma(a0, a0, sum0);
@@ -395,6 +398,29 @@ PA_FORCE_INLINE float compute_scale(
 }
 
 
+template <typename SumATA2>
+PA_FORCE_INLINE float compute_dot_products(
+    size_t width, size_t height,
+    const float* A,
+    float const* const* T,
+    float* dot
+){
+    constexpr size_t ALIGNMENT = alignof(typename SumATA2::vtype);
+    SumATA2 norm;
+    norm.accumulate(width, A, A);
+    for (size_t r = 0; r < height; r++){
+        const float* ptrT = T[r];
+        if ((size_t)A % ALIGNMENT != (size_t)ptrT % ALIGNMENT){
+            throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "A and T must have the same alignment.");
+        }
+        SumATA2 sum;
+        sum.accumulate(width, A, ptrT);
+        dot[r] = sum.dot();
+    }
+    return norm.dot();
+}
+
+
 template <typename SumError>
 PA_FORCE_INLINE float compute_error(
     size_t width, size_t height,
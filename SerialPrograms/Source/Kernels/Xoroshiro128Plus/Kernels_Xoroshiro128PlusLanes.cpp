@@ -0,0 +1,113 @@
+/*  Xoroshiro128+ Lanes
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include "Common/Cpp/CpuId/CpuId.h"
+#include "Kernels_Xoroshiro128PlusLanes.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+void xoroshiro128plus_next_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t stride, size_t advances
+);
+void xoroshiro128plus_next_lanes_x64_AVX2(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t stride, size_t advances
+);
+void xoroshiro128plus_next_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t stride, size_t advances
+);
+
+void xoroshiro128plus_last_bits_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t stride, size_t words
+);
+void xoroshiro128plus_last_bits_lanes_x64_AVX2(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t stride, size_t words
+);
+void xoroshiro128plus_last_bits_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t stride, size_t words
+);
+
+void xoroshiro128plus_next_int_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+);
+void xoroshiro128plus_next_int_lanes_x64_AVX2(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+);
+void xoroshiro128plus_next_int_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+);
+
+
+
+void xoroshiro128plus_next_lanes(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t advances
+){
+#ifdef PA_AutoDispatch_x64_17_Skylake
+    if (CPU_CAPABILITY_CURRENT.OK_17_Skylake){
+        xoroshiro128plus_next_lanes_x64_AVX512(s0, s1, lanes, results, lanes, advances);
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_13_Haswell
+    if (CPU_CAPABILITY_CURRENT.OK_13_Haswell){
+        xoroshiro128plus_next_lanes_x64_AVX2(s0, s1, lanes, results, lanes, advances);
+        return;
+    }
+#endif
+    xoroshiro128plus_next_lanes_Default(s0, s1, lanes, results, lanes, advances);
+}
+void xoroshiro128plus_last_bits_lanes(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t words
+){
+#ifdef PA_AutoDispatch_x64_17_Skylake
+    if (CPU_CAPABILITY_CURRENT.OK_17_Skylake){
+        xoroshiro128plus_last_bits_lanes_x64_AVX512(s0, s1, lanes, bits, lanes, words);
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_13_Haswell
+    if (CPU_CAPABILITY_CURRENT.OK_13_Haswell){
+        xoroshiro128plus_last_bits_lanes_x64_AVX2(s0, s1, lanes, bits, lanes, words);
+        return;
+    }
+#endif
+    xoroshiro128plus_last_bits_lanes_Default(s0, s1, lanes, bits, lanes, words);
+}
+void xoroshiro128plus_next_int_lanes(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+){
+#ifdef PA_AutoDispatch_x64_17_Skylake
+    if (CPU_CAPABILITY_CURRENT.OK_17_Skylake){
+        xoroshiro128plus_next_int_lanes_x64_AVX512(s0, s1, lanes, results, bounds, calls);
+        return;
+    }
+#endif
+#ifdef PA_AutoDispatch_x64_13_Haswell
+    if (CPU_CAPABILITY_CURRENT.OK_13_Haswell){
+        xoroshiro128plus_next_int_lanes_x64_AVX2(s0, s1, lanes, results, bounds, calls);
+        return;
+    }
+#endif
+    xoroshiro128plus_next_int_lanes_Default(s0, s1, lanes, results, bounds, calls);
+}
+
+
+
+}
+}
@@ -0,0 +1,61 @@
+/*  Xoroshiro128+ Lanes
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Advance many independent Xoroshiro128+ generators in lockstep.
+ *
+ *  The states are kept as structure-of-arrays so that each SIMD register holds
+ *  the same half of 4 (AVX2) or 8 (AVX512) different generators. Searches over
+ *  a range of advances can split the range into lanes (see
+ *  Xoroshiro128Plus::jump()) and run them side by side.
+ *
+ */
+
+#ifndef PokemonAutomation_Kernels_Xoroshiro128PlusLanes_H
+#define PokemonAutomation_Kernels_Xoroshiro128PlusLanes_H
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+//  "s0[l]" and "s1[l]" are the state of lane "l" of "lanes".
+//
+//  Advance every lane "advances" times. If "results" isn't null, the "i"th
+//  output of lane "l" is written to "results[i * lanes + l]".
+//
+//  Every instruction set gives exactly the same outputs and final states as
+//  calling Xoroshiro128Plus::next() on each lane.
+void xoroshiro128plus_next_lanes(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t advances
+);
+
+//  Same as above, but only the last bit of each output is kept and they are
+//  packed 64 to a word. Every lane advances "64 * words" times.
+//
+//  Bit "i" of "bits[w * lanes + l]" is the last bit of output "64 * w + i" of
+//  lane "l".
+void xoroshiro128plus_last_bits_lanes(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t words
+);
+
+//  Every lane calls Xoroshiro128Plus::nextInt(bounds[l]) "calls" times. If
+//  "results" isn't null, the last result of lane "l" is written to
+//  "results[l]".
+//
+//  nextInt() is rejection sampling, so lanes need different numbers of
+//  advances. Lanes that have accepted stop advancing (they are masked off)
+//  while the rest retry.
+void xoroshiro128plus_next_int_lanes(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+);
+
+
+}
+}
+#endif
@@ -0,0 +1,104 @@
+/*  Xoroshiro128+ Lanes (Default)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include <stdint.h>
+#include <cstddef>
+#include "Common/Compiler.h"
+#include "Kernels_Xoroshiro128PlusLanes.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+PA_FORCE_INLINE uint64_t rotl_Default(uint64_t x, int k){
+    return (x << k) | (x >> (64 - k));
+}
+
+
+//  Same as "xoroshiro128plus_next_lanes()", but the results of each advance
+//  are "stride" apart instead of "lanes". This lets the SIMD versions hand
+//  their leftover lanes to this.
+void xoroshiro128plus_next_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t stride, size_t advances
+){
+    for (size_t l = 0; l < lanes; l++){
+        uint64_t x0 = s0[l];
+        uint64_t x1 = s1[l];
+        for (size_t i = 0; i < advances; i++){
+            if (results != nullptr){
+                results[i * stride + l] = x0 + x1;
+            }
+            x1 ^= x0;
+            x0 = rotl_Default(x0, 24) ^ x1 ^ (x1 << 16);
+            x1 = rotl_Default(x1, 37);
+        }
+        s0[l] = x0;
+        s1[l] = x1;
+    }
+}
+void xoroshiro128plus_last_bits_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t stride, size_t words
+){
+    for (size_t l = 0; l < lanes; l++){
+        uint64_t x0 = s0[l];
+        uint64_t x1 = s1[l];
+        for (size_t w = 0; w < words; w++){
+            //  Shift each new bit in from the top. After 64 of them, the
+            //  first one is at the bottom.
+            uint64_t word = 0;
+            for (size_t i = 0; i < 64; i++){
+                word = (word >> 1) | ((x0 + x1) << 63);
+                x1 ^= x0;
+                x0 = rotl_Default(x0, 24) ^ x1 ^ (x1 << 16);
+                x1 = rotl_Default(x1, 37);
+            }
+            bits[w * stride + l] = word;
+        }
+        s0[l] = x0;
+        s1[l] = x1;
+    }
+}
+void xoroshiro128plus_next_int_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+){
+    for (size_t l = 0; l < lanes; l++){
+        uint64_t x0 = s0[l];
+        uint64_t x1 = s1[l];
+        uint64_t bound = bounds[l];
+
+        //  nextPowerOfTwo(bound) - 1
+        uint64_t mask = bound - 1;
+        mask |= mask >> 1;
+        mask |= mask >> 2;
+        mask |= mask >> 4;
+        mask |= mask >> 8;
+        mask |= mask >> 16;
+        mask |= mask >> 32;
+
+        uint64_t result = 0;
+        for (size_t c = 0; c < calls; c++){
+            do{
+                result = (x0 + x1) & mask;
+                x1 ^= x0;
+                x0 = rotl_Default(x0, 24) ^ x1 ^ (x1 << 16);
+                x1 = rotl_Default(x1, 37);
+            }while (result >= bound);
+        }
+        if (results != nullptr){
+            results[l] = result;
+        }
+        s0[l] = x0;
+        s1[l] = x1;
+    }
+}
+
+
+
+}
+}
@@ -0,0 +1,211 @@
+/*  Xoroshiro128+ Lanes (x64 AVX2)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_x64_13_Haswell
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "Common/Compiler.h"
+#include "Kernels_Xoroshiro128PlusLanes.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+void xoroshiro128plus_next_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t stride, size_t advances
+);
+void xoroshiro128plus_last_bits_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t stride, size_t words
+);
+void xoroshiro128plus_next_int_lanes_Default(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+);
+
+
+
+//  AVX2 has no 64-bit rotate.
+template <int k>
+PA_FORCE_INLINE __m256i rotl_x64_AVX2(__m256i x){
+    return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+//  4 lanes.
+template <bool store>
+PA_FORCE_INLINE void next_lanes_x64_AVX2(
+    uint64_t* s0, uint64_t* s1,
+    uint64_t* results, size_t stride, size_t advances
+){
+    __m256i x0 = _mm256_loadu_si256((const __m256i*)s0);
+    __m256i x1 = _mm256_loadu_si256((const __m256i*)s1);
+    for (size_t i = 0; i < advances; i++){
+        if (store){
+            _mm256_storeu_si256((__m256i*)results, _mm256_add_epi64(x0, x1));
+            results += stride;
+        }
+        x1 = _mm256_xor_si256(x1, x0);
+        x0 = _mm256_xor_si256(rotl_x64_AVX2<24>(x0), x1);
+        x0 = _mm256_xor_si256(x0, _mm256_slli_epi64(x1, 16));
+        x1 = rotl_x64_AVX2<37>(x1);
+    }
+    _mm256_storeu_si256((__m256i*)s0, x0);
+    _mm256_storeu_si256((__m256i*)s1, x1);
+}
+
+
+void xoroshiro128plus_next_lanes_x64_AVX2(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t stride, size_t advances
+){
+    size_t l = 0;
+    for (; l + 4 <= lanes; l += 4){
+        if (results != nullptr){
+            next_lanes_x64_AVX2<true>(s0 + l, s1 + l, results + l, stride, advances);
+        }else{
+            next_lanes_x64_AVX2<false>(s0 + l, s1 + l, nullptr, stride, advances);
+        }
+    }
+    if (l < lanes){
+        xoroshiro128plus_next_lanes_Default(
+            s0 + l, s1 + l, lanes - l,
+            results == nullptr ? nullptr : results + l, stride,
+            advances
+        );
+    }
+}
+
+
+
+//  4 lanes.
+PA_FORCE_INLINE void last_bits_lanes_x64_AVX2(
+    uint64_t* s0, uint64_t* s1,
+    uint64_t* bits, size_t stride, size_t words
+){
+    __m256i x0 = _mm256_loadu_si256((const __m256i*)s0);
+    __m256i x1 = _mm256_loadu_si256((const __m256i*)s1);
+    for (size_t w = 0; w < words; w++){
+        __m256i word = _mm256_setzero_si256();
+        for (size_t i = 0; i < 64; i++){
+            word = _mm256_or_si256(
+                _mm256_srli_epi64(word, 1),
+                _mm256_slli_epi64(_mm256_add_epi64(x0, x1), 63)
+            );
+            x1 = _mm256_xor_si256(x1, x0);
+            x0 = _mm256_xor_si256(rotl_x64_AVX2<24>(x0), x1);
+            x0 = _mm256_xor_si256(x0, _mm256_slli_epi64(x1, 16));
+            x1 = rotl_x64_AVX2<37>(x1);
+        }
+        _mm256_storeu_si256((__m256i*)(bits + w * stride), word);
+    }
+    _mm256_storeu_si256((__m256i*)s0, x0);
+    _mm256_storeu_si256((__m256i*)s1, x1);
+}
+
+
+void xoroshiro128plus_last_bits_lanes_x64_AVX2(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t stride, size_t words
+){
+    size_t l = 0;
+    for (; l + 4 <= lanes; l += 4){
+        last_bits_lanes_x64_AVX2(s0 + l, s1 + l, bits + l, stride, words);
+    }
+    if (l < lanes){
+        xoroshiro128plus_last_bits_lanes_Default(s0 + l, s1 + l, lanes - l, bits + l, stride, words);
+    }
+}
+
+
+
+//  nextInt() on 4 lanes.
+struct NextIntLanes_x64_AVX2{
+    __m256i x0;
+    __m256i x1;
+    __m256i bound;  //  Sign bit flipped.
+    __m256i mask;
+    __m256i result;
+    __m256i active;
+
+    PA_FORCE_INLINE void load(const uint64_t* s0, const uint64_t* s1, const uint64_t* bounds){
+        x0 = _mm256_loadu_si256((const __m256i*)s0);
+        x1 = _mm256_loadu_si256((const __m256i*)s1);
+        bound = _mm256_loadu_si256((const __m256i*)bounds);
+
+        //  nextPowerOfTwo(bound) - 1
+        mask = _mm256_sub_epi64(bound, _mm256_set1_epi64x(1));
+        mask = _mm256_or_si256(mask, _mm256_srli_epi64(mask, 1));
+        mask = _mm256_or_si256(mask, _mm256_srli_epi64(mask, 2));
+        mask = _mm256_or_si256(mask, _mm256_srli_epi64(mask, 4));
+        mask = _mm256_or_si256(mask, _mm256_srli_epi64(mask, 8));
+        mask = _mm256_or_si256(mask, _mm256_srli_epi64(mask, 16));
+        mask = _mm256_or_si256(mask, _mm256_srli_epi64(mask, 32));
+
+        //  AVX2 only has signed 64-bit compares. Flip the sign bits to make
+        //  them unsigned.
+        bound = _mm256_xor_si256(bound, _mm256_set1_epi64x(0x8000000000000000));
+        result = _mm256_setzero_si256();
+    }
+    PA_FORCE_INLINE void store(uint64_t* s0, uint64_t* s1, uint64_t* results) const{
+        if (results != nullptr){
+            _mm256_storeu_si256((__m256i*)results, result);
+        }
+        _mm256_storeu_si256((__m256i*)s0, x0);
+        _mm256_storeu_si256((__m256i*)s1, x1);
+    }
+
+    //  Advance the lanes that haven't accepted yet. Returns true if any are
+    //  still left.
+    PA_FORCE_INLINE bool step(){
+        __m256i r = _mm256_and_si256(_mm256_add_epi64(x0, x1), mask);
+
+        __m256i n1 = _mm256_xor_si256(x1, x0);
+        __m256i n0 = _mm256_xor_si256(rotl_x64_AVX2<24>(x0), n1);
+        n0 = _mm256_xor_si256(n0, _mm256_slli_epi64(n1, 16));
+        n1 = rotl_x64_AVX2<37>(n1);
+        x0 = _mm256_blendv_epi8(x0, n0, active);
+        x1 = _mm256_blendv_epi8(x1, n1, active);
+
+        __m256i accepted = _mm256_and_si256(
+            active,
+            _mm256_cmpgt_epi64(bound, _mm256_xor_si256(r, _mm256_set1_epi64x(0x8000000000000000)))
+        );
+        result = _mm256_blendv_epi8(result, r, accepted);
+        active = _mm256_andnot_si256(accepted, active);
+        return !_mm256_testz_si256(active, active);
+    }
+};
+
+
+void xoroshiro128plus_next_int_lanes_x64_AVX2(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+){
+    size_t l = 0;
+    for (; l + 4 <= lanes; l += 4){
+        NextIntLanes_x64_AVX2 group;
+        group.load(s0 + l, s1 + l, bounds + l);
+        for (size_t c = 0; c < calls; c++){
+            group.active = _mm256_set1_epi32(-1);
+            while (group.step());
+        }
+        group.store(s0 + l, s1 + l, results == nullptr ? nullptr : results + l);
+    }
+    if (l < lanes){
+        xoroshiro128plus_next_int_lanes_Default(
+            s0 + l, s1 + l, lanes - l,
+            results == nullptr ? nullptr : results + l, bounds + l, calls
+        );
+    }
+}
+
+
+
+}
+}
+#endif
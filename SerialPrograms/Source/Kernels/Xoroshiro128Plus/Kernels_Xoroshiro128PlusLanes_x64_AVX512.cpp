@@ -0,0 +1,167 @@
+/*  Xoroshiro128+ Lanes (x64 AVX512)
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#ifdef PA_AutoDispatch_x64_17_Skylake
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "Common/Compiler.h"
+#include "Kernels_Xoroshiro128PlusLanes.h"
+
+namespace PokemonAutomation{
+namespace Kernels{
+
+
+
+//  Up to 8 lanes. "mask" selects which of them exist.
+template <bool store>
+PA_FORCE_INLINE void next_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1,
+    uint64_t* results, size_t stride, size_t advances,
+    __mmask8 mask
+){
+    __m512i x0 = _mm512_maskz_loadu_epi64(mask, s0);
+    __m512i x1 = _mm512_maskz_loadu_epi64(mask, s1);
+    for (size_t i = 0; i < advances; i++){
+        if (store){
+            _mm512_mask_storeu_epi64(results, mask, _mm512_add_epi64(x0, x1));
+            results += stride;
+        }
+        x1 = _mm512_xor_si512(x1, x0);
+        x0 = _mm512_ternarylogic_epi64(
+            _mm512_rol_epi64(x0, 24), x1, _mm512_slli_epi64(x1, 16),
+            0x96    //  a ^ b ^ c
+        );
+        x1 = _mm512_rol_epi64(x1, 37);
+    }
+    _mm512_mask_storeu_epi64(s0, mask, x0);
+    _mm512_mask_storeu_epi64(s1, mask, x1);
+}
+
+
+void xoroshiro128plus_next_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, size_t stride, size_t advances
+){
+    for (size_t l = 0; l < lanes; l += 8){
+        size_t left = lanes - l;
+        __mmask8 mask = left >= 8 ? (__mmask8)0xff : (__mmask8)((1u << left) - 1);
+        if (results != nullptr){
+            next_lanes_x64_AVX512<true>(s0 + l, s1 + l, results + l, stride, advances, mask);
+        }else{
+            next_lanes_x64_AVX512<false>(s0 + l, s1 + l, nullptr, stride, advances, mask);
+        }
+    }
+}
+
+
+
+//  Up to 8 lanes. "mask" selects which of them exist.
+PA_FORCE_INLINE void last_bits_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1,
+    uint64_t* bits, size_t stride, size_t words,
+    __mmask8 mask
+){
+    __m512i x0 = _mm512_maskz_loadu_epi64(mask, s0);
+    __m512i x1 = _mm512_maskz_loadu_epi64(mask, s1);
+    for (size_t w = 0; w < words; w++){
+        __m512i word = _mm512_setzero_si512();
+        for (size_t i = 0; i < 64; i++){
+            word = _mm512_or_si512(
+                _mm512_srli_epi64(word, 1),
+                _mm512_slli_epi64(_mm512_add_epi64(x0, x1), 63)
+            );
+            x1 = _mm512_xor_si512(x1, x0);
+            x0 = _mm512_ternarylogic_epi64(
+                _mm512_rol_epi64(x0, 24), x1, _mm512_slli_epi64(x1, 16),
+                0x96    //  a ^ b ^ c
+            );
+            x1 = _mm512_rol_epi64(x1, 37);
+        }
+        _mm512_mask_storeu_epi64(bits + w * stride, mask, word);
+    }
+    _mm512_mask_storeu_epi64(s0, mask, x0);
+    _mm512_mask_storeu_epi64(s1, mask, x1);
+}
+
+
+void xoroshiro128plus_last_bits_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* bits, size_t stride, size_t words
+){
+    for (size_t l = 0; l < lanes; l += 8){
+        size_t left = lanes - l;
+        __mmask8 mask = left >= 8 ? (__mmask8)0xff : (__mmask8)((1u << left) - 1);
+        last_bits_lanes_x64_AVX512(s0 + l, s1 + l, bits + l, stride, words, mask);
+    }
+}
+
+
+
+//  Up to 8 lanes. "mask" selects which of them exist.
+PA_FORCE_INLINE void next_int_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1,
+    uint64_t* results, const uint64_t* bounds, size_t calls,
+    __mmask8 mask
+){
+    __m512i x0 = _mm512_maskz_loadu_epi64(mask, s0);
+    __m512i x1 = _mm512_maskz_loadu_epi64(mask, s1);
+    __m512i bound = _mm512_maskz_loadu_epi64(mask, bounds);
+
+    //  nextPowerOfTwo(bound) - 1. (a shift by 64 gives zero)
+    __m512i bits = _mm512_srlv_epi64(
+        _mm512_set1_epi64(-1),
+        _mm512_lzcnt_epi64(_mm512_sub_epi64(bound, _mm512_set1_epi64(1)))
+    );
+
+    __m512i result = _mm512_setzero_si512();
+    for (size_t c = 0; c < calls; c++){
+        __mmask8 active = mask;
+        do{
+            __m512i r = _mm512_and_si512(_mm512_add_epi64(x0, x1), bits);
+
+            __m512i n1 = _mm512_xor_si512(x1, x0);
+            __m512i n0 = _mm512_ternarylogic_epi64(
+                _mm512_rol_epi64(x0, 24), n1, _mm512_slli_epi64(n1, 16),
+                0x96    //  a ^ b ^ c
+            );
+            x0 = _mm512_mask_mov_epi64(x0, active, n0);
+            x1 = _mm512_mask_rol_epi64(x1, active, n1, 37);
+
+            __mmask8 accepted = _mm512_mask_cmplt_epu64_mask(active, r, bound);
+            result = _mm512_mask_mov_epi64(result, accepted, r);
+            active &= ~accepted;
+        }while (active != 0);
+    }
+
+    if (results != nullptr){
+        _mm512_mask_storeu_epi64(results, mask, result);
+    }
+    _mm512_mask_storeu_epi64(s0, mask, x0);
+    _mm512_mask_storeu_epi64(s1, mask, x1);
+}
+
+
+void xoroshiro128plus_next_int_lanes_x64_AVX512(
+    uint64_t* s0, uint64_t* s1, size_t lanes,
+    uint64_t* results, const uint64_t* bounds, size_t calls
+){
+    for (size_t l = 0; l < lanes; l += 8){
+        size_t left = lanes - l;
+        __mmask8 mask = left >= 8 ? (__mmask8)0xff : (__mmask8)((1u << left) - 1);
+        next_int_lanes_x64_AVX512(
+            s0 + l, s1 + l,
+            results == nullptr ? nullptr : results + l, bounds + l, calls,
+            mask
+        );
+    }
+}
+
+
+
+}
+}
+#endif
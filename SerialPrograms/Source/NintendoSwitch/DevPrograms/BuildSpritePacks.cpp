@@ -0,0 +1,98 @@
+/*  Build Sprite Packs
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include "Common/Cpp/Exceptions.h"
+#include "Common/Cpp/Time.h"
+#include "Common/Cpp/CancellableScope.h"
+#include "CommonFramework/Resources/SpriteDatabase.h"
+#include "CommonFramework/Tools/ProgramEnvironment.h"
+#include "BuildSpritePacks.h"
+
+namespace PokemonAutomation{
+
+
+namespace{
+
+//  Every composite sprite image that is loaded into a SpriteDatabase.
+struct SpriteSource{
+    const char* sprite_path;
+    const char* json_path;
+};
+const SpriteSource SPRITE_SOURCES[] = {
+    {"Pokemon/BerrySprites.png",                        "Pokemon/BerrySprites.json"},
+    {"PokemonLA/MMOSprites.png",                        "PokemonLA/MMOSprites.json"},
+    {"PokemonLA/PokemonSprites.png",                    "PokemonLA/PokemonSprites.json"},
+    {"PokemonSV/Auction/AuctionItemSprites.png",        "PokemonSV/Auction/AuctionItemSprites.json"},
+    {"PokemonSV/Picnic/SandwichCondimentSprites.png",   "PokemonSV/Picnic/SandwichCondimentSprites.json"},
+    {"PokemonSV/Picnic/SandwichFillingSprites.png",     "PokemonSV/Picnic/SandwichFillingSprites.json"},
+    {"PokemonSV/PokemonSilhouettes.png",                "PokemonSV/PokemonSprites.json"},
+    {"PokemonSV/PokemonSprites.png",                    "PokemonSV/PokemonSprites.json"},
+    {"PokemonSwSh/PokeballSprites.png",                 "PokemonSwSh/PokeballSprites.json"},
+    {"PokemonSwSh/PokemonSilhouettes.png",              "PokemonSwSh/PokemonSprites.json"},
+    {"PokemonSwSh/PokemonSprites.png",                  "PokemonSwSh/PokemonSprites.json"},
+};
+
+}
+
+
+
+BuildSpritePacks_Descriptor::BuildSpritePacks_Descriptor()
+    : ComputerProgramDescriptor(
+        "Computer:BuildSpritePacks",
+        "Computer", "Build Sprite Packs",
+        "",
+        "Precompile the sprite databases into sprite packs that load without decoding any images."
+    )
+{}
+BuildSpritePacks::BuildSpritePacks()
+    : DESCRIPTION(
+        "Load every sprite database from its PNG and JSON, then write a \".spritepack\" "
+        "next to the PNG. The program will use the packs from then on until the PNG or "
+        "JSON changes. Rerun this whenever the sprites are updated."
+    )
+{
+    PA_ADD_OPTION(DESCRIPTION);
+}
+
+
+
+void BuildSpritePacks::program(ProgramEnvironment& env, CancellableScope& scope){
+    auto ms = [](auto duration){
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / 1000.;
+    };
+
+    for (const SpriteSource& source : SPRITE_SOURCES){
+        scope.throw_if_cancelled();
+
+        WallClock time_start = current_time();
+        SpriteDatabase database(source.sprite_path, source.json_path, false);
+        WallClock time_loaded = current_time();
+
+        std::string path = SpriteDatabase::pack_path(source.sprite_path);
+        database.write_pack(path, source.sprite_path, source.json_path);
+        WallClock time_written = current_time();
+
+        //  Make sure it reads back.
+        SpriteDatabase pack(path);
+        WallClock time_end = current_time();
+        if (pack.get().size() != database.get().size()){
+            throw FileException(&env.logger(), PA_CURRENT_FUNCTION, "Sprite pack did not read back correctly.", path);
+        }
+
+        env.log(
+            std::string(source.sprite_path) + ": " + std::to_string(database.get().size()) +
+            " sprites, load from sources: " + std::to_string(ms(time_loaded - time_start)) +
+            " ms, write: " + std::to_string(ms(time_written - time_loaded)) +
+            " ms, load from pack: " + std::to_string(ms(time_end - time_written)) + " ms"
+        );
+    }
+    env.log("All sprite packs written.", COLOR_BLUE);
+}
+
+
+
+
+}
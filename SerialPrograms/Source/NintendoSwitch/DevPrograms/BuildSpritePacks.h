@@ -0,0 +1,39 @@
+/*  Build Sprite Packs
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      Precompile every sprite database into a sprite pack. (see SpritePack.h)
+ *
+ */
+
+#ifndef PokemonAutomation_Computer_BuildSpritePacks_H
+#define PokemonAutomation_Computer_BuildSpritePacks_H
+
+#include "Common/Cpp/Options/StaticTextOption.h"
+#include "ComputerPrograms/ComputerProgram.h"
+
+namespace PokemonAutomation{
+
+
+class BuildSpritePacks_Descriptor : public ComputerProgramDescriptor{
+public:
+    BuildSpritePacks_Descriptor();
+};
+
+
+
+class BuildSpritePacks : public ComputerProgramInstance{
+public:
+    BuildSpritePacks();
+
+    virtual void program(ProgramEnvironment& env, CancellableScope& scope) override;
+
+private:
+    StaticTextOption DESCRIPTION;
+};
+
+
+
+
+}
+#endif
@@ -170,7 +170,7 @@ SandwichFillingMatcher::SandwichFillingMatcher(const std::vector<double>& min_eu
         m_min_euclidean_distance_squared.emplace_back(x * x);
     }
     for (const auto& item : SANDWICH_FILLINGS_DATABASE()){
-        add(item.first, item.second.sprite);
+        add_cropped(item.first, item.second.icon, item.second.icon_stats);
     }
 }
 auto SandwichFillingMatcher::get_crop_candidates(const ImageViewRGB32& image) const -> std::vector<ImageViewRGB32>{
@@ -206,7 +206,7 @@ SandwichCondimentMatcher::SandwichCondimentMatcher(const std::vector<double>& mi
         m_min_euclidean_distance_squared.emplace_back(x * x);
     }
     for (const auto& item : SANDWICH_CONDIMENTS_DATABASE()){
-        add(item.first, item.second.sprite);
+        add_cropped(item.first, item.second.icon, item.second.icon_stats);
     }
 }
 auto SandwichCondimentMatcher::get_crop_candidates(const ImageViewRGB32& image) const -> std::vector<ImageViewRGB32>{
@@ -190,6 +190,8 @@ public:
     // The OCR works on any ingredient, selected or not
     OCR::StringMatchResult read_with_ocr(const ImageViewRGB32& screen, Logger& logger, Language language) const;
 
+    const ImageFloatBox& text_box() const{ return m_text_box; }
+
 private:
     Color m_color;
     ImageFloatBox m_icon_box;
@@ -55,7 +55,7 @@ PokemonSpriteMatcherCropped::PokemonSpriteMatcherCropped(const std::set<std::str
     for (const auto& item : ALL_POKEMON_SPRITES()){
         if (subset == nullptr || subset->find(item.first) != subset->end()){
 //            cout << item.first << endl;
-            add(item.first, item.second.sprite);
+            add_cropped(item.first, item.second.icon, item.second.icon_stats);
         }
     }
 }
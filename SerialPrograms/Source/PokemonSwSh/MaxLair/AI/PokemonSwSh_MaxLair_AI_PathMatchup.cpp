@@ -4,12 +4,17 @@
  *
  */
 
+#include <cmath>
+#include <limits>
+#include <algorithm>
 #include <map>
+#include <functional>
 #include "Common/Cpp/Exceptions.h"
 #include "Common/Cpp/Json/JsonValue.h"
 #include "Common/Cpp/Json/JsonArray.h"
 #include "Common/Cpp/Json/JsonObject.h"
 #include "CommonFramework/Globals.h"
+#include "CommonFramework/Logging/Logger.h"
 #include "PokemonSwSh/Resources/PokemonSwSh_MaxLairDatabase.h"
 #include "PokemonSwSh/PkmnLib/PokemonSwSh_PkmnLib_Pokemon.h"
 #include "PokemonSwSh_MaxLair_AI_PathMatchup.h"
@@ -20,15 +25,28 @@ namespace PokemonSwSh{
 namespace MaxLairInternal{
 
 
+//  Number of PokemonType values. (including NONE)
+const size_t TYPE_COUNT = (size_t)PokemonType::FAIRY + 1;
+
+
 struct PathMatchDatabase{
     std::map<PokemonType, std::set<std::string>> rentals_by_type;
-    std::map<std::string, std::map<PokemonType, double>> type_vs_boss;
+
+    //  type_vs_boss[boss * TYPE_COUNT + type]. NaN for PokemonType::NONE.
+    std::vector<double> type_vs_boss;
+
+    //  type_vs_boss_type[boss_type * TYPE_COUNT + type]
+    std::vector<double> type_vs_boss_type;
 
     static const PathMatchDatabase& instance(){
         static PathMatchDatabase database;
         return database;
     }
 
+    bool has_boss(BossId boss) const{
+        return !std::isnan(type_vs_boss[(size_t)boss * TYPE_COUNT + (size_t)PokemonType::NORMAL]);
+    }
+
 private:
     PathMatchDatabase(){
         std::string path = RESOURCE_PATH() + "PokemonSwSh/MaxLair/path_tree.json";
@@ -50,9 +68,18 @@ private:
             }
         }
 
+        //  The boss IDs come from the rental/boss database. A tree that is
+        //  out of sync with it should not stop the AI from loading. So skip
+        //  the bosses it doesn't know about.
+        const std::map<std::string, papkmnlib::Pokemon>& bosses = papkmnlib::all_boss_pokemon();
+        type_vs_boss.resize(boss_count() * TYPE_COUNT, std::numeric_limits<double>::quiet_NaN());
         JsonObject& node = root.get_object_throw("base_node", path).get_object_throw("hash_table");
         for (auto& item : node){
-            std::map<PokemonType, double>& boss = type_vs_boss[item.first];
+            if (bosses.find(item.first) == bosses.end()){
+                global_logger_tagged().log("Path tree has unknown boss: " + item.first, COLOR_ORANGE);
+                continue;
+            }
+            double* boss = type_vs_boss.data() + (size_t)boss_id(item.first) * TYPE_COUNT;
 
             JsonObject& obj = item.second.get_object_throw(path).get_object_throw("hash_table", path);
 
@@ -60,7 +87,41 @@ private:
                 if (type.first == PokemonType::NONE){
                     continue;
                 }
-                boss[type.first] = obj.get_double_throw(type.second, path);
+                boss[(size_t)type.first] = obj.get_double_throw(type.second, path);
+            }
+        }
+
+        //  Bosses missing from the tree keep their NaN scores. They are left
+        //  out of the averages and throw if they are looked up directly.
+        for (const auto& item : all_bosses_by_dex()){
+            if (!has_boss(boss_id(item.second))){
+                global_logger_tagged().log("Path tree is missing boss: " + item.second, COLOR_ORANGE);
+            }
+        }
+
+        //  Average over the bosses of each type.
+        using namespace papkmnlib;
+        type_vs_boss_type.resize(TYPE_COUNT * TYPE_COUNT, std::numeric_limits<double>::quiet_NaN());
+        for (size_t boss_type = 0; boss_type < TYPE_COUNT; boss_type++){
+            Type pkmnlib_type = serial_type_to_pkmnlib((PokemonType)boss_type);
+            double sum[TYPE_COUNT] = {};
+            size_t count = 0;
+            for (const auto& item : all_bosses_by_dex()){
+                BossId boss = boss_id(item.second);
+                if (!has_boss(boss)){
+                    continue;
+                }
+                if (boss_type != (size_t)PokemonType::NONE && !boss_pokemon(boss).has_type(pkmnlib_type)){
+                    continue;
+                }
+                const double* scores = type_vs_boss.data() + (size_t)boss * TYPE_COUNT;
+                for (size_t type = 0; type < TYPE_COUNT; type++){
+                    sum[type] += scores[type];
+                }
+                count++;
+            }
+            for (size_t type = 1; type < TYPE_COUNT; type++){
+                type_vs_boss_type[boss_type * TYPE_COUNT + type] = sum[type] / count;
             }
         }
     }
@@ -78,38 +139,38 @@ const std::set<std::string>& rentals_by_type(PokemonType type){
     return iter->second;
 }
 
-double type_vs_boss(PokemonType type, const std::string& boss_slug){
+const double* type_scores_vs_boss(BossId boss){
     const PathMatchDatabase& database = PathMatchDatabase::instance();
-
-    auto iter0 = database.type_vs_boss.find(boss_slug);
-    if (iter0 == database.type_vs_boss.end()){
-        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Invalid Boss: " + boss_slug);
+    if (!database.has_boss(boss)){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Invalid Boss: " + boss_pokemon(boss).name());
+    }
+    return database.type_vs_boss.data() + (size_t)boss * TYPE_COUNT;
+}
+const double* type_scores_vs_boss_type(PokemonType boss_type){
+    if ((size_t)boss_type >= TYPE_COUNT){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Invalid Type: " + std::to_string((int)boss_type));
     }
+    const PathMatchDatabase& database = PathMatchDatabase::instance();
+    return database.type_vs_boss_type.data() + (size_t)boss_type * TYPE_COUNT;
+}
 
-    auto iter1 = iter0->second.find(type);
-    if (iter1 == iter0->second.end()){
+namespace{
+double get_type_score(const double* scores, PokemonType type){
+    if ((size_t)type >= TYPE_COUNT || type == PokemonType::NONE){
         throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Invalid Type: " + std::to_string((int)type));
     }
+    return scores[(size_t)type];
+}
+}
 
-    return iter1->second;
+double type_vs_boss(PokemonType type, const std::string& boss_slug){
+    return get_type_score(type_scores_vs_boss(boss_id(boss_slug)), type);
 }
 double type_vs_boss(PokemonType type, PokemonType boss_type){
-    using namespace papkmnlib;
-
-    Type pkmnlib_type = serial_type_to_pkmnlib(boss_type);
+    return get_type_score(type_scores_vs_boss_type(boss_type), type);
+}
 
-    double weight = 0;
-    size_t count = 0;
-    for (const auto& item : all_bosses_by_dex()){
-        const Pokemon& boss = get_pokemon(item.second);
-        if (boss_type == PokemonType::NONE || boss.has_type(pkmnlib_type)){
-            weight += type_vs_boss(type, boss.name());
-            count++;
-        }
-    }
 
-    return weight / (double)count;
-}
 
 
 
@@ -121,128 +182,149 @@ double type_vs_boss(PokemonType type, PokemonType boss_type){
 
 
 
+namespace{
 
+//  The lair as a graph. Each row of a level is one node the player can be at
+//  (the side they came from) and lists the nodes reachable from it.
+struct PathEdge{
+    uint8_t slot;   //  Path slot as seen from the current node.
+    uint8_t mon;    //  Index into "mon1", "mon2" or "mon3".
+    int8_t side;    //  Which node of the next level this leads to.
+};
+struct PathChoices{
+    uint8_t count;
+    PathEdge edges[3];
+};
 
-void append_subpath(
-    std::vector<std::vector<PathNode>>& paths,
-    const PathNode& node,
-    const std::vector<std::vector<PathNode>>& subpaths
-){
-    for (const auto& item : subpaths){
-        paths.emplace_back();
-        std::vector<PathNode>& path = paths.back();
-        path.emplace_back(node);
-        path.insert(path.end(), item.begin(), item.end());
+//  [path_type][side]
+const PathChoices LEVEL1[3][2] = {
+    {
+        {3, {{0, 0, 0}, {1, 1, 0}, {2, 2, 0}}},
+        {2, {{0, 2, 0}, {1, 3, 1}}},
+    },
+    {
+        {2, {{0, 0, 0}, {1, 1, 0}}},
+        {3, {{0, 1, 0}, {1, 2, 1}, {2, 3, 1}}},
+    },
+    {
+        {2, {{0, 0, 0}, {1, 1, 1}}},
+        {2, {{0, 2, 1}, {1, 3, 1}}},
+    },
+};
+const PathChoices LEVEL2[3][2] = {
+    {
+        {2, {{0, 0, 0}, {1, 1, 0}}},
+        {3, {{0, 1, 0}, {1, 2, 0}, {2, 3, 0}}},
+    },
+    {
+        {3, {{0, 0, 0}, {1, 1, 0}, {2, 2, 0}}},
+        {2, {{0, 2, 0}, {1, 3, 0}}},
+    },
+    {
+        {2, {{0, 0, 0}, {1, 1, 0}}},
+        {3, {{0, 1, 0}, {1, 2, 0}, {2, 3, 0}}},
+    },
+};
+const PathChoices LEVEL0 = {2, {{0, 0, 0}, {1, 1, 1}}};
+
+const PathChoices& path_choices(const PathMap& map, size_t level, int8_t side){
+    size_t s = side == 0 ? 0 : 1;
+    switch (level){
+    case 0:
+        return LEVEL0;
+    case 1:
+        return LEVEL1[map.path_type][s];
+    default:
+        return LEVEL2[map.path_type][s];
+    }
+}
+PokemonType path_type_at(const PathMap& map, size_t level, uint8_t mon){
+    switch (level){
+    case 0:
+        return map.mon1[mon];
+    case 1:
+        return map.mon2[mon];
+    default:
+        return map.mon3[mon];
     }
 }
-std::vector<std::vector<PathNode>> generate_paths(
-    const PathMap& map, uint8_t wins, int8_t side
-){
-    std::vector<std::vector<PathNode>> ret;
 
-    if (wins == 0){
-        append_subpath(ret, {0, map.mon1[0]}, generate_paths(map, 1, 0));
-        append_subpath(ret, {1, map.mon1[1]}, generate_paths(map, 1, 1));
+}
+
+
+PathList enumerate_paths(const PathMap& map, uint8_t wins, int8_t side){
+    PathList ret;
+    if (wins > 2 || map.path_type < 0 || map.path_type > 2){
         return ret;
     }
-
-    if (side == -1){
+    if (wins > 0 && side == -1){
         return ret;
     }
 
-    if (wins == 1){
-        std::vector<std::vector<PathNode>> left = generate_paths(map, 2, 0);
-        std::vector<std::vector<PathNode>> right = generate_paths(map, 2, 1);
-        switch (map.path_type){
-        case 0:
-            if (side == 0){
-                append_subpath(ret, {0, map.mon2[0]}, left);
-                append_subpath(ret, {1, map.mon2[1]}, left);
-                append_subpath(ret, {2, map.mon2[2]}, left);
-            }else{
-                append_subpath(ret, {0, map.mon2[2]}, left);
-                append_subpath(ret, {1, map.mon2[3]}, right);
-            }
-            break;
-        case 1:
-            if (side == 0){
-                append_subpath(ret, {0, map.mon2[0]}, left);
-                append_subpath(ret, {1, map.mon2[1]}, left);
-            }else{
-                append_subpath(ret, {0, map.mon2[1]}, left);
-                append_subpath(ret, {1, map.mon2[2]}, right);
-                append_subpath(ret, {2, map.mon2[3]}, right);
+    //  Depth-first in slot order. So the paths come out in the same order as
+    //  the recursive version did.
+    const size_t depth = 3 - wins;
+    FlatPath path;
+    path.length = (uint8_t)depth;
+    uint8_t index[3] = {0, 0, 0};
+    int8_t sides[3] = {side, 0, 0};
+    size_t current = 0;
+    while (true){
+        const PathChoices& choices = path_choices(map, wins + current, sides[current]);
+        if (index[current] == choices.count){
+            if (current == 0){
+                break;
             }
-            break;
-        case 2:
-            if (side == 0){
-                append_subpath(ret, {0, map.mon2[0]}, left);
-                append_subpath(ret, {1, map.mon2[1]}, right);
-            }else{
-                append_subpath(ret, {0, map.mon2[2]}, right);
-                append_subpath(ret, {1, map.mon2[3]}, right);
-            }
-            break;
+            index[current] = 0;
+            current--;
+            index[current]++;
+            continue;
         }
-        return ret;
-    }
 
-    if (wins == 2){
-        switch (map.path_type){
-        case 0:
-            if (side == 0){
-                ret.emplace_back(std::vector<PathNode>{PathNode{0, map.mon3[0]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{1, map.mon3[1]}});
-            }else{
-                ret.emplace_back(std::vector<PathNode>{PathNode{0, map.mon3[1]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{1, map.mon3[2]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{2, map.mon3[3]}});
-            }
-            break;
-        case 1:
-            if (side == 0){
-                ret.emplace_back(std::vector<PathNode>{PathNode{0, map.mon3[0]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{1, map.mon3[1]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{2, map.mon3[2]}});
-            }else{
-                ret.emplace_back(std::vector<PathNode>{PathNode{0, map.mon3[2]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{1, map.mon3[3]}});
-            }
-            break;
-        case 2:
-            if (side == 0){
-                ret.emplace_back(std::vector<PathNode>{PathNode{0, map.mon3[0]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{1, map.mon3[1]}});
-            }else{
-                ret.emplace_back(std::vector<PathNode>{PathNode{0, map.mon3[1]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{1, map.mon3[2]}});
-                ret.emplace_back(std::vector<PathNode>{PathNode{2, map.mon3[3]}});
-            }
-            break;
+        const PathEdge& edge = choices.edges[index[current]];
+        path.nodes[current] = PathNode{edge.slot, path_type_at(map, wins + current, edge.mon)};
+        if (current + 1 < depth){
+            current++;
+            sides[current] = edge.side;
+            continue;
         }
-        return ret;
+
+        ret.paths[ret.count++] = path;
+        index[current]++;
     }
 
     return ret;
 }
+std::vector<std::vector<PathNode>> generate_paths(
+    const PathMap& map, uint8_t wins, int8_t side
+){
+    PathList paths = enumerate_paths(map, wins, side);
+    std::vector<std::vector<PathNode>> ret;
+    ret.reserve(paths.count);
+    for (size_t c = 0; c < paths.count; c++){
+        ret.emplace_back(paths.paths[c].to_vector());
+    }
+    return ret;
+}
 
 
-template <typename Boss>
-double evaluate_path(const Boss& boss, const std::vector<PathNode>& path){
-    if (path.size() > 3){
-        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Path is longer than 3: " + std::to_string(path.size()));
-    }
-    const double weights[] = {1, 2, 3};
-    double weight = 0;
+namespace{
+
+const double PATH_WEIGHTS[] = {1, 2, 3};
 
-    size_t battle_index = 3 - path.size();
+//  "type_scores" is from "type_scores_vs_boss()" or "type_scores_vs_boss_type()".
+double evaluate_path(const double* type_scores, const FlatPath& path){
+    double weight = 0;
+    size_t battle_index = 3 - path.length;
     size_t node_index = 0;
     for (; battle_index < 3; node_index++, battle_index++){
-        weight += type_vs_boss(path[node_index].type, boss) * weights[battle_index];
+        weight += get_type_score(type_scores, path.nodes[node_index].type) * PATH_WEIGHTS[battle_index];
     }
     return weight;
 }
 
+}
+
 
 std::vector<PathNode> select_path(
     Logger* logger,
@@ -254,36 +336,78 @@ std::vector<PathNode> select_path(
 //        return {};
 //    }
 
-    std::vector<std::vector<PathNode>> paths = generate_paths(pathmap, wins, path_side);
-    if (paths.empty()){
+    PathList paths = enumerate_paths(pathmap, wins, path_side);
+    if (paths.count == 0){
         if (logger){
             logger->log("No available paths due to read errors.", COLOR_RED);
         }
         return {};
     }
 
-    std::multimap<double, std::vector<PathNode>, std::greater<double>> rank;
-    if (boss.empty()){
-        for (const std::vector<PathNode>& path : paths){
-            rank.emplace(evaluate_path(pathmap.boss, path), path);
-        }
-    }else{
-        for (const std::vector<PathNode>& path : paths){
-            rank.emplace(evaluate_path(boss, path), path);
+    const double* type_scores = boss.empty()
+        ? type_scores_vs_boss_type(pathmap.boss)
+        : type_scores_vs_boss(boss_id(boss));
+
+    //  Every type is looked up first so that a bad read throws no matter
+    //  which paths get pruned.
+    const size_t depth = 3 - wins;
+    double level_max[3] = {
+        -std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(),
+    };
+    for (size_t c = 0; c < paths.count; c++){
+        for (size_t n = 0; n < depth; n++){
+            level_max[n] = std::max(level_max[n], get_type_score(type_scores, paths.paths[c].nodes[n].type));
         }
     }
-    std::string str = "Available Paths:\n";
-    for (const auto& path : rank){
-        str += std::to_string(path.first);
-        str += " : ";
-        str += dump_path(path.second);
-        str += "\n";
+
+    //  Branch and bound: stop scoring a path once even the best types for
+    //  the rest of it can't beat the best path so far. The bound is summed
+    //  in the same order as the score. So it is never below it. Compared
+    //  with ">" so ties go to the earliest path and NaN scores never
+    //  replace the best.
+    size_t best_index = 0;
+    double best_score = evaluate_path(type_scores, paths.paths[0]);
+    for (size_t c = 1; c < paths.count; c++){
+        const FlatPath& path = paths.paths[c];
+        double score = 0;
+        bool pruned = false;
+        for (size_t n = 0, battle = 3 - depth; n < depth; n++, battle++){
+            score += type_scores[(size_t)path.nodes[n].type] * PATH_WEIGHTS[battle];
+            double bound = score;
+            for (size_t r = n + 1, b = battle + 1; r < depth; r++, b++){
+                bound += level_max[r] * PATH_WEIGHTS[b];
+            }
+            if (!(bound > best_score)){
+                pruned = true;
+                break;
+            }
+        }
+        if (!pruned){
+            best_index = c;
+            best_score = score;
+        }
     }
+
+    //  The log still shows every path ranked by score. That scores them all
+    //  again, but only when there is someone to read it.
     if (logger){
+        std::multimap<double, size_t, std::greater<double>> rank;
+        for (size_t c = 0; c < paths.count; c++){
+            rank.emplace(evaluate_path(type_scores, paths.paths[c]), c);
+        }
+        std::string str = "Available Paths:\n";
+        for (const auto& path : rank){
+            str += std::to_string(path.first);
+            str += " : ";
+            str += dump_path(paths.paths[path.second].to_vector());
+            str += "\n";
+        }
         logger->log(str);
     }
 
-    return std::move(rank.begin()->second);
+    return paths.paths[best_index].to_vector();
 }
 
 
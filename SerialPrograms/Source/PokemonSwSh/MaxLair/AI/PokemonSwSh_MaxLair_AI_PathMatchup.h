@@ -12,6 +12,7 @@
 #include "CommonFramework/Logging/Logger.h"
 #include "Pokemon/Pokemon_Types.h"
 #include "PokemonSwSh/MaxLair/Framework/PokemonSwSh_MaxLair_State.h"
+#include "PokemonSwSh_MaxLair_AI_RentalBossMatchup.h"
 
 namespace PokemonAutomation{
 namespace NintendoSwitch{
@@ -24,8 +25,39 @@ const std::set<std::string>& rentals_by_type(PokemonType type);
 double type_vs_boss(PokemonType type, const std::string& boss_slug);
 double type_vs_boss(PokemonType type, PokemonType boss_type);
 
+//  The scores of every type against the boss. Indexed by PokemonType.
+//  Throws if the boss is not in the path tree.
+const double* type_scores_vs_boss(BossId boss);
 
+//  Same as above, but averaged over all the bosses of "boss_type".
+//  (PokemonType::NONE for all bosses)
+const double* type_scores_vs_boss_type(PokemonType boss_type);
 
+
+
+//  A path from the current position to the boss. One node per remaining
+//  battle. So "length" is "3 - wins".
+struct FlatPath{
+    uint8_t length = 0;
+    PathNode nodes[3];
+
+    std::vector<PathNode> to_vector() const{
+        return std::vector<PathNode>(nodes, nodes + length);
+    }
+};
+
+//  Every path from the current position. The most a map can have is 2 x 3 x 3.
+struct PathList{
+    static constexpr size_t MAX_PATHS = 18;
+
+    size_t count = 0;
+    FlatPath paths[MAX_PATHS];
+};
+
+PathList enumerate_paths(const PathMap& map, uint8_t wins, int8_t side);
+
+
+//  Same as above, but as vectors.
 std::vector<std::vector<PathNode>> generate_paths(
     const PathMap& map, uint8_t wins, int8_t side
 );
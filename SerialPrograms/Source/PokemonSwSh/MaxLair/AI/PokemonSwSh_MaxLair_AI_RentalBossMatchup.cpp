@@ -4,6 +4,8 @@
  *
  */
 
+#include <cmath>
+#include <limits>
 #include <map>
 #include "Common/Cpp/Exceptions.h"
 #include "Common/Cpp/Json/JsonValue.h"
@@ -20,63 +22,155 @@ namespace MaxLairInternal{
 
 
 struct MatchupDatabase{
-    std::map<std::string, std::map<std::string, double>> map;
+    std::vector<const papkmnlib::Pokemon*> rentals;
+    std::vector<const papkmnlib::Pokemon*> bosses;
+    std::map<std::string, RentalId> rental_ids;
+    std::map<std::string, BossId> boss_ids;
+
+    //  table[rental * bosses.size() + boss]. NaN if the LUT doesn't have it.
+    std::vector<float> table;
+
+    //  Average of each boss over all the rentals.
+    std::vector<double> average_vs_boss;
 
     static const MatchupDatabase& instance(){
         static MatchupDatabase database;
         return database;
     }
 
-    double get(const std::string& rental, const std::string& boss) const{
-        auto iter0 = map.find(rental);
-        if (iter0 == map.end()){
-            throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Rental not found: " + rental);
-        }
-        auto iter1 = iter0->second.find(boss);
-        if (iter1 == iter0->second.end()){
-            throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Boss not found: " + rental);
+    double get(RentalId rental, BossId boss) const{
+        float score = table[(size_t)rental * bosses.size() + boss];
+        if (std::isnan(score)){
+            throw InternalProgramError(
+                nullptr, PA_CURRENT_FUNCTION,
+                "Matchup not found: " + rentals[rental]->name() + " vs. " + bosses[boss]->name()
+            );
         }
-        return iter1->second;
+        return score;
     }
 
 private:
     MatchupDatabase(){
+        using namespace papkmnlib;
+
+        for (const auto& item : all_rental_pokemon()){
+            rental_ids.emplace(item.first, (RentalId)rentals.size());
+            rentals.emplace_back(&item.second);
+        }
+        for (const auto& item : all_boss_pokemon()){
+            boss_ids.emplace(item.first, (BossId)bosses.size());
+            bosses.emplace_back(&item.second);
+        }
+        table.resize(rentals.size() * bosses.size(), std::numeric_limits<float>::quiet_NaN());
+
         std::string path = RESOURCE_PATH() + "PokemonSwSh/MaxLair/boss_matchup_LUT.json";
         JsonValue json = load_json_file(path);
         JsonObject& root = json.get_object_throw(path);
         for (auto& item0 : root){
-            std::map<std::string, double>& sub = map[item0.first];
+            auto rental = rental_ids.find(item0.first);
+            if (rental == rental_ids.end()){
+                continue;
+            }
+            float* row = table.data() + (size_t)rental->second * bosses.size();
             JsonObject& obj = item0.second.get_object_throw(path);
             for (auto& item1 : obj){
-                sub[item1.first] = item1.second.get_double_throw(path);
+                auto boss = boss_ids.find(item1.first);
+                if (boss == boss_ids.end()){
+                    continue;
+                }
+                row[boss->second] = (float)item1.second.get_double_throw(path);
             }
         }
+
+        average_vs_boss.resize(bosses.size(), std::numeric_limits<double>::quiet_NaN());
+        for (size_t boss = 0; boss < bosses.size(); boss++){
+            double sum = 0;
+            for (size_t rental = 0; rental < rentals.size(); rental++){
+                sum += table[rental * bosses.size() + boss];
+            }
+            average_vs_boss[boss] = sum / rentals.size();
+        }
     }
 };
 
-double rental_vs_boss_matchup(const std::string& rental, const std::string& boss){
-    return MatchupDatabase::instance().get(rental, boss);
+
+
+size_t rental_count(){
+    return MatchupDatabase::instance().rentals.size();
 }
-double rental_vs_boss_matchup(const std::string& rental, const std::vector<std::string>& bosses){
-    using namespace papkmnlib;
+size_t boss_count(){
+    return MatchupDatabase::instance().bosses.size();
+}
+RentalId rental_id(const std::string& slug){
+    const MatchupDatabase& database = MatchupDatabase::instance();
+    auto iter = database.rental_ids.find(slug);
+    if (iter == database.rental_ids.end()){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Rental not found: " + slug);
+    }
+    return iter->second;
+}
+BossId boss_id(const std::string& slug){
+    const MatchupDatabase& database = MatchupDatabase::instance();
+    auto iter = database.boss_ids.find(slug);
+    if (iter == database.boss_ids.end()){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Boss not found: " + slug);
+    }
+    return iter->second;
+}
+const papkmnlib::Pokemon& rental_pokemon(RentalId rental){
+    return *MatchupDatabase::instance().rentals[rental];
+}
+const papkmnlib::Pokemon& boss_pokemon(BossId boss){
+    return *MatchupDatabase::instance().bosses[boss];
+}
+
 
+
+double rental_vs_boss_matchup(RentalId rental, BossId boss){
+    return MatchupDatabase::instance().get(rental, boss);
+}
+double rental_vs_boss_matchup(RentalId rental, const std::vector<BossId>& bosses){
+    const MatchupDatabase& database = MatchupDatabase::instance();
     double score = 0;
     if (bosses.empty()){
-        const auto& all_bosses = all_boss_pokemon();
-        for (const auto& boss : all_bosses){
-            score += rental_vs_boss_matchup(rental, boss.second.name());
+        for (size_t boss = 0; boss < database.bosses.size(); boss++){
+            score += database.get(rental, (BossId)boss);
         }
-        score /= bosses.size();
+        score /= database.bosses.size();
     }else{
-        for (const std::string& boss : bosses){
-            score += rental_vs_boss_matchup(rental, boss);
+        for (BossId boss : bosses){
+            score += database.get(rental, boss);
         }
         score /= bosses.size();
     }
     return score;
 }
+double average_rental_vs_boss_matchup(BossId boss){
+    const MatchupDatabase& database = MatchupDatabase::instance();
+    double score = database.average_vs_boss[boss];
+    if (std::isnan(score)){
+        throw InternalProgramError(
+            nullptr, PA_CURRENT_FUNCTION,
+            "Matchup table is incomplete for: " + database.bosses[boss]->name()
+        );
+    }
+    return score;
+}
+
 
 
+double rental_vs_boss_matchup(const std::string& rental, const std::string& boss){
+    return rental_vs_boss_matchup(rental_id(rental), boss_id(boss));
+}
+double rental_vs_boss_matchup(const std::string& rental, const std::vector<std::string>& bosses){
+    std::vector<BossId> ids;
+    ids.reserve(bosses.size());
+    for (const std::string& boss : bosses){
+        ids.emplace_back(boss_id(boss));
+    }
+    return rental_vs_boss_matchup(rental_id(rental), ids);
+}
+
 
 
 
@@ -7,8 +7,10 @@
 #ifndef PokemonAutomation_PokemonSwSh_MaxLair_AI_RentalBossMatchup_H
 #define PokemonAutomation_PokemonSwSh_MaxLair_AI_RentalBossMatchup_H
 
+#include <stdint.h>
 #include <string>
 #include <vector>
+#include "PokemonSwSh/PkmnLib/PokemonSwSh_PkmnLib_Pokemon.h"
 
 namespace PokemonAutomation{
 namespace NintendoSwitch{
@@ -16,6 +18,35 @@ namespace PokemonSwSh{
 namespace MaxLairInternal{
 
 
+//  Dense IDs for the rental and boss Pokemon. They are the indices into
+//  "all_rental_pokemon()" and "all_boss_pokemon()".
+//
+//  The AI works entirely with these. Slugs are only converted at the edges.
+using RentalId = uint16_t;
+using BossId = uint16_t;
+
+size_t rental_count();
+size_t boss_count();
+
+//  Throw InternalProgramError if the slug is not a rental/boss.
+RentalId rental_id(const std::string& slug);
+BossId boss_id(const std::string& slug);
+
+const papkmnlib::Pokemon& rental_pokemon(RentalId rental);
+const papkmnlib::Pokemon& boss_pokemon(BossId boss);
+
+
+
+//  Scores from "boss_matchup_LUT.json".
+double rental_vs_boss_matchup(RentalId rental, BossId boss);
+
+//  Average over "bosses". If it's empty, average over all the bosses.
+double rental_vs_boss_matchup(RentalId rental, const std::vector<BossId>& bosses);
+
+//  Average over all the rentals.
+double average_rental_vs_boss_matchup(BossId boss);
+
+
 double rental_vs_boss_matchup(const std::string& rental, const std::string& boss);
 double rental_vs_boss_matchup(const std::string& rental, const std::vector<std::string>& bosses);
 
@@ -39,8 +39,7 @@ std::vector<PathNode> select_path(
         COLOR_PURPLE
     );
 
-    std::vector<std::vector<PathNode>> paths = generate_paths(state.path, state.wins, state.path_side);
-    if (paths.empty()){
+    if (enumerate_paths(state.path, state.wins, state.path_side).count == 0){
         return {};
     }
 
@@ -32,7 +32,7 @@ int8_t select_starter(
 
     using namespace papkmnlib;
 
-    std::vector<const Pokemon*> bosses = get_boss_candidates(state);
+    std::vector<BossId> bosses = get_boss_candidates(state);
     if (bosses.empty()){
         logger.log("Cannot pick a starter since there are no boss candidates.", COLOR_RED);
         return 0;
@@ -44,12 +44,7 @@ int8_t select_starter(
             continue;
         }
 //        const Pokemon& rental = get_pokemon(options[c]);
-        double score = 0;
-        for (const Pokemon* boss : bosses){
-//            score += evaluate_matchup(rental, *boss, {}, 4);
-            score += rental_vs_boss_matchup(options[c], boss->name());
-        }
-        score /= bosses.size();
+        double score = rental_vs_boss_matchup(rental_id(options[c]), bosses);
         rank.emplace(score, c);
     }
     if (rank.empty()){
@@ -46,7 +46,7 @@ bool should_swap_with_newly_caught(
     std::vector<const Pokemon*> rental_candidates_on_path =
         get_rental_candidates_on_path_pkmnlib(state);
 
-    std::vector<const Pokemon*> boss_candidates_on_path =
+    std::vector<BossId> boss_candidates_on_path =
         get_boss_candidates(state);
 
     std::unique_ptr<Pokemon> current_team[4];
@@ -40,7 +40,7 @@ bool should_swap_with_professor(
     std::vector<const Pokemon*> rental_candidates_on_path =
         get_rental_candidates_on_path_pkmnlib(state);
 
-    std::vector<const Pokemon*> boss_candidates_on_path =
+    std::vector<BossId> boss_candidates_on_path =
         get_boss_candidates(state);
 
     std::unique_ptr<Pokemon> current_team[4];
@@ -52,12 +52,12 @@ bool should_swap_with_professor(
 
     //  Find the "average" rental against this boss.
     std::multimap<double, const Pokemon*> list;
-    for (const Pokemon* boss : boss_candidates_on_path){
+    for (BossId boss : boss_candidates_on_path){
         for (const auto& rental : all_rental_pokemon()){
             if (state.seen.find(rental.first) != state.seen.end()){
                 continue;
             }
-            list.emplace(evaluate_matchup(rental.second, *boss, {}, lives), &rental.second);
+            list.emplace(evaluate_matchup(rental.second, boss_pokemon(boss), {}, lives), &rental.second);
         }
     }
     if (list.empty()){
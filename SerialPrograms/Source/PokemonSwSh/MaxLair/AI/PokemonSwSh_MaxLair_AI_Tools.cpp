@@ -69,20 +69,19 @@ std::vector<const papkmnlib::Pokemon*> get_rental_candidates_on_path_pkmnlib(con
     }
     return candidates;
 }
-std::vector<const papkmnlib::Pokemon*> get_boss_candidates(const GlobalState& state){
+std::vector<BossId> get_boss_candidates(const GlobalState& state){
     using namespace papkmnlib;
-    std::vector<const Pokemon*> candidates;
+    std::vector<BossId> candidates;
     if (state.boss.empty()){
         PokemonType boss_type = state.path.boss;
         Type pkmnlib_type = serial_type_to_pkmnlib(boss_type);
-        for (const auto& item : all_boss_pokemon()){
-            const Pokemon& boss = get_pokemon(item.first);
-            if (boss_type == PokemonType::NONE || boss.has_type(pkmnlib_type)){
-                candidates.emplace_back(&boss);
+        for (size_t c = 0; c < boss_count(); c++){
+            if (boss_type == PokemonType::NONE || boss_pokemon((BossId)c).has_type(pkmnlib_type)){
+                candidates.emplace_back((BossId)c);
             }
         }
     }else{
-        candidates.emplace_back(&get_pokemon(state.boss));
+        candidates.emplace_back(boss_id(state.boss));
     }
     return candidates;
 }
@@ -91,30 +90,19 @@ std::vector<const papkmnlib::Pokemon*> get_boss_candidates(const GlobalState& st
 
 
 
-double rental_vs_boss_matchup(const std::string& rental, const std::vector<const papkmnlib::Pokemon*>& bosses){
-    using namespace papkmnlib;
-
+//  If "rental" is null, average over all the rentals.
+double rental_vs_boss_matchup(const papkmnlib::Pokemon* rental, const std::vector<BossId>& bosses){
     if (bosses.empty()){
         throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Boss list cannot be empty.");
     }
+    if (rental != nullptr){
+        return rental_vs_boss_matchup(rental_id(rental->name()), bosses);
+    }
     double score = 0;
-    if (rental.empty()){
-        for (const Pokemon* boss : bosses){
-            for (const auto& candidate : all_rental_pokemon()){
-                score += rental_vs_boss_matchup(candidate.first, boss->name());
-            }
-        }
-        score /= bosses.size() * all_rental_pokemon().size();
-    }else{
-        for (const Pokemon* boss : bosses){
-            score += rental_vs_boss_matchup(rental, boss->name());
-        }
-        score /= bosses.size();
+    for (BossId boss : bosses){
+        score += average_rental_vs_boss_matchup(boss);
     }
-    return score;
-}
-double rental_vs_boss_matchup(const papkmnlib::Pokemon* rental, const std::vector<const papkmnlib::Pokemon*>& bosses){
-    return rental_vs_boss_matchup(rental == nullptr ? "" : rental->name(), bosses);
+    return score / bosses.size();
 }
 
 
@@ -123,7 +111,7 @@ double evaluate_hypothetical_team(
     const GlobalState& state,
     const papkmnlib::Pokemon* team[4],
     const std::vector<const papkmnlib::Pokemon*>& rental_candidates_on_path,
-    const std::vector<const papkmnlib::Pokemon*>& boss_candidates_on_path
+    const std::vector<BossId>& boss_candidates_on_path
 ){
     using namespace papkmnlib;
 
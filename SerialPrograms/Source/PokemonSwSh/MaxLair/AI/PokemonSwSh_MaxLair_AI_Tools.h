@@ -11,6 +11,7 @@
 #include "CommonFramework/Logging/Logger.h"
 #include "PokemonSwSh/PkmnLib/PokemonSwSh_PkmnLib_Pokemon.h"
 #include "PokemonSwSh/MaxLair/Framework/PokemonSwSh_MaxLair_State.h"
+#include "PokemonSwSh_MaxLair_AI_RentalBossMatchup.h"
 
 namespace PokemonAutomation{
 namespace NintendoSwitch{
@@ -23,14 +24,14 @@ std::unique_ptr<papkmnlib::Pokemon> convert_player_to_pkmnlib(const PlayerState&
 
 
 std::vector<const papkmnlib::Pokemon*> get_rental_candidates_on_path_pkmnlib(const GlobalState& state);
-std::vector<const papkmnlib::Pokemon*> get_boss_candidates(const GlobalState& state);
+std::vector<BossId> get_boss_candidates(const GlobalState& state);
 
 
 double evaluate_hypothetical_team(
     const GlobalState& state,
     const papkmnlib::Pokemon* team[4],
     const std::vector<const papkmnlib::Pokemon*>& rental_candidates_on_path,
-    const std::vector<const papkmnlib::Pokemon*>& boss_candidates_on_path
+    const std::vector<BossId>& boss_candidates_on_path
 );
 
 
@@ -4,7 +4,10 @@
  *
  */
 
-#include <set>
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include "Common/Cpp/Exceptions.h"
 #include "PokemonSwSh_PkmnLib_Battle.h"
 
 namespace PokemonAutomation{
@@ -38,163 +41,164 @@ void calc_damage_range(
     // done
 }
 
-double ability_damage_multiplier(const Pokemon& attacker, const Pokemon& defender, const Move& move){
-
-    // final multiplier that we're going to modify
-    double multiplier = 1.0;
-
-    const std::string& attacker_ability = attacker.ability();
-    const std::string& defender_ability = defender.ability();
-//    const std::string& move_name = attack_move.name();
-    Type move_type = move.type();
-
-    do{
-        if (attacker_ability == "mold-breaker") break;
-        if (attacker_ability == "turboblaze") break;
-        if (attacker_ability == "teravolt") break;
-        if (attacker_ability == "tinted-lens"){
-            if (damage_multiplier(move_type, defender.type1(), defender.type2()) < 1.0){
-                multiplier *= 2.0;
-            }
-            break;
-        }
-
-        switch (move_type){
-        case Type::ground:
-            if (defender_ability == "levitate"){
-                if (move == "thousand-arrows"){
-                    multiplier = 1.0;
-                }else{
-                    multiplier = 0.0;
-                }
-            }
-            break;
-
-        case Type::water:
-            if (defender_ability == "water-absorb" ||
-                defender_ability == "storm-drain" ||
-                defender_ability == "dry-skin"
-            ){
-//                multiplier = -1.0;
-                multiplier = 0.0;
-            }
-            break;
-
-        case Type::fire:
-            if (defender_ability == "flash-fire"){
-//                multiplier = -1.0;
-                multiplier = 0.0;
-            }else if (defender_ability == "fluffy" || defender_ability == "dry-skin"){
-                multiplier = 2.0;
-            }else if (defender_ability == "thick-fat" || defender_ability == "heatproof"){
-                multiplier = 0.5;
-            }
-            break;
-
-        case Type::grass:
-            if (defender_ability == "sap-sipper"){
-//                multiplier = -1.0;
-                multiplier = 0.0;
-            }
-            break;
-
-        case Type::electric:
-            if (defender_ability == "lightning-rod" ||
-                defender_ability == "motor-drive" ||
-                defender_ability == "volt-absorb"
-            ){
-//                multiplier = -1.0;
-                multiplier = 0.0;
-            }
-            break;
-
-        case Type::ice:
-            if (defender_ability == "thick-fat"){
-                multiplier = 0.5;
-            }
-            break;
-
-        default:;
-        }
-    }while (false);
-
-    if (attacker_ability == "iron-fist"){
-        static std::set<std::string> MOVES{
-            verify_move_slug("bullet-punch"),
-            verify_move_slug("comet-punch"),
-            verify_move_slug("dizzy-punch"),
-            verify_move_slug("double-iron-bash"),
-            verify_move_slug("drain-punch"),
-            verify_move_slug("dynamic-punch"),
-            verify_move_slug("fire-punch"),
-            verify_move_slug("focus-punch"),
-            verify_move_slug("hammer-arm"),
-            verify_move_slug("ice-hammer"),
-            verify_move_slug("ice-punch"),
-            verify_move_slug("mach-punch"),
-            verify_move_slug("mega-punch"),
-            verify_move_slug("meteor-mash"),
-            verify_move_slug("plasma-fists"),
-            verify_move_slug("power-up-punch"),
-            verify_move_slug("shadow-punch"),
-            verify_move_slug("sky-uppercut"),
-            verify_move_slug("surging-strikes"),
-            verify_move_slug("thunder-punch"),
-            verify_move_slug("wicked-blow"),
-        };
-        if (MOVES.find(move.name()) != MOVES.end()){
-            multiplier *= 1.2;
-        }
-    }else if (attacker_ability == "strong-jaw"){
-        static std::set<std::string> MOVES{
-            verify_move_slug("bite"),
-            verify_move_slug("crunch"),
-            verify_move_slug("fire-fang"),
-            verify_move_slug("fishious-rend"),
-            verify_move_slug("hyper-fang"),
-            verify_move_slug("ice-fang"),
-            verify_move_slug("jaw-lock"),
-            verify_move_slug("poison-fang"),
-            verify_move_slug("psychic-fangs"),
-            verify_move_slug("thunder-fang"),
-        };
-        if (MOVES.find(move.name()) != MOVES.end()){
-            multiplier *= 1.5;
+//  Everything the damage formula looks up by name is resolved once up front.
+//  So scoring a move doesn't copy it or compare strings.
+namespace{
+
+enum MoveTrait : uint16_t{
+    WEATHER_BALL        = 1 << 0,
+    SOLAR_BEAM          = 1 << 1,
+    THUNDER_HURRICANE   = 1 << 2,
+    BLIZZARD            = 1 << 3,
+    TERRAIN_PULSE       = 1 << 4,
+    EXPANDING_FORCE     = 1 << 5,
+    RISING_VOLTAGE      = 1 << 6,
+    THOUSAND_ARROWS     = 1 << 7,
+    BODY_PRESS          = 1 << 8,
+    FOUL_PLAY           = 1 << 9,
+    PSYSTRIKE_PSYSHOCK  = 1 << 10,
+    PUNCH               = 1 << 11,  //  Boosted by iron-fist.
+    BITE                = 1 << 12,  //  Boosted by strong-jaw.
+};
+
+uint16_t compute_move_traits(const Move& move){
+    static const std::unordered_map<std::string, uint16_t> TRAITS{
+        {"weather-ball",        WEATHER_BALL},
+        {"solar-beam",          SOLAR_BEAM},
+        {"thunder",             THUNDER_HURRICANE},
+        {"hurricane",           THUNDER_HURRICANE},
+        {"blizzard",            BLIZZARD},
+        {"terrain-pulse",       TERRAIN_PULSE},
+        {"expanding-force",     EXPANDING_FORCE},
+        {"rising-voltage",      RISING_VOLTAGE},
+        {"thousand-arrows",     THOUSAND_ARROWS},
+        {"body-press",          BODY_PRESS},
+        {"foul-play",           FOUL_PLAY},
+        {"psystrike",           PSYSTRIKE_PSYSHOCK},
+        {"psyshock",            PSYSTRIKE_PSYSHOCK},
+        {"bullet-punch",        PUNCH},
+        {"comet-punch",         PUNCH},
+        {"dizzy-punch",         PUNCH},
+        {"double-iron-bash",    PUNCH},
+        {"drain-punch",         PUNCH},
+        {"dynamic-punch",       PUNCH},
+        {"fire-punch",          PUNCH},
+        {"focus-punch",         PUNCH},
+        {"hammer-arm",          PUNCH},
+        {"ice-hammer",          PUNCH},
+        {"ice-punch",           PUNCH},
+        {"mach-punch",          PUNCH},
+        {"mega-punch",          PUNCH},
+        {"meteor-mash",         PUNCH},
+        {"plasma-fists",        PUNCH},
+        {"power-up-punch",      PUNCH},
+        {"shadow-punch",        PUNCH},
+        {"sky-uppercut",        PUNCH},
+        {"surging-strikes",     PUNCH},
+        {"thunder-punch",       PUNCH},
+        {"wicked-blow",         PUNCH},
+        {"bite",                BITE},
+        {"crunch",              BITE},
+        {"fire-fang",           BITE},
+        {"fishious-rend",       BITE},
+        {"hyper-fang",          BITE},
+        {"ice-fang",            BITE},
+        {"jaw-lock",            BITE},
+        {"poison-fang",         BITE},
+        {"psychic-fangs",       BITE},
+        {"thunder-fang",        BITE},
+    };
+    auto iter = TRAITS.find(move.name());
+    return iter == TRAITS.end() ? 0 : iter->second;
+}
+uint16_t move_traits(const Move& move){
+    //  Pokemon point into the move database. So look those up by address.
+    static const std::unordered_map<const Move*, uint16_t> DATABASE = []{
+        std::unordered_map<const Move*, uint16_t> ret;
+        for (const auto& item : all_moves_by_id()){
+            ret[item.second] = compute_move_traits(*item.second);
         }
-    }else if (attacker_ability == "adaptability"){
-        if (move_type == attacker.type1() || move_type == attacker.type2()){
-            multiplier *= (4.0 / 3.0);
+        for (const auto& item : all_max_moves_by_id()){
+            ret[item.second] = compute_move_traits(*item.second);
         }
-    }
-
-    return multiplier;
+        return ret;
+    }();
+    auto iter = DATABASE.find(&move);
+    return iter == DATABASE.end() ? compute_move_traits(move) : iter->second;
 }
 
-double weather_damage_multiplier(Move& move, const Field& field){
 
-    double modifier = 1.0;
+//  The abilities that the damage formula checks for. Abilities that behave the
+//  same share a value. Everything else is NONE.
+enum class DamageAbility : uint8_t{
+    NONE,
+    MOLD_BREAKER,   //  Also turboblaze and teravolt.
+    TINTED_LENS,
+    IRON_FIST,
+    STRONG_JAW,
+    ADAPTABILITY,
+    ATE,            //  refrigerate, aerilate, galvanize and pixilate
+    NORMALIZE,
+    FAIRY_AURA,
+    DARK_AURA,
+    LEVITATE,
+    WATER_ABSORB,   //  Also storm-drain.
+    DRY_SKIN,
+    FLASH_FIRE,
+    FLUFFY,
+    THICK_FAT,
+    HEATPROOF,
+    SAP_SIPPER,
+    VOLT_ABSORB,    //  Also lightning-rod and motor-drive.
+};
+
+DamageAbility damage_ability(const std::string& ability){
+    static const std::unordered_map<std::string, DamageAbility> ABILITIES{
+        {"mold-breaker",    DamageAbility::MOLD_BREAKER},
+        {"turboblaze",      DamageAbility::MOLD_BREAKER},
+        {"teravolt",        DamageAbility::MOLD_BREAKER},
+        {"tinted-lens",     DamageAbility::TINTED_LENS},
+        {"iron-fist",       DamageAbility::IRON_FIST},
+        {"strong-jaw",      DamageAbility::STRONG_JAW},
+        {"adaptability",    DamageAbility::ADAPTABILITY},
+        {"refrigerate",     DamageAbility::ATE},
+        {"aerilate",        DamageAbility::ATE},
+        {"galvanize",       DamageAbility::ATE},
+        {"pixilate",        DamageAbility::ATE},
+        {"normalize",       DamageAbility::NORMALIZE},
+        {"fairy-aura",      DamageAbility::FAIRY_AURA},
+        {"dark-aura",       DamageAbility::DARK_AURA},
+        {"levitate",        DamageAbility::LEVITATE},
+        {"water-absorb",    DamageAbility::WATER_ABSORB},
+        {"storm-drain",     DamageAbility::WATER_ABSORB},
+        {"dry-skin",        DamageAbility::DRY_SKIN},
+        {"flash-fire",      DamageAbility::FLASH_FIRE},
+        {"fluffy",          DamageAbility::FLUFFY},
+        {"thick-fat",       DamageAbility::THICK_FAT},
+        {"heatproof",       DamageAbility::HEATPROOF},
+        {"sap-sipper",      DamageAbility::SAP_SIPPER},
+        {"lightning-rod",   DamageAbility::VOLT_ABSORB},
+        {"motor-drive",     DamageAbility::VOLT_ABSORB},
+        {"volt-absorb",     DamageAbility::VOLT_ABSORB},
+    };
+    auto iter = ABILITIES.find(ability);
+    return iter == ABILITIES.end() ? DamageAbility::NONE : iter->second;
+}
 
-//    const std::string& attacker_ability = attacker.ability();
-//    const std::string& defender_ability = defender.ability();
-//    const std::string& move_name = move.name();
-    Type move_type = move.type();
 
-    switch (field.weather()){
+double weather_multiplier(Type move_type, uint16_t traits, Weather weather){
+    double modifier = 1.0;
+    switch (weather){
     case Weather::CLEAR:
-        if (move == "weather-ball"){
-            move.set_type(Type::normal);
-        }
         break;
     case Weather::SUN:
-        if (move == "solar-beam"){
+        if (traits & SOLAR_BEAM){
             modifier *= 2.0;
-        }else if (move == "thunder" || move == "hurricane"){
+        }else if (traits & THUNDER_HURRICANE){
             modifier *= (0.5 / 0.7);
-        }else if (move == "weather-ball"){
-            move.set_type(Type::fire);
+        }else if (traits & WEATHER_BALL){
             modifier *= 2.0;
         }
-
         if (move_type == Type::fire){
             modifier *= 1.5;
         }else if (move_type == Type::water){
@@ -202,15 +206,13 @@ double weather_damage_multiplier(Move& move, const Field& field){
         }
         break;
     case Weather::RAIN:
-        if (move == "solar-beam"){
+        if (traits & SOLAR_BEAM){
             modifier *= 0.5;
-        }else if (move == "thunder" || move == "hurricane"){
+        }else if (traits & THUNDER_HURRICANE){
             modifier *= (1.0 / 0.7);
-        }else if (move == "weather-ball"){
-            move.set_type(Type::water);
+        }else if (traits & WEATHER_BALL){
             modifier *= 2.0;
         }
-
         if (move_type == Type::fire){
             modifier *= 0.5;
         }else if (move_type == Type::water){
@@ -218,54 +220,40 @@ double weather_damage_multiplier(Move& move, const Field& field){
         }
         break;
     case Weather::HAIL:
-        if (move == "solar-beam"){
+        if (traits & SOLAR_BEAM){
             modifier *= 0.5;
-        }else if (move == "blizzard"){
+        }else if (traits & BLIZZARD){
             modifier *= (1.0 / 0.7);
-        }else if (move == "weather-ball"){
+        }else if (traits & WEATHER_BALL){
             modifier *= 2.0;
-            move.set_type(Type::ice);
         }
         break;
     case Weather::SANDSTORM:
-        if (move == "solar-beam"){
+        if (traits & SOLAR_BEAM){
             modifier *= 0.5;
-        }else if (move == "weather-ball"){
+        }else if (traits & WEATHER_BALL){
             modifier *= 2.0;
-            move.set_type(Type::rock);
         }
         break;
     }
-
     return modifier;
 }
 
-double terrain_damage_multiplier(const Pokemon& attacker, const Pokemon& defender, Move& move, const Field& field){
+//  Rising voltage only needs the defender to be grounded.
+double terrain_multiplier(
+    Type move_type, uint16_t traits, Terrain terrain,
+    bool attacker_grounded, bool defender_grounded
+){
     double modifier = 1.0;
-
-    // if there's no terrain, just exit
-    if (field.is_none_terrain()){
+    if (terrain == Terrain::NONE){
         return modifier;
     }
-
-//    const std::string& attacker_ability = attacker.ability();
-//    const std::string& defender_ability = defender.ability();
-//    const std::string& move_name = move.name();
-    Type move_type = move.type();
-
-    bool is_flying = (attacker.type1() == Type::flying) || (attacker.type2() == Type::flying);
-    bool is_levitate = attacker.ability() == "levitate";
-
-    if (!is_flying || !is_levitate)
-    {
-        // TODO: investigate the modifier based on terrain pulse
-        // bulbapedia says that the power *doubles* to 100 *and* gets powered up from the terrain
-        switch (field.terrain()){
+    if (attacker_grounded){
+        switch (terrain){
         case Terrain::NONE:
             break;
         case Terrain::ELECTRIC:
-            if (move == "terrain-pulse"){
-                move.set_type(Type::electric);
+            if (traits & TERRAIN_PULSE){
                 modifier *= 1.5;
             }
             if (move_type == Type::electric){
@@ -273,8 +261,7 @@ double terrain_damage_multiplier(const Pokemon& attacker, const Pokemon& defende
             }
             break;
         case Terrain::GRASSY:
-            if (move == "terrain-pulse"){
-                move.set_type(Type::grass);
+            if (traits & TERRAIN_PULSE){
                 modifier *= 1.5;
             }
             if (move_type == Type::grass){
@@ -282,10 +269,7 @@ double terrain_damage_multiplier(const Pokemon& attacker, const Pokemon& defende
             }
             break;
         case Terrain::PSYCHIC:
-            if (move == "terrain-pulse"){
-                move.set_type(Type::psychic);
-                modifier *= 1.5;
-            }else if (move == "expanding-force"){
+            if (traits & (TERRAIN_PULSE | EXPANDING_FORCE)){
                 modifier *= 1.5;
             }
             if (move_type == Type::psychic){
@@ -293,146 +277,363 @@ double terrain_damage_multiplier(const Pokemon& attacker, const Pokemon& defende
             }
             break;
         case Terrain::MISTY:
-            if (move == "terrain-pulse"){
-                move.set_type(Type::fairy);
-//                modifier *= 1.3;
-            }
             if (move_type == Type::dragon){
                 modifier *= 0.5;
             }
             break;
         }
     }
+    if (defender_grounded && terrain == Terrain::ELECTRIC && (traits & RISING_VOLTAGE)){
+        modifier *= 2.0;
+    }
+    return modifier;
+}
 
-    // rising voltage applies if the defender is affected by the terrain
-    is_flying = (defender.type1() == Type::flying) || (defender.type2() == Type::flying);
-    is_levitate = defender.ability() == "levitate";
+//  Abilities that block a type set the multiplier to zero.
+double ability_multiplier(
+    const Pokemon& attacker, DamageAbility attacker_ability, DamageAbility defender_ability,
+    Type move_type, uint16_t traits, float effectiveness
+){
+    double multiplier = 1.0;
 
-    if (!is_flying || !is_levitate){
-        if (field.is_electric()){
-            if (move == "rising-voltage"){
-                modifier *= 2.0;
+    switch (attacker_ability){
+    case DamageAbility::MOLD_BREAKER:
+        break;
+    case DamageAbility::TINTED_LENS:
+        if (effectiveness < 1.0){
+            multiplier *= 2.0;
+        }
+        break;
+    default:
+        switch (move_type){
+        case Type::ground:
+            if (defender_ability == DamageAbility::LEVITATE){
+                multiplier = (traits & THOUSAND_ARROWS) ? 1.0 : 0.0;
+            }
+            break;
+        case Type::water:
+            if (defender_ability == DamageAbility::WATER_ABSORB || defender_ability == DamageAbility::DRY_SKIN){
+                multiplier = 0.0;
+            }
+            break;
+        case Type::fire:
+            if (defender_ability == DamageAbility::FLASH_FIRE){
+                multiplier = 0.0;
+            }else if (defender_ability == DamageAbility::FLUFFY || defender_ability == DamageAbility::DRY_SKIN){
+                multiplier = 2.0;
+            }else if (defender_ability == DamageAbility::THICK_FAT || defender_ability == DamageAbility::HEATPROOF){
+                multiplier = 0.5;
+            }
+            break;
+        case Type::grass:
+            if (defender_ability == DamageAbility::SAP_SIPPER){
+                multiplier = 0.0;
             }
+            break;
+        case Type::electric:
+            if (defender_ability == DamageAbility::VOLT_ABSORB){
+                multiplier = 0.0;
+            }
+            break;
+        case Type::ice:
+            if (defender_ability == DamageAbility::THICK_FAT){
+                multiplier = 0.5;
+            }
+            break;
+        default:;
         }
     }
 
-    return modifier;
-}
-
-double damage_score(
-    const Pokemon& attacker, const Pokemon& defender,
-    size_t moveIdx, const Field& field, bool multipleTargets
-){
+    switch (attacker_ability){
+    case DamageAbility::IRON_FIST:
+        if (traits & PUNCH){
+            multiplier *= 1.2;
+        }
+        break;
+    case DamageAbility::STRONG_JAW:
+        if (traits & BITE){
+            multiplier *= 1.5;
+        }
+        break;
+    case DamageAbility::ADAPTABILITY:
+        if (attacker.is_stab(move_type)){
+            multiplier *= (4.0 / 3.0);
+        }
+        break;
+    default:;
+    }
 
-    // get the right attacker move
-    Move move = attacker.is_dynamax() ? attacker.max_move(moveIdx) : attacker.move(moveIdx);
+    return multiplier;
+}
 
-    // NOTE: starting the multiplier that we're using at 1.0 because the damage calculation function
-    // includes the "ranges" for high and low damage, so we can use that to calculate an average
-    double avgMultiplier = move.correction_factor();
-    // NOTE: the original function used to call accuracy here, it's now included at the end
-    // avgMultiplier *= move.getAccuracy();
 
-    // then if we're dealing with multiple targets and it's a spread
+//  Fill in slot "index" of "batch" for "move" of "attacker".
+void prepare_damage_move(
+    DamageBatch& batch, size_t index, const Move& move,
+    const Pokemon& attacker, DamageAbility attacker_ability,
+    const Pokemon& defender, DamageAbility defender_ability,
+    const Field& field, bool multipleTargets
+){
+    //  Not affected by terrain only if both flying and levitating.
+    bool attacker_grounded = !(attacker.has_type(Type::flying) && attacker_ability == DamageAbility::LEVITATE);
+    bool defender_grounded = !(defender.has_type(Type::flying) && defender_ability == DamageAbility::LEVITATE);
+    bool burned = attacker.non_volatile_status_effect() == NonVolatileStatusEffects::BURN;
+    bool fairy_aura = attacker_ability == DamageAbility::FAIRY_AURA || defender_ability == DamageAbility::FAIRY_AURA;
+    bool dark_aura = attacker_ability == DamageAbility::DARK_AURA || defender_ability == DamageAbility::DARK_AURA;
+
+    //  Moves are scored with their listed type. Weather ball, terrain pulse
+    //  and the -ate abilities only change the multiplier.
+    uint16_t traits = move_traits(move);
+    Type type = move.type();
+    float effectiveness = damage_multiplier(type, defender.type1(), defender.type2());
+
+    //  The damage range already averages the random roll. So this starts
+    //  from the move's correction factor rather than 0.925.
+    double modifier = move.correction_factor();
     if (multipleTargets && move.is_spread()){
-        avgMultiplier *= 0.75;
+        modifier *= 0.75;
+    }
+    modifier *= weather_multiplier(type, traits, field.weather());
+    modifier *= terrain_multiplier(type, traits, field.terrain(), attacker_grounded, defender_grounded);
+    if (type == Type::normal){
+        if (attacker_ability == DamageAbility::ATE){
+            modifier *= 1.2;
+        }
+    }else if (attacker_ability == DamageAbility::NORMALIZE){
+        modifier *= 1.2;
+    }
+    if (attacker.is_stab(type)){
+        modifier *= 1.5;
+    }
+    if (!((traits & THOUSAND_ARROWS) && defender.has_type(Type::flying))){
+        modifier *= effectiveness;
+    }
+    if (move.category() == MoveCategory::PHYSICAL && burned){
+        modifier *= 0.5;
+    }
+    modifier *= ability_multiplier(attacker, attacker_ability, defender_ability, type, traits, effectiveness);
+    if (type == Type::fairy && fairy_aura){
+        modifier *= 1.33;
+    }
+    if (type == Type::dark && dark_aura){
+        modifier *= 1.33;
     }
 
-    // ignore crits for now
-    // TODO: any high-crit chance moves could be incorporated
-
-    // get the weather damage mod
-    avgMultiplier *= weather_damage_multiplier(move, field);
-    // get the terrain damage mod
-    avgMultiplier *= terrain_damage_multiplier(attacker, defender, move, field);
-
-    // calculations for refrigerate, aerilate, galvanize, pixilate, and normalize done before stab
-    if (move.type() == Type::normal){
-        if (attacker.ability() == "refrigerate"){
-            move.set_type(Type::ice);
-            avgMultiplier *= 1.2;
-        }else if (attacker.ability() == "aerilate"){
-            move.set_type(Type::flying);
-            avgMultiplier *= 1.2;
-        }else if (attacker.ability() == "galvanize"){
-            move.set_type(Type::electric);
-            avgMultiplier *= 1.2;
-        }else if (attacker.ability() == "pixilate"){
-            move.set_type(Type::fairy);
-            avgMultiplier *= 1.2;
+    uint16_t attack, defense;
+    if (move.category() == MoveCategory::PHYSICAL){
+        if (traits & BODY_PRESS){
+            attack = attacker.defense();
+        }else if (traits & FOUL_PLAY){
+            attack = defender.attack();
+        }else{
+            attack = attacker.attack();
         }
+        defense = defender.defense();
     }else{
-        if (attacker.ability() == "normalize"){
-            move.set_type(Type::normal);
-            avgMultiplier *= 1.2;
-        }
+        attack = attacker.special_attack();
+        defense = (traits & PSYSTRIKE_PSYSHOCK) ? defender.defense() : defender.special_defense();
     }
 
-    // now we determine stab
-    if (attacker.is_stab(move.type())){
-        avgMultiplier *= 1.5;
-    }
+    batch.power[index] = move.base_power();
+    batch.attack[index] = attack;
+    batch.defense[index] = defense;
+    batch.modifier[index] = modifier;
+    batch.accuracy[index] = move.accuracy();
+}
 
-    // and now we deal with type effectiveness
-    if (!(move == "thousand-arrows" && defender.has_type(Type::flying))){
-        avgMultiplier *= damage_multiplier(move.type(), defender.type1(), defender.type2());
+void prepare_damage_batch(
+    DamageBatch& batch,
+    const Pokemon& attacker, DamageAbility attacker_ability,
+    const Pokemon& defender, DamageAbility defender_ability,
+    const Field& field, bool multipleTargets
+){
+    size_t count = attacker.num_moves();
+    if (count > DamageBatch::MAX_MOVES){
+        throw InternalProgramError(
+            nullptr, PA_CURRENT_FUNCTION,
+            "Too many moves: mon = " + attacker.name() + ", moves = " + std::to_string(count)
+        );
     }
-
-    // apply status effects
-    if (move.category() == MoveCategory::PHYSICAL && attacker.non_volatile_status_effect() == NonVolatileStatusEffects::BURN){
-        avgMultiplier *= 0.5;
+    batch.count = count;
+    batch.level = attacker.level();
+    for (size_t c = 0; c < count; c++){
+        const Move& move = attacker.is_dynamax() ? attacker.max_move(c) : attacker.move(c);
+        prepare_damage_move(
+            batch, c, move,
+            attacker, attacker_ability,
+            defender, defender_ability,
+            field, multipleTargets
+        );
     }
+}
+
+}
 
-    // apply modifiers from ability
-    avgMultiplier *= ability_damage_multiplier(attacker, defender, move);
 
-    // apply boosts from aura
-    if (move.type() == Type::fairy && (attacker.ability() == "fairy-aura" || defender.ability() == "fairy-aura")){
-        avgMultiplier *= 1.33;
+void prepare_damage_batch(
+    DamageBatch& batch,
+    const Pokemon& attacker, const Pokemon& defender,
+    const Field& field, bool multipleTargets
+){
+    prepare_damage_batch(
+        batch,
+        attacker, damage_ability(attacker.ability()),
+        defender, damage_ability(defender.ability()),
+        field, multipleTargets
+    );
+}
+
+void calc_damage_rolls(const DamageBatch& batch, uint16_t rolls[][16]){
+    //  Same integer math as calc_damage_range().
+    int level_factor = (2 * (int)batch.level) / 5 + 2;
+    for (size_t c = 0; c < batch.count; c++){
+        double attack_defense = (double)batch.attack[c] / (double)batch.defense[c];
+        int base_damage = (int)((level_factor * batch.power[c] * attack_defense) / 50 + 2);
+        double modifier = batch.modifier[c];
+        uint16_t* out = rolls[c];
+        for (int r = 0; r < 16; r++){
+            out[r] = (uint16_t)((base_damage * (85 + r) / 100) * modifier);
+        }
     }
+}
 
-    if (move.type() == Type::dark && (attacker.ability() == "dark-aura" || defender.ability() == "dark-aura")){
-        avgMultiplier *= 1.33;
+void calc_damage_scores(const DamageBatch& batch, double* scores){
+    uint16_t rolls[DamageBatch::MAX_MOVES][16];
+    calc_damage_rolls(batch, rolls);
+    for (size_t c = 0; c < batch.count; c++){
+        scores[c] = (rolls[c][0] + rolls[c][15]) * batch.accuracy[c] / 2;
     }
+}
 
-    // attacker and defender stats time
-    // declare the attack and defense stats
-    uint16_t attackUse, defenseUse;
+double damage_score(
+    const Pokemon& attacker, const Pokemon& defender,
+    size_t moveIdx, const Field& field, bool multipleTargets
+){
+    const Move& move = attacker.is_dynamax() ? attacker.max_move(moveIdx) : attacker.move(moveIdx);
+    DamageBatch batch;
+    batch.count = 1;
+    batch.level = attacker.level();
+    prepare_damage_move(
+        batch, 0, move,
+        attacker, damage_ability(attacker.ability()),
+        defender, damage_ability(defender.ability()),
+        field, multipleTargets
+    );
+    double score;
+    calc_damage_scores(batch, &score);
+    return score;
+}
 
-    if (move.category() == MoveCategory::PHYSICAL){
-        if (move == "body-press"){
-            attackUse = attacker.defense();
-        }else if (move == "foul-play"){
-            attackUse = defender.attack();
-        }else{
-            attackUse = attacker.attack();
-        }
-        defenseUse = defender.defense();
-    }else{
-        attackUse = attacker.special_attack();
-        if (move == "psystrike" || move == "psyshock"){
-            defenseUse = defender.defense();
-        }else{
-            defenseUse = defender.special_defense();
+
+
+namespace{
+
+//  Everything the batch reads, packed into words. Moves are identified by
+//  address since they all live in the move database. (which is never
+//  reloaded, so the addresses are never reused)
+using DamageKey = std::array<uint64_t, 9>;
+
+struct DamageKeyHash{
+    size_t operator()(const DamageKey& key) const{
+        uint64_t hash = 0;
+        for (uint64_t word : key){
+            hash = (hash ^ word) * 0x9e3779b97f4a7c15;
+            hash ^= hash >> 32;
         }
+        return (size_t)hash;
     }
+};
+
+DamageKey make_damage_key(
+    const Pokemon& attacker, DamageAbility attacker_ability,
+    const Pokemon& defender, DamageAbility defender_ability,
+    const Field& field, bool multipleTargets
+){
+    DamageKey key{};
+    size_t count = std::min(attacker.num_moves(), DamageBatch::MAX_MOVES);
+    for (size_t c = 0; c < count; c++){
+        const Move& move = attacker.is_dynamax() ? attacker.max_move(c) : attacker.move(c);
+        key[c] = (uint64_t)(uintptr_t)&move;
+    }
+    key[5] = (uint64_t)attacker.level()
+        | (uint64_t)attacker.type1() << 8
+        | (uint64_t)attacker.type2() << 16
+        | (uint64_t)attacker_ability << 24
+        | (uint64_t)attacker.attack() << 32
+        | (uint64_t)attacker.defense() << 48;
+    key[6] = (uint64_t)attacker.special_attack()
+        | (uint64_t)attacker.is_dynamax() << 16
+        | (uint64_t)(attacker.non_volatile_status_effect() == NonVolatileStatusEffects::BURN) << 17
+        | (uint64_t)multipleTargets << 18
+        | (uint64_t)field.weather() << 24
+        | (uint64_t)field.terrain() << 32
+        | (uint64_t)attacker.num_moves() << 40;
+    key[7] = (uint64_t)defender.type1()
+        | (uint64_t)defender.type2() << 8
+        | (uint64_t)defender_ability << 16
+        | (uint64_t)defender.attack() << 32
+        | (uint64_t)defender.defense() << 48;
+    key[8] = defender.special_defense();
+    return key;
+}
+
+}
+
 
-    // then calculate the damage
-    uint16_t damageLow, damageHigh;
-    // NOTE: the calcDamageRanges function will give the max damage and the min damage
-    // no need to include the 0.925 modifier above!
-    calc_damage_range(
-        move.base_power(), attacker.level(), attackUse, defenseUse, avgMultiplier,
-        damageLow, damageHigh
+DamageScores cached_damage_scores(
+    const Pokemon& attacker, const Pokemon& defender,
+    const Field& field, bool multipleTargets
+){
+    //  Every rental against every boss with every field is a few hundred
+    //  thousand entries. Start over long before that.
+    constexpr size_t MAX_ENTRIES = 1 << 16;
+
+    //  The MaxLair AI runs on every console thread. So keep one per thread
+    //  rather than lock.
+    thread_local std::unordered_map<DamageKey, DamageScores, DamageKeyHash> cache;
+
+    DamageAbility attacker_ability = damage_ability(attacker.ability());
+    DamageAbility defender_ability = damage_ability(defender.ability());
+    DamageKey key = make_damage_key(
+        attacker, attacker_ability,
+        defender, defender_ability,
+        field, multipleTargets
     );
 
-    // so get the average between the two multiplied by accuracy
-    double damageScore = (damageLow + damageHigh) * move.accuracy() / 2;
+    auto iter = cache.find(key);
+    if (iter != cache.end()){
+        return iter->second;
+    }
 
-//    // return the move type back to its original value
-//    move.reset_move_type();
+    DamageBatch batch;
+    prepare_damage_batch(
+        batch,
+        attacker, attacker_ability,
+        defender, defender_ability,
+        field, multipleTargets
+    );
+    DamageScores scores;
+    scores.count = batch.count;
+    calc_damage_scores(batch, scores.score);
 
-    return damageScore;
+    if (cache.size() >= MAX_ENTRIES){
+        cache.clear();
+    }
+    cache.emplace(key, scores);
+    return scores;
+}
+double cached_damage_score(
+    const Pokemon& attacker, const Pokemon& defender,
+    size_t moveIdx, const Field& field, bool multipleTargets
+){
+    DamageScores scores = cached_damage_scores(attacker, defender, field, multipleTargets);
+    if (moveIdx >= scores.count){
+        throw InternalProgramError(
+            nullptr, PA_CURRENT_FUNCTION,
+            "Move index out-of-range: mon = " + attacker.name() + ", index = " + std::to_string(moveIdx)
+        );
+    }
+    return scores.score[moveIdx];
 }
 
 
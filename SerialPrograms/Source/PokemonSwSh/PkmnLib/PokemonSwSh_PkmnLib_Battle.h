@@ -23,12 +23,65 @@ void calc_damage_range(
 );
 
 
+
+
+//  The inputs to calc_damage_range() for every move of an attacker, stored
+//  as one array per input so each step runs over all the moves at once.
+struct DamageBatch{
+    static constexpr size_t MAX_MOVES = 5;
+
+    size_t count = 0;
+    uint8_t level = 0;
+    uint8_t power[MAX_MOVES];
+    uint16_t attack[MAX_MOVES];
+    uint16_t defense[MAX_MOVES];
+    double modifier[MAX_MOVES];
+    double accuracy[MAX_MOVES];
+};
+
+//  Fill "batch" for every move of "attacker" against "defender".
+void prepare_damage_batch(
+    DamageBatch& batch,
+    const Pokemon& attacker, const Pokemon& defender,
+    const Field& field, bool multipleTargets = false
+);
+
+//  Same as calc_damage_range(), but for each of the 16 random rolls. (85% to
+//  100%) The first and last rolls are the lower and upper bounds.
+void calc_damage_rolls(const DamageBatch& batch, uint16_t rolls[][16]);
+
+//  The average damage of every move in the batch, weighted by accuracy.
+void calc_damage_scores(const DamageBatch& batch, double* scores);
+
+//  calc_damage_scores() for a single move of "attacker".
 double damage_score(
     const Pokemon& attacker, const Pokemon& defender,
     size_t moveIdx, const Field& field, bool multipleTargets = false
 );
 
 
+struct DamageScores{
+    size_t count = 0;
+    double score[DamageBatch::MAX_MOVES];
+};
+
+//  damage_score() for every move of "attacker". The results are memoized
+//  per thread on everything the damage formula reads from the attacker,
+//  defender and field. (stats, types, abilities, moves, dynamax, burn,
+//  weather, terrain) So this is safe to call on modified copies.
+//
+//  Moves are keyed by address. This relies on every move coming from the
+//  move database, which is loaded once and never reloaded or freed.
+DamageScores cached_damage_scores(
+    const Pokemon& attacker, const Pokemon& defender,
+    const Field& field, bool multipleTargets = false
+);
+double cached_damage_score(
+    const Pokemon& attacker, const Pokemon& defender,
+    size_t moveIdx, const Field& field, bool multipleTargets = false
+);
+
+
 }
 }
 }
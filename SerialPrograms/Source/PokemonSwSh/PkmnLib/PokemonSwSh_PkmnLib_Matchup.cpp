@@ -37,18 +37,19 @@ double calc_average_damage(
             // we're now iterating through attackers and defenders!
             subTotalDamage = 0.0;
             // so we need to go through the moves we have and calculate the damage they can do
-            size_t numMoves = attacker->num_moves();
+            DamageScores scores = cached_damage_scores(*attacker, *defender, field, multipleTargets);
+            size_t numMoves = scores.count;
 
 #if 0
             //  Assume the other players pick random moves.
             for (size_t ii = 0; ii < numMoves; ii++){
-                subTotalDamage += damage_score(*attacker, *defender, ii, field, multipleTargets);
+                subTotalDamage += scores.score[ii];
             }
             subTotalDamage /= numMoves;
 #else
             //  Assume the other players pick the most damaging move.
             for (size_t ii = 0; ii < numMoves; ii++){
-                subTotalDamage = std::max(subTotalDamage, damage_score(*attacker, *defender, ii, field, multipleTargets));
+                subTotalDamage = std::max(subTotalDamage, scores.score[ii]);
             }
 #endif
 
@@ -74,7 +75,7 @@ double calc_move_score(
     // first start by calculating damage based on the attacker
     // no on multiple targets since we're only hitting the boss
     // TODO: set defender to dynamax?
-    double damageScore = damage_score(attacker, defender, moveIdx, field, false) / 2.0;
+    double damageScore = cached_damage_score(attacker, defender, moveIdx, field, false) / 2.0;
 
     // TODO: make sure the defender and attacker aren't in the teammates list
 
@@ -107,18 +108,24 @@ double calc_move_score(
 //    double dmax_hp_ratio = attacker.is_dynamax() ? 2.0 : 1.0;
     double dmax_hp_ratio = 1.0;
 
+    // none of these depend on which defender move it is, so get them all once
+    DamageScores spreadDamage = cached_damage_scores(defender, attacker, field, true);
+    DamageScores singleDamage = cached_damage_scores(defender, attacker, field, false);
+    double teammateSpreadDamage = calc_average_damage(tempDefenderList, teammates, field, true);
+    double teammateSingleDamage = calc_average_damage(tempDefenderList, teammates, field, false);
+
     // iterate through defender moves for non-dynamax
     for (size_t ii = 0; ii < defenderNumMoves; ii++){
         const Move& defenderMove = defender.move(ii);
         // NOTE: original function in python also checked to make sure we aren't dynamax, we already did that
         if (defenderMove.is_spread()){
             if (attackerMove != "wide-guard" || attacker.is_dynamax()){
-                receivedRegularDamage += damage_score(defender, attacker, ii, field, true) / defenderNumMoves;
-                receivedRegularDamage += 3 * calc_average_damage(tempDefenderList, teammates, field, true) / defenderNumMoves;
+                receivedRegularDamage += spreadDamage.score[ii] / defenderNumMoves;
+                receivedRegularDamage += 3 * teammateSpreadDamage / defenderNumMoves;
             }
         }else{
-            receivedRegularDamage += 0.25 * damage_score(defender, attacker, ii, field, false) / dmax_hp_ratio / defenderNumMoves;
-            receivedRegularDamage += 0.75 * calc_average_damage(tempDefenderList, teammates, field, false) / defenderNumMoves;
+            receivedRegularDamage += 0.25 * singleDamage.score[ii] / dmax_hp_ratio / defenderNumMoves;
+            receivedRegularDamage += 0.75 * teammateSingleDamage / defenderNumMoves;
         }
     }
 //    cout << "receivedRegularDamage = " << receivedRegularDamage << endl;
@@ -126,9 +133,11 @@ double calc_move_score(
     // then set up for max moves
     defender.set_is_dynamax(true);
     tempDefenderList[0] = &defender;
+    DamageScores maxMoveDamage = cached_damage_scores(defender, attacker, field, false);
+    double teammateMaxMoveDamage = calc_average_damage(tempDefenderList, teammates, field, false);
     for (size_t ii = 0; ii < defenderNumMoves; ii++){
-        receivedMaxMoveDamage += 0.25 * damage_score(defender, attacker, ii, field, false) / dmax_hp_ratio / defenderNumMoves;
-        receivedMaxMoveDamage += 0.75 * calc_average_damage(tempDefenderList, teammates, field, false) / defenderNumMoves;
+        receivedMaxMoveDamage += 0.25 * maxMoveDamage.score[ii] / dmax_hp_ratio / defenderNumMoves;
+        receivedMaxMoveDamage += 0.75 * teammateMaxMoveDamage / defenderNumMoves;
     }
 //    cout << "receivedMaxMoveDamage = " << receivedMaxMoveDamage << endl;
 
@@ -81,6 +81,9 @@ MoveCategory get_move_category_from_string(const std::string& category){
 }
 
 
+//  Loaded once and never reloaded. The moves are referenced by address from
+//  every Pokemon and from the damage cache. So they must never move or be
+//  freed.
 struct MoveDatabase{
     std::deque<Move> moves;
     std::map<uint32_t, const Move*> moves_id;
@@ -123,6 +123,7 @@ public:
     const Move& max_move(size_t index) const;
 
     // function for setting the pointers to the moves
+    // the moves must come from the move database (see cached_damage_scores())
     void set_move(const Move& move, size_t index);
     void set_max_move(const Move& move, size_t index);
 
@@ -4,8 +4,8 @@
  *
  */
 
-#include <algorithm>
 #include "Common/Cpp/PrettyPrint.h"
+#include "Kernels/Kernels_BitScan.h"
 #include "CommonFramework/Exceptions/OperationFailedException.h"
 #include "NintendoSwitch/Commands/NintendoSwitch_Commands_PushButtons.h"
 #include "PokemonSwSh/Inference/RNG/PokemonSwSh_OrbeetleAttackAnimationDetector.h"
@@ -15,6 +15,61 @@ namespace PokemonAutomation{
 namespace NintendoSwitch{
 namespace PokemonSwSh{
 
+
+LastBitMatches find_last_bit_sequence(
+    const std::vector<uint64_t>& last_bits, size_t length,
+    const std::vector<bool>& sequence
+){
+    LastBitMatches ret;
+    size_t size = sequence.size();
+    if (size == 0 || size > length){
+        return ret;
+    }
+    size_t last_start = length - size;
+
+    //  The 64 bits starting at "position". Past the end is zeros.
+    size_t words = last_bits.size();
+    auto bits_at = [&](size_t position){
+        size_t index = position / 64;
+        size_t shift = position % 64;
+        uint64_t lo = index < words ? last_bits[index] : 0;
+        if (shift == 0){
+            return lo;
+        }
+        uint64_t hi = index + 1 < words ? last_bits[index + 1] : 0;
+        return (lo >> shift) | (hi << (64 - shift));
+    };
+
+    //  All ones where the sequence has a 0.
+    std::vector<uint64_t> flip(size);
+    for (size_t k = 0; k < size; k++){
+        flip[k] = sequence[k] ? 0 : ~(uint64_t)0;
+    }
+
+    //  Shift-and with the bits transposed: bit "j" of "candidates" is whether
+    //  the sequence can still start at "start + j". Each bit of the sequence
+    //  is compared against 64 starts at once. Most blocks run out of
+    //  candidates after a few bits.
+    for (size_t start = 0; start <= last_start; start += 64){
+        uint64_t candidates = ~(uint64_t)0;
+        if (last_start - start < 63){
+            candidates = ((uint64_t)1 << (last_start - start + 1)) - 1;
+        }
+        for (size_t k = 0; k < size && candidates != 0; k++){
+            candidates &= bits_at(start + k) ^ flip[k];
+        }
+        if (candidates != 0){
+            ret.last_offset = start + Kernels::bitlength(candidates) - 1;
+        }
+        for (; candidates != 0; candidates &= candidates - 1){
+            ret.count++;
+        }
+    }
+
+    return ret;
+}
+
+
 Xoroshiro128PlusState find_rng_state(
     ConsoleHandle& console,
     BotBaseContext& context,
@@ -57,10 +112,7 @@ Xoroshiro128PlusState find_rng_state(
         }
     }
     Xoroshiro128Plus rng = Xoroshiro128Plus::xoroshiro128plus_from_last_bits(std::pair(last_bits0, last_bits1));
-
-    for (size_t j = 0; j < 128; j++){
-        rng.next();
-    }
+    rng.jump(128);
     console.log("RNG: state[0] = " + tostr_hex(rng.get_state().s0));
     console.log("RNG: state[1] = " + tostr_hex(rng.get_state().s1));
     return rng.get_state();
@@ -77,13 +129,11 @@ Xoroshiro128PlusState refind_rng_state(
     bool log_image_values)
 {
     Xoroshiro128Plus rng(last_known_state.s0, last_known_state.s1);
-    for (size_t i = 0; i < min_advances; i++){
-        rng.next();
-    }
+    rng.jump(min_advances);
     OrbeetleAttackAnimationDetector detector(console, context);
     size_t possible_indices = SIZE_MAX;
     std::vector<bool> sequence = {};
-    std::vector<bool> last_bit_sequence = rng.generate_last_bit_sequence(max_advances - min_advances);
+    std::vector<uint64_t> last_bits = rng.generate_last_bit_words(max_advances - min_advances);
     size_t distance = 0;
 
     size_t i = 0;
@@ -111,16 +161,9 @@ Xoroshiro128PlusState refind_rng_state(
         console.overlay().add_log(text, COLOR_BLUE);
         pbf_wait(context, 180);
 
-        std::vector<bool>::iterator last_bit_start = std::search(last_bit_sequence.begin(), last_bit_sequence.end(), sequence.begin(), sequence.end());
-        possible_indices = 0;
-        distance = 0;
-        while (last_bit_start != last_bit_sequence.end()){
-            possible_indices++;
-            distance = std::distance(last_bit_sequence.begin(), last_bit_start);
-
-            last_bit_start++;
-            last_bit_start = std::search(last_bit_start, last_bit_sequence.end(), sequence.begin(), sequence.end());
-        }
+        LastBitMatches matches = find_last_bit_sequence(last_bits, max_advances - min_advances, sequence);
+        possible_indices = matches.count;
+        distance = matches.last_offset;
     }
     if (possible_indices == 0){
         throw OperationFailedException(
@@ -132,9 +175,7 @@ Xoroshiro128PlusState refind_rng_state(
     distance += sequence.size();
     console.log("RNG: needed " + std::to_string(sequence.size()) + " animations.");
     console.log("RNG: new state is " + std::to_string(distance + min_advances) + " advances from last known state.");
-    for (size_t advance = 0; advance < distance; advance++){
-        rng.next();
-    }
+    rng.jump(distance);
     console.log("RNG: state[0] = " + tostr_hex(rng.get_state().s0));
     console.log("RNG: state[1] = " + tostr_hex(rng.get_state().s1));
 
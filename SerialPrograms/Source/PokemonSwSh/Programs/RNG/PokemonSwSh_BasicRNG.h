@@ -13,6 +13,19 @@ class BotBaseContext;
 namespace NintendoSwitch{
 namespace PokemonSwSh{
 
+struct LastBitMatches{
+    size_t count = 0;
+    size_t last_offset = 0;     //  Start of the last match if "count > 0".
+};
+
+// Finds every (possibly overlapping) place "sequence" occurs in the first
+// "length" bits of "last_bits". The bits are packed as by
+// Xoroshiro128Plus::generate_last_bit_words().
+LastBitMatches find_last_bit_sequence(
+    const std::vector<uint64_t>& last_bits, size_t length,
+    const std::vector<bool>& sequence
+);
+
 // Performs 128 Orbeetle attack animations. 
 // Returns the state after those animations.
 Xoroshiro128PlusState find_rng_state(
@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <set>
+#include "Common/Cpp/Concurrency/WorkStealingPool.h"
 #include "CommonFramework/Exceptions/ProgramFinishedException.h"
 #include "CommonFramework/Exceptions/OperationFailedException.h"
 #include "CommonFramework/ImageTools/ImageStats.h"
@@ -19,6 +20,7 @@
 #include "CommonFramework/VideoPipeline/VideoFeed.h"
 #include "CommonFramework/Tools/StatsTracking.h"
 #include "CommonFramework/Tools/DebugDumper.h"
+#include "Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes.h"
 #include "NintendoSwitch/Commands/NintendoSwitch_Commands_PushButtons.h"
 #include "NintendoSwitch/NintendoSwitch_Settings.h"
 #include "Pokemon/Pokemon_Strings.h"
@@ -178,65 +180,126 @@ void CramomaticRNG::navigate_to_party(SingleSwitchProgramEnvironment& env, BotBa
     pbf_wait(context, 2 * TICKS_PER_SECOND);
 }
 
-CramomaticTarget CramomaticRNG::calculate_target(SingleSwitchProgramEnvironment& env, Xoroshiro128PlusState state, std::vector<CramomaticSelection> selected_balls){
+namespace{
+
+//  Advances per SIMD batch. The states, bounds and results of a batch stay in
+//  L1 while it goes through every nextInt().
+const size_t CRAMOMATIC_CHUNK = 512;
+
+void calculate_cramomatic_outcomes_chunk(
+    CramomaticOutcome* outcomes, size_t count,
+    Xoroshiro128PlusState state, size_t num_npcs
+){
+    //  Lane "l" is the state "l" advances after "state".
+    std::vector<uint64_t> s0(count);
+    std::vector<uint64_t> s1(count);
     Xoroshiro128Plus rng(state);
-    size_t advances = 0;
-    uint16_t priority_advances = 0;
-    std::vector<CramomaticTarget> possible_targets;
+    for (size_t l = 0; l < count; l++){
+        s0[l] = rng.state.s0;
+        s1[l] = rng.state.s1;
+        rng.next();
+    }
 
-    std::sort(selected_balls.begin(), selected_balls.end(), [](CramomaticSelection sel1, CramomaticSelection sel2) { return sel1.priority > sel2.priority; });
-    // priority_advances only starts counting up after the first good result is found
-    while (priority_advances <= MAX_PRIORITY_ADVANCES){
-        // calculate the result for the current temp_rng state
-        Xoroshiro128Plus temp_rng(rng.get_state());
+    std::vector<uint64_t> bounds(count);
+    std::vector<uint64_t> ball_roll(count);
+    std::vector<uint64_t> safari_roll(count);
+    std::vector<uint64_t> bonus_roll(count);
+    auto next_int = [&](uint64_t* results, uint64_t bound, size_t calls){
+        std::fill(bounds.begin(), bounds.end(), bound);
+        Kernels::xoroshiro128plus_next_int_lanes(s0.data(), s1.data(), count, results, bounds.data(), calls);
+    };
 
-        for (size_t i = 0; i < NUM_NPCS; i++){
-            temp_rng.nextInt(91);
+    next_int(nullptr, 91, num_npcs);
+    Kernels::xoroshiro128plus_next_lanes(s0.data(), s1.data(), count, nullptr, 1);
+    next_int(nullptr, 60, 1);
+    next_int(nullptr, 4, 1);    //  item roll
+    next_int(ball_roll.data(), 100, 1);
+    next_int(safari_roll.data(), 1000, 1);
+    for (size_t l = 0; l < count; l++){
+        bounds[l] = safari_roll[l] == 0 || ball_roll[l] == 99 ? 1000 : 100;
+    }
+    Kernels::xoroshiro128plus_next_int_lanes(s0.data(), s1.data(), count, bonus_roll.data(), bounds.data(), 1);
+
+    for (size_t l = 0; l < count; l++){
+        CramomaticOutcome& outcome = outcomes[l];
+        outcome.is_safari_sport = safari_roll[l] == 0;
+        outcome.is_bonus = bonus_roll[l] == 0;
+        uint64_t roll = ball_roll[l];
+        if (outcome.is_safari_sport){
+            outcome.type = CramomaticBallType::Safari;
+        }else if (roll < 25){
+            outcome.type = CramomaticBallType::Poke;
+        }else if (roll < 50){
+            outcome.type = CramomaticBallType::Great;
+        }else if (roll < 75){
+            outcome.type = CramomaticBallType::Shop1;
+        }else if (roll < 99){
+            outcome.type = CramomaticBallType::Shop2;
+        }else{
+            outcome.type = CramomaticBallType::Apricorn;
         }
-        temp_rng.next();
-        temp_rng.nextInt(60);
+    }
+}
 
-        /*uint64_t item_roll =*/ temp_rng.nextInt(4);
-        uint64_t ball_roll = temp_rng.nextInt(100);
-        bool is_safari_sport = temp_rng.nextInt(1000) == 0;
-        bool is_bonus = false;
+}
 
-        if (is_safari_sport || ball_roll == 99){
-            is_bonus = temp_rng.nextInt(1000) == 0;
-        }else{
-            is_bonus = temp_rng.nextInt(100) == 0;
+void calculate_cramomatic_outcomes(
+    CramomaticOutcome* outcomes, size_t count,
+    Xoroshiro128PlusState state, size_t num_npcs,
+    WorkStealingPool* pool
+){
+    size_t chunks = (count + CRAMOMATIC_CHUNK - 1) / CRAMOMATIC_CHUNK;
+    auto run_chunk = [&](size_t index){
+        size_t start = index * CRAMOMATIC_CHUNK;
+        Xoroshiro128Plus rng(state);
+        rng.jump(start);
+        calculate_cramomatic_outcomes_chunk(
+            outcomes + start, std::min(CRAMOMATIC_CHUNK, count - start),
+            rng.state, num_npcs
+        );
+    };
+    if (pool == nullptr || chunks <= 1){
+        for (size_t c = 0; c < chunks; c++){
+            run_chunk(c);
         }
+    }else{
+        pool->run_in_parallel(0, chunks, run_chunk, 1);
+    }
+}
 
-        CramomaticBallType type;
-        if (is_safari_sport){
-            type = CramomaticBallType::Safari;
-        }else if (ball_roll < 25){
-            type = CramomaticBallType::Poke;
-        }else if (ball_roll < 50){
-            type = CramomaticBallType::Great;
-        }else if (ball_roll < 75){
-            type = CramomaticBallType::Shop1;
-        }else if (ball_roll < 99){
-            type = CramomaticBallType::Shop2;
-        }else{
-            type = CramomaticBallType::Apricorn;
+CramomaticTarget calculate_cramomatic_target(
+    Xoroshiro128PlusState state, std::vector<CramomaticSelection> selected_balls,
+    size_t num_npcs, size_t max_priority_advances,
+    WorkStealingPool* pool
+){
+    size_t advances = 0;
+    size_t priority_advances = 0;
+    std::vector<CramomaticTarget> possible_targets;
+
+    std::sort(selected_balls.begin(), selected_balls.end(), [](CramomaticSelection sel1, CramomaticSelection sel2) { return sel1.priority > sel2.priority; });
+
+    //  Check one advance. Returns false when the search is done.
+    auto check = [&](CramomaticOutcome outcome){
+        // priority_advances only starts counting up after the first good result is found
+        if (priority_advances > max_priority_advances){
+            return false;
         }
-        
 
         // check whether the result is a good result
+        CramomaticBallType type = outcome.type;
         for (size_t i = 0; i < selected_balls.size(); i++){
             CramomaticSelection selection = selected_balls[i];
-            if (!selection.is_bonus || is_bonus){
-                if (is_safari_sport){
+            if (!selection.is_bonus || outcome.is_bonus){
+                if (outcome.is_safari_sport){
                     if (selection.ball_type == CramomaticBallType::Safari || selection.ball_type == CramomaticBallType::Sport){
                         type = selection.ball_type;
                     }
                 }
-                
+
                 if (selection.ball_type == type){
                     CramomaticTarget target;
                     target.ball_type = type;
-                    target.is_bonus = is_bonus;
+                    target.is_bonus = outcome.is_bonus;
                     target.needed_advances = advances;
                     possible_targets.emplace_back(target);
 
@@ -254,14 +317,36 @@ CramomaticTarget CramomaticRNG::calculate_target(SingleSwitchProgramEnvironment&
         }
         if (possible_targets.size() > 0){
             if (selected_balls.empty()){
-                //priority_advances = MAX_PRIORITY_ADVANCES + 1;
-                break;
+                return false;
             }
             priority_advances++;
         }
 
-        rng.next();
         advances++;
+        return true;
+    };
+
+    //  Evaluate the advances in batches and scan them in order. Batches start
+    //  small since the target is usually close, then grow so that far targets
+    //  can use more threads.
+    Xoroshiro128Plus rng(state);
+    size_t batch = 64;
+    std::vector<CramomaticOutcome> outcomes;
+    while (true){
+        outcomes.resize(batch);
+        calculate_cramomatic_outcomes(outcomes.data(), batch, rng.state, num_npcs, pool);
+        bool done = false;
+        for (CramomaticOutcome outcome : outcomes){
+            if (!check(outcome)){
+                done = true;
+                break;
+            }
+        }
+        if (done){
+            break;
+        }
+        rng.jump(batch);
+        batch = std::min<size_t>(2 * batch, 32 * CRAMOMATIC_CHUNK);
     }
 
     // Choose the first result which doesn't overshadow a higher priority choice.
@@ -270,7 +355,7 @@ CramomaticTarget CramomaticRNG::calculate_target(SingleSwitchProgramEnvironment&
         auto last_target = possible_targets.end() - 1;
         auto second_to_last_target = possible_targets.end() - 2;
 
-        if ((*last_target).needed_advances - (*second_to_last_target).needed_advances > MAX_PRIORITY_ADVANCES){
+        if ((*last_target).needed_advances - (*second_to_last_target).needed_advances > max_priority_advances){
             possible_targets.erase(last_target);
         }else{
             possible_targets.erase(second_to_last_target);
@@ -280,6 +365,14 @@ CramomaticTarget CramomaticRNG::calculate_target(SingleSwitchProgramEnvironment&
     return possible_targets[0];
 }
 
+CramomaticTarget CramomaticRNG::calculate_target(SingleSwitchProgramEnvironment& env, Xoroshiro128PlusState state, std::vector<CramomaticSelection> selected_balls){
+    return calculate_cramomatic_target(
+        state, std::move(selected_balls),
+        NUM_NPCS, MAX_PRIORITY_ADVANCES,
+        &env.compute_pool()
+    );
+}
+
 void CramomaticRNG::leave_to_overworld_and_interact(SingleSwitchProgramEnvironment& env, BotBaseContext& context){
     pbf_press_button(context, BUTTON_B, 2 * TICKS_PER_SECOND, 5);
     pbf_press_button(context, BUTTON_B, 10, 70);
@@ -19,6 +19,7 @@
 #include "PokemonSwSh/Programs/RNG/PokemonSwSh_Xoroshiro128Plus.h"
 
 namespace PokemonAutomation{
+    class WorkStealingPool;
 namespace NintendoSwitch{
 namespace PokemonSwSh{
 
@@ -37,6 +38,30 @@ struct CramomaticTarget{
     size_t needed_advances;
 };
 
+//  The ball the Cram-o-matic gives for a given RNG state.
+struct CramomaticOutcome{
+    CramomaticBallType type;    //  Safari if "is_safari_sport".
+    bool is_safari_sport;
+    bool is_bonus;
+};
+
+//  outcomes[i] is the outcome for the state "i" advances after "state".
+//  The advances are evaluated side by side in SIMD lanes. If "pool" isn't
+//  null, large counts are also split across its threads.
+void calculate_cramomatic_outcomes(
+    CramomaticOutcome* outcomes, size_t count,
+    Xoroshiro128PlusState state, size_t num_npcs,
+    WorkStealingPool* pool
+);
+
+//  Find how many advances are needed from "state" to get the highest priority
+//  selection that isn't more than "max_priority_advances" after a lower one.
+CramomaticTarget calculate_cramomatic_target(
+    Xoroshiro128PlusState state, std::vector<CramomaticSelection> selected_balls,
+    size_t num_npcs, size_t max_priority_advances,
+    WorkStealingPool* pool
+);
+
 class CramomaticRNG : public SingleSwitchProgramInstance{
 public:
     CramomaticRNG();
@@ -5,6 +5,9 @@
  */
 
 #include <cstddef>
+#include <algorithm>
+#include "Common/Cpp/Exceptions.h"
+#include "Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes.h"
 #include "PokemonSwSh/Programs/RNG/PokemonSwSh_Xoroshiro128Plus.h"
 
 namespace PokemonAutomation{
@@ -45,6 +48,111 @@ Xoroshiro128PlusState Xoroshiro128Plus::get_state(){
     return state;
 }
 
+
+
+namespace{
+
+//  The state is a vector of 128 bits over GF(2). (s0 is bits 0-63, s1 is bits
+//  64-127) A step of "next()" is linear in it. So "n" steps is a multiplication
+//  by the 128x128 matrix T^n.
+//
+//  Matrices are stored by column. Column "c" is the state that bit "c" alone
+//  turns into. Multiplying is then the XOR of the columns of the set bits.
+struct JumpMatrix{
+    uint64_t column[128][2];
+
+    void apply(uint64_t& s0, uint64_t& s1) const{
+        uint64_t r0 = 0;
+        uint64_t r1 = 0;
+        for (size_t c = 0; c < 64; c++){
+            uint64_t mask = 0 - ((s0 >> c) & 1);
+            r0 ^= column[c][0] & mask;
+            r1 ^= column[c][1] & mask;
+        }
+        for (size_t c = 0; c < 64; c++){
+            uint64_t mask = 0 - ((s1 >> c) & 1);
+            r0 ^= column[64 + c][0] & mask;
+            r1 ^= column[64 + c][1] & mask;
+        }
+        s0 = r0;
+        s1 = r1;
+    }
+};
+
+//  power[k] = T^(2^k). Since the period is 2^128 - 1, T^(2^128) = T. So these
+//  128 cover every power of two.
+struct JumpTable{
+    JumpMatrix power[128];
+
+    JumpTable(){
+        for (size_t c = 0; c < 128; c++){
+            Xoroshiro128Plus rng(
+                c < 64 ? (uint64_t)1 << c : 0,
+                c < 64 ? 0 : (uint64_t)1 << (c - 64)
+            );
+            rng.next();
+            power[0].column[c][0] = rng.state.s0;
+            power[0].column[c][1] = rng.state.s1;
+        }
+        //  T^(2^(k+1)) = T^(2^k) * T^(2^k)
+        for (size_t k = 0; k + 1 < 128; k++){
+            for (size_t c = 0; c < 128; c++){
+                uint64_t s0 = power[k].column[c][0];
+                uint64_t s1 = power[k].column[c][1];
+                power[k].apply(s0, s1);
+                power[k + 1].column[c][0] = s0;
+                power[k + 1].column[c][1] = s1;
+            }
+        }
+    }
+};
+
+const JumpTable& jump_table(){
+    static const JumpTable table;
+    return table;
+}
+
+}
+
+void Xoroshiro128Plus::jump(uint64_t advances){
+    const JumpTable& table = jump_table();
+    for (size_t k = 0; advances != 0; k++, advances >>= 1){
+        if (advances & 1){
+            table.power[k].apply(state.s0, state.s1);
+        }
+    }
+}
+void Xoroshiro128Plus::jump_power_of_two(size_t power){
+    jump_table().power[power % 128].apply(state.s0, state.s1);
+}
+
+
+
+Xoroshiro128PlusLanes::Xoroshiro128PlusLanes(Xoroshiro128PlusState state, size_t lanes, uint64_t stride)
+    : m_lanes(lanes)
+{
+    if (lanes == 0 || lanes > MAX_LANES){
+        throw InternalProgramError(nullptr, PA_CURRENT_FUNCTION, "Invalid # of lanes: " + std::to_string(lanes));
+    }
+    Xoroshiro128Plus rng(state);
+    for (size_t l = 0; l < lanes; l++){
+        if (l != 0){
+            rng.jump(stride);
+        }
+        m_s0[l] = rng.state.s0;
+        m_s1[l] = rng.state.s1;
+    }
+}
+Xoroshiro128PlusState Xoroshiro128PlusLanes::get_state(size_t lane) const{
+    return Xoroshiro128PlusState(m_s0[lane], m_s1[lane]);
+}
+void Xoroshiro128PlusLanes::next(uint64_t* results, size_t advances){
+    Kernels::xoroshiro128plus_next_lanes(m_s0, m_s1, m_lanes, results, advances);
+}
+void Xoroshiro128PlusLanes::last_bits(uint64_t* bits, size_t words){
+    Kernels::xoroshiro128plus_last_bits_lanes(m_s0, m_s1, m_lanes, bits, words);
+}
+
 uint64_t nextPowerOfTwo(uint64_t number){
     uint64_t x = number;
     x--;
@@ -78,6 +186,35 @@ std::vector<bool> Xoroshiro128Plus::generate_last_bit_sequence(size_t max_advanc
     return sequence;
 }
 
+std::vector<uint64_t> Xoroshiro128Plus::generate_last_bit_words(size_t max_advances){
+    size_t words = (max_advances + 63) / 64;
+    std::vector<uint64_t> ret(words);
+    if (words == 0){
+        return ret;
+    }
+
+    //  Each lane generates a contiguous run of the words.
+    size_t lanes = std::min(words, Xoroshiro128PlusLanes::MAX_LANES);
+    size_t words_per_lane = (words + lanes - 1) / lanes;
+    Xoroshiro128PlusLanes batch(state, lanes, 64 * words_per_lane);
+
+    std::vector<uint64_t> interleaved(words_per_lane * lanes);
+    batch.last_bits(interleaved.data(), words_per_lane);
+    for (size_t l = 0; l < lanes; l++){
+        for (size_t w = 0; w < words_per_lane; w++){
+            size_t index = l * words_per_lane + w;
+            if (index < words){
+                ret[index] = interleaved[w * lanes + l];
+            }
+        }
+    }
+
+    if (max_advances % 64 != 0){
+        ret.back() &= ((uint64_t)1 << (max_advances % 64)) - 1;
+    }
+    return ret;
+}
+
 // The generic solution to the system of equations to calculate the initial state from the last bits of 128 consecutive Xoroshiro128+ results.
 uint64_t Xoroshiro128Plus::last_bits_reverse_matrix[128][2] = {
     /*s0 bit 0*/ {0b0101001100100001111011111110111001010011111110101011100011001101, 0b0111010111110111000101010100001111101001111001011111001011010111} ,
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <utility>
 #include <vector>
+#include "Common/Compiler.h"
 
 namespace PokemonAutomation{
 
@@ -28,8 +29,22 @@ public:
     uint64_t next();
     uint64_t nextInt(uint64_t);
     Xoroshiro128PlusState get_state();
+
+    //  Advance the state as if "next()" were called "advances" times.
+    //  This takes at most 64 matrix products instead of "advances" steps.
+    void jump(uint64_t advances);
+
+    //  Advance the state by 2^power. (power may be anything since the period
+    //  is 2^128 - 1)
+    void jump_power_of_two(size_t power);
+
     std::vector<bool> generate_last_bit_sequence(size_t max_advances);
 
+    //  Same as above, but packed 64 advances to a word. Bit "i" of word "w" is
+    //  the last bit of the output "64 * w + i" advances from now. Bits past
+    //  "max_advances" are zero. This doesn't change the state.
+    std::vector<uint64_t> generate_last_bit_words(size_t max_advances);
+
     static Xoroshiro128Plus xoroshiro128plus_from_last_bits(std::pair<uint64_t, uint64_t> last_bits);
 
 
@@ -39,5 +54,34 @@ private:
     uint64_t rotl(const uint64_t x, int k);
 };
 
+
+
+//  Up to 8 independent generators advanced in lockstep using SIMD.
+//  (see Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes.h)
+class Xoroshiro128PlusLanes{
+public:
+    static constexpr size_t MAX_LANES = 8;
+
+    //  Lane "l" starts at "state" advanced by "l * stride".
+    Xoroshiro128PlusLanes(Xoroshiro128PlusState state, size_t lanes, uint64_t stride);
+
+    size_t lanes() const{ return m_lanes; }
+    Xoroshiro128PlusState get_state(size_t lane) const;
+
+    //  Advance every lane "advances" times. If "results" isn't null, the "i"th
+    //  output of lane "l" is written to "results[i * lanes() + l]".
+    void next(uint64_t* results, size_t advances);
+
+    //  Advance every lane "64 * words" times. Bit "i" of "bits[w * lanes() + l]"
+    //  is the last bit of output "64 * w + i" of lane "l".
+    void last_bits(uint64_t* bits, size_t words);
+
+
+private:
+    size_t m_lanes;
+    alignas(PA_ALIGNMENT) uint64_t m_s0[MAX_LANES];
+    alignas(PA_ALIGNMENT) uint64_t m_s1[MAX_LANES];
+};
+
 }
 #endif
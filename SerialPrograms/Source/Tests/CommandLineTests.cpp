@@ -7,16 +7,24 @@
 
 #include "CommandLineTests.h"
 #include "Common/Cpp/Exceptions.h"
+#include "Common/Cpp/Time.h"
+#include "Common/Cpp/Concurrency/ParallelTaskRunner.h"
 #include "CommonFramework/GlobalSettingsPanel.h"
+#include "CommonFramework/Environment/Environment.h"
 #include "PokemonLA_Tests.h"
 #include "TestMap.h"
+#include "TestUtils.h"
 #include <QDir>
 #include <QDirIterator>
 #include <QFileInfo>
 
 #include <iostream>
+#include <fstream>
+#include <streambuf>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <atomic>
 #include <map>
 #include <list>
 #include <functional>
@@ -46,24 +54,477 @@ void print_equals(){
         } \
     } while (0)
 
-#define RETURN_IF_TEST_FAILED(test_func, file_path, num_passed) \
-    do { \
-        int _ret = 0; \
-        try{ \
-            _ret = test_func(file_path); \
-        } catch (const std::exception& e) { \
-            cout << "Test: " << (file_path) << " threw exception: " << e.what() << endl; \
-        } catch (const Exception& e) {\
-           cout << "Test: " << (file_path) << " threw " << e.name() << ": <<<" << e.message() << ">>>" << endl; \
-        } \
-        if (_ret > 0) {\
-            print_equals(); \
-            cout << "Test: " << (file_path) << " failed." << endl; \
-            return _ret; \
-        }else if (_ret == 0){ \
-            num_passed++; \
-        } \
-    } while (0)
+
+
+struct CommandLineTestOptions{
+    size_t threads = 1;
+    size_t shard_index = 0;
+    size_t shard_count = 1;
+    std::string junit_path;
+};
+
+bool parse_options(int argc, char* argv[], CommandLineTestOptions& options){
+    for (int c = 1; c < argc; c++){
+        const std::string arg = argv[c];
+        if (arg.rfind("--", 0) != 0){
+            //  Not ours. (eg. "-psn_..." when launched from a macOS bundle)
+            continue;
+        }
+        if (c + 1 >= argc){
+            cerr << "Error: missing value for " << arg << endl;
+            return false;
+        }
+        const std::string value = argv[++c];
+        if (arg == "--threads"){
+            if (!parse_size_t(value, options.threads)){
+                cerr << "Error: invalid thread count: " << value << endl;
+                return false;
+            }
+            if (options.threads == 0){
+                options.threads = std::thread::hardware_concurrency();
+            }
+        }else if (arg == "--shard"){
+            const size_t slash = value.find('/');
+            size_t index = 0;
+            size_t count = 0;
+            if (slash == std::string::npos ||
+                !parse_size_t(value.substr(0, slash), index) ||
+                !parse_size_t(value.substr(slash + 1), count) ||
+                index == 0 || index > count
+            ){
+                cerr << "Error: invalid shard " << value << ". Expected i/n where 1 <= i <= n." << endl;
+                return false;
+            }
+            options.shard_index = index - 1;
+            options.shard_count = count;
+        }else if (arg == "--junit"){
+            options.junit_path = value;
+        }else{
+            cerr << "Error: unknown option " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+//  Everything a test prints to cout/cerr, in order.
+struct CapturedOutput{
+    struct Chunk{
+        bool error;
+        std::string text;
+    };
+    std::vector<Chunk> chunks;
+
+    void append(bool error, const char* str, size_t count){
+        if (chunks.empty() || chunks.back().error != error){
+            chunks.emplace_back(Chunk{error, std::string()});
+        }
+        chunks.back().text.append(str, count);
+    }
+    void replay() const{
+        for (const Chunk& chunk : chunks){
+            std::ostream& stream = chunk.error ? cerr : cout;
+            stream << chunk.text << std::flush;
+        }
+    }
+    std::string to_string() const{
+        std::string ret;
+        for (const Chunk& chunk : chunks){
+            ret += chunk.text;
+        }
+        return ret;
+    }
+};
+
+//  The output of the current thread goes here instead of to the console.
+thread_local CapturedOutput* t_captured_output = nullptr;
+
+//  Installed on cout and cerr for the duration of the run. Writes from a
+//  thread that is capturing go into its buffer. Everything else is passed
+//  through unchanged.
+//
+//  Threads started by the test itself are not capturing. So their output goes
+//  straight to the console.
+class OutputCapture : public std::basic_streambuf<char>{
+public:
+    OutputCapture(std::ostream& stream, bool error)
+        : m_stream(stream)
+        , m_old_buf(stream.rdbuf())
+        , m_error(error)
+    {
+        stream.rdbuf(this);
+    }
+    ~OutputCapture(){
+        m_stream.rdbuf(m_old_buf);
+    }
+
+private:
+    virtual int_type overflow(int_type ch) override{
+        if (traits_type::eq_int_type(ch, traits_type::eof())){
+            return traits_type::not_eof(ch);
+        }
+        CapturedOutput* captured = t_captured_output;
+        if (captured == nullptr){
+            return m_old_buf->sputc((char)ch);
+        }
+        char c = (char)ch;
+        captured->append(m_error, &c, 1);
+        return ch;
+    }
+    virtual std::streamsize xsputn(const char_type* s, std::streamsize count) override{
+        CapturedOutput* captured = t_captured_output;
+        if (captured == nullptr){
+            return m_old_buf->sputn(s, count);
+        }
+        captured->append(m_error, s, (size_t)count);
+        return count;
+    }
+    virtual int sync() override{
+        return t_captured_output == nullptr ? m_old_buf->pubsync() : 0;
+    }
+
+private:
+    std::ostream& m_stream;
+    std::streambuf* m_old_buf;
+    bool m_error;
+};
+
+
+
+struct TestCase{
+    std::string test_space;
+    std::string test_obj_name;
+    std::string file_path;
+    TestFunction test_func;
+};
+
+//  All the tests to run, found up front by walking the test folder.
+//
+//  The walk prints the same headers and messages as running the tests in
+//  place would. That output is captured and split at each test. So when the
+//  tests are run later, the console output can be put back together in the
+//  same order: text(0), test(0), text(1), test(1), ..., text(N).
+class TestPlan{
+public:
+    TestPlan(const std::string& root_folder, size_t shard_index, size_t shard_count)
+        : m_root_dir(QString::fromStdString(root_folder))
+        , m_shard_index(shard_index)
+        , m_shard_count(shard_count)
+        , m_text(1)
+    {}
+
+    //  Capture the output of the walk on this thread.
+    void start_capture(){
+        t_captured_output = &m_text.back();
+    }
+    void stop_capture(){
+        t_captured_output = nullptr;
+    }
+
+    void add_test(
+        const std::string& test_space, const std::string& test_obj_name,
+        const std::string& file_path, const TestFunction& test_func,
+        bool print_path
+    ){
+        //  Shard by the path within the test folder. Unlike the position
+        //  within the walk, this doesn't depend on the directory order of
+        //  the file system. So every machine agrees on which tests are whose.
+        const std::string relative_path = m_root_dir.relativeFilePath(QString::fromStdString(file_path)).toStdString();
+        if (hash_path(relative_path) % m_shard_count != m_shard_index){
+            return;
+        }
+        if (print_path){
+            cout << file_path << endl;
+        }
+        m_tests.emplace_back(TestCase{test_space, test_obj_name, file_path, test_func});
+        m_text.emplace_back();
+        t_captured_output = &m_text.back();
+    }
+
+    //  Set when the walk fails. It's returned once everything before it has
+    //  been run.
+    void set_return_code(int return_code){
+        m_return_code = return_code;
+    }
+
+    const std::vector<TestCase>& tests() const{ return m_tests; }
+    const CapturedOutput& text(size_t index) const{ return m_text[index]; }
+    int return_code() const{ return m_return_code; }
+
+private:
+    static uint64_t hash_path(const std::string& path){
+        //  FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (char ch : path){
+            hash ^= (uint8_t)ch;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+private:
+    QDir m_root_dir;
+    size_t m_shard_index;
+    size_t m_shard_count;
+    std::vector<TestCase> m_tests;
+    std::vector<CapturedOutput> m_text;
+    int m_return_code = 0;
+};
+
+
+
+struct TestResult{
+    bool ran = false;
+    int ret = 0;
+    std::chrono::microseconds wall_time{0};
+    //  Growth of the peak RSS of the whole process while the test ran.
+    //  Only meaningful when the tests run one at a time.
+    uint64_t peak_memory_delta = 0;
+    CapturedOutput output;
+};
+
+//  Run the tests of a plan and print their output in the plan's order as
+//  they finish. Like the sequential runner, stop at the first failure.
+class TestRunner{
+public:
+    TestRunner(const TestPlan& plan)
+        : m_plan(plan)
+        , m_results(plan.tests().size())
+        , m_finished(plan.tests().size(), false)
+        , m_first_failure(SIZE_MAX)
+    {}
+
+    //  Returns 0 if all tests passed.
+    int run(size_t threads){
+        m_threads = threads;
+        const std::vector<TestCase>& tests = m_plan.tests();
+        m_plan.text(0).replay();
+
+        if (threads <= 1){
+            for (size_t c = 0; c < tests.size() && !m_stopped; c++){
+                run_test(c);
+            }
+        }else{
+            ParallelTaskRunner runner(nullptr, 0, threads);
+            for (size_t c = 0; c < tests.size(); c++){
+                //  Nothing past the first failure will be printed.
+                if (c > m_first_failure.load(std::memory_order_acquire)){
+                    break;
+                }
+                runner.dispatch([this, c]{ run_test(c); });
+            }
+            runner.wait_for_everything();
+        }
+
+        if (m_stopped){
+            return m_return_code;
+        }
+        if (m_plan.return_code() != 0){
+            return m_plan.return_code();
+        }
+        print_equals();
+        cout << m_num_passed << " test" << (m_num_passed > 1 ? "s" : "") << " passed" << std::endl;
+        return 0;
+    }
+
+    bool write_junit_report(const std::string& path, std::chrono::microseconds wall_time) const;
+
+private:
+    void run_test(size_t index){
+        if (index > m_first_failure.load(std::memory_order_acquire)){
+            return;
+        }
+
+        const TestCase& test = m_plan.tests()[index];
+        TestResult& result = m_results[index];
+        result.ran = true;
+
+        //  Only cout and cerr are captured. Anything logged through
+        //  global_logger_command_line() also goes to the shared log file.
+        //  So with more than one thread, the tests are interleaved there.
+        t_captured_output = &result.output;
+        const uint64_t peak_memory = peak_process_memory();
+        const WallClock start = current_time();
+        try{
+            result.ret = test.test_func(test.file_path);
+        }catch (const std::exception& e){
+            cout << "Test: " << test.file_path << " threw exception: " << e.what() << endl;
+            result.ret = 1;
+        }catch (const Exception& e){
+            cout << "Test: " << test.file_path << " threw " << e.name() << ": <<<" << e.message() << ">>>" << endl;
+            result.ret = 1;
+        }catch (...){
+            //  Don't let it take down a worker. Otherwise the run never ends.
+            cout << "Test: " << test.file_path << " threw an unknown exception." << endl;
+            result.ret = 1;
+        }
+        result.wall_time = std::chrono::duration_cast<std::chrono::microseconds>(current_time() - start);
+        result.peak_memory_delta = peak_process_memory() - peak_memory;
+        t_captured_output = nullptr;
+
+        if (result.ret > 0){
+            size_t first = m_first_failure.load(std::memory_order_acquire);
+            while (index < first && !m_first_failure.compare_exchange_weak(first, index)){}
+        }
+
+        std::lock_guard<std::mutex> lg(m_lock);
+        m_finished[index] = true;
+        print_finished();
+    }
+
+    //  Print everything that is ready, in order.
+    void print_finished(){
+        const std::vector<TestCase>& tests = m_plan.tests();
+        while (!m_stopped && m_next < tests.size() && m_finished[m_next]){
+            const TestResult& result = m_results[m_next];
+            result.output.replay();
+            if (result.ret > 0){
+                print_equals();
+                cout << "Test: " << tests[m_next].file_path << " failed." << endl;
+                m_return_code = result.ret;
+                m_stopped = true;
+                return;
+            }
+            if (result.ret == 0){
+                m_num_passed++;
+            }
+            m_next++;
+            m_plan.text(m_next).replay();
+        }
+    }
+
+private:
+    const TestPlan& m_plan;
+    std::vector<TestResult> m_results;
+
+    std::mutex m_lock;
+    std::vector<bool> m_finished;
+    size_t m_next = 0;
+    size_t m_num_passed = 0;
+    bool m_stopped = false;
+    int m_return_code = 0;
+    size_t m_threads = 1;
+
+    std::atomic<size_t> m_first_failure;
+};
+
+
+std::string xml_escape(const std::string& str){
+    std::string ret;
+    ret.reserve(str.size());
+    for (char ch : str){
+        switch (ch){
+        case '&':   ret += "&amp;";     break;
+        case '<':   ret += "&lt;";      break;
+        case '>':   ret += "&gt;";      break;
+        case '"':   ret += "&quot;";    break;
+        case '\'':  ret += "&apos;";    break;
+        case '\t':
+        case '\n':
+        case '\r':
+            ret += ch;
+            break;
+        default:
+            //  Other control characters aren't allowed in XML 1.0.
+            if ((uint8_t)ch >= 0x20){
+                ret += ch;
+            }
+        }
+    }
+    return ret;
+}
+std::string seconds_string(std::chrono::microseconds time){
+    return std::to_string(time.count() / 1000000.);
+}
+
+//  One <testsuite> per test object and one <testcase> per test file. Tests
+//  that were not run because an earlier one failed are left out.
+bool TestRunner::write_junit_report(const std::string& path, std::chrono::microseconds wall_time) const{
+    struct Suite{
+        std::string name;
+        std::vector<size_t> tests;
+        size_t failures = 0;
+        size_t skipped = 0;
+        std::chrono::microseconds time{0};
+    };
+    std::vector<Suite> suites;
+    std::map<std::string, size_t> suite_map;
+    size_t total_tests = 0;
+    size_t total_failures = 0;
+    size_t total_skipped = 0;
+
+    const std::vector<TestCase>& tests = m_plan.tests();
+    for (size_t c = 0; c < tests.size(); c++){
+        const TestResult& result = m_results[c];
+        if (!result.ran){
+            continue;
+        }
+        const std::string name = tests[c].test_space + "/" + tests[c].test_obj_name;
+        auto iter = suite_map.find(name);
+        if (iter == suite_map.end()){
+            iter = suite_map.emplace(name, suites.size()).first;
+            suites.emplace_back();
+            suites.back().name = name;
+        }
+        Suite& suite = suites[iter->second];
+        suite.tests.emplace_back(c);
+        suite.failures += result.ret > 0;
+        suite.skipped += result.ret < 0;
+        suite.time += result.wall_time;
+        total_tests++;
+        total_failures += result.ret > 0;
+        total_skipped += result.ret < 0;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file){
+        return false;
+    }
+    file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    file << "<testsuites name=\"CommandLineTests\""
+         << " tests=\"" << total_tests << "\""
+         << " failures=\"" << total_failures << "\""
+         << " skipped=\"" << total_skipped << "\""
+         << " time=\"" << seconds_string(wall_time) << "\">\n";
+    for (const Suite& suite : suites){
+        file << "  <testsuite name=\"" << xml_escape(suite.name) << "\""
+             << " tests=\"" << suite.tests.size() << "\""
+             << " failures=\"" << suite.failures << "\""
+             << " skipped=\"" << suite.skipped << "\""
+             << " time=\"" << seconds_string(suite.time) << "\">\n";
+        for (size_t index : suite.tests){
+            const TestCase& test = tests[index];
+            const TestResult& result = m_results[index];
+            file << "    <testcase classname=\"" << xml_escape(test.test_space + "." + test.test_obj_name) << "\""
+                 << " name=\"" << xml_escape(test.file_path) << "\""
+                 << " time=\"" << seconds_string(result.wall_time) << "\">\n";
+            //  The peak RSS is per process. So it can't be split between
+            //  tests that ran at the same time.
+            if (m_threads <= 1){
+                file << "      <properties>\n";
+                file << "        <property name=\"peak_rss_delta_bytes\" value=\"" << result.peak_memory_delta << "\"/>\n";
+                file << "      </properties>\n";
+            }
+            if (result.ret > 0){
+                file << "      <failure message=\"Returned " << result.ret << "\"/>\n";
+            }else if (result.ret < 0){
+                file << "      <skipped/>\n";
+            }
+            const std::string output = result.output.to_string();
+            if (!output.empty()){
+                file << "      <system-out>" << xml_escape(output) << "</system-out>\n";
+            }
+            file << "    </testcase>\n";
+        }
+        file << "  </testsuite>\n";
+    }
+    file << "</testsuites>\n";
+    return (bool)file.flush();
+}
+
+
 
 bool skip_ignored_path(const QString& file_path, const std::vector<QString>& ignore_list){
     for(const auto& path_prefix : ignore_list){
@@ -75,7 +536,10 @@ bool skip_ignored_path(const QString& file_path, const std::vector<QString>& ign
     return false;
 }
 
-int run_test_obj_dir(TestFunction test_func, const QString& directory_path, size_t& num_passed, const std::vector<QString>& ignore_list){
+int collect_test_obj_dir(
+    TestPlan& plan, const std::string& test_space, const std::string& test_name,
+    TestFunction test_func, const QString& directory_path, const std::vector<QString>& ignore_list
+){
     QDirIterator file_iter(directory_path, QDir::Filter::Files, QDirIterator::IteratorFlag::Subdirectories);
 
     bool first_test_file = true;
@@ -86,7 +550,7 @@ int run_test_obj_dir(TestFunction test_func, const QString& directory_path, size
         first_test_file = false;
 
         const QString next_file = file_iter.next();
-        
+
         // If filename starts with _, its considered a "hidden" file so skip it.
         const QFileInfo file_info(next_file);
         if (file_info.fileName().startsWith('_')){
@@ -99,17 +563,15 @@ int run_test_obj_dir(TestFunction test_func, const QString& directory_path, size
             continue;
         }
 
-        // Call the function to do the actual test:
-        cout << file_path << endl;
-        RETURN_IF_TEST_FAILED(test_func, file_path, num_passed);
+        plan.add_test(test_space, test_name, file_path, test_func, true);
     }
 
     return 0;
 }
 
-// Run the tests inside a folder representing a "test object".
+// Collect the tests inside a folder representing a "test object".
 // It is usually defined as one detector, e.g. CommandLineTests/PokemonLA/BattleMenuDetector/
-int run_test_obj(const std::string& test_space, const QFileInfo& obj_info, size_t& num_passed, const std::vector<QString>& ignore_list){
+int collect_test_obj(TestPlan& plan, const std::string& test_space, const QFileInfo& obj_info, const std::vector<QString>& ignore_list){
     const std::string test_name = obj_info.fileName().toStdString();
     if (test_name == "." || test_name == ".."){
         return 0;
@@ -130,12 +592,12 @@ int run_test_obj(const std::string& test_space, const QFileInfo& obj_info, size_
 
     // Recursively get test filenames, like:
     // ./CommandLineTests/PokemonLA/BattleMenuDetector/IngoBattleMenuDayTime_True.png
-    return run_test_obj_dir(test_func, obj_info.filePath(), num_passed, ignore_list);
+    return collect_test_obj_dir(plan, test_space, test_name, test_func, obj_info.filePath(), ignore_list);
 }
 
-// Run the tests inside a folder representing a "test space".
+// Collect the tests inside a folder representing a "test space".
 // It is usually defined as one pokemon game, e.g. CommandLineTests/PokemonLA/
-int run_test_space(const QFileInfo& space_info, size_t& num_passed, const std::vector<QString>& ignore_list){
+int collect_test_space(TestPlan& plan, const QFileInfo& space_info, const std::vector<QString>& ignore_list){
     QDir sub_dir(space_info.filePath());
     if (!sub_dir.exists()){
         cerr << "Error: cannot access " << space_info.filePath().toStdString() << endl;
@@ -157,9 +619,109 @@ int run_test_space(const QFileInfo& space_info, size_t& num_passed, const std::v
     // ./CommandLineTests/PokemonLA/BattleMenuDetector/
     const QFileInfoList obj_list = sub_dir.entryInfoList();
     for(const QFileInfo& obj_info : obj_list){
-        RETURN_IF_NOT_ZERO(run_test_obj(test_space, obj_info, num_passed, ignore_list));
+        RETURN_IF_NOT_ZERO(collect_test_obj(plan, test_space, obj_info, ignore_list));
+    }
+
+    return 0;
+}
+
+// Walk the test folder, or only the paths in TEST_LIST, and add every test
+// file to the plan.
+int collect_tests(TestPlan& plan, const std::string& root_folder_name, const std::vector<QString>& ignore_list){
+    QDir test_root_dir(root_folder_name.c_str());
+    QFileInfo test_root_info(root_folder_name.c_str());
+
+    const auto& selected_test_list = GlobalSettings::instance().COMMAND_LINE_TEST_LIST;
+
+    // Run all tests
+    if (selected_test_list.size() == 0){
+        // Look for sub-folders, e.g.
+        // ./CommandLineTests/PokemonLA/
+        // ./CommandLineTests/PokemonSwSh/
+        test_root_dir.setFilter(QDir::Filter::Dirs);
+        const QFileInfoList sub_dir_list = test_root_dir.entryInfoList();
+        for(const QFileInfo& sub_dir_info : sub_dir_list){
+            RETURN_IF_NOT_ZERO(collect_test_space(plan, sub_dir_info, ignore_list));
+        }
+        return 0;
     }
 
+    // Only run on selected tests
+    for(const std::string& test_path : selected_test_list){
+        const std::string full_path = root_folder_name + "/" + test_path;
+        const QString full_path_cleaned = QDir::cleanPath(QString::fromStdString(full_path));
+
+        if (full_path_cleaned.size() == 0){
+            cerr << "Error: empty path found in TEST_LIST" << endl;
+            return 1;
+        }
+
+        if (skip_ignored_path(full_path_cleaned, ignore_list)){
+            continue;
+        }
+
+        QFileInfo selected_path_info(full_path_cleaned);
+
+        if (selected_path_info.exists() == false){
+            cerr << "Error: path " << full_path << " in TEST_LIST does not exist." << endl;
+            return 1;
+        }
+
+        std::list<QString> path_components;
+        {
+            QString path = full_path_cleaned;
+            QFileInfo cur_info(path);
+            while(cur_info != test_root_info){
+                path_components.push_front(cur_info.fileName());
+                // Go upper one level of folder:
+                path = cur_info.path();
+                cur_info = QFileInfo(path);
+            }
+        }
+        // If full_path is "CommandLineTest/PokemonLA/DialogueEllipseDetector/macOS_bright/WendyNight_True.png", then
+        // path_components contains:
+        // - PokemonLA
+        // - DialogueEllipseDetector
+        // - macOS_bright
+        // - WendyNight_True.png
+        if (path_components.size() == 0){
+            cerr << "Error: cannot parse " << full_path << ". Empty path in TEST_LIST?" << endl;
+            return 1;
+        }
+
+        QDir cur_dir(root_folder_name.c_str());
+
+        auto it = path_components.begin();
+        std::string test_space = it->toStdString();
+        QFileInfo test_space_info(cur_dir.filePath(*it));
+        cur_dir = QDir(test_space_info.filePath());
+        if (path_components.size() == 1){
+            RETURN_IF_NOT_ZERO(collect_test_space(plan, test_space_info, ignore_list));
+            continue;
+        }
+
+        it++;
+        std::string test_name = it->toStdString();
+        QFileInfo test_obj_info(cur_dir.filePath(*it));
+        if (path_components.size() == 2){
+            RETURN_IF_NOT_ZERO(collect_test_obj(plan, test_space, test_obj_info, ignore_list));
+            continue;
+        }
+
+        const auto test_func = find_test_function(test_space, test_name);
+        if (test_func == nullptr){
+            return 2;
+        }
+
+        print_equals();
+        if (selected_path_info.isFile()){
+            plan.add_test(test_space, test_name, full_path_cleaned.toStdString(), test_func, false);
+        }else{
+            // selected_path_info is a directory, go through each file recursively in the directory
+            RETURN_IF_NOT_ZERO(collect_test_obj_dir(plan, test_space, test_name, test_func, full_path_cleaned, ignore_list));
+        }
+    } // end selected_test_list
+
     return 0;
 }
 
@@ -170,7 +732,16 @@ int run_test_space(const QFileInfo& space_info, size_t& num_passed, const std::v
 
 
 
-int run_command_line_tests(){
+int run_command_line_tests(int argc, char* argv[]){
+    CommandLineTestOptions options;
+    if (!parse_options(argc, argv, options)){
+        return 1;
+    }
+    if (options.threads > 1){
+        cerr << "Warning: running " << options.threads << " tests at once. The log file is shared by all of them." << endl;
+        cerr << "         Lines logged by tests running at the same time are mixed together there." << endl;
+    }
+
     const auto& root_folder_name = GlobalSettings::instance().COMMAND_LINE_TEST_FOLDER;
 
     QDir test_root_dir(root_folder_name.c_str());
@@ -179,12 +750,6 @@ int run_command_line_tests(){
         return 1;
     }
 
-    QFileInfo test_root_info(root_folder_name.c_str());
-
-    size_t num_passed = 0;
-
-    const auto& selected_test_list = GlobalSettings::instance().COMMAND_LINE_TEST_LIST;
-
     // The ignore list will be used to skip path.
     // The ignore list functions as path prefixes when determining which path to skip.
     std::vector<QString> ignore_list;
@@ -198,99 +763,28 @@ int run_command_line_tests(){
         ignore_list.emplace_back(std::move(path_cleaned));
     }
 
-    // Run all tests
-    if (selected_test_list.size() == 0){
-        // Look for sub-folders, e.g.
-        // ./CommandLineTests/PokemonLA/
-        // ./CommandLineTests/PokemonSwSh/
-        test_root_dir.setFilter(QDir::Filter::Dirs);
-        const QFileInfoList sub_dir_list = test_root_dir.entryInfoList();
-        for(const QFileInfo& sub_dir_info : sub_dir_list){
-            RETURN_IF_NOT_ZERO(run_test_space(sub_dir_info, num_passed, ignore_list));
-        }
-    }else{
-        // Only run on selected tests
-        for(const std::string& test_path : selected_test_list){
-            const std::string full_path = root_folder_name + "/" + test_path;
-            const QString full_path_cleaned = QDir::cleanPath(QString::fromStdString(full_path));
-
-            if (full_path_cleaned.size() == 0){
-                cerr << "Error: empty path found in TEST_LIST" << endl;
-                return 1;
-            }
-
-            if (skip_ignored_path(full_path_cleaned, ignore_list)){
-                continue;
-            }
-
-            QFileInfo selected_path_info(full_path_cleaned);
-
-            if (selected_path_info.exists() == false){
-                cerr << "Error: path " << full_path << " in TEST_LIST does not exist." << endl;
-                return 1;
-            }
-
-            std::list<QString> path_components;
-            {
-                QString path = full_path_cleaned;
-                QFileInfo cur_info(path);
-                while(cur_info != test_root_info){
-                    path_components.push_front(cur_info.fileName());
-                    // Go upper one level of folder:
-                    path = cur_info.path();
-                    cur_info = QFileInfo(path);
-                }
-            }
-            // If full_path is "CommandLineTest/PokemonLA/DialogueEllipseDetector/macOS_bright/WendyNight_True.png", then
-            // path_components contains:
-            // - PokemonLA
-            // - DialogueEllipseDetector
-            // - macOS_bright
-            // - WendyNight_True.png
-            if (path_components.size() == 0){
-                cerr << "Error: cannot parse " << full_path << ". Empty path in TEST_LIST?" << endl;
-                return 1;
-            }
-
-            QDir cur_dir(root_folder_name.c_str());
-
-            auto it = path_components.begin();
-            std::string test_space = it->toStdString();
-            QFileInfo test_space_info(cur_dir.filePath(*it));
-            cur_dir = QDir(test_space_info.filePath());
-            if (path_components.size() == 1){
-                RETURN_IF_NOT_ZERO(run_test_space(test_space_info, num_passed, ignore_list));
-                continue;
-            }
+    OutputCapture capture_stdout(cout, false);
+    OutputCapture capture_stderr(cerr, true);
 
-            it++;
-            std::string test_name = it->toStdString();
-            QFileInfo test_obj_info(cur_dir.filePath(*it));
-            if (path_components.size() == 2){
-                RETURN_IF_NOT_ZERO(run_test_obj(test_space, test_obj_info, num_passed, ignore_list));
-                continue;
-            }
+    TestPlan plan(root_folder_name, options.shard_index, options.shard_count);
+    plan.start_capture();
+    plan.set_return_code(collect_tests(plan, root_folder_name, ignore_list));
+    plan.stop_capture();
 
-            const auto test_func = find_test_function(test_space, test_name);
-            if (test_func == nullptr){
-                return 2;
-            }
+    const WallClock start = current_time();
+    TestRunner runner(plan);
+    int ret = runner.run(options.threads);
+    const auto wall_time = std::chrono::duration_cast<std::chrono::microseconds>(current_time() - start);
 
-            print_equals();
-            if (selected_path_info.isFile()){
-                // Call the function to do the actual test:
-                RETURN_IF_TEST_FAILED(test_func, full_path_cleaned.toStdString(), num_passed);
-            }else{
-                // selected_path_info is a directory, go through each file recursively in the directory
-                RETURN_IF_NOT_ZERO(run_test_obj_dir(test_func, full_path_cleaned, num_passed, ignore_list));
-            }
-        } // end selected_test_list
+    if (!options.junit_path.empty() && !runner.write_junit_report(options.junit_path, wall_time)){
+        cerr << "Error: unable to write test report to " << options.junit_path << endl;
+        if (ret == 0){
+            ret = 1;
+        }
     }
 
-    print_equals();
-    cout << num_passed << " test" << (num_passed > 1 ? "s" : "") << " passed" << std::endl;
-    return 0;
+    return ret;
 }
 
 
-}
\ No newline at end of file
+}
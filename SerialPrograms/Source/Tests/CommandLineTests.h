@@ -47,6 +47,20 @@
  *  
  * Those "hidden" files are useful for storing some metadata in the folder, or serving as an extra file in case some tests need more than one test files.
  * 
+ *  Running in parallel:
+ * 
+ *  The test files are all found first. Then they are run with these command line options:
+ *  --threads N     Run N test files at once. 0 means one per hardware thread. The default is 1.
+ *                  The output of each test is held back and printed in the same order as running them one by one.
+ *                  So the console output doesn't depend on the thread count. The log file is not held back.
+ *                  So lines logged by tests running at the same time are mixed together there. A warning
+ *                  is printed at the start as a reminder. Use one thread to get a clean log of each test.
+ *  --shard i/n     Only run the i-th of n shards (1 <= i <= n). Use this to split the tests across machines.
+ *                  The split is by a hash of each file's path within the test folder.
+ *  --junit PATH    Write a JUnit-style XML report to PATH. It has the wall time of each test file. With one thread,
+ *                  it also has how much each test file raised the peak memory usage of the process.
+ *  Like running in sequence, no more tests are started after one fails.
+ * 
  *  How to add new test code:
  * 
  *  The test framework calls TestMap.h: find_test_function(test_space, test_obj_name) to find the test function related to a test path.
@@ -93,8 +107,9 @@ namespace PokemonAutomation{
 
 // Called by main() to run tests on command line, without launching any GUI.
 // This function is only called when GlobalSettings::COMMAND_LINE_TEST_MODE is true.
+// "argc" and "argv" are the command line arguments for the options above.
 // Return 0 if all tests are passed.
-int run_command_line_tests();
+int run_command_line_tests(int argc, char* argv[]);
 
 
 
@@ -7,13 +7,55 @@
 
 #include "Common/Compiler.h"
 #include "Common/Cpp/Time.h"
+#include "Common/Cpp/Exceptions.h"
+#include "Common/Cpp/CancellableScope.h"
+#include "Common/Cpp/Json/JsonArray.h"
+#include "Common/Cpp/Json/JsonObject.h"
+#include "Common/Qt/StringToolsQt.h"
+#include "Common/Cpp/Concurrency/AsyncDispatcher.h"
+#include "CommonFramework/Logging/AsyncLogWriter.h"
 #include "CommonFramework/ImageTypes/ImageRGB32.h"
 #include "CommonFramework/ImageTypes/ImageViewRGB32.h"
+#include "CommonFramework/ImageMatch/ImageDiff.h"
+#include "CommonFramework/ImageMatch/ExactImageMatcher.h"
+#include "CommonFramework/ImageMatch/ExactImageDictionaryMatcher.h"
+#include "CommonFramework/ImageTools/ImageBoxes.h"
+#include "CommonFramework/Resources/SpriteDatabase.h"
+#include "CommonFramework/Resources/SpritePack.h"
+#include "CommonFramework/Globals.h"
 #include "CommonFramework/Inference/BlackBorderDetector.h"
+#include "CommonFramework/Tools/ImageEncodeService.h"
+#include "CommonFramework/Inference/SpectrogramMatcher.h"
+#include "CommonFramework/OCR/OCR_StringNormalization.h"
+#include "CommonFramework/OCR/OCR_TextMatcher.h"
+#include "CommonFramework/OCR/OCR_DictionaryOCR.h"
+#include "CommonFramework/OCR/OCR_QGramIndex.h"
+#include "CommonFramework/InferenceInfra/VisualInferencePivot.h"
+#include "CommonFramework/AudioPipeline/AudioFeed.h"
+#include "CommonFramework/AudioPipeline/AudioTemplate.h"
+#include "Kernels/ScaleInvariantMatrixMatch/Kernels_ScaleInvariantMatrixMatch.h"
+#include "CommonFramework/VideoPipeline/VideoFeed.h"
+#include "PokemonSwSh/Resources/PokemonSwSh_PokemonSprites.h"
+#include "PokemonLA/Resources/PokemonLA_PokemonSprites.h"
+#include "Pokemon/Inference/Pokemon_NameReader.h"
 #include "CommonFramework_Tests.h"
 #include "TestUtils.h"
 
 
+#include <cmath>
+#include <cfloat>
+#include <stdio.h>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include <random>
+#include <thread>
 #include <iostream>
 using std::cout;
 using std::cerr;
@@ -32,4 +74,900 @@ int test_CommonFramework_BlackBorderDetector(const ImageViewRGB32& image, bool t
 }
 
 
+
+namespace{
+
+class StillImageFeed : public VideoFeed{
+public:
+    StillImageFeed(const ImageViewRGB32& image) : m_image(image), m_snapshots(0) {}
+    size_t snapshots() const{ return m_snapshots.load(std::memory_order_relaxed); }
+
+    virtual void reset() override{}
+    virtual VideoSnapshot snapshot() override{
+        m_snapshots.fetch_add(1, std::memory_order_relaxed);
+        return VideoSnapshot(m_image.copy(), current_time());
+    }
+    virtual double fps_source() override{ return 0; }
+    virtual double fps_display() override{ return 0; }
+
+private:
+    const ImageViewRGB32& m_image;
+    std::atomic<size_t> m_snapshots;
+};
+
+//  A callback that takes a fixed amount of time and fires on its Nth frame.
+class DelayCallback : public VisualInferenceCallback{
+public:
+    DelayCallback(std::chrono::milliseconds delay, size_t trigger_call)
+        : VisualInferenceCallback("DelayCallback")
+        , m_delay(delay)
+        , m_trigger_call(trigger_call)
+        , m_calls(0)
+    {}
+    size_t calls() const{ return m_calls.load(std::memory_order_relaxed); }
+
+    virtual void make_overlays(VideoOverlaySet&) const override{}
+    virtual bool process_frame(const ImageViewRGB32&, WallClock) override{
+        std::this_thread::sleep_for(m_delay);
+        return m_calls.fetch_add(1, std::memory_order_relaxed) + 1 >= m_trigger_call;
+    }
+
+private:
+    std::chrono::milliseconds m_delay;
+    size_t m_trigger_call;
+    std::atomic<size_t> m_calls;
+};
+
+}
+
+//  Callbacks that are due on the same tick share one screenshot and run in
+//  parallel. When several of them fire on the same frame, the one that was
+//  registered first wins, even if it finishes last.
+int test_CommonFramework_VisualInferencePivot(const ImageViewRGB32& image){
+    const size_t NUM_CALLBACKS = 8;
+    const size_t TRIGGER_CALL = 3;
+    const std::chrono::milliseconds PERIOD(50);
+
+    AsyncDispatcher dispatcher(nullptr, 0);
+    CancellableHolder<CancellableScope> scope;
+    StillImageFeed feed(image);
+
+    //  The first one is the slowest.
+    std::vector<std::unique_ptr<DelayCallback>> callbacks;
+    for (size_t c = 0; c < NUM_CALLBACKS; c++){
+        callbacks.emplace_back(new DelayCallback(std::chrono::milliseconds(3 * (NUM_CALLBACKS - c)), TRIGGER_CALL));
+    }
+
+    std::atomic<InferenceCallback*> triggered(nullptr);
+    {
+        VisualInferencePivot pivot(scope, feed, dispatcher);
+        CancellableHolder<CancellableScope> subscope(static_cast<CancellableScope&>(scope));
+        for (std::unique_ptr<DelayCallback>& callback : callbacks){
+            pivot.add_callback(subscope, &triggered, *callback, PERIOD);
+        }
+        try{
+            subscope.wait_for(std::chrono::seconds(10));
+        }catch (OperationCancelledException&){}
+        for (std::unique_ptr<DelayCallback>& callback : callbacks){
+            pivot.remove_callback(*callback);
+        }
+    }
+
+    size_t total_calls = 0;
+    for (const std::unique_ptr<DelayCallback>& callback : callbacks){
+        TEST_RESULT_EQUAL(callback->calls() >= 1, true);
+        TEST_RESULT_EQUAL(callback->calls() <= TRIGGER_CALL, true);
+        total_calls += callback->calls();
+    }
+    cout << "Callbacks: " << NUM_CALLBACKS << ", calls: " << total_calls << ", snapshots: " << feed.snapshots() << endl;
+
+    TEST_RESULT_EQUAL(triggered.load() == callbacks[0].get(), true);
+    TEST_RESULT_EQUAL(callbacks[0]->calls(), TRIGGER_CALL);
+    TEST_RESULT_EQUAL(feed.snapshots() < total_calls, true);
+
+    return 0;
+}
+
+
+namespace{
+
+//  What "ExactImageMatcher::rmsd()" used to do before the fused kernel.
+double unfused_rmsd(const ImageMatch::ExactImageMatcher& matcher, const ImageViewRGB32& image){
+    const ImageRGB32& image_template = matcher.image_template();
+    ImageRGB32 scaled = image.scale_to(image_template.width(), image_template.height());
+
+    FloatPixel scale = ImageMatch::pixel_average(scaled, image_template) / matcher.stats().average;
+    if (std::isnan(scale.r)) scale.r = 1.0;
+    if (std::isnan(scale.g)) scale.g = 1.0;
+    if (std::isnan(scale.b)) scale.b = 1.0;
+    scale.bound(0.85, 1.15);
+
+    ImageRGB32 reference = image_template.copy();
+    ImageMatch::scale_brightness(reference, scale);
+    return ImageMatch::pixel_RMSD(reference, scaled);
+}
+
+int test_ExactImageMatcher_sprites(const std::string& name, const SpriteDatabase& database){
+    const size_t MAX_SPRITES = 64;
+
+    std::vector<std::unique_ptr<ImageMatch::ExactImageMatcher>> matchers;
+    std::vector<ImageViewRGB32> candidates;
+    std::vector<ImageRGB32> enlarged;
+    for (const auto& item : database){
+        if (matchers.size() >= MAX_SPRITES){
+            break;
+        }
+        const ImageViewRGB32& sprite = item.second.sprite;
+        matchers.emplace_back(new ImageMatch::ExactImageMatcher(sprite.copy()));
+        candidates.emplace_back(sprite);
+        enlarged.emplace_back(sprite.scale_to(sprite.width() * 3 / 2, sprite.height() * 3 / 2));
+    }
+    size_t pairs = matchers.size() * candidates.size();
+    cout << name << ": " << matchers.size() << " templates, " << pairs << " pairs" << endl;
+
+    //  Same dimensions. This is the common path from the dictionary matchers.
+    //  The results must be identical.
+    std::vector<double> expected(pairs);
+    for (size_t t = 0; t < matchers.size(); t++){
+        for (size_t c = 0; c < candidates.size(); c++){
+            expected[t * candidates.size() + c] = unfused_rmsd(*matchers[t], candidates[c]);
+        }
+    }
+    size_t mismatches = 0;
+    for (size_t t = 0; t < matchers.size(); t++){
+        for (size_t c = 0; c < candidates.size(); c++){
+            double rmsd = matchers[t]->rmsd(candidates[c]);
+            if (rmsd != expected[t * candidates.size() + c]){
+                mismatches++;
+            }
+        }
+    }
+    TEST_RESULT_EQUAL(mismatches, (size_t)0);
+
+    //  Different dimensions. The resize is nearest-neighbor in both paths, but
+    //  may round differently at the edges. So just report how close they are.
+    double max_difference = 0;
+    for (size_t t = 0; t < matchers.size(); t++){
+        for (size_t c = 0; c < enlarged.size(); c++){
+            expected[t * enlarged.size() + c] = unfused_rmsd(*matchers[t], enlarged[c]);
+        }
+    }
+    for (size_t t = 0; t < matchers.size(); t++){
+        for (size_t c = 0; c < enlarged.size(); c++){
+            double rmsd = matchers[t]->rmsd(enlarged[c]);
+            max_difference = std::max(max_difference, std::abs(rmsd - expected[t * enlarged.size() + c]));
+        }
+    }
+    cout << "    Resampled: max difference = " << max_difference << endl;
+
+    return 0;
+}
+
+}
+
+int test_CommonFramework_ExactImageMatcher(){
+    int ret = test_ExactImageMatcher_sprites("PokemonSwSh", NintendoSwitch::PokemonSwSh::ALL_POKEMON_SPRITES());
+    if (ret != 0){
+        return ret;
+    }
+    return test_ExactImageMatcher_sprites("PokemonLA", NintendoSwitch::PokemonLA::ALL_POKEMON_SPRITES());
+}
+
+
+//  Each test image is a crop around a sprite. Match it with the default
+//  thumbnail pruning and without any. Every result within the spread must be
+//  the same.
+int test_CommonFramework_ExactImageDictionaryMatcher(const ImageViewRGB32& image){
+    using ImageMatch::ExactImageDictionaryMatcher;
+    auto make_matcher = [](bool pruning){
+        std::unique_ptr<ExactImageDictionaryMatcher> matcher(new ExactImageDictionaryMatcher({1, 256}));
+        for (const auto& item : NintendoSwitch::PokemonSwSh::ALL_POKEMON_SPRITES()){
+            matcher->add(item.first, item.second.sprite.copy());
+        }
+        if (!pruning){
+            matcher->set_pruning({SIZE_MAX, 0.10});
+        }
+        return matcher;
+    };
+    static const std::unique_ptr<ExactImageDictionaryMatcher> exhaustive = make_matcher(false);
+    static const std::unique_ptr<ExactImageDictionaryMatcher> pruned = make_matcher(true);
+
+    const size_t TOLERANCE = 2;
+    const double ALPHA_SPREAD = 0.02;
+    ImageFloatBox box(0, 0, 1, 1);
+
+    ImageMatch::ImageMatchResult expected = exhaustive->match(image, box, TOLERANCE, ALPHA_SPREAD);
+    ImageMatch::ImageMatchResult result = pruned->match(image, box, TOLERANCE, ALPHA_SPREAD);
+    cout << "Best: " << expected.results.begin()->second << " (" << expected.results.begin()->first << ")"
+         << ", results: " << expected.results.size() << endl;
+
+    TEST_RESULT_EQUAL(result.results.size(), expected.results.size());
+    auto iter0 = result.results.begin();
+    auto iter1 = expected.results.begin();
+    for (; iter1 != expected.results.end(); ++iter0, ++iter1){
+        TEST_RESULT_COMPONENT_EQUAL(iter0->second, iter1->second, "slug");
+        TEST_RESULT_COMPONENT_EQUAL(iter0->first, iter1->first, iter1->second);
+    }
+
+    return 0;
+}
+
+
+
+namespace{
+
+//  The plain dynamic programming edit distances. The bit-parallel versions
+//  must give the same results.
+size_t levenshtein_reference(const std::u32string& substring, const std::u32string& fullstring, bool substring_mode){
+    const size_t ylen = substring.size();
+    std::vector<size_t> v0(ylen + 1);
+    std::vector<size_t> v1(ylen + 1);
+    for (size_t c = 0; c <= ylen; c++){
+        v0[c] = c;
+    }
+    size_t min = ylen;
+    for (size_t i = 0; i < fullstring.size(); i++){
+        v1[0] = substring_mode ? 0 : i + 1;
+        for (size_t j = 0; j < ylen; j++){
+            size_t deletion = v0[j + 1] + 1;
+            size_t insertion = v1[j] + 1;
+            size_t substitution = v0[j] + (fullstring[i] == substring[j] ? 0 : 1);
+            v1[j + 1] = std::min(std::min(deletion, insertion), substitution);
+        }
+        std::swap(v0, v1);
+        min = std::min(min, v0[ylen]);
+    }
+    return substring_mode ? min : v0[ylen];
+}
+
+}
+
+
+int test_CommonFramework_Levenshtein(){
+    //  Random strings. Small alphabets make lots of matches. Long strings
+    //  cover patterns that span multiple 64-bit blocks.
+    std::mt19937_64 rng(0);
+    for (size_t iteration = 0; iteration < 20000; iteration++){
+        size_t alphabet = iteration % 4 == 0 ? 64 : 1 + rng() % 6;
+        size_t max_length = iteration % 3 == 0 ? 200 : 70;
+        std::u32string x;
+        std::u32string y;
+        size_t x_length = rng() % max_length;
+        size_t y_length = rng() % max_length;
+        for (size_t c = 0; c < x_length; c++){
+            x += (char32_t)(0x3040 + rng() % alphabet);
+        }
+        for (size_t c = 0; c < y_length; c++){
+            y += (char32_t)(0x3040 + rng() % alphabet);
+        }
+
+        TEST_RESULT_COMPONENT_EQUAL(OCR::levenshtein_distance(x, y), levenshtein_reference(y, x, false), "distance");
+        TEST_RESULT_COMPONENT_EQUAL(OCR::levenshtein_distance_substring(y, x), levenshtein_reference(y, x, true), "substring");
+    }
+
+    //  Corrupted Pokemon names against the English name dictionary.
+    std::vector<std::u32string> names;
+    JsonObject json = Pokemon::PokemonNameReader::instance().dictionary(Language::English).to_json();
+    for (const auto& item : json){
+        for (const auto& candidate : item.second.get_array_throw()){
+            names.emplace_back(OCR::normalize_utf32(candidate.get_string_throw()));
+        }
+    }
+    std::vector<std::u32string> queries;
+    for (size_t c = 0; c < 20; c++){
+        std::u32string query = names[rng() % names.size()];
+        for (char32_t& ch : query){
+            if (rng() % 8 == 0){
+                ch = (char32_t)('a' + rng() % 26);
+            }
+        }
+        queries.emplace_back(U"The wild " + query + U" appeared!");
+    }
+
+    size_t checksum_reference = 0;
+    for (const std::u32string& query : queries){
+        for (const std::u32string& name : names){
+            checksum_reference += levenshtein_reference(name, query, true);
+        }
+    }
+    size_t checksum = 0;
+    for (const std::u32string& query : queries){
+        OCR::LevenshteinText<char32_t> text(query.data(), query.size());
+        for (const std::u32string& name : names){
+            checksum += text.distance_substring(name.data(), name.size());
+        }
+    }
+    TEST_RESULT_EQUAL(checksum, checksum_reference);
+
+    return 0;
+}
+
+
+//  Match corrupted Pokemon names in every language with and without the
+//  index. The results must be the same.
+int test_CommonFramework_DictionaryQGramIndex(){
+    const Pokemon::PokemonNameReader& reader = Pokemon::PokemonNameReader::instance();
+    std::mt19937_64 rng(0);
+
+    for (Language language : reader.languages()){
+        const LanguageData& data = language_data(language);
+
+        OCR::QGramIndex::Database database;
+        std::vector<std::u32string> names;
+        JsonObject json = reader.dictionary(language).to_json();
+        for (const auto& item : json){
+            for (const auto& candidate : item.second.get_array_throw()){
+                std::u32string normalized = OCR::normalize_utf32(candidate.get_string_throw());
+                database[normalized].insert(item.first);
+                names.emplace_back(std::move(normalized));
+            }
+        }
+
+        OCR::QGramIndex index(data.random_match_chance);
+        for (const auto& item : database){
+            index.add(item);
+        }
+
+        //  Names with some characters replaced by characters from other names
+        //  and random junk around them.
+        auto random_char = [&](){
+            const std::u32string& name = names[rng() % names.size()];
+            return name[rng() % name.size()];
+        };
+        std::vector<std::string> queries;
+        for (size_t c = 0; c < 100; c++){
+            std::u32string query;
+            for (size_t i = rng() % 6; i > 0; i--){
+                query += random_char();
+            }
+            for (char32_t ch : names[rng() % names.size()]){
+                query += rng() % 6 == 0 ? random_char() : ch;
+            }
+            for (size_t i = rng() % 6; i > 0; i--){
+                query += random_char();
+            }
+            queries.emplace_back(to_utf8(query));
+        }
+
+        std::vector<OCR::StringMatchResult> expected;
+        for (const std::string& query : queries){
+            expected.emplace_back(OCR::match_substring(database, data.random_match_chance, query, 0.50));
+        }
+        std::vector<OCR::StringMatchResult> results;
+        for (const std::string& query : queries){
+            results.emplace_back(index.match_substring(database, query, 0.50));
+        }
+        cout << data.name << ": " << index.candidates() << " candidates" << endl;
+
+        for (size_t c = 0; c < queries.size(); c++){
+            TEST_RESULT_COMPONENT_EQUAL(results[c].exact_match, expected[c].exact_match, queries[c]);
+            TEST_RESULT_COMPONENT_EQUAL(results[c].results.size(), expected[c].results.size(), queries[c]);
+            auto iter0 = results[c].results.begin();
+            auto iter1 = expected[c].results.begin();
+            for (; iter0 != results[c].results.end(); ++iter0, ++iter1){
+                TEST_RESULT_COMPONENT_EQUAL(iter0->first, iter1->first, queries[c]);
+                TEST_RESULT_COMPONENT_EQUAL(iter0->second.token, iter1->second.token, queries[c]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+//  Match a stream with the template embedded in noise. Compare against
+//  matching the last N spectrums from scratch every time.
+int test_CommonFramework_SpectrogramMatcher(){
+    const size_t sample_rate = 48000;
+    const size_t frequencies = 2048;
+    const size_t windows = 40;
+    const double low_frequency_filter = 58.59375;
+    std::mt19937_64 rng(0);
+    std::uniform_real_distribution<float> random(0, 1);
+
+    AudioTemplate audio_template(frequencies, windows);
+    for (size_t i = 0; i < windows; i++){
+        for (size_t j = 0; j < frequencies; j++){
+            audio_template.getWindow(i)[j] = random(rng) * random(rng) * (j < 400 ? 10 : 1);
+        }
+    }
+
+    std::vector<AudioSpectrum> stream;
+    for (size_t s = 0; s < 3000; s++){
+        AlignedVector<float> magnitudes(frequencies);
+        size_t phase = s % 500;
+        for (size_t j = 0; j < frequencies; j++){
+            magnitudes[j] = random(rng) * 0.5f;
+            if (phase < windows){
+                magnitudes[j] += 3.0f * audio_template.getWindow(phase)[j];
+            }
+        }
+        stream.emplace_back(s, sample_rate, std::make_shared<const AlignedVector<float>>(std::move(magnitudes)));
+    }
+
+    //  Same frequency range as the matcher uses in RAW mode.
+    const size_t half_sample_rate = sample_rate / 2;
+    const size_t freq_start = int(low_frequency_filter * frequencies / half_sample_rate + 0.5);
+    const size_t freq_end = 20000 * frequencies / half_sample_rate + 1;
+    float template_sum_sqr = 0;
+    for (size_t i = 0; i < windows; i++){
+        for (size_t j = freq_start; j < freq_end; j++){
+            const float v = audio_template.getWindow(i)[j];
+            template_sum_sqr += v * v;
+        }
+    }
+    const float template_norm = std::sqrt(template_sum_sqr);
+
+    std::vector<float> expected;
+    std::deque<const float*> history;
+    std::vector<const float*> matrixA(windows);
+    std::vector<const float*> matrixT(windows);
+    for (const AudioSpectrum& spectrum : stream){
+        history.emplace_front(spectrum.magnitudes->data());
+        if (history.size() > windows){
+            history.pop_back();
+        }
+        if (history.size() < windows){
+            expected.emplace_back(FLT_MAX);
+            continue;
+        }
+        for (size_t i = 0; i < windows; i++){
+            matrixA[i] = freq_start + history[i];
+            matrixT[i] = freq_start + audio_template.getWindow(windows - 1 - i);
+        }
+        float scale = Kernels::ScaleInvariantMatrixMatch::compute_scale(
+            freq_end - freq_start, windows, matrixA.data(), matrixT.data()
+        );
+        scale = std::min<float>(scale, 1000000);
+        float error = Kernels::ScaleInvariantMatrixMatch::compute_error(
+            freq_end - freq_start, windows, scale, matrixA.data(), matrixT.data()
+        );
+        expected.emplace_back(std::min<float>(std::sqrt(error) / template_norm, 1.0));
+    }
+
+    SpectrogramMatcher matcher(
+        "Test", std::move(audio_template), SpectrogramMatcher::Mode::RAW,
+        sample_rate, low_frequency_filter
+    );
+    std::vector<float> results;
+    for (const AudioSpectrum& spectrum : stream){
+        results.emplace_back(matcher.match({spectrum}));
+    }
+
+    size_t matches = 0;
+    for (size_t c = 0; c < stream.size(); c++){
+        TEST_RESULT_COMPONENT_EQUAL(results[c] == FLT_MAX, expected[c] == FLT_MAX, "spectrum " + std::to_string(c));
+        if (expected[c] == FLT_MAX){
+            continue;
+        }
+        TEST_RESULT_APPROXIMATE(results[c], expected[c], 1e-4);
+        matches += expected[c] < 0.2;
+    }
+
+    //  The template is embedded every 500 spectrums.
+    TEST_RESULT_EQUAL(matches > 0, true);
+
+    return 0;
+}
+
+
+//  FileWindowLogger minus the windows. Lines go into a plain file.
+class TestLogWriter : public AsyncLogWriter{
+public:
+    TestLogWriter(
+        const std::string& path, const AsyncLogWriterConfig& config,
+        std::chrono::microseconds write_delay = std::chrono::microseconds(0)
+    )
+        : AsyncLogWriter(config)
+        , m_file(fopen(path.c_str(), "wb"))
+        , m_write_delay(write_delay)
+    {
+        start();
+    }
+    ~TestLogWriter(){
+        stop();
+        fclose(m_file);
+    }
+    size_t writes() const{ return m_writes; }
+
+private:
+    virtual void process_batch(std::string& file_buffer, std::vector<Entry>& batch) override{
+        for (const Entry& entry : batch){
+            file_buffer += entry.msg;
+            file_buffer += "\r\n";
+        }
+    }
+    virtual void write_file(const std::string& data) override{
+        fwrite(data.c_str(), 1, data.size(), m_file);
+        fflush(m_file);
+        m_writes++;
+        if (m_write_delay.count() > 0){
+            std::this_thread::sleep_for(m_write_delay);
+        }
+    }
+
+private:
+    FILE* m_file;
+    std::chrono::microseconds m_write_delay;
+    std::atomic<size_t> m_writes{0};
+};
+
+//  The FileWindowLogger writer before batching. One line at a time with a
+//  flush after every line.
+class ReferenceLogWriter{
+public:
+    ReferenceLogWriter(const std::string& path)
+        : m_file(fopen(path.c_str(), "wb"))
+        , m_thread(&ReferenceLogWriter::thread_loop, this)
+    {}
+    ~ReferenceLogWriter(){
+        {
+            std::lock_guard<std::mutex> lg(m_lock);
+            m_stopping = true;
+            m_cv.notify_all();
+        }
+        m_thread.join();
+        fclose(m_file);
+    }
+    void push(std::string&& msg){
+        std::unique_lock<std::mutex> lg(m_lock);
+        m_cv.wait(lg, [this]{ return m_queue.size() < MAX_QUEUE_SIZE; });
+        m_queue.emplace_back(std::move(msg));
+        m_cv.notify_all();
+    }
+
+private:
+    void thread_loop(){
+        std::unique_lock<std::mutex> lg(m_lock);
+        while (true){
+            m_cv.wait(lg, [&]{
+                return m_stopping || !m_queue.empty();
+            });
+            if (m_queue.empty()){
+                break;
+            }
+            std::string msg = std::move(m_queue.front());
+            m_queue.pop_front();
+
+            lg.unlock();
+            msg += "\r\n";
+            fwrite(msg.c_str(), 1, msg.size(), m_file);
+            fflush(m_file);
+            lg.lock();
+
+            if (m_queue.size() <= MAX_QUEUE_SIZE / 2){
+                m_cv.notify_all();
+            }
+        }
+    }
+
+private:
+    static constexpr size_t MAX_QUEUE_SIZE = 10000;
+    FILE* m_file;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+    std::deque<std::string> m_queue;
+    std::thread m_thread;
+};
+
+//  Read back a log of lines "<thread>:<index>". Every thread's lines must be
+//  in order. Returns the number of lines from each thread.
+std::vector<size_t> read_test_log(const std::string& path, size_t threads, size_t& other_lines, bool& in_order){
+    std::vector<size_t> counts(threads);
+    std::vector<int64_t> last(threads, -1);
+    other_lines = 0;
+    in_order = true;
+
+    std::ifstream file(path, std::ios::binary);
+    std::string line;
+    while (std::getline(file, line)){
+        if (!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        size_t colon = line.find(':');
+        if (colon == std::string::npos){
+            other_lines++;
+            continue;
+        }
+        size_t thread = std::stoull(line.substr(0, colon));
+        int64_t index = std::stoll(line.substr(colon + 1));
+        if (thread >= threads || index <= last[thread]){
+            in_order = false;
+            continue;
+        }
+        last[thread] = index;
+        counts[thread]++;
+    }
+    return counts;
+}
+
+//  Log from many threads at once through the batched writer and through the
+//  old one-line-at-a-time writer. Then check that nothing is lost or
+//  reordered, that the size and time bounds and explicit flushes work, and
+//  that the drop policy drops instead of blocking.
+int test_CommonFramework_AsyncLogWriter(){
+    const std::string path = "AsyncLogWriterTest.log";
+    const size_t THREADS = 8;
+    const size_t LINES = 100000 / THREADS;
+
+    auto run_threads = [&](size_t lines, auto&& push){
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; t++){
+            threads.emplace_back([&, t]{
+                for (size_t c = 0; c < lines; c++){
+                    push(std::to_string(t) + ":" + std::to_string(c));
+                }
+            });
+        }
+        for (std::thread& thread : threads){
+            thread.join();
+        }
+    };
+    size_t other_lines;
+    bool in_order;
+
+    //  Old writer
+    {
+        {
+            ReferenceLogWriter writer(path);
+            run_threads(LINES, [&](std::string&& msg){ writer.push(std::move(msg)); });
+        }
+
+        std::vector<size_t> counts = read_test_log(path, THREADS, other_lines, in_order);
+        TEST_RESULT_EQUAL(in_order, true);
+        for (size_t t = 0; t < THREADS; t++){
+            TEST_RESULT_EQUAL(counts[t], LINES);
+        }
+    }
+
+    //  Batched writer, blocking when full.
+    {
+        size_t writes;
+        {
+            TestLogWriter writer(path, AsyncLogWriterConfig());
+            run_threads(LINES, [&](std::string&& msg){ writer.push(std::move(msg), Color()); });
+            writer.flush();
+            writes = writer.writes();
+            TEST_RESULT_EQUAL(writer.dropped(), (uint64_t)0);
+        }
+        cout << "Batched: " << writes << " writes" << endl;
+
+        std::vector<size_t> counts = read_test_log(path, THREADS, other_lines, in_order);
+        TEST_RESULT_EQUAL(in_order, true);
+        TEST_RESULT_EQUAL(other_lines, (size_t)0);
+        for (size_t t = 0; t < THREADS; t++){
+            TEST_RESULT_EQUAL(counts[t], LINES);
+        }
+    }
+
+    //  Nothing is written until the time bound unless asked for.
+    {
+        AsyncLogWriterConfig config;
+        config.flush_delay = std::chrono::milliseconds(200);
+        TestLogWriter writer(path, config);
+
+        auto wait_for_writes = [&](size_t writes){
+            WallClock deadline = current_time() + std::chrono::seconds(5);
+            while (writer.writes() < writes && current_time() < deadline){
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        };
+
+        auto time_start = current_time();
+        writer.push("0:0", Color());
+        writer.push("0:1", Color());
+        wait_for_writes(1);
+        auto elapsed = current_time() - time_start;
+        TEST_RESULT_EQUAL(writer.writes(), (size_t)1);
+        TEST_RESULT_EQUAL(elapsed >= std::chrono::milliseconds(150), true);
+
+        //  Errors go out right away.
+        time_start = current_time();
+        writer.push("0:2", COLOR_RED);
+        wait_for_writes(2);
+        elapsed = current_time() - time_start;
+        TEST_RESULT_EQUAL(writer.writes(), (size_t)2);
+        TEST_RESULT_EQUAL(elapsed < std::chrono::milliseconds(150), true);
+
+        writer.push("0:3", Color());
+        writer.flush();
+        TEST_RESULT_EQUAL(writer.writes(), (size_t)3);
+    }
+    {
+        std::vector<size_t> counts = read_test_log(path, 1, other_lines, in_order);
+        TEST_RESULT_EQUAL(in_order, true);
+        TEST_RESULT_EQUAL(counts[0], (size_t)4);
+    }
+
+    //  Slow disk with a tiny queue that drops when full.
+    {
+        AsyncLogWriterConfig config;
+        config.queue_capacity = 16;
+        config.full_policy = LogQueueFullPolicy::DROP;
+        config.flush_bytes = 0;
+        uint64_t dropped;
+        {
+            TestLogWriter writer(path, config, std::chrono::microseconds(1000));
+            run_threads(1000, [&](std::string&& msg){ writer.push(std::move(msg), Color()); });
+            dropped = writer.dropped();
+        }
+        cout << "Dropped: " << dropped << endl;
+
+        std::vector<size_t> counts = read_test_log(path, THREADS, other_lines, in_order);
+        TEST_RESULT_EQUAL(in_order, true);
+        TEST_RESULT_EQUAL(dropped > 0, true);
+        TEST_RESULT_EQUAL(other_lines > 0, true);
+        size_t total = 0;
+        for (size_t count : counts){
+            total += count;
+        }
+        TEST_RESULT_EQUAL(total + dropped, (uint64_t)THREADS * 1000);
+    }
+
+    remove(path.c_str());
+
+    return 0;
+}
+
+
+//  Save screenshots through ImageEncodeService. Then read the files back.
+int test_CommonFramework_ImageEncodeService(){
+    const size_t COUNT = 4;
+
+    //  A gradient with some noise so the encoder has real work to do.
+    ImageRGB32 image(1920, 1080);
+    std::mt19937 rng(0);
+    for (size_t r = 0; r < image.height(); r++){
+        for (size_t c = 0; c < image.width(); c++){
+            uint32_t red = (uint32_t)(c * 255 / image.width());
+            uint32_t green = (uint32_t)(r * 255 / image.height());
+            uint32_t blue = rng() & 0x3f;
+            image.pixel(c, r) = 0xff000000 | (red << 16) | (green << 8) | blue;
+        }
+    }
+
+    auto path = [](size_t index){
+        return "ImageEncodeServiceTest-" + std::to_string(index) + ".png";
+    };
+    std::vector<std::shared_future<bool>> futures;
+    {
+        ImageEncodeService service(2, 16);
+        for (size_t c = 0; c < COUNT; c++){
+            futures.emplace_back(service.save(image, path(c)));
+        }
+        for (size_t c = 0; c < COUNT; c++){
+            TEST_RESULT_EQUAL(futures[c].get(), true);
+            TEST_RESULT_EQUAL(service.pending(path(c)).valid(), false);
+        }
+
+        TEST_RESULT_EQUAL(service.save(ImageViewRGB32(), path(COUNT)).get(), false);
+
+        //  Nothing is written after stop().
+        service.stop();
+        TEST_RESULT_EQUAL(service.save(image, path(COUNT)).get(), false);
+    }
+
+    for (size_t c = 0; c < COUNT; c++){
+        ImageRGB32 loaded(path(c));
+        remove(path(c).c_str());
+        TEST_RESULT_EQUAL(loaded.width(), image.width());
+        TEST_RESULT_EQUAL(loaded.height(), image.height());
+        for (size_t r = 0; r < image.height(); r++){
+            for (size_t x = 0; x < image.width(); x++){
+                TEST_RESULT_COMPONENT_EQUAL(loaded.pixel(x, r), image.pixel(x, r), path(c));
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+//  Load a sprite database from its sources and from a pack built from it.
+//  They must be identical.
+int test_CommonFramework_SpritePack(){
+    const char* SPRITE_PATH = "PokemonSwSh/PokemonSprites.png";
+    const char* JSON_PATH = "PokemonSwSh/PokemonSprites.json";
+    const std::string PACK_PATH = "SpritePackTest.spritepack";
+
+    std::unique_ptr<SpriteDatabase> expected(new SpriteDatabase(SPRITE_PATH, JSON_PATH, false));
+    expected->write_pack(PACK_PATH, SPRITE_PATH, JSON_PATH);
+    std::unique_ptr<SpriteDatabase> database(new SpriteDatabase(PACK_PATH));
+    cout << "Sprites: " << expected->get().size() << endl;
+
+    TEST_RESULT_EQUAL(database->get().size(), expected->get().size());
+    auto iter0 = database->begin();
+    auto iter1 = expected->begin();
+    for (; iter1 != expected->end(); ++iter0, ++iter1){
+        const std::string& slug = iter1->first;
+        const SpriteDatabase::Sprite& sprite = iter0->second;
+        const SpriteDatabase::Sprite& reference = iter1->second;
+        TEST_RESULT_COMPONENT_EQUAL(iter0->first, slug, "slug");
+
+        TEST_RESULT_COMPONENT_EQUAL((size_t)sprite.sprite.data() % PA_ALIGNMENT, (size_t)0, slug);
+        TEST_RESULT_COMPONENT_EQUAL(sprite.sprite.width(), reference.sprite.width(), slug);
+        TEST_RESULT_COMPONENT_EQUAL(sprite.sprite.height(), reference.sprite.height(), slug);
+        for (size_t r = 0; r < sprite.sprite.height(); r++){
+            for (size_t c = 0; c < sprite.sprite.width(); c++){
+                TEST_RESULT_COMPONENT_EQUAL(sprite.sprite.pixel(c, r), reference.sprite.pixel(c, r), slug);
+            }
+        }
+
+        TEST_RESULT_COMPONENT_EQUAL(sprite.icon.width(), reference.icon.width(), slug);
+        TEST_RESULT_COMPONENT_EQUAL(sprite.icon.height(), reference.icon.height(), slug);
+
+        //  The integer sums in "image_stats()" make these exact.
+        ImageStats stats = image_stats(sprite.icon);
+        TEST_RESULT_COMPONENT_EQUAL(sprite.icon_stats.count, reference.icon_stats.count, slug);
+        TEST_RESULT_COMPONENT_EQUAL(sprite.icon_stats.average.sum(), reference.icon_stats.average.sum(), slug);
+        TEST_RESULT_COMPONENT_EQUAL(sprite.icon_stats.stddev.sum(), reference.icon_stats.stddev.sum(), slug);
+        TEST_RESULT_COMPONENT_EQUAL(sprite.icon_stats.stddev.sum(), stats.stddev.sum(), slug);
+    }
+    database.reset();
+
+    auto read_file = [](const std::string& path){
+        std::ifstream in(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    };
+    auto write_file = [](const std::string& path, const std::string& data){
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    };
+
+    //  Changing a source without changing its size makes the pack out of date.
+    {
+        const std::string image = RESOURCE_PATH() + SPRITE_PATH;
+        const std::string json = RESOURCE_PATH() + JSON_PATH;
+        const std::string JSON_COPY = "SpritePackTest.json";
+        std::string data = read_file(json);
+        write_file(JSON_COPY, data);
+        SpritePack pack(PACK_PATH);
+        TEST_RESULT_EQUAL(pack.built_from(image, json), true);
+        TEST_RESULT_EQUAL(pack.built_from(image, JSON_COPY), true);
+        data[data.size() / 2] ^= 1;
+        write_file(JSON_COPY, data);
+        TEST_RESULT_EQUAL(pack.built_from(image, JSON_COPY), false);
+        remove(JSON_COPY.c_str());
+    }
+
+    //  A misaligned entry table must be rejected.
+    {
+        std::string data = read_file(PACK_PATH);
+        SpritePackHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        header.entries_offset += 4;
+        const std::string BAD_PATH = "SpritePackTest-misaligned.spritepack";
+        write_file(BAD_PATH, data.replace(0, sizeof(header), (const char*)&header, sizeof(header)));
+        bool misaligned_rejected = false;
+        try{
+            SpritePack pack(BAD_PATH);
+        }catch (FileException&){
+            misaligned_rejected = true;
+        }
+        remove(BAD_PATH.c_str());
+        TEST_RESULT_EQUAL(misaligned_rejected, true);
+    }
+
+    //  A truncated pack must be rejected.
+    {
+        std::string data = read_file(PACK_PATH);
+        std::ofstream out(PACK_PATH, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size() / 2);
+    }
+    bool rejected = false;
+    try{
+        SpriteDatabase truncated(PACK_PATH);
+    }catch (FileException&){
+        rejected = true;
+    }
+    remove(PACK_PATH.c_str());
+    TEST_RESULT_EQUAL(rejected, true);
+
+    return 0;
+}
+
+
+
+
 }
@@ -15,6 +15,24 @@ class ImageViewRGB32;
 
 int test_CommonFramework_BlackBorderDetector(const ImageViewRGB32& image, bool target);
 
+int test_CommonFramework_VisualInferencePivot(const ImageViewRGB32& image);
+
+int test_CommonFramework_ExactImageMatcher();
+
+int test_CommonFramework_ExactImageDictionaryMatcher(const ImageViewRGB32& image);
+
+int test_CommonFramework_Levenshtein();
+
+int test_CommonFramework_DictionaryQGramIndex();
+
+int test_CommonFramework_SpectrogramMatcher();
+
+int test_CommonFramework_AsyncLogWriter();
+
+int test_CommonFramework_ImageEncodeService();
+
+int test_CommonFramework_SpritePack();
+
 }
 
 #endif
@@ -0,0 +1,608 @@
+/*  Common Tests
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+
+#include "Common/Compiler.h"
+#include "Common/Cpp/Time.h"
+#include "Common/Cpp/CpuId/CpuId.h"
+#include "Common/Cpp/Concurrency/WorkStealingPool.h"
+#include "Common/Cpp/Concurrency/TimerWheel.h"
+#include "Common/CRC32.h"
+#include "Common/Microcontroller/MessageProtocol.h"
+#include "Common/Microcontroller/DeviceRoutines.h"
+#include "ClientSource/Connection/BotBaseMessage.h"
+#include "ClientSource/Connection/PABotBaseConnection.h"
+#include "ClientSource/Connection/PABotBase.h"
+#include "CommonFramework/Logging/Logger.h"
+#include "Common_Tests.h"
+#include "LoopbackDevice.h"
+#include "TestUtils.h"
+
+#include <map>
+#include <set>
+#include <deque>
+#include <random>
+#include <thread>
+#include <iostream>
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace PokemonAutomation{
+
+
+int test_Common_WorkStealingPool(){
+    WorkStealingPool pool(nullptr, 0);
+    cout << "Testing WorkStealingPool with " << pool.threads() << " threads." << endl;
+
+    //  Every index runs exactly once.
+    {
+        const size_t N = 100000;
+        std::vector<std::atomic<uint8_t>> hits(N);
+        pool.run_in_parallel(0, N, [&](size_t index){
+            hits[index].fetch_add(1, std::memory_order_relaxed);
+        });
+        for (size_t c = 0; c < N; c++){
+            TEST_RESULT_EQUAL((int)hits[c].load(), 1);
+        }
+    }
+
+    //  Nested parallel loops must not deadlock.
+    {
+        std::atomic<size_t> sum(0);
+        pool.run_in_parallel(0, 64, [&](size_t){
+            pool.run_in_parallel(0, 1000, [&](size_t index){
+                sum.fetch_add(index, std::memory_order_relaxed);
+            }, 7);
+        }, 1);
+        TEST_RESULT_EQUAL(sum.load(), (size_t)64 * 999 * 1000 / 2);
+    }
+
+    //  Exceptions propagate to the caller.
+    {
+        bool caught = false;
+        try{
+            pool.run_in_parallel(0, 1000, [](size_t index){
+                if (index == 500){
+                    throw std::runtime_error("test");
+                }
+            });
+        }catch (const std::runtime_error&){
+            caught = true;
+        }
+        TEST_RESULT_EQUAL(caught, true);
+    }
+
+    return 0;
+}
+
+
+namespace{
+
+struct TestTimer : public TimerWheelNode{
+    size_t index;
+    WallClock expiration;
+    std::multimap<WallClock, size_t>::iterator iter;
+};
+
+}
+
+
+int test_Common_TimerWheel(){
+    const size_t TIMERS = 100000;
+    const WallClock origin = current_time();
+
+    std::mt19937_64 rng(12345);
+    auto random_expiration = [&](WallClock now){
+        //  Mostly short timers with a long tail to exercise all the levels.
+        uint64_t r = rng();
+        uint64_t ms;
+        switch (r % 8){
+        case 0: ms = 0; break;
+        case 1: ms = (r >> 8) % 64; break;
+        case 2: ms = (r >> 8) % 4096; break;
+        case 3: ms = (r >> 8) % 262144; break;
+        case 4: ms = (r >> 8) % 100000000; break;
+        default: ms = (r >> 8) % 1000;
+        }
+        return std::chrono::time_point_cast<std::chrono::milliseconds>(now) + std::chrono::milliseconds(ms);
+    };
+
+    //  Randomized stress against a multimap reference. Time is simulated.
+    //  Since all expirations are whole milliseconds, every timer must fire
+    //  exactly on its tick.
+    {
+        TimerWheel wheel(std::chrono::time_point_cast<std::chrono::milliseconds>(origin));
+        std::multimap<WallClock, size_t> reference;
+        std::vector<TestTimer> timers(TIMERS);
+
+        WallClock now = std::chrono::time_point_cast<std::chrono::milliseconds>(origin);
+        for (size_t c = 0; c < TIMERS; c++){
+            TestTimer& timer = timers[c];
+            timer.index = c;
+            timer.expiration = random_expiration(now);
+            timer.iter = reference.emplace(timer.expiration, c);
+            wheel.add(timer, timer.expiration);
+        }
+        TEST_RESULT_EQUAL(wheel.size(), TIMERS);
+
+        size_t fired = 0;
+        std::set<size_t> expected;
+        for (size_t step = 0; step < 200000; step++){
+            //  Mostly small steps. Occasionally jump far ahead.
+            uint64_t r = rng();
+            now += std::chrono::milliseconds(r % 64 == 0 ? (r >> 8) % 1000000 : (r >> 8) % 4);
+
+            //  Random adds, cancels and reschedules.
+            for (size_t i = 0; i < 4; i++){
+                TestTimer& timer = timers[rng() % TIMERS];
+                if (timer.scheduled()){
+                    reference.erase(timer.iter);
+                }
+                if (rng() % 4 == 0){
+                    wheel.cancel(timer);
+                }else{
+                    timer.expiration = random_expiration(now);
+                    timer.iter = reference.emplace(timer.expiration, timer.index);
+                    wheel.add(timer, timer.expiration);
+                }
+            }
+
+            //  The next expiration is never late.
+            WallClock next = wheel.next_expiration();
+            if (!reference.empty() && reference.begin()->first > now){
+                TEST_RESULT_EQUAL(next <= reference.begin()->first, true);
+            }
+
+            expected.clear();
+            while (!reference.empty() && reference.begin()->first <= now){
+                expected.insert(reference.begin()->second);
+                reference.erase(reference.begin());
+            }
+            WallClock last = WallClock::min();
+            while (TimerWheelNode* node = wheel.pop_expired(now)){
+                TestTimer& timer = static_cast<TestTimer&>(*node);
+                TEST_RESULT_EQUAL(expected.erase(timer.index), (size_t)1);
+                TEST_RESULT_EQUAL(timer.expiration >= last, true);
+                last = timer.expiration;
+                fired++;
+
+                //  Re-arm half of them like a periodic timer would.
+                if (rng() % 2){
+                    timer.expiration = random_expiration(now + std::chrono::milliseconds(1));
+                    timer.iter = reference.emplace(timer.expiration, timer.index);
+                    wheel.add(timer, timer.expiration);
+                }
+            }
+            TEST_RESULT_EQUAL(expected.size(), (size_t)0);
+            TEST_RESULT_EQUAL(wheel.size(), reference.size());
+        }
+        cout << "Stress test: " << fired << " timers fired, " << wheel.size() << " still scheduled." << endl;
+    }
+
+    return 0;
+}
+
+
+
+
+
+namespace{
+
+//  Everything that comes out of the receive path. Both messages and logs are
+//  recorded so that the order of the two is compared.
+struct RecvEvent{
+    bool is_message;
+    uint8_t type;
+    std::string body;
+
+    bool operator==(const RecvEvent& x) const{
+        return is_message == x.is_message && type == x.type && body == x.body;
+    }
+};
+
+class RecordingSniffer : public MessageSniffer{
+public:
+    RecordingSniffer(std::vector<RecvEvent>& events) : m_events(events) {}
+    virtual void log(std::string msg) override{
+        m_events.emplace_back(RecvEvent{false, 0, std::move(msg)});
+    }
+private:
+    std::vector<RecvEvent>& m_events;
+};
+
+class NullStreamConnection : public StreamConnection{
+public:
+    virtual void stop() override{}
+    virtual void send(const void* data, size_t bytes) override{}
+};
+
+class RecordingConnection : public PABotBaseConnection{
+public:
+    RecordingConnection(std::vector<RecvEvent>& events)
+        : PABotBaseConnection(global_logger_command_line(), std::make_unique<NullStreamConnection>())
+        , m_events(events)
+    {}
+    void recv(const void* data, size_t bytes){
+        static_cast<StreamListener&>(*this).on_recv(data, bytes);
+    }
+    size_t messages = 0;
+private:
+    virtual void on_recv_message(BotBaseMessage message) override{
+        messages++;
+        m_events.emplace_back(RecvEvent{true, message.type, std::move(message.body)});
+    }
+private:
+    std::vector<RecvEvent>& m_events;
+};
+
+//  The old receive path. A byte at a time through a deque.
+class ReferenceParser{
+public:
+    ReferenceParser(std::vector<RecvEvent>& events) : m_events(events) {}
+
+    void recv(const void* data, size_t bytes){
+        for (size_t c = 0; c < bytes; c++){
+            m_buffer.emplace_back(((const char*)data)[c]);
+        }
+        while (!m_buffer.empty()){
+            uint8_t length = ~m_buffer[0];
+            if (m_buffer[0] == 0){
+                log("Skipping zero byte.");
+                m_buffer.pop_front();
+                continue;
+            }
+            if (length < PABB_PROTOCOL_OVERHEAD){
+                log("Message is too short: bytes = " + std::to_string(length));
+                m_buffer.pop_front();
+                continue;
+            }
+            if (length > PABB_MAX_PACKET_SIZE){
+                log("Message is too long: bytes = " + std::to_string(length));
+                m_buffer.pop_front();
+                continue;
+            }
+            if (length > m_buffer.size()){
+                return;
+            }
+            std::string message(m_buffer.begin(), m_buffer.begin() + length);
+            uint32_t checksumA = pabb_crc32(0xffffffff, &message[0], length - sizeof(uint32_t));
+            uint32_t checksumE;
+            memcpy(&checksumE, &message[0] + length - sizeof(uint32_t), sizeof(uint32_t));
+            if (checksumA != checksumE){
+                log("Invalid Checksum: bytes = " + std::to_string(length));
+                m_buffer.pop_front();
+                continue;
+            }
+            m_buffer.erase(m_buffer.begin(), m_buffer.begin() + length);
+            BotBaseMessage msg(message[1], std::string(&message[2], length - PABB_PROTOCOL_OVERHEAD));
+            on_recv_message(std::move(msg));
+        }
+    }
+
+private:
+    PA_NO_INLINE void on_recv_message(BotBaseMessage message){
+        m_events.emplace_back(RecvEvent{true, message.type, std::move(message.body)});
+    }
+    void log(std::string msg){
+        m_events.emplace_back(RecvEvent{false, 0, std::move(msg)});
+    }
+
+private:
+    std::vector<RecvEvent>& m_events;
+    std::deque<char> m_buffer;
+};
+
+template <typename Rng>
+void append_frame(std::string& stream, Rng& rng, size_t body_size){
+    size_t start = stream.size();
+    stream += (char)~(uint8_t)(PABB_PROTOCOL_OVERHEAD + body_size);
+    stream += (char)(rng() % 256);
+    for (size_t c = 0; c < body_size; c++){
+        stream += (char)(rng() % 256);
+    }
+    stream += std::string(sizeof(uint32_t), 0);
+    pabb_crc32_write_to_message(&stream[start], stream.size() - start);
+}
+
+//  Valid messages mixed with zeros, garbage, and corrupted messages.
+template <typename Rng>
+std::string random_stream(Rng& rng, size_t items){
+    std::string stream;
+    for (size_t c = 0; c < items; c++){
+        switch (rng() % 6){
+        case 0:
+            stream += std::string(rng() % 4 + 1, 0);
+            break;
+        case 1:
+            for (size_t i = rng() % 20 + 1; i > 0; i--){
+                stream += (char)(rng() % 256);
+            }
+            break;
+        case 2:{
+            size_t start = stream.size();
+            append_frame(stream, rng, rng() % (PABB_MAX_MESSAGE_SIZE + 1));
+            stream[start + 1 + rng() % (stream.size() - start - 1)] ^= (char)(1 << (rng() % 8));
+            break;
+        }
+        case 3:{
+            //  Cut off in the middle.
+            append_frame(stream, rng, rng() % (PABB_MAX_MESSAGE_SIZE + 1));
+            stream.resize(stream.size() - rng() % (PABB_PROTOCOL_OVERHEAD - 1) - 1);
+            break;
+        }
+        default:
+            append_frame(stream, rng, rng() % (PABB_MAX_MESSAGE_SIZE + 1));
+        }
+    }
+    return stream;
+}
+
+//  Feed a stream in random size chunks.
+template <typename Rng, typename Parser>
+void feed_stream(Parser& parser, Rng& rng, const std::string& stream, size_t max_chunk){
+    size_t index = 0;
+    while (index < stream.size()){
+        size_t block = std::min<size_t>(rng() % max_chunk + 1, stream.size() - index);
+        parser.recv(stream.data() + index, block);
+        index += block;
+    }
+}
+
+}
+
+
+int test_Common_PABotBaseConnection(){
+    std::mt19937_64 rng(2023);
+
+    //  Fuzz against the old receive path.
+    for (size_t iteration = 0; iteration < 200; iteration++){
+        std::string stream = random_stream(rng, 500);
+
+        std::vector<RecvEvent> expected;
+        ReferenceParser reference(expected);
+        reference.recv(stream.data(), stream.size());
+
+        //  Small chunks exercise the wrap-around. Large ones overflow the
+        //  ring buffer in a single call.
+        size_t max_chunk = iteration % 2 == 0 ? 32 : 2000;
+        std::vector<RecvEvent> events;
+        {
+            RecordingConnection connection(events);
+            RecordingSniffer sniffer(events);
+            connection.set_sniffer(&sniffer);
+            feed_stream(connection, rng, stream, max_chunk);
+        }
+
+        if (events.size() != expected.size()){
+            cerr << "Iteration " << iteration << ": " << events.size()
+                 << " events, expected " << expected.size() << endl;
+            return 1;
+        }
+        for (size_t c = 0; c < events.size(); c++){
+            if (!(events[c] == expected[c])){
+                cerr << "Iteration " << iteration << ": event " << c << " differs." << endl;
+                return 1;
+            }
+        }
+    }
+    cout << "Fuzzed 200 streams against the deque parser." << endl;
+
+
+    //  A long clean stream of messages of every size.
+    {
+        const size_t MESSAGES = 20000;
+        std::string stream;
+        for (size_t c = 0; c < MESSAGES; c++){
+            append_frame(stream, rng, c % (PABB_MAX_MESSAGE_SIZE + 1));
+        }
+        const size_t CHUNK = 64;
+
+        std::vector<RecvEvent> expected;
+        ReferenceParser reference(expected);
+        for (size_t index = 0; index < stream.size(); index += CHUNK){
+            reference.recv(stream.data() + index, std::min(CHUNK, stream.size() - index));
+        }
+
+        std::vector<RecvEvent> events;
+        RecordingConnection connection(events);
+        for (size_t index = 0; index < stream.size(); index += CHUNK){
+            connection.recv(stream.data() + index, std::min(CHUNK, stream.size() - index));
+        }
+
+        if (connection.messages != MESSAGES || !(events == expected)){
+            cerr << "Received " << connection.messages << " messages, expected " << MESSAGES << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+
+namespace{
+
+using CRC32Function = uint32_t (*)(uint32_t crc, const void* data, size_t length);
+
+struct CRC32Implementation{
+    const char* name;
+    CRC32Function function;
+    bool available;
+};
+
+std::vector<CRC32Implementation> crc32_implementations(){
+    std::vector<CRC32Implementation> ret{
+        {"basic",       pabb_crc32_basic,       true},
+        {"table",       pabb_crc32_table,       true},
+        {"slice8",      pabb_crc32_slice8,      true},
+#ifdef PA_AutoDispatch_x64_08_Nehalem
+        {"x64_SSE42",   pabb_crc32_x64_SSE42,   CPU_CAPABILITY_NATIVE.OK_08_Nehalem},
+#endif
+#if defined PA_AutoDispatch_arm64_20_M1 && defined __ARM_FEATURE_CRC32
+        {"arm64_CRC",   pabb_crc32_arm64_CRC,   CPU_CAPABILITY_NATIVE.OK_M1},
+#endif
+        {"dispatch",    pabb_crc32_dispatch,    true},
+    };
+    return ret;
+}
+
+}
+
+
+int test_Common_CRC32(){
+    std::mt19937_64 rng(2024);
+    std::vector<CRC32Implementation> implementations = crc32_implementations();
+
+    //  Random buffers at random alignments against the bit-by-bit version.
+    std::vector<char> buffer(4096 + 16);
+    for (size_t iteration = 0; iteration < 20000; iteration++){
+        size_t offset = rng() % 16;
+        size_t length = iteration < 1000 ? iteration % 64 : rng() % 4096;
+        for (size_t c = 0; c < length; c++){
+            buffer[offset + c] = (char)rng();
+        }
+        uint32_t seed = iteration % 2 == 0 ? 0xffffffff : (uint32_t)rng();
+
+        uint32_t expected = pabb_crc32_basic(seed, buffer.data() + offset, length);
+        for (const CRC32Implementation& item : implementations){
+            if (!item.available){
+                continue;
+            }
+            uint32_t crc = item.function(seed, buffer.data() + offset, length);
+            if (crc != expected){
+                cerr << item.name << ": length = " << length << ", offset = " << offset
+                     << ", crc = " << crc << ", expected " << expected << endl;
+                return 1;
+            }
+        }
+    }
+
+    //  Check value of CRC32C.
+    {
+        const char* str = "123456789";
+        uint32_t crc = ~pabb_crc32(0xffffffff, str, 9);
+        if (crc != 0xe3069283){
+            cerr << "CRC32C of \"123456789\" = " << crc << ", expected " << 0xe3069283 << endl;
+            return 1;
+        }
+    }
+    cout << "CRC32 implementations match on random buffers." << endl;
+
+    return 0;
+}
+
+
+
+namespace{
+
+class NullLogger : public Logger{
+public:
+    virtual void log(const std::string& msg, Color color = Color()) override{}
+};
+
+class TestCommand : public BotBaseRequest{
+public:
+    pabb_end_program_callback params;
+    TestCommand()
+        : BotBaseRequest(true)
+    {}
+    virtual BotBaseMessage message() const override{
+        return BotBaseMessage(PABB_MSG_COMMAND_END_PROGRAM_CALLBACK, params);
+    }
+};
+
+struct PABotBaseRun{
+    bool ok = true;
+    size_t dropped = 0;
+};
+
+//  Issue "commands" async commands and wait for them. Then have "threads"
+//  threads each wait on "requests" requests one after another.
+PABotBaseRun run_pabotbase(
+    const LoopbackDeviceConfig& config, bool adaptive,
+    size_t commands, size_t threads, size_t requests
+){
+    NullLogger logger;
+    PABotBaseRun ret;
+
+    std::unique_ptr<LoopbackDevice> connection(new LoopbackDevice(logger, config));
+    LoopbackDevice& device = *connection;
+    PABotBase botbase(logger, std::move(connection));
+    botbase.set_adaptive_retransmits(adaptive);
+    botbase.connect();
+    botbase.set_queue_limit(Microcontroller::device_queue_size(botbase));
+
+    for (size_t c = 0; c < commands; c++){
+        static_cast<BotBase&>(botbase).issue_request(TestCommand());
+    }
+    botbase.wait_for_all_requests();
+
+    //  Every command runs exactly once and in order.
+    std::vector<seqnum_t> finished = device.finished_commands();
+    if (finished.size() != commands){
+        cerr << "Commands finished: " << finished.size() << ", expected " << commands << endl;
+        ret.ok = false;
+    }
+    for (size_t c = 1; c < finished.size(); c++){
+        if (finished[c] <= finished[c - 1]){
+            cerr << "Commands finished out of order: " << finished[c - 1] << " then " << finished[c] << endl;
+            ret.ok = false;
+            break;
+        }
+    }
+
+    std::mutex lock;
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++){
+        workers.emplace_back([&]{
+            for (size_t c = 0; c < requests; c++){
+                uint32_t version = Microcontroller::program_version(botbase);
+                if (version != PABB_PROGRAM_VERSION){
+                    std::lock_guard<std::mutex> lg(lock);
+                    ret.ok = false;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : workers){
+        thread.join();
+    }
+
+    ret.dropped = device.dropped_messages();
+    botbase.stop();
+    return ret;
+}
+
+}
+
+
+int test_Common_PABotBase(){
+    //  Against a link with 1ms latency each way and a device with a 16 deep
+    //  command queue.
+    LoopbackDeviceConfig config;
+    config.latency = std::chrono::milliseconds(1);
+    config.queue_size = 16;
+
+    for (double loss : {0., 0.01, 0.05}){
+        config.loss = loss;
+        for (bool adaptive : {false, true}){
+            config.seed++;
+            PABotBaseRun run = run_pabotbase(config, adaptive, 200, 4, 100);
+            if (!run.ok){
+                cerr << "Failed: loss = " << loss << ", adaptive = " << adaptive << endl;
+                return 1;
+            }
+            cout << "Loss = " << loss * 100 << "%, "
+                 << (adaptive ? "adaptive timeout:" : "fixed timeout:   ")
+                 << " dropped = " << run.dropped << endl;
+        }
+    }
+
+    return 0;
+}
+
+}
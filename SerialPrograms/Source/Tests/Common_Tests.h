@@ -0,0 +1,28 @@
+/*  Common Tests
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *  
+ *  
+ */
+
+
+#ifndef PokemonAutomation_Tests_Common_Tests_H
+#define PokemonAutomation_Tests_Common_Tests_H
+
+namespace PokemonAutomation{
+
+
+int test_Common_WorkStealingPool();
+
+int test_Common_TimerWheel();
+
+int test_Common_PABotBaseConnection();
+
+int test_Common_CRC32();
+
+int test_Common_PABotBase();
+
+
+}
+
+#endif
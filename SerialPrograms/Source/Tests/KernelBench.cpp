@@ -0,0 +1,1183 @@
+/*  Kernel Benchmarks
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *  Standalone throughput benchmarks for the kernels in Kernels/. This is the
+ *  "KernelBench" target. It only links Kernels/ and the parts of Common/Cpp
+ *  they need, so it builds and runs without Qt or any resources.
+ *
+ *  Every kernel benchmark is run once for each instruction set in
+ *  AVAILABLE_CAPABILITIES() that this machine supports. The instruction set is
+ *  forced by overwriting CPU_CAPABILITY_CURRENT, just like the CPU option in
+ *  the settings. The inputs are synthetic and the same for every run.
+ *
+ *  The thread pools and the timer wheel in Common/Cpp/Concurrency are also
+ *  benchmarked here. They don't depend on the instruction set, so they are run
+ *  only once. (and not at all with --isa)
+ *
+ *  Usage:
+ *      KernelBench [--filter TEXT] [--isa SLUG] [--cpu N] [--min-time MS] [--json PATH]
+ *
+ *      --filter    Only run benchmarks with TEXT in their name.
+ *      --isa       Only run this instruction set. (eg. "haswell-avx2")
+ *      --cpu       Pin the benchmark thread to this CPU. (default 0)
+ *      --min-time  Spend at least this many milliseconds timing each benchmark. (default 200)
+ *      --json      Also write the results as JSON to PATH. Use "-" for stdout.
+ *                  (The table then goes to stderr.)
+ *
+ *  For each benchmark, this reports the median and 95th percentile time of one
+ *  call, the median time per pixel (or sample) and the median throughput in
+ *  GB/s. The JSON is meant to be diffed between commits to find regressions.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "Common/Compiler.h"
+#include "Common/CRC32.h"
+#include "Common/Cpp/Exceptions.h"
+#include "Common/Cpp/CpuId/CpuId.h"
+#include "Common/Cpp/Containers/AlignedVector.tpp"
+#include "Common/Cpp/Concurrency/AsyncDispatcher.h"
+#include "Common/Cpp/Concurrency/WorkStealingPool.h"
+#include "Common/Cpp/Concurrency/TimerWheel.h"
+#include "Kernels/BinaryMatrix/Kernels_BinaryMatrix.h"
+#include "Kernels/BinaryImageFilters/Kernels_BinaryImage_BasicFilters.h"
+#include "Kernels/Waterfill/Kernels_Waterfill.h"
+#include "Kernels/ImageStats/Kernels_ImagePixelSumSqr.h"
+#include "Kernels/ImageStats/Kernels_ImagePixelSumSqrDev.h"
+#include "Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightness.h"
+#include "Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightnessRMSD.h"
+#include "Kernels/AbsFFT/Kernels_AbsFFT.h"
+#include "Kernels/SpikeConvolution/Kernels_SpikeConvolution.h"
+#include "Kernels/ScaleInvariantMatrixMatch/Kernels_ScaleInvariantMatrixMatch.h"
+#include "Kernels/Xoroshiro128Plus/Kernels_Xoroshiro128PlusLanes.h"
+
+#if _WIN32
+#include <Windows.h>
+#elif defined(__linux)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace PokemonAutomation{
+namespace{
+
+using namespace Kernels;
+
+
+
+//  Results are stored here so the compiler can't drop the calls.
+volatile uint64_t SINK;
+
+
+
+//  Pin the calling thread to one CPU so it isn't migrated mid-measurement.
+bool pin_thread(size_t cpu){
+#if _WIN32
+    if (cpu >= sizeof(DWORD_PTR) * 8){
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux)
+    if (cpu >= CPU_SETSIZE){
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    //  macOS has no way to pin a thread.
+    (void)cpu;
+    return false;
+#endif
+}
+
+
+
+struct Image{
+    size_t width;
+    size_t height;
+    AlignedVector<uint32_t> pixels;
+
+    Image(size_t p_width, size_t p_height)
+        : width(p_width)
+        , height(p_height)
+        , pixels(p_width * p_height)
+    {}
+
+    uint32_t* data(){ return pixels.data(); }
+    const uint32_t* data() const{ return pixels.data(); }
+    size_t bytes_per_row() const{ return width * sizeof(uint32_t); }
+    size_t bytes() const{ return width * height * sizeof(uint32_t); }
+};
+
+//  A screenshot-like image. It is made of 16 x 16 cells of random color with
+//  some noise on top. About 1/4 of the cells are dark. So a range filter for
+//  dark pixels gives waterfill plenty of objects of different sizes.
+//
+//  If "sprite" is true, the pixels outside of an ellipse are transparent.
+Image make_image(size_t width, size_t height, uint32_t seed, bool sprite){
+    std::mt19937 rng(seed);
+    const size_t cells_x = (width + 15) / 16;
+    const size_t cells_y = (height + 15) / 16;
+    std::vector<uint32_t> cells(cells_x * cells_y);
+    for (uint32_t& cell : cells){
+        uint32_t color = rng() & 0x00ffffff;
+        if (rng() % 4 == 0){
+            color &= 0x003f3f3f;
+        }
+        cell = color;
+    }
+
+    Image image(width, height);
+    const double cx = width / 2.;
+    const double cy = height / 2.;
+    for (size_t r = 0; r < height; r++){
+        for (size_t c = 0; c < width; c++){
+            uint32_t color = cells[(r / 16) * cells_x + c / 16];
+            uint32_t noise = rng() & 0x00070707;
+            color = (color & 0x00f8f8f8) | noise;
+
+            bool opaque = true;
+            if (sprite){
+                double dx = (c - cx) / cx;
+                double dy = (r - cy) / cy;
+                opaque = dx*dx + dy*dy <= 1;
+            }
+            image.data()[r * width + c] = color | (opaque ? 0xff000000 : 0);
+        }
+    }
+    return image;
+}
+
+std::string size_string(size_t width, size_t height){
+    return std::to_string(width) + "x" + std::to_string(height);
+}
+
+
+
+struct Benchmark{
+    std::string name;
+    std::string size;
+    size_t elements;    //  Pixels or samples per call.
+    size_t bytes;       //  Bytes read and written per call.
+
+    //  Called before every timed call. Use this to restore inputs that the
+    //  kernel destroys. Not timed. Can be null.
+    std::function<void()> setup;
+
+    //  The timed call.
+    std::function<void()> run;
+};
+
+struct BenchmarkResult{
+    std::string isa;
+    std::string name;
+    std::string size;
+    size_t elements;
+    size_t bytes;
+    size_t samples;
+    double median_ns;
+    double p95_ns;
+};
+
+BenchmarkResult measure(const std::string& isa, const Benchmark& bench, std::chrono::milliseconds min_time){
+    using clock = std::chrono::steady_clock;
+    const size_t MIN_SAMPLES = 10;
+    const size_t MAX_SAMPLES = 100000;
+
+    auto call = [&]{
+        if (bench.setup){
+            bench.setup();
+        }
+        auto start = clock::now();
+        bench.run();
+        auto end = clock::now();
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    };
+
+    //  Warm up the caches and branch predictors.
+    for (size_t c = 0; c < 3; c++){
+        call();
+    }
+
+    //  Very fast kernels are timed in batches of calls to get above the
+    //  resolution of the clock. This isn't possible if there's a setup.
+    size_t batch = 1;
+    if (!bench.setup){
+        double ns = call();
+        batch = (size_t)std::max<double>(1, 10000 / std::max<double>(ns, 1));
+    }
+
+    std::vector<double> samples;
+    auto start = clock::now();
+    while (samples.size() < MAX_SAMPLES){
+        if (samples.size() >= MIN_SAMPLES && clock::now() - start >= min_time){
+            break;
+        }
+        if (batch == 1){
+            samples.emplace_back(call());
+            continue;
+        }
+        auto batch_start = clock::now();
+        for (size_t c = 0; c < batch; c++){
+            bench.run();
+        }
+        auto batch_end = clock::now();
+        samples.emplace_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(batch_end - batch_start).count() / batch);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return BenchmarkResult{
+        isa, bench.name, bench.size,
+        bench.elements, bench.bytes, samples.size(),
+        samples[samples.size() / 2],
+        samples[std::min(samples.size() - 1, samples.size() * 95 / 100)],
+    };
+}
+
+
+
+//  The inputs for one image size. Shared by every instruction set.
+struct ImageInputs{
+    Image image;
+    Image sprite;       //  Has transparent pixels.
+    Image scratch;      //  For kernels that write to the image.
+    std::vector<uint32_t> sample_cols;
+    std::vector<uint32_t> sample_rows;
+    SampledImage sampled;
+
+    ImageInputs(const Image& source, size_t width, size_t height)
+        : image(make_image(width, height, 1, false))
+        , sprite(make_image(width, height, 2, true))
+        , scratch(make_image(width, height, 3, false))
+    {
+        //  Read from "source" as if resampled to this size.
+        if (source.width == width && source.height == height){
+            sampled.image = source.data();
+            sampled.bytes_per_row = source.bytes_per_row();
+            return;
+        }
+        for (size_t c = 0; c < width; c++){
+            sample_cols.emplace_back((uint32_t)(c * source.width / width));
+        }
+        for (size_t r = 0; r < height; r++){
+            sample_rows.emplace_back((uint32_t)(r * source.height / height));
+        }
+        sampled.image = source.data();
+        sampled.bytes_per_row = source.bytes_per_row();
+        sampled.cols = sample_cols.data();
+        sampled.rows = sample_rows.data();
+    }
+};
+
+//  Float matrices for ScaleInvariantMatrixMatch. Rows are separately aligned
+//  like the spectrograms they usually are.
+struct FloatMatrix{
+    size_t width;
+    size_t height;
+    std::vector<AlignedVector<float>> rows;
+    std::vector<const float*> pointers;
+
+    FloatMatrix(size_t p_width, size_t p_height, uint32_t seed)
+        : width(p_width)
+        , height(p_height)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> dist(0, 1);
+        for (size_t r = 0; r < height; r++){
+            rows.emplace_back(width);
+            for (size_t c = 0; c < width; c++){
+                rows.back()[c] = dist(rng);
+            }
+            pointers.emplace_back(rows.back().data());
+        }
+    }
+};
+
+struct MatrixInputs{
+    FloatMatrix A;
+    FloatMatrix T;
+    FloatMatrix W;
+    FloatMatrix TW;
+    std::vector<float> dots;
+
+    MatrixInputs(size_t width, size_t height)
+        : A(width, height, 1)
+        , T(width, height, 2)
+        , W(width, height, 3)
+        , TW(width, height, 4)
+        , dots(height)
+    {}
+};
+
+struct Inputs{
+    Image source;
+    std::vector<std::unique_ptr<ImageInputs>> images;
+    std::vector<std::unique_ptr<MatrixInputs>> matrices;
+
+    Inputs()
+        : source(make_image(1920, 1080, 0, false))
+    {
+        images.emplace_back(new ImageInputs(source, 1920, 1080));
+        images.emplace_back(new ImageInputs(source, 256, 256));
+
+        //  One audio template (frequencies x windows), then a square one.
+        matrices.emplace_back(new MatrixInputs(1024, 32));
+        matrices.emplace_back(new MatrixInputs(256, 256));
+    }
+};
+
+
+
+//  Binary matrices depend on the instruction set. So these are rebuilt for
+//  each one.
+struct BinaryInputs{
+    std::unique_ptr<PackedBinaryMatrix_IB> matrix;
+    std::unique_ptr<PackedBinaryMatrix_IB> filters[4];
+    std::unique_ptr<PackedBinaryMatrix_IB> waterfill_source;
+    std::unique_ptr<PackedBinaryMatrix_IB> waterfill;
+};
+
+
+void add_binary_image_benchmarks(
+    std::vector<Benchmark>& benchmarks,
+    std::vector<std::unique_ptr<BinaryInputs>>& binary_inputs,
+    ImageInputs& in
+){
+    const size_t width = in.image.width;
+    const size_t height = in.image.height;
+    const size_t pixels = width * height;
+    const size_t matrix_bytes = pixels / 8;
+    const std::string size = size_string(width, height);
+
+    binary_inputs.emplace_back(new BinaryInputs());
+    BinaryInputs& binary = *binary_inputs.back();
+    BinaryMatrixType type = get_BinaryMatrixType();
+    binary.matrix = make_PackedBinaryMatrix(type, width, height);
+    for (auto& filter : binary.filters){
+        filter = make_PackedBinaryMatrix(type, width, height);
+    }
+
+    benchmarks.emplace_back(Benchmark{
+        "BinaryImageFilters/compress_rgb32_to_binary_range", size,
+        pixels, in.image.bytes() + matrix_bytes,
+        nullptr,
+        [&in, &binary]{
+            compress_rgb32_to_binary_range(
+                in.image.data(), in.image.bytes_per_row(),
+                *binary.matrix, 0xff000000, 0xff3f3f3f
+            );
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "BinaryImageFilters/compress_rgb32_to_binary_range(4 filters)", size,
+        pixels, in.image.bytes() + 4 * matrix_bytes,
+        nullptr,
+        [&in, &binary]{
+            CompressRgb32ToBinaryRangeFilter filters[] = {
+                {*binary.filters[0], 0xff000000, 0xff3f3f3f},
+                {*binary.filters[1], 0xff400000, 0xffffffff},
+                {*binary.filters[2], 0xff004000, 0xffffffff},
+                {*binary.filters[3], 0xff808080, 0xffffffff},
+            };
+            compress_rgb32_to_binary_range(
+                in.image.data(), in.image.bytes_per_row(),
+                filters, 4
+            );
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "BinaryImageFilters/compress_rgb32_to_binary_euclidean", size,
+        pixels, in.image.bytes() + matrix_bytes,
+        nullptr,
+        [&in, &binary]{
+            compress_rgb32_to_binary_euclidean(
+                in.image.data(), in.image.bytes_per_row(),
+                *binary.matrix, 0xff202020, 64
+            );
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "BinaryImageFilters/filter_by_mask", size,
+        pixels, 2 * in.scratch.bytes() + matrix_bytes,
+        nullptr,
+        [&in, &binary]{
+            filter_by_mask(
+                *binary.matrix,
+                in.scratch.data(), in.scratch.bytes_per_row(),
+                0xff00ff00, true
+            );
+        }
+    });
+
+    //  Waterfill destroys its input. So it is restored before every call.
+    binary.waterfill_source = make_PackedBinaryMatrix(type, width, height);
+    compress_rgb32_to_binary_range(
+        in.image.data(), in.image.bytes_per_row(),
+        *binary.waterfill_source, 0xff000000, 0xff3f3f3f
+    );
+    binary.waterfill = binary.waterfill_source->clone();
+    benchmarks.emplace_back(Benchmark{
+        "Waterfill/find_objects_inplace", size,
+        pixels, matrix_bytes,
+        [&binary]{
+            binary.waterfill->set_zero();
+            *binary.waterfill |= *binary.waterfill_source;
+        },
+        [&binary]{
+            SINK = Waterfill::find_objects_inplace(*binary.waterfill, 10).size();
+        }
+    });
+}
+
+void add_image_stats_benchmarks(std::vector<Benchmark>& benchmarks, ImageInputs& in){
+    const size_t width = in.image.width;
+    const size_t height = in.image.height;
+    const size_t pixels = width * height;
+    const std::string size = size_string(width, height);
+
+    benchmarks.emplace_back(Benchmark{
+        "ImageStats/pixel_sum_sqr", size,
+        pixels, in.image.bytes(),
+        nullptr,
+        [&in, width, height]{
+            PixelSums sums;
+            pixel_sum_sqr(
+                sums, width, height,
+                in.image.data(), in.image.bytes_per_row(),
+                in.image.data(), in.image.bytes_per_row()
+            );
+            SINK = sums.sqrR;
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ImageStats/pixel_sum_sqr(alpha)", size,
+        pixels, in.image.bytes() + in.sprite.bytes(),
+        nullptr,
+        [&in, width, height]{
+            PixelSums sums;
+            pixel_sum_sqr(
+                sums, width, height,
+                in.image.data(), in.image.bytes_per_row(),
+                in.sprite.data(), in.sprite.bytes_per_row()
+            );
+            SINK = sums.sqrR;
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ImageStats/sum_sqr_deviation", size,
+        pixels, in.sprite.bytes() + in.image.bytes(),
+        nullptr,
+        [&in, width, height]{
+            uint64_t count, sumsqrs;
+            sum_sqr_deviation(
+                count, sumsqrs, width, height,
+                in.sprite.data(), in.sprite.bytes_per_row(),
+                in.image.data(), in.image.bytes_per_row()
+            );
+            SINK = sumsqrs;
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ImageStats/sum_sqr_deviation(background)", size,
+        pixels, in.sprite.bytes() + in.image.bytes(),
+        nullptr,
+        [&in, width, height]{
+            uint64_t count, sumsqrs;
+            sum_sqr_deviation(
+                count, sumsqrs, width, height,
+                in.sprite.data(), in.sprite.bytes_per_row(),
+                in.image.data(), in.image.bytes_per_row(),
+                0xffffffff
+            );
+            SINK = sumsqrs;
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ImageStats/sum_sqr_deviation_masked", size,
+        pixels, in.sprite.bytes() + in.image.bytes(),
+        nullptr,
+        [&in, width, height]{
+            uint64_t count, sumsqrs;
+            sum_sqr_deviation_masked(
+                count, sumsqrs, width, height,
+                in.sprite.data(), in.sprite.bytes_per_row(),
+                in.image.data(), in.image.bytes_per_row()
+            );
+            SINK = sumsqrs;
+        }
+    });
+}
+
+void add_scale_brightness_benchmarks(std::vector<Benchmark>& benchmarks, ImageInputs& in){
+    const size_t width = in.image.width;
+    const size_t height = in.image.height;
+    const size_t pixels = width * height;
+    const std::string size = size_string(width, height);
+
+    //  Scale by 1 so the image doesn't saturate over many calls.
+    benchmarks.emplace_back(Benchmark{
+        "ImageScaleBrightness/scale_brightness", size,
+        pixels, 2 * in.scratch.bytes(),
+        nullptr,
+        [&in, width, height]{
+            scale_brightness(
+                width, height,
+                in.scratch.data(), in.scratch.bytes_per_row(),
+                1.0f, 1.0f, 1.0f
+            );
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ImageScaleBrightness/pixel_sum_sampled", size,
+        pixels, 2 * in.sprite.bytes(),
+        nullptr,
+        [&in, width, height]{
+            PixelSums sums;
+            pixel_sum_sampled(
+                sums, width, height, in.sampled,
+                in.sprite.data(), in.sprite.bytes_per_row()
+            );
+            SINK = sums.sumR;
+        }
+    });
+
+    const std::pair<SumSquareMode, const char*> MODES[] = {
+        {SumSquareMode::REFERENCE_ALPHA,    "ImageScaleBrightness/sum_sqr_deviation_scaled_brightness(reference alpha)"},
+        {SumSquareMode::USE_BACKGROUND,     "ImageScaleBrightness/sum_sqr_deviation_scaled_brightness(background)"},
+        {SumSquareMode::ARBITRATE_ALPHAS,   "ImageScaleBrightness/sum_sqr_deviation_scaled_brightness(arbitrate alphas)"},
+    };
+    for (const auto& mode : MODES){
+        SumSquareMode sum_mode = mode.first;
+        benchmarks.emplace_back(Benchmark{
+            mode.second, size,
+            pixels, 2 * in.sprite.bytes(),
+            nullptr,
+            [&in, width, height, sum_mode]{
+                uint64_t count, sumsqrs;
+                sum_sqr_deviation_scaled_brightness(
+                    count, sumsqrs, width, height,
+                    in.sprite.data(), in.sprite.bytes_per_row(),
+                    1.1f, 0.9f, 1.0f,
+                    in.sampled,
+                    sum_mode, 0xffffffff
+                );
+                SINK = sumsqrs;
+            }
+        });
+    }
+}
+
+void add_matrix_match_benchmarks(std::vector<Benchmark>& benchmarks, MatrixInputs& in){
+    const size_t width = in.A.width;
+    const size_t height = in.A.height;
+    const size_t elements = width * height;
+    const size_t bytes = elements * sizeof(float);
+    const std::string size = size_string(width, height);
+
+    benchmarks.emplace_back(Benchmark{
+        "ScaleInvariantMatrixMatch/compute_scale", size,
+        elements, 2 * bytes,
+        nullptr,
+        [&in, width, height]{
+            float scale = ScaleInvariantMatrixMatch::compute_scale(
+                width, height, in.A.pointers.data(), in.T.pointers.data()
+            );
+            SINK = (uint64_t)scale;
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ScaleInvariantMatrixMatch/compute_scale(weighted)", size,
+        elements, 3 * bytes,
+        nullptr,
+        [&in, width, height]{
+            float scale = ScaleInvariantMatrixMatch::compute_scale(
+                width, height, in.A.pointers.data(), in.TW.pointers.data(), in.W.pointers.data()
+            );
+            SINK = (uint64_t)scale;
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ScaleInvariantMatrixMatch/compute_error", size,
+        elements, 2 * bytes,
+        nullptr,
+        [&in, width, height]{
+            float error = ScaleInvariantMatrixMatch::compute_error(
+                width, height, 0.5f, in.A.pointers.data(), in.T.pointers.data()
+            );
+            SINK = (uint64_t)error;
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ScaleInvariantMatrixMatch/compute_error(weighted)", size,
+        elements, 3 * bytes,
+        nullptr,
+        [&in, width, height]{
+            float error = ScaleInvariantMatrixMatch::compute_error(
+                width, height, 0.5f, in.A.pointers.data(), in.TW.pointers.data(), in.W.pointers.data()
+            );
+            SINK = (uint64_t)error;
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "ScaleInvariantMatrixMatch/compute_dot_products", size,
+        elements, bytes + width * sizeof(float) + height * sizeof(float),
+        nullptr,
+        [&in, width, height]{
+            float norm = ScaleInvariantMatrixMatch::compute_dot_products(
+                width, height, in.A.pointers[0], in.T.pointers.data(), in.dots.data()
+            );
+            SINK = (uint64_t)norm;
+        }
+    });
+}
+
+
+//  1D kernels. The sizes are those of the audio pipeline.
+struct AudioInputs{
+    struct FFT{
+        int k;
+        AlignedVector<float> input;
+        AlignedVector<float> real;
+        AlignedVector<float> abs;
+        FFT(int p_k)
+            : k(p_k)
+            , input((size_t)1 << p_k)
+            , real((size_t)1 << p_k)
+            , abs((size_t)1 << (p_k - 1))
+        {
+            std::mt19937 rng(p_k);
+            std::uniform_real_distribution<float> dist(-1, 1);
+            for (float& x : input){
+                x = dist(rng);
+            }
+        }
+    };
+    struct Spike{
+        size_t lengthI;
+        size_t lengthK;
+        AlignedVector<float> in;
+        AlignedVector<float> kernel;
+        AlignedVector<float> out;
+        Spike(size_t p_lengthI, size_t p_lengthK)
+            : lengthI(p_lengthI)
+            , lengthK(p_lengthK)
+            , in(p_lengthI)
+            , kernel(p_lengthK)
+            , out(p_lengthI + PA_ALIGNMENT / sizeof(float))
+        {
+            std::mt19937 rng((uint32_t)p_lengthK);
+            std::uniform_real_distribution<float> dist(0, 1);
+            for (float& x : in){
+                x = dist(rng);
+            }
+            for (float& x : kernel){
+                x = dist(rng);
+            }
+        }
+    };
+
+    std::vector<std::unique_ptr<FFT>> ffts;
+    std::vector<std::unique_ptr<Spike>> spikes;
+
+    AudioInputs(){
+        for (int k : {10, 12, 14}){
+            ffts.emplace_back(new FFT(k));
+        }
+        for (size_t lengthK : {20, 200}){
+            spikes.emplace_back(new Spike(2048, lengthK));
+        }
+    }
+};
+
+void add_audio_benchmarks(std::vector<Benchmark>& benchmarks, AudioInputs& in){
+    for (auto& item : in.ffts){
+        AudioInputs::FFT& fft = *item;
+        const size_t length = (size_t)1 << fft.k;
+        benchmarks.emplace_back(Benchmark{
+            "AbsFFT/fft_abs", "2^" + std::to_string(fft.k),
+            length, (length + length / 2) * sizeof(float),
+            [&fft]{
+                //  The transform is destructive on its input.
+                memcpy(fft.real.data(), fft.input.data(), fft.input.size() * sizeof(float));
+            },
+            [&fft]{
+                AbsFFT::fft_abs(fft.k, fft.abs.data(), fft.real.data());
+            }
+        });
+    }
+    for (auto& item : in.spikes){
+        AudioInputs::Spike& spike = *item;
+        const size_t outputs = spike.lengthI - spike.lengthK + 1;
+        benchmarks.emplace_back(Benchmark{
+            "SpikeConvolution/compute_spike_kernel", size_string(spike.lengthI, spike.lengthK),
+            outputs, (spike.lengthI + spike.lengthK + outputs) * sizeof(float),
+            nullptr,
+            [&spike]{
+                SpikeConvolution::compute_spike_kernel(
+                    spike.out.data(), spike.in.data(), spike.lengthI,
+                    spike.kernel.data(), spike.lengthK
+                );
+            }
+        });
+    }
+}
+
+
+
+//  CRC32C of serial messages and of files. (Common/CRC32.h)
+struct CRC32Inputs{
+    std::vector<std::string> buffers;
+
+    CRC32Inputs(){
+        std::mt19937 rng(0);
+        for (size_t length : {64, 4096, 1 << 20}){
+            std::string data(length, 0);
+            for (char& ch : data){
+                ch = (char)rng();
+            }
+            buffers.emplace_back(std::move(data));
+        }
+    }
+};
+
+void add_crc32_benchmarks(std::vector<Benchmark>& benchmarks, CRC32Inputs& in){
+    using CRC32Function = uint32_t (*)(uint32_t crc, const void* data, size_t length);
+    const std::pair<const char*, CRC32Function> IMPLEMENTATIONS[] = {
+        {"CRC32/pabb_crc32_table",      pabb_crc32_table},
+        {"CRC32/pabb_crc32_slice8",     pabb_crc32_slice8},
+        {"CRC32/pabb_crc32_dispatch",   pabb_crc32_dispatch},
+    };
+    for (const std::string& data : in.buffers){
+        for (const auto& item : IMPLEMENTATIONS){
+            CRC32Function function = item.second;
+            benchmarks.emplace_back(Benchmark{
+                item.first, std::to_string(data.size()),
+                data.size(), data.size(),
+                nullptr,
+                [&data, function]{
+                    SINK = function(0xffffffff, data.data(), data.size());
+                }
+            });
+        }
+    }
+}
+
+
+//  Xoroshiro128+ lanes as the RNG programs use them. The states just keep
+//  advancing from one call to the next.
+struct RngInputs{
+    static constexpr size_t LANES = 8;
+    static constexpr size_t ADVANCES = 256;
+
+    uint64_t s0[LANES];
+    uint64_t s1[LANES];
+    uint64_t bounds[LANES];
+    std::vector<uint64_t> results;
+
+    RngInputs()
+        : results(ADVANCES * LANES)
+    {
+        std::mt19937_64 rng(0);
+        for (size_t c = 0; c < LANES; c++){
+            s0[c] = rng();
+            s1[c] = rng();
+            //  The bounds of the Cram-o-matic rolls.
+            const uint64_t BOUNDS[] = {91, 60, 4, 100};
+            bounds[c] = BOUNDS[c % 4];
+        }
+    }
+};
+
+void add_rng_benchmarks(std::vector<Benchmark>& benchmarks, RngInputs& in){
+    const size_t LANES = RngInputs::LANES;
+    const size_t ADVANCES = RngInputs::ADVANCES;
+    const std::string size = size_string(LANES, ADVANCES);
+
+    benchmarks.emplace_back(Benchmark{
+        "Xoroshiro128PlusLanes/next_lanes", size,
+        LANES * ADVANCES, LANES * ADVANCES * sizeof(uint64_t),
+        nullptr,
+        [&in]{
+            xoroshiro128plus_next_lanes(in.s0, in.s1, LANES, in.results.data(), ADVANCES);
+            SINK = in.results[0];
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "Xoroshiro128PlusLanes/last_bits_lanes", size,
+        LANES * ADVANCES, LANES * ADVANCES / 64 * sizeof(uint64_t),
+        nullptr,
+        [&in]{
+            xoroshiro128plus_last_bits_lanes(in.s0, in.s1, LANES, in.results.data(), ADVANCES / 64);
+            SINK = in.results[0];
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "Xoroshiro128PlusLanes/next_int_lanes", size,
+        LANES * ADVANCES, LANES * sizeof(uint64_t),
+        nullptr,
+        [&in]{
+            xoroshiro128plus_next_int_lanes(in.s0, in.s1, LANES, in.results.data(), in.bounds, ADVANCES);
+            SINK = in.results[0];
+        }
+    });
+}
+
+
+//  Thread pools and timers. These don't depend on the instruction set.
+struct ConcurrencyInputs{
+    static constexpr size_t TASKS = 64;
+    static constexpr size_t INDICES = 1000;
+    static constexpr size_t TIMERS = 100000;
+    static constexpr size_t RESCHEDULES = 1000;
+
+    struct Timer : public TimerWheelNode{
+        std::multimap<WallClock, size_t>::iterator iter;
+    };
+
+    AsyncDispatcher dispatcher;
+    WorkStealingPool pool;
+    std::atomic<size_t> counter;
+
+    TimerWheel wheel;
+    std::multimap<WallClock, size_t> schedule;
+    std::vector<Timer> timers;
+    std::vector<size_t> order;
+    std::vector<WallClock> times;
+    size_t next_reschedule = 0;
+
+    ConcurrencyInputs()
+        : dispatcher(nullptr, 0)
+        , pool(nullptr, 0)
+        , counter(0)
+        , timers(TIMERS)
+    {
+        //  Mostly short timers with a long tail to use all the levels.
+        std::mt19937_64 rng(0);
+        const WallClock now = current_time();
+        auto random_expiration = [&]{
+            uint64_t r = rng();
+            uint64_t ms;
+            switch (r % 8){
+            case 0: ms = (r >> 8) % 64; break;
+            case 1: ms = (r >> 8) % 4096; break;
+            case 2: ms = (r >> 8) % 262144; break;
+            default: ms = (r >> 8) % 1000;
+            }
+            return now + std::chrono::milliseconds(ms);
+        };
+        for (size_t c = 0; c < TIMERS; c++){
+            WallClock expiration = random_expiration();
+            timers[c].iter = schedule.emplace(expiration, c);
+            wheel.add(timers[c], expiration);
+        }
+        for (size_t c = 0; c < 64 * RESCHEDULES; c++){
+            order.emplace_back(rng() % TIMERS);
+            times.emplace_back(random_expiration());
+        }
+    }
+};
+
+template <typename Pool>
+void add_pool_benchmarks(std::vector<Benchmark>& benchmarks, const std::string& name, Pool& pool, std::atomic<size_t>& counter){
+    const size_t TASKS = ConcurrencyInputs::TASKS;
+    const size_t INDICES = ConcurrencyInputs::INDICES;
+
+    //  Dispatch a batch of tiny tasks, then wait for all of them.
+    benchmarks.emplace_back(Benchmark{
+        name + "/dispatch", std::to_string(TASKS),
+        TASKS, 0,
+        nullptr,
+        [&pool, &counter]{
+            std::unique_ptr<AsyncTask> tasks[TASKS];
+            for (std::unique_ptr<AsyncTask>& task : tasks){
+                task = pool.dispatch([&counter]{
+                    counter.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            for (std::unique_ptr<AsyncTask>& task : tasks){
+                task->wait_and_rethrow_exceptions();
+            }
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        name + "/run_in_parallel", std::to_string(INDICES),
+        INDICES, 0,
+        nullptr,
+        [&pool, &counter]{
+            pool.run_in_parallel(0, INDICES, [&counter](size_t){
+                counter.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+    });
+}
+
+void add_concurrency_benchmarks(std::vector<Benchmark>& benchmarks, ConcurrencyInputs& in){
+    add_pool_benchmarks(benchmarks, "AsyncDispatcher", in.dispatcher, in.counter);
+    add_pool_benchmarks(benchmarks, "WorkStealingPool", in.pool, in.counter);
+
+    //  Move timers to new times, like PeriodicScheduler does every period.
+    //  "std::multimap" is what PeriodicScheduler used before the wheel.
+    const size_t RESCHEDULES = ConcurrencyInputs::RESCHEDULES;
+    const std::string size = std::to_string(ConcurrencyInputs::TIMERS);
+    benchmarks.emplace_back(Benchmark{
+        "TimerWheel/add(reschedule)", size,
+        RESCHEDULES, 0,
+        nullptr,
+        [&in]{
+            size_t s = in.next_reschedule;
+            in.next_reschedule = (s + RESCHEDULES) % in.order.size();
+            for (size_t c = s; c < s + RESCHEDULES; c++){
+                in.wheel.add(in.timers[in.order[c]], in.times[c]);
+            }
+        }
+    });
+    benchmarks.emplace_back(Benchmark{
+        "std::multimap/reschedule", size,
+        RESCHEDULES, 0,
+        nullptr,
+        [&in]{
+            size_t s = in.next_reschedule;
+            in.next_reschedule = (s + RESCHEDULES) % in.order.size();
+            for (size_t c = s; c < s + RESCHEDULES; c++){
+                ConcurrencyInputs::Timer& timer = in.timers[in.order[c]];
+                size_t index = timer.iter->second;
+                in.schedule.erase(timer.iter);
+                timer.iter = in.schedule.emplace(in.times[c], index);
+            }
+        }
+    });
+}
+
+
+
+struct Options{
+    std::string filter;
+    std::string isa;
+    size_t cpu = 0;
+    std::chrono::milliseconds min_time{200};
+    std::string json_path;
+};
+
+bool parse_options(int argc, char* argv[], Options& options){
+    for (int c = 1; c < argc; c++){
+        const std::string arg = argv[c];
+        if (c + 1 >= argc){
+            cerr << "Error: missing value for " << arg << endl;
+            return false;
+        }
+        const std::string value = argv[++c];
+        try{
+            if (arg == "--filter"){
+                options.filter = value;
+            }else if (arg == "--isa"){
+                options.isa = value;
+            }else if (arg == "--cpu"){
+                options.cpu = std::stoul(value);
+            }else if (arg == "--min-time"){
+                options.min_time = std::chrono::milliseconds(std::stoul(value));
+            }else if (arg == "--json"){
+                options.json_path = value;
+            }else{
+                cerr << "Error: unknown option " << arg << endl;
+                return false;
+            }
+        }catch (const std::exception&){
+            cerr << "Error: invalid value for " << arg << ": " << value << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+
+std::string json_string(const std::string& str){
+    std::string ret = "\"";
+    for (char ch : str){
+        if (ch == '"' || ch == '\\'){
+            ret += '\\';
+        }
+        ret += ch;
+    }
+    return ret + "\"";
+}
+void write_json(std::ostream& stream, const Options& options, const std::vector<BenchmarkResult>& results){
+    stream << std::setprecision(6);
+    stream << "{\n";
+    stream << "    \"arch\": " << json_string(PA_ARCH_STRING) << ",\n";
+    stream << "    \"min_time_ms\": " << options.min_time.count() << ",\n";
+    stream << "    \"results\": [";
+    for (size_t c = 0; c < results.size(); c++){
+        const BenchmarkResult& result = results[c];
+        stream << (c == 0 ? "\n" : ",\n");
+        stream << "        {"
+               << "\"isa\": " << json_string(result.isa)
+               << ", \"kernel\": " << json_string(result.name)
+               << ", \"size\": " << json_string(result.size)
+               << ", \"elements\": " << result.elements
+               << ", \"bytes\": " << result.bytes
+               << ", \"samples\": " << result.samples
+               << ", \"median_ns\": " << (uint64_t)(result.median_ns + 0.5)
+               << ", \"p95_ns\": " << (uint64_t)(result.p95_ns + 0.5)
+               << ", \"ns_per_element\": " << result.median_ns / result.elements
+               << ", \"gb_per_s\": " << result.bytes / result.median_ns
+               << "}";
+    }
+    stream << "\n    ]\n";
+    stream << "}\n";
+}
+
+
+
+int run_kernel_benchmarks(int argc, char* argv[]){
+    Options options;
+    if (!parse_options(argc, argv, options)){
+        return 1;
+    }
+
+    std::vector<const CpuCapabilityOption*> capabilities;
+    for (const CpuCapabilityOption& item : AVAILABLE_CAPABILITIES()){
+        if (!item.available){
+            continue;
+        }
+        if (!options.isa.empty() && options.isa != item.slug){
+            continue;
+        }
+        capabilities.emplace_back(&item);
+    }
+    if (capabilities.empty()){
+        cerr << "Error: instruction set " << options.isa << " is not available. Choose from:" << endl;
+        for (const CpuCapabilityOption& item : AVAILABLE_CAPABILITIES()){
+            if (item.available){
+                cerr << "    " << item.slug << endl;
+            }
+        }
+        return 1;
+    }
+
+    std::ostream& table = options.json_path == "-" ? cerr : cout;
+
+    std::vector<BenchmarkResult> results;
+    auto run_benchmarks = [&](const std::string& title, const std::string& isa, const std::vector<Benchmark>& benchmarks){
+        table << "==== " << title << " ====" << endl;
+        table << std::left
+              << std::setw(76) << "Kernel" << std::setw(12) << "Size"
+              << std::right
+              << std::setw(14) << "Median (ns)" << std::setw(14) << "P95 (ns)"
+              << std::setw(12) << "ns/elem" << std::setw(10) << "GB/s" << endl;
+        for (const Benchmark& bench : benchmarks){
+            if (bench.name.find(options.filter) == std::string::npos){
+                continue;
+            }
+            BenchmarkResult result = measure(isa, bench, options.min_time);
+            table << std::left
+                  << std::setw(76) << result.name << std::setw(12) << result.size
+                  << std::right << std::fixed
+                  << std::setprecision(0)
+                  << std::setw(14) << result.median_ns << std::setw(14) << result.p95_ns
+                  << std::setprecision(3)
+                  << std::setw(12) << result.median_ns / result.elements
+                  << std::setprecision(2)
+                  << std::setw(10) << result.bytes / result.median_ns
+                  << std::defaultfloat << endl;
+            results.emplace_back(std::move(result));
+        }
+        table << endl;
+    };
+
+    //  These go first. The worker threads of the pools would inherit the
+    //  pinning below.
+    if (options.isa.empty()){
+        ConcurrencyInputs concurrency;
+        std::vector<Benchmark> benchmarks;
+        add_concurrency_benchmarks(benchmarks, concurrency);
+        run_benchmarks("Any instruction set", "any", benchmarks);
+    }
+
+    if (!pin_thread(options.cpu)){
+        cerr << "Warning: unable to pin to CPU " << options.cpu << ". Results may be noisy." << endl;
+    }
+
+    Inputs inputs;
+    AudioInputs audio;
+    CRC32Inputs crc32;
+    RngInputs rng;
+
+    const CPU_Features saved = CPU_CAPABILITY_CURRENT;
+    for (const CpuCapabilityOption* capability : capabilities){
+        CPU_CAPABILITY_CURRENT = capability->features;
+
+        std::vector<std::unique_ptr<BinaryInputs>> binary_inputs;
+        std::vector<Benchmark> benchmarks;
+        for (auto& item : inputs.images){
+            add_binary_image_benchmarks(benchmarks, binary_inputs, *item);
+        }
+        for (auto& item : inputs.images){
+            add_image_stats_benchmarks(benchmarks, *item);
+        }
+        for (auto& item : inputs.images){
+            add_scale_brightness_benchmarks(benchmarks, *item);
+        }
+        add_audio_benchmarks(benchmarks, audio);
+        for (auto& item : inputs.matrices){
+            add_matrix_match_benchmarks(benchmarks, *item);
+        }
+        add_crc32_benchmarks(benchmarks, crc32);
+        add_rng_benchmarks(benchmarks, rng);
+
+        run_benchmarks(
+            std::string(capability->display) + " (" + capability->slug + ")",
+            capability->slug, benchmarks
+        );
+    }
+    CPU_CAPABILITY_CURRENT = saved;
+
+    if (options.json_path == "-"){
+        write_json(cout, options, results);
+    }else if (!options.json_path.empty()){
+        std::ofstream file(options.json_path, std::ios::binary | std::ios::trunc);
+        write_json(file, options, results);
+        if (!file.flush()){
+            cerr << "Error: unable to write " << options.json_path << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+
+}
+}
+
+
+
+int main(int argc, char* argv[]){
+    try{
+        return PokemonAutomation::run_kernel_benchmarks(argc, argv);
+    }catch (const PokemonAutomation::Exception& e){
+        cerr << e.name() << ": " << e.message() << endl;
+        return 1;
+    }
+}
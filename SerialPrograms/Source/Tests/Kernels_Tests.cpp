@@ -9,6 +9,7 @@
 #include "Common/Cpp/Color.h"
 #include "Common/Cpp/CpuId/CpuId.h"
 #include "Common/Cpp/Time.h"
+#include "Common/Cpp/Containers/AlignedVector.tpp"
 #include "CommonFramework/ImageTypes/BinaryImage.h"
 #include "CommonFramework/ImageTools/ImageBoxes.h"
 #include "CommonFramework/ImageTypes/ImageRGB32.h"
@@ -24,7 +25,10 @@
 #include "Kernels/BinaryMatrix/Kernels_BinaryMatrixTile_64xH_Default.h"
 #include "Kernels/BinaryImageFilters/Kernels_BinaryImage_BasicFilters.h"
 #include "Kernels/ImageFilters/Kernels_ImageFilter_Basic.h"
+#include "Kernels/ImageResample/Kernels_ImageResample.h"
 #include "Kernels/ImageScaleBrightness/Kernels_ImageScaleBrightness.h"
+#include "Kernels/ScaleInvariantMatrixMatch/Kernels_ScaleInvariantMatrixMatch.h"
+#include "Kernels/SpikeConvolution/Kernels_SpikeConvolution.h"
 #include "Kernels/Waterfill/Kernels_Waterfill.h"
 #include "Kernels/Waterfill/Kernels_Waterfill_Session.h"
 #include "Kernels/Waterfill/Kernels_Waterfill_Core_64xH_Default.h"
@@ -32,7 +36,9 @@
 #include "Kernels_Tests.h"
 #include "TestUtils.h"
 
+#include <cmath>
 #include <functional>
+#include <random>
 #include <iostream>
 using std::cout;
 using std::cerr;
@@ -73,6 +79,117 @@ int test_kernels_ImageScaleBrightness(const ImageViewRGB32& image){
 }
 
 
+namespace{
+
+//  Straightforward version of "resample()" with the same fixed-point rounding.
+ImageRGB32 resample_reference(const ImageViewRGB32& image, size_t width, size_t height, ResampleFilter filter){
+    ImageRGB32 ret(width, height);
+    std::shared_ptr<const ResampleAxis> x = resample_axis(filter, image.width(), width);
+    std::shared_ptr<const ResampleAxis> y = resample_axis(filter, image.height(), height);
+    for (size_t r = 0; r < height; r++){
+        for (size_t c = 0; c < width; c++){
+            if (filter == ResampleFilter::NEAREST){
+                ret.pixel(c, r) = image.pixel(x->start[c], y->start[r]);
+                continue;
+            }
+            uint32_t pixel = 0;
+            for (size_t ch = 0; ch < 32; ch += 8){
+                uint64_t sum = 0;
+                for (size_t tx = 0; tx < x->taps; tx++){
+                    uint64_t wx = x->weights[c * x->taps + tx];
+                    if (wx == 0){
+                        continue;
+                    }
+                    uint64_t column = 0;
+                    for (size_t ty = 0; ty < y->taps; ty++){
+                        uint64_t wy = y->weights[r * y->taps + ty];
+                        if (wy == 0){
+                            continue;
+                        }
+                        uint32_t p = image.pixel(x->start[c] + tx, y->start[r] + ty);
+                        column += ((p >> ch) & 0xff) * wy;
+                    }
+                    sum += ((column + 64) >> 7) * wx;
+                }
+                pixel |= (uint32_t)((sum + (1 << 20)) >> 21) << ch;
+            }
+            ret.pixel(c, r) = pixel;
+        }
+    }
+    return ret;
+}
+
+}
+
+int test_kernels_ImageResample(const ImageViewRGB32& image){
+    const size_t width = image.width(), height = image.height();
+    const std::vector<std::pair<size_t, size_t>> sizes{
+        {width / 2, height / 2},
+        {width / 3, height / 5},
+        {width * 3 / 2, height * 5 / 4},
+        {37, 23},
+        {width, height / 7},
+        {1, 1},
+    };
+    const std::vector<std::pair<ResampleFilter, const char*>> filters{
+        {ResampleFilter::NEAREST, "nearest"},
+        {ResampleFilter::AREA, "area"},
+        {ResampleFilter::BILINEAR, "bilinear"},
+    };
+
+    for (const auto& filter : filters){
+        for (const auto& size : sizes){
+            if (size.first == 0 || size.second == 0){
+                continue;
+            }
+            std::shared_ptr<const ResampleAxis> x = resample_axis(filter.first, width, size.first);
+            for (size_t c = 0; c < size.first; c++){
+                int sum = 0;
+                for (size_t t = 0; t < x->taps; t++){
+                    sum += x->weights[c * x->taps + t];
+                }
+                TEST_RESULT_EQUAL(sum, 1 << ResampleAxis::WEIGHT_BITS);
+            }
+
+            ImageRGB32 expected = resample_reference(image, size.first, size.second, filter.first);
+
+            auto time_start = current_time();
+            ImageRGB32 scaled = image.scale_to(size.first, size.second, filter.first);
+            auto time_end = current_time();
+            const auto us = std::chrono::duration_cast<std::chrono::microseconds>(time_end - time_start).count();
+            cout << filter.second << " " << width << " x " << height << " -> "
+                 << size.first << " x " << size.second << ": " << us << " us" << endl;
+
+            size_t errors = 0;
+            for (size_t r = 0; r < size.second; r++){
+                for (size_t c = 0; c < size.first; c++){
+                    if (scaled.pixel(c, r) != expected.pixel(c, r)){
+                        if (errors < 10){
+                            cout << "Error: (" << c << ", " << r << ") got " << scaled.pixel(c, r)
+                                 << " but expected " << expected.pixel(c, r) << endl;
+                        }
+                        errors++;
+                    }
+                }
+            }
+            TEST_RESULT_EQUAL(errors, (size_t)0);
+        }
+    }
+
+    //  Same size is an exact copy for every filter.
+    for (const auto& filter : filters){
+        ImageRGB32 same = image.scale_to(width, height, filter.first);
+        for (size_t r = 0; r < height; r++){
+            for (size_t c = 0; c < width; c++){
+                TEST_RESULT_EQUAL(same.pixel(c, r), image.pixel(c, r));
+            }
+        }
+    }
+
+    return 0;
+}
+
+
 int test_kernels_BinaryMatrix(const ImageViewRGB32& image){
 
     if (test_binary_matrix_tile() != 0){
@@ -663,6 +780,146 @@ int test_kernels_Waterfill(const ImageViewRGB32& image){
     return 0;
 }
 
+
+namespace{
+
+//  Random rows that all start "offset" floats past an aligned address. The
+//  padding around each row is filled with a large value so that any lane read
+//  outside of the row shows up in the result.
+struct OffsetMatrix{
+    static constexpr float PADDING = 1000.f;
+
+    std::vector<AlignedVector<float>> rows;
+    std::vector<const float*> pointers;
+
+    OffsetMatrix(size_t width, size_t height, size_t offset, std::mt19937& rng){
+        std::uniform_real_distribution<float> dist(0.1f, 2.0f);
+        for (size_t r = 0; r < height; r++){
+            rows.emplace_back(offset + width + 16);
+            for (float& x : rows.back()){
+                x = PADDING;
+            }
+            for (size_t c = 0; c < width; c++){
+                rows.back()[offset + c] = dist(rng);
+            }
+            pointers.emplace_back(rows.back().data() + offset);
+        }
+    }
+    float operator()(size_t r, size_t c) const{ return pointers[r][c]; }
+};
+
+bool kernel_result_close(const char* name, size_t length, size_t offset, double x, double expected){
+    if (std::fabs(x - expected) <= 1e-4 * std::max(1.0, std::fabs(expected))){
+        return true;
+    }
+    cout << "Error: " << name << "(), length = " << length << ", offset = " << offset
+         << " is " << x << ", but should be " << expected << endl;
+    return false;
+}
+
+}
+
+
+//  The vectorized versions do the last (width % vector length) columns with
+//  partial loads. Run every width from one to five vectors at every alignment
+//  and compare against a double-precision reference.
+int test_kernels_ScaleInvariantMatrixMatch(){
+    using namespace ScaleInvariantMatrixMatch;
+    const size_t HEIGHT = 5;
+    std::mt19937 rng(0);
+
+    for (size_t width = 16; width <= 80; width++){
+        for (size_t offset = 0; offset < 16; offset++){
+            OffsetMatrix A(width, HEIGHT, offset, rng);
+            OffsetMatrix T(width, HEIGHT, offset, rng);
+            OffsetMatrix W(width, HEIGHT, offset, rng);
+            OffsetMatrix TW(width, HEIGHT, offset, rng);
+            for (size_t r = 0; r < HEIGHT; r++){
+                for (size_t c = 0; c < width; c++){
+                    TW.rows[r][offset + c] = T(r, c) * W(r, c);
+                }
+            }
+
+            double AT = 0, AA = 0, AWTW = 0, AWAW = 0;
+            std::vector<double> dot(HEIGHT);
+            for (size_t r = 0; r < HEIGHT; r++){
+                for (size_t c = 0; c < width; c++){
+                    double a = A(r, c), aw = a * W(r, c);
+                    AT += a * T(r, c);
+                    AA += a * a;
+                    AWTW += aw * TW(r, c);
+                    AWAW += aw * aw;
+                    dot[r] += (double)A(0, c) * T(r, c);
+                }
+            }
+            double scale = AT / AA;
+            double scale_weighted = AWTW / AWAW;
+            double error = 0, error_weighted = 0;
+            for (size_t r = 0; r < HEIGHT; r++){
+                for (size_t c = 0; c < width; c++){
+                    double x = scale * A(r, c) - T(r, c);
+                    double y = scale_weighted * A(r, c) * W(r, c) - TW(r, c);
+                    error += x * x;
+                    error_weighted += y * y;
+                }
+            }
+
+            float s = compute_scale(width, HEIGHT, A.pointers.data(), T.pointers.data());
+            float sw = compute_scale(width, HEIGHT, A.pointers.data(), TW.pointers.data(), W.pointers.data());
+            float e = compute_error(width, HEIGHT, (float)scale, A.pointers.data(), T.pointers.data());
+            float ew = compute_error(width, HEIGHT, (float)scale_weighted, A.pointers.data(), TW.pointers.data(), W.pointers.data());
+            if (!kernel_result_close("compute_scale", width, offset, s, scale) ||
+                !kernel_result_close("compute_scale(weighted)", width, offset, sw, scale_weighted) ||
+                !kernel_result_close("compute_error", width, offset, e, error) ||
+                !kernel_result_close("compute_error(weighted)", width, offset, ew, error_weighted)
+            ){
+                return 1;
+            }
+
+            std::vector<float> dot_out(HEIGHT);
+            compute_dot_products(width, HEIGHT, A.pointers[0], T.pointers.data(), dot_out.data());
+            for (size_t r = 0; r < HEIGHT; r++){
+                if (!kernel_result_close("compute_dot_products", width, offset, dot_out[r], dot[r])){
+                    return 1;
+                }
+            }
+        }
+    }
+
+    cout << "ScaleInvariantMatrixMatch matches the reference." << endl;
+    return 0;
+}
+
+
+//  The input is a spectrum offset by the low frequency cut-off, so it can have
+//  any alignment. Run every alignment with lengths that leave a partial vector.
+int test_kernels_SpikeConvolution(){
+    const float KERNEL[] = {-4, -3, -2, -1, 0, 1, 2, 3, 4, 4, 3, 2, 1, 0, -1, -2, -3, -4};
+    const size_t LENGTH_K = sizeof(KERNEL) / sizeof(float);
+    std::mt19937 rng(0);
+
+    for (size_t offset = 0; offset < 16; offset++){
+        OffsetMatrix in(320, 1, offset, rng);
+        AlignedVector<float> out(320);
+        for (size_t length = LENGTH_K; length < 300; length += 7){
+            SpikeConvolution::compute_spike_kernel(out.data(), in.pointers[0], length, KERNEL, LENGTH_K);
+            for (size_t c = 0; c + LENGTH_K <= length; c++){
+                double expected = 0;
+                for (size_t k = 0; k < LENGTH_K; k++){
+                    expected += (double)KERNEL[k] * in(0, c + k);
+                }
+                if (!kernel_result_close("compute_spike_kernel", length, offset, out[c], expected)){
+                    return 1;
+                }
+            }
+        }
+    }
+
+    cout << "SpikeConvolution matches the reference." << endl;
+    return 0;
+}
+
+
 // Additional tests on binary matrix tile implementation
 template<class Tile> int test_binary_matrix_tile_t(){
     size_t num_iters = 100000;
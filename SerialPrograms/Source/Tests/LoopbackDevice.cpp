@@ -0,0 +1,300 @@
+/*  Loopback Device
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ */
+
+#include <string.h>
+#include <algorithm>
+#include "Common/Cpp/PanicDump.h"
+#include "ClientSource/Connection/BotBaseMessage.h"
+#include "ClientSource/Connection/PABotBaseConnection.h"
+#include "LoopbackDevice.h"
+
+namespace PokemonAutomation{
+
+
+
+class LoopbackDevice::DeviceStream : public StreamConnection{
+public:
+    DeviceStream(LoopbackDevice& parent)
+        : m_parent(parent)
+    {}
+    virtual void stop() override{}
+    virtual void send(const void* data, size_t bytes) override{
+        m_parent.device_send(data, bytes);
+    }
+    void deliver(const std::string& data){
+        on_recv(data.data(), data.size());
+    }
+
+private:
+    LoopbackDevice& m_parent;
+};
+
+
+
+//  The device side of the protocol. Everything here runs on the device thread.
+class LoopbackDevice::Device : public PABotBaseConnection{
+public:
+    Device(Logger& logger, LoopbackDevice& parent, std::unique_ptr<DeviceStream> stream)
+        : PABotBaseConnection(logger, std::move(stream))
+        , m_parent(parent)
+        , m_config(parent.m_config)
+    {}
+
+    //  Finish commands and retransmit finish messages that are due. Returns
+    //  when this needs to be called again.
+    WallClock run_timers(WallClock now);
+
+private:
+    virtual void on_recv_message(BotBaseMessage message) override;
+
+    template <typename Params>
+    void send(uint8_t type, const Params& params){
+        send_message(BotBaseMessage(type, std::string((const char*)&params, sizeof(params))), false);
+    }
+
+    //  Send the response to a request. May be called more than once for the
+    //  same request.
+    void respond_to_request(uint8_t type, seqnum_t seqnum);
+
+private:
+    LoopbackDevice& m_parent;
+    const LoopbackDeviceConfig& m_config;
+
+    //  The next host seqnum to process. Nothing is processed until the host
+    //  resets it.
+    bool m_seqnum_valid = false;
+    seqnum_t m_expected_seqnum = 0;
+
+    //  Host seqnums of the queued commands. The front one is running.
+    std::deque<seqnum_t> m_commands;
+    WallClock m_command_end;
+
+    //  Command finished messages that have not been acked by the host.
+    struct PendingFinish{
+        BotBaseMessage message;
+        WallClock last_sent;
+    };
+    seqnum_t m_device_seqnum = 1;
+    std::map<seqnum_t, PendingFinish> m_pending_finishes;
+};
+
+
+void LoopbackDevice::Device::respond_to_request(uint8_t type, seqnum_t seqnum){
+    switch (type){
+    case PABB_MSG_REQUEST_PROTOCOL_VERSION:
+        send(PABB_MSG_ACK_REQUEST_I32, pabb_MsgAckRequestI32{seqnum, PABB_PROTOCOL_VERSION});
+        return;
+    case PABB_MSG_REQUEST_PROGRAM_VERSION:
+        send(PABB_MSG_ACK_REQUEST_I32, pabb_MsgAckRequestI32{seqnum, PABB_PROGRAM_VERSION});
+        return;
+    case PABB_MSG_REQUEST_QUEUE_SIZE:
+        send(PABB_MSG_ACK_REQUEST_I8, pabb_MsgAckRequestI8{seqnum, (uint8_t)m_config.queue_size});
+        return;
+    case PABB_MSG_REQUEST_PROGRAM_ID:
+        send(PABB_MSG_ACK_REQUEST_I8, pabb_MsgAckRequestI8{seqnum, 0});
+        return;
+    default:
+        send(PABB_MSG_ACK_REQUEST, pabb_MsgAckRequest{seqnum});
+        return;
+    }
+}
+void LoopbackDevice::Device::on_recv_message(BotBaseMessage message){
+    if (message.type == PABB_MSG_ACK_REQUEST && message.body.size() == sizeof(pabb_MsgAckRequest)){
+        pabb_MsgAckRequest params;
+        memcpy(&params, message.body.data(), sizeof(params));
+        m_pending_finishes.erase(params.seqnum);
+        return;
+    }
+    if (!PABB_MSG_IS_REQUEST_OR_COMMAND(message.type) || message.body.size() < sizeof(seqnum_t)){
+        return;
+    }
+
+    seqnum_t seqnum;
+    memcpy(&seqnum, message.body.data(), sizeof(seqnum_t));
+    bool is_command = PABB_MSG_IS_COMMAND(message.type);
+
+    if (message.type == PABB_MSG_SEQNUM_RESET){
+        m_seqnum_valid = true;
+        m_expected_seqnum = seqnum + 1;
+        m_commands.clear();
+        m_pending_finishes.clear();
+        respond_to_request(message.type, seqnum);
+        return;
+    }
+    if (!m_seqnum_valid){
+        return;
+    }
+
+    int32_t ahead = (int32_t)(seqnum - m_expected_seqnum);
+
+    //  Ahead of what we expect. Something before it was lost.
+    if (ahead > 0){
+        return;
+    }
+
+    //  Retransmit of something we already have. Ack it but don't run it again.
+    if (ahead < 0){
+        if (is_command){
+            send(PABB_MSG_ACK_COMMAND, pabb_MsgAckCommand{seqnum});
+        }else{
+            respond_to_request(message.type, seqnum);
+        }
+        return;
+    }
+
+    if (!is_command){
+        m_expected_seqnum++;
+        if (message.type == PABB_MSG_REQUEST_STOP){
+            m_commands.clear();
+        }
+        respond_to_request(message.type, seqnum);
+        return;
+    }
+
+    //  Command queue is full. Don't advance so the retransmit is accepted.
+    if (m_commands.size() >= m_config.queue_size){
+        send(PABB_MSG_ERROR_COMMAND_DROPPED, pabb_MsgInfoCommandDropped{seqnum});
+        return;
+    }
+
+    m_expected_seqnum++;
+    send(PABB_MSG_ACK_COMMAND, pabb_MsgAckCommand{seqnum});
+    if (m_commands.empty()){
+        m_command_end = current_time() + m_config.command_duration;
+    }
+    m_commands.emplace_back(seqnum);
+}
+WallClock LoopbackDevice::Device::run_timers(WallClock now){
+    while (!m_commands.empty() && m_command_end <= now){
+        seqnum_t command = m_commands.front();
+        m_commands.pop_front();
+        {
+            std::lock_guard<std::mutex> lg(m_parent.m_lock);
+            m_parent.m_finished_commands.emplace_back(command);
+        }
+
+        seqnum_t seqnum = m_device_seqnum++;
+        pabb_MsgRequestCommandFinished params{seqnum, command, 0};
+        PendingFinish& finish = m_pending_finishes[seqnum];
+        finish.message = BotBaseMessage(
+            PABB_MSG_REQUEST_COMMAND_FINISHED,
+            std::string((const char*)&params, sizeof(params))
+        );
+        finish.last_sent = now;
+        send_message(finish.message, false);
+
+        m_command_end += m_config.command_duration;
+    }
+
+    WallClock next = now + std::chrono::seconds(1);
+    if (!m_commands.empty()){
+        next = std::min(next, m_command_end);
+    }
+    for (auto& item : m_pending_finishes){
+        if (item.second.last_sent + m_config.retransmit_delay <= now){
+            send_message(item.second.message, true);
+            item.second.last_sent = now;
+        }
+        next = std::min(next, item.second.last_sent + m_config.retransmit_delay);
+    }
+    return next;
+}
+
+
+
+LoopbackDevice::LoopbackDevice(Logger& logger, const LoopbackDeviceConfig& config)
+    : m_config(config)
+    , m_rng(config.seed)
+{
+    std::unique_ptr<DeviceStream> stream(new DeviceStream(*this));
+    m_device_stream = stream.get();
+    m_device.reset(new Device(logger, *this, std::move(stream)));
+    m_thread = std::thread(run_with_catch, "LoopbackDevice::thread_body()", [this]{ thread_body(); });
+}
+LoopbackDevice::~LoopbackDevice(){
+    stop();
+}
+void LoopbackDevice::stop(){
+    {
+        std::lock_guard<std::mutex> lg(m_lock);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()){
+        m_thread.join();
+    }
+}
+
+std::vector<seqnum_t> LoopbackDevice::finished_commands() const{
+    std::lock_guard<std::mutex> lg(m_lock);
+    return m_finished_commands;
+}
+size_t LoopbackDevice::dropped_messages() const{
+    std::lock_guard<std::mutex> lg(m_lock);
+    return m_dropped;
+}
+
+void LoopbackDevice::send(const void* data, size_t bytes){
+    push_packet(m_to_device, data, bytes);
+}
+void LoopbackDevice::device_send(const void* data, size_t bytes){
+    push_packet(m_to_host, data, bytes);
+}
+void LoopbackDevice::push_packet(std::deque<Packet>& queue, const void* data, size_t bytes){
+    std::lock_guard<std::mutex> lg(m_lock);
+    if (std::uniform_real_distribution<double>(0, 1)(m_rng) < m_config.loss){
+        m_dropped++;
+        return;
+    }
+    queue.emplace_back(Packet{current_time() + m_config.latency, std::string((const char*)data, bytes)});
+    m_cv.notify_all();
+}
+
+void LoopbackDevice::thread_body(){
+    std::vector<std::string> to_device;
+    std::vector<std::string> to_host;
+
+    std::unique_lock<std::mutex> lg(m_lock);
+    while (!m_stopping){
+        WallClock now = current_time();
+        to_device.clear();
+        to_host.clear();
+        while (!m_to_device.empty() && m_to_device.front().arrival <= now){
+            to_device.emplace_back(std::move(m_to_device.front().data));
+            m_to_device.pop_front();
+        }
+        while (!m_to_host.empty() && m_to_host.front().arrival <= now){
+            to_host.emplace_back(std::move(m_to_host.front().data));
+            m_to_host.pop_front();
+        }
+
+        //  Both sides send from inside these. So they can't be called under
+        //  the lock.
+        lg.unlock();
+        for (const std::string& data : to_device){
+            m_device_stream->deliver(data);
+        }
+        WallClock next = m_device->run_timers(now);
+        for (const std::string& data : to_host){
+            on_recv(data.data(), data.size());
+        }
+        lg.lock();
+
+        if (!m_to_device.empty()){
+            next = std::min(next, m_to_device.front().arrival);
+        }
+        if (!m_to_host.empty()){
+            next = std::min(next, m_to_host.front().arrival);
+        }
+        if (next > current_time() && !m_stopping){
+            m_cv.wait_until(lg, next);
+        }
+    }
+}
+
+
+
+}
@@ -0,0 +1,112 @@
+/*  Loopback Device
+ *
+ *  From: https://github.com/PokemonAutomation/Arduino-Source
+ *
+ *      A fake PABotBase device that runs in-process. It implements the
+ *  protocol in MessageProtocol.h over a simulated link with latency and
+ *  packet loss. Commands do nothing other than take time.
+ *
+ *  Pass it to PABotBase in place of a serial connection.
+ *
+ */
+
+#ifndef PokemonAutomation_Tests_LoopbackDevice_H
+#define PokemonAutomation_Tests_LoopbackDevice_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <random>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "Common/Cpp/Time.h"
+#include "Common/Cpp/AbstractLogger.h"
+#include "Common/Microcontroller/MessageProtocol.h"
+#include "ClientSource/Connection/StreamInterface.h"
+
+namespace PokemonAutomation{
+
+
+struct LoopbackDeviceConfig{
+    //  One-way delay of the link in each direction.
+    std::chrono::microseconds latency = std::chrono::microseconds(1000);
+
+    //  Probability that a message is dropped. Applies to each direction.
+    double loss = 0;
+
+    //  How long each command runs for.
+    std::chrono::microseconds command_duration = std::chrono::microseconds(0);
+
+    size_t queue_size = PABB_DEVICE_QUEUE_SIZE;
+
+    //  How long the device waits for an ack of a command finished message
+    //  before it sends it again.
+    std::chrono::milliseconds retransmit_delay = std::chrono::milliseconds(PABB_RETRANSMIT_DELAY_MILLIS);
+
+    uint64_t seed = 0;
+};
+
+
+class LoopbackDevice : public StreamConnection{
+public:
+    LoopbackDevice(Logger& logger, const LoopbackDeviceConfig& config);
+    virtual ~LoopbackDevice();
+
+    virtual void stop() override;
+
+    //  Host -> Device
+    virtual void send(const void* data, size_t bytes) override;
+
+    //  The host seqnums of all the commands in the order they finished.
+    std::vector<seqnum_t> finished_commands() const;
+
+    //  Messages dropped by the link in either direction.
+    size_t dropped_messages() const;
+
+
+private:
+    class Device;
+    class DeviceStream;
+
+    //  Messages in flight. Ordered by arrival time since the latency is fixed.
+    struct Packet{
+        WallClock arrival;
+        std::string data;
+    };
+
+    //  Device -> Host
+    void device_send(const void* data, size_t bytes);
+    void push_packet(std::deque<Packet>& queue, const void* data, size_t bytes);
+
+    void thread_body();
+
+
+private:
+    const LoopbackDeviceConfig m_config;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+    std::mt19937_64 m_rng;
+    size_t m_dropped = 0;
+
+    std::deque<Packet> m_to_device;
+    std::deque<Packet> m_to_host;
+
+    std::vector<seqnum_t> m_finished_commands;
+
+    //  Only touched by the device thread.
+    DeviceStream* m_device_stream;
+    std::unique_ptr<Device> m_device;
+
+    std::thread m_thread;
+};
+
+
+
+}
+#endif
@@ -9,7 +9,11 @@
 #include "PokemonSV_Tests.h"
 #include "TestUtils.h"
 
+#include "Common/Cpp/Time.h"
+#include "Common/Cpp/Concurrency/AsyncDispatcher.h"
 #include "Common/Cpp/Containers/FixedLimitVector.tpp"
+#include "CommonFramework/OCR/OCR_RawOCR.h"
+#include "CommonFramework/OCR/OCR_Routines.h"
 #include "PokemonSV/Inference/Battles/PokemonSV_NormalBattleMenus.h"
 #include "PokemonSV/Inference/Boxes/PokemonSV_BoxDetection.h"
 #include "PokemonSV/Inference/Boxes/PokemonSV_BoxEggDetector.h"
@@ -435,6 +439,71 @@ int test_pokemonSV_SandwichIngredientReader(const ImageViewRGB32& image, const s
     return 0;
 }
 
+int test_pokemonSV_SandwichIngredientOCRThreads(const ImageViewRGB32& image, const std::vector<std::string>& words){
+    // Same file names as PokemonSV_SandwichIngredientReader:
+    //   <current ingredient page "Fillings" or "Condiments"> <language> <current selected ingredient index 0 to 9>
+    //   <first ingredient> <second ingredient> ...
+    // Reads all 10 ingredient names with different # of threads running the OCR filters.
+    if (words.size() < 13){
+        cerr << "Error: not enough number of words in the filename. Found only " << words.size() << "." << endl;
+        return 1;
+    }
+    std::string target_type = words[words.size() - 13];
+    SandwichIngredientType sandwich_type;
+    if (target_type == "Fillings"){
+        sandwich_type = SandwichIngredientType::FILLING;
+    }else if (target_type == "Condiments"){
+        sandwich_type = SandwichIngredientType::CONDIMENT;
+    }else{
+        return 1;
+    }
+
+    Language language = language_code_to_enum(words[words.size() - 12]);
+    if (language == Language::None || language == Language::EndOfList){
+        cerr << "Error: language word " << words[words.size() - 12] << " is wrong." << endl;
+        return 1;
+    }
+
+    const OCR::DictionaryMatcher& dictionary = sandwich_type == SandwichIngredientType::FILLING
+        ? (const OCR::DictionaryMatcher&)SandwichFillingOCR::instance()
+        : (const OCR::DictionaryMatcher&)SandwichCondimentOCR::instance();
+    const double log10p_spread = SandwichFillingOCR::MAX_LOG10P_SPREAD;
+
+    std::vector<ImageViewRGB32> crops;
+    for (size_t i = 0; i < 10; ++i){
+        crops.emplace_back(extract_box_reference(image, SandwichIngredientReader(sandwich_type, i).text_box()));
+    }
+
+    auto read_all = [&](AsyncDispatcher* dispatcher){
+        std::vector<std::string> ret;
+        for (const ImageViewRGB32& crop : crops){
+            OCR::StringMatchResult result = OCR::multifiltered_OCR(
+                dispatcher, language, dictionary, crop,
+                OCR::BLACK_OR_WHITE_TEXT_FILTERS(),
+                log10p_spread, 0.01, 0.50
+            );
+            ret.emplace_back(result.results.empty() ? "" : result.results.begin()->second.token);
+        }
+        return ret;
+    };
+
+    const std::vector<size_t> THREADS{1, 2, 4, 8};
+    std::vector<std::string> expected = read_all(nullptr);
+    for (size_t i = 0; i < 10; ++i){
+        TEST_RESULT_COMPONENT_EQUAL(expected[i], words[words.size() - 10 + i], "ocr : ingredient slot " + std::to_string(i));
+    }
+
+    for (size_t threads : THREADS){
+        AsyncDispatcher dispatcher(nullptr, threads);
+        std::vector<std::string> results = read_all(&dispatcher);
+        for (size_t i = 0; i < 10; ++i){
+            TEST_RESULT_COMPONENT_EQUAL(results[i], expected[i], "parallel ocr : ingredient slot " + std::to_string(i));
+        }
+    }
+
+    return 0;
+}
+
 int test_pokemonSV_AdvanceDialogDetector(const ImageViewRGB32& image, bool target){
     AdvanceDialogDetector detector(COLOR_RED);
     bool result = detector.detect(image);
@@ -48,6 +48,8 @@ int test_pokemonSV_SandwichIngredientsDetector(const ImageViewRGB32& image, cons
 
 int test_pokemonSV_SandwichIngredientReader(const ImageViewRGB32& image, const std::vector<std::string>& words);
 
+int test_pokemonSV_SandwichIngredientOCRThreads(const ImageViewRGB32& image, const std::vector<std::string>& words);
+
 int test_pokemonSV_AdvanceDialogDetector(const ImageViewRGB32& image, bool target);
 
 int test_pokemonSV_SwapMenuDetector(const ImageViewRGB32& image, bool target);
@@ -16,6 +16,19 @@
 #include "PokemonSwSh/MaxLair/Inference/PokemonSwSh_MaxLair_Detect_BattleMenu.h"
 #include "PokemonSwSh/Inference/PokemonSwSh_DialogBoxDetector.h"
 #include "PokemonSwSh/Inference/PokemonSwSh_BoxShinySymbolDetector.h"
+#include "PokemonSwSh/MaxLair/AI/PokemonSwSh_MaxLair_AI_PathMatchup.h"
+#include "PokemonSwSh/MaxLair/AI/PokemonSwSh_MaxLair_AI_RentalBossMatchup.h"
+#include "PokemonSwSh/PkmnLib/PokemonSwSh_PkmnLib_Pokemon.h"
+#include "PokemonSwSh/PkmnLib/PokemonSwSh_PkmnLib_Matchup.h"
+#include "PokemonSwSh/Resources/PokemonSwSh_MaxLairDatabase.h"
+#include "PokemonSwSh/Programs/RNG/PokemonSwSh_Xoroshiro128Plus.h"
+#include "PokemonSwSh/Programs/RNG/PokemonSwSh_BasicRNG.h"
+#include "PokemonSwSh/Programs/RNG/PokemonSwSh_CramomaticRNG.h"
+#include "Common/Cpp/Concurrency/WorkStealingPool.h"
+#include "Common/Cpp/Time.h"
+#include "Common/Cpp/Json/JsonValue.h"
+#include "Common/Cpp/Json/JsonObject.h"
+#include "CommonFramework/Globals.h"
 
 #include <QFileInfo>
 #include <QDir>
@@ -24,6 +37,10 @@
 #include <iomanip>
 #include <sstream>
 #include <map>
+#include <set>
+#include <random>
+#include <functional>
+#include <algorithm>
 using std::cout;
 using std::cerr;
 using std::endl;
@@ -125,4 +142,1197 @@ int test_pokemonSwSh_BoxGenderDetector(const ImageViewRGB32& image, int target){
     return 0;
 }
 
+
+namespace{
+
+class NullLogger : public Logger{
+public:
+    virtual void log(const std::string& msg, Color color = Color()) override{}
+};
+
+class LastMessageLogger : public Logger{
+public:
+    virtual void log(const std::string& msg, Color color = Color()) override{
+        last = msg;
+    }
+    std::string last;
+};
+
+}
+
+
+//  Select paths on random lairs with the lookup tables and with the old
+//  string-keyed maps. They must pick equally good paths.
+int test_pokemonSwSh_MaxLair_SelectPath(){
+    using namespace MaxLairInternal;
+
+    //  The old tables, loaded the old way.
+    std::map<std::string, std::map<std::string, double>> boss_matchup_LUT;
+    {
+        std::string path = RESOURCE_PATH() + "PokemonSwSh/MaxLair/boss_matchup_LUT.json";
+        JsonValue json = load_json_file(path);
+        for (auto& item0 : json.get_object_throw(path)){
+            for (auto& item1 : item0.second.get_object_throw(path)){
+                boss_matchup_LUT[item0.first][item1.first] = item1.second.get_double_throw(path);
+            }
+        }
+    }
+    std::map<std::string, std::map<PokemonType, double>> type_vs_boss_map;
+    {
+        std::string path = RESOURCE_PATH() + "PokemonSwSh/MaxLair/path_tree.json";
+        JsonValue json = load_json_file(path);
+        JsonObject& node = json.get_object_throw(path).get_object_throw("base_node", path).get_object_throw("hash_table", path);
+        for (auto& item : node){
+            JsonObject& obj = item.second.get_object_throw(path).get_object_throw("hash_table", path);
+            for (const auto& type : TYPE_ENUM_TO_SLUG){
+                if (type.first != PokemonType::NONE){
+                    type_vs_boss_map[item.first][type.first] = obj.get_double_throw(type.second, path);
+                }
+            }
+        }
+    }
+    auto reference_type_vs_boss_type = [&](PokemonType type, PokemonType boss_type){
+        papkmnlib::Type pkmnlib_type = papkmnlib::serial_type_to_pkmnlib(boss_type);
+        double weight = 0;
+        size_t count = 0;
+        for (const auto& item : all_bosses_by_dex()){
+            const papkmnlib::Pokemon& boss = papkmnlib::get_pokemon(item.second);
+            if (boss_type == PokemonType::NONE || boss.has_type(pkmnlib_type)){
+                weight += type_vs_boss_map.find(boss.name())->second.find(type)->second;
+                count++;
+            }
+        }
+        return weight / (double)count;
+    };
+    auto reference_evaluate_path = [&](const std::string& boss, PokemonType boss_type, const std::vector<PathNode>& path){
+        const double weights[] = {1, 2, 3};
+        double weight = 0;
+        for (size_t c = 0, battle = 3 - path.size(); battle < 3; c++, battle++){
+            double score = boss.empty()
+                ? reference_type_vs_boss_type(path[c].type, boss_type)
+                : type_vs_boss_map.find(boss)->second.find(path[c].type)->second;
+            weight += score * weights[battle];
+        }
+        return weight;
+    };
+
+    //  The loader skips bosses that the tree and the boss list don't agree
+    //  on. Make sure the shipped resources have none of them.
+    for (const auto& item : type_vs_boss_map){
+        TEST_RESULT_EQUAL(papkmnlib::all_boss_pokemon().count(item.first), (size_t)1);
+    }
+    for (const auto& item : all_bosses_by_dex()){
+        auto iter = type_vs_boss_map.find(item.second);
+        TEST_RESULT_EQUAL(iter != type_vs_boss_map.end(), true);
+        for (const auto& type : iter->second){
+            TEST_RESULT_EQUAL(type_vs_boss(type.first, item.second), type.second);
+        }
+    }
+
+    //  Every entry of the LUT must be in the flat table.
+    for (const auto& rental : boss_matchup_LUT){
+        for (const auto& boss : rental.second){
+            if (!papkmnlib::all_rental_pokemon().count(rental.first) || !papkmnlib::all_boss_pokemon().count(boss.first)){
+                continue;
+            }
+            double score = rental_vs_boss_matchup(rental_id(rental.first), boss_id(boss.first));
+            TEST_RESULT_APPROXIMATE(score, boss.second, 1e-5);
+        }
+    }
+
+    //  Random lairs. Half with a known boss.
+    struct Lair{
+        std::string boss;
+        PathMap map;
+        uint8_t wins;
+        int8_t side;
+    };
+    std::vector<std::string> bosses;
+    for (const auto& item : type_vs_boss_map){
+        bosses.emplace_back(item.first);
+    }
+    std::mt19937 rng(0);
+    auto random_type = [&]{ return (PokemonType)(1 + rng() % 18); };
+    std::vector<Lair> lairs(2000);
+    for (Lair& lair : lairs){
+        if (rng() % 2){
+            lair.boss = bosses[rng() % bosses.size()];
+        }
+        lair.map.path_type = (int8_t)(rng() % 3);
+        lair.map.boss = rng() % 4 == 0 ? PokemonType::NONE : random_type();
+        for (PokemonType& type : lair.map.mon1) type = random_type();
+        for (PokemonType& type : lair.map.mon2) type = random_type();
+        for (PokemonType& type : lair.map.mon3) type = random_type();
+        lair.wins = (uint8_t)(rng() % 3);
+        lair.side = (int8_t)(rng() % 2);
+    }
+
+    //  The old select_path(): rank every path with the string-keyed tables.
+    std::vector<double> expected;
+    for (const Lair& lair : lairs){
+        double best = -1e100;
+        for (const auto& path : generate_paths(lair.map, lair.wins, lair.side)){
+            best = std::max(best, reference_evaluate_path(lair.boss, lair.map.boss, path));
+        }
+        expected.emplace_back(best);
+    }
+    //  With a logger like the AI calls it.
+    NullLogger logger;
+    std::vector<std::vector<PathNode>> results;
+    for (const Lair& lair : lairs){
+        results.emplace_back(select_path(&logger, lair.boss, lair.map, lair.wins, lair.side));
+    }
+
+    for (size_t c = 0; c < lairs.size(); c++){
+        const Lair& lair = lairs[c];
+        double score = reference_evaluate_path(lair.boss, lair.map.boss, results[c]);
+        TEST_RESULT_APPROXIMATE(score, expected[c], 1e-4);
+    }
+
+    return 0;
+}
+
+
+//  Enumerate paths on every map layout with the old recursive generator and
+//  with the flat one. Then select paths on all of them against every boss.
+int test_pokemonSwSh_MaxLair_PathEnumeration(){
+    using namespace MaxLairInternal;
+
+    //  The old generate_paths().
+    std::function<std::vector<std::vector<PathNode>>(const PathMap&, uint8_t, int8_t)> reference_generate;
+    reference_generate = [&](const PathMap& map, uint8_t wins, int8_t side){
+        std::vector<std::vector<PathNode>> ret;
+        auto append = [&](uint8_t slot, PokemonType type, const std::vector<std::vector<PathNode>>& subpaths){
+            for (const auto& item : subpaths){
+                ret.emplace_back(std::vector<PathNode>{PathNode{slot, type}});
+                ret.back().insert(ret.back().end(), item.begin(), item.end());
+            }
+        };
+        auto leaf = [&](uint8_t slot, PokemonType type){
+            ret.emplace_back(std::vector<PathNode>{PathNode{slot, type}});
+        };
+        if (wins == 0){
+            append(0, map.mon1[0], reference_generate(map, 1, 0));
+            append(1, map.mon1[1], reference_generate(map, 1, 1));
+            return ret;
+        }
+        if (side == -1){
+            return ret;
+        }
+        if (wins == 1){
+            std::vector<std::vector<PathNode>> left = reference_generate(map, 2, 0);
+            std::vector<std::vector<PathNode>> right = reference_generate(map, 2, 1);
+            switch (map.path_type){
+            case 0:
+                if (side == 0){
+                    append(0, map.mon2[0], left);
+                    append(1, map.mon2[1], left);
+                    append(2, map.mon2[2], left);
+                }else{
+                    append(0, map.mon2[2], left);
+                    append(1, map.mon2[3], right);
+                }
+                break;
+            case 1:
+                if (side == 0){
+                    append(0, map.mon2[0], left);
+                    append(1, map.mon2[1], left);
+                }else{
+                    append(0, map.mon2[1], left);
+                    append(1, map.mon2[2], right);
+                    append(2, map.mon2[3], right);
+                }
+                break;
+            case 2:
+                if (side == 0){
+                    append(0, map.mon2[0], left);
+                    append(1, map.mon2[1], right);
+                }else{
+                    append(0, map.mon2[2], right);
+                    append(1, map.mon2[3], right);
+                }
+                break;
+            }
+            return ret;
+        }
+        if (wins == 2){
+            switch (map.path_type){
+            case 0:
+            case 2:
+                if (side == 0){
+                    leaf(0, map.mon3[0]);
+                    leaf(1, map.mon3[1]);
+                }else{
+                    leaf(0, map.mon3[1]);
+                    leaf(1, map.mon3[2]);
+                    leaf(2, map.mon3[3]);
+                }
+                break;
+            case 1:
+                if (side == 0){
+                    leaf(0, map.mon3[0]);
+                    leaf(1, map.mon3[1]);
+                    leaf(2, map.mon3[2]);
+                }else{
+                    leaf(0, map.mon3[2]);
+                    leaf(1, map.mon3[3]);
+                }
+                break;
+            }
+        }
+        return ret;
+    };
+    auto same_path = [](const std::vector<PathNode>& x, const std::vector<PathNode>& y){
+        if (x.size() != y.size()){
+            return false;
+        }
+        for (size_t c = 0; c < x.size(); c++){
+            if (x[c].path_slot != y[c].path_slot || x[c].type != y[c].type){
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::mt19937 rng(0);
+    auto random_map = [&](int8_t path_type){
+        PathMap map;
+        map.path_type = path_type;
+        map.boss = (PokemonType)(rng() % 19);
+        for (PokemonType& type : map.mon1) type = (PokemonType)(1 + rng() % 18);
+        for (PokemonType& type : map.mon2) type = (PokemonType)(1 + rng() % 18);
+        for (PokemonType& type : map.mon3) type = (PokemonType)(1 + rng() % 18);
+        return map;
+    };
+
+    //  Every layout, including the unreadable ones.
+    for (int8_t path_type = -1; path_type <= 3; path_type++){
+        for (uint8_t wins = 0; wins <= 3; wins++){
+            for (int8_t side = -1; side <= 1; side++){
+                for (size_t c = 0; c < 100; c++){
+                    PathMap map = random_map(path_type);
+                    std::vector<std::vector<PathNode>> expected = reference_generate(map, wins, side);
+                    PathList paths = enumerate_paths(map, wins, side);
+                    TEST_RESULT_EQUAL(paths.count, expected.size());
+                    for (size_t p = 0; p < paths.count; p++){
+                        TEST_RESULT_EQUAL(same_path(paths.paths[p].to_vector(), expected[p]), true);
+                    }
+                }
+            }
+        }
+    }
+
+    //  The old select_path(): rank every path with a multimap.
+    auto reference_select = [&](const std::string& boss, const PathMap& map, uint8_t wins, int8_t side){
+        std::multimap<double, std::vector<PathNode>, std::greater<double>> rank;
+        for (std::vector<PathNode>& path : reference_generate(map, wins, side)){
+            const double weights[] = {1, 2, 3};
+            double weight = 0;
+            for (size_t c = 0, battle = 3 - path.size(); battle < 3; c++, battle++){
+                double score = boss.empty()
+                    ? type_vs_boss(path[c].type, map.boss)
+                    : type_vs_boss(path[c].type, boss);
+                weight += score * weights[battle];
+            }
+            rank.emplace(weight, std::move(path));
+        }
+        return rank.empty() ? std::vector<PathNode>() : rank.begin()->second;
+    };
+
+    //  Every layout against every boss, known or by type only.
+    std::vector<std::string> bosses{""};
+    for (const auto& item : all_bosses_by_dex()){
+        bosses.emplace_back(item.second);
+    }
+    struct Lair{
+        std::string boss;
+        PathMap map;
+        uint8_t wins;
+        int8_t side;
+    };
+    std::vector<Lair> lairs;
+    for (const std::string& boss : bosses){
+        for (int8_t path_type = 0; path_type < 3; path_type++){
+            for (uint8_t wins = 0; wins < 3; wins++){
+                for (int8_t side = 0; side < 2; side++){
+                    for (size_t c = 0; c < 5; c++){
+                        lairs.emplace_back(Lair{boss, random_map(path_type), wins, side});
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<std::vector<PathNode>> expected;
+    for (const Lair& lair : lairs){
+        expected.emplace_back(reference_select(lair.boss, lair.map, lair.wins, lair.side));
+    }
+    LastMessageLogger logger;
+    std::vector<std::vector<PathNode>> results;
+    for (const Lair& lair : lairs){
+        results.emplace_back(select_path(&logger, lair.boss, lair.map, lair.wins, lair.side));
+
+        //  The log lists every path, best first.
+        std::vector<std::string> lines;
+        std::istringstream stream(logger.last);
+        for (std::string line; std::getline(stream, line);){
+            lines.emplace_back(std::move(line));
+        }
+        TEST_RESULT_EQUAL(lines.size(), 1 + reference_generate(lair.map, lair.wins, lair.side).size());
+        TEST_RESULT_EQUAL(lines[0], "Available Paths:");
+        TEST_RESULT_EQUAL(lines[1].substr(lines[1].find(" : ") + 3), dump_path(results.back()));
+    }
+
+    for (size_t c = 0; c < lairs.size(); c++){
+        TEST_RESULT_EQUAL(same_path(results[c], expected[c]), true);
+    }
+
+    return 0;
+}
+
+
+namespace NintendoSwitch{
+namespace PokemonSwSh{
+namespace papkmnlib{
+namespace{
+
+//  damage_score() as it was before the batch. Abilities and move names are
+//  compared as strings and the move is copied so its type can be changed.
+double reference_ability_multiplier(const Pokemon& attacker, const Pokemon& defender, const Move& move){
+    double multiplier = 1.0;
+    const std::string& attacker_ability = attacker.ability();
+    const std::string& defender_ability = defender.ability();
+    Type move_type = move.type();
+
+    do{
+        if (attacker_ability == "mold-breaker") break;
+        if (attacker_ability == "turboblaze") break;
+        if (attacker_ability == "teravolt") break;
+        if (attacker_ability == "tinted-lens"){
+            if (damage_multiplier(move_type, defender.type1(), defender.type2()) < 1.0){
+                multiplier *= 2.0;
+            }
+            break;
+        }
+        switch (move_type){
+        case Type::ground:
+            if (defender_ability == "levitate"){
+                multiplier = move == "thousand-arrows" ? 1.0 : 0.0;
+            }
+            break;
+        case Type::water:
+            if (defender_ability == "water-absorb" || defender_ability == "storm-drain" || defender_ability == "dry-skin"){
+                multiplier = 0.0;
+            }
+            break;
+        case Type::fire:
+            if (defender_ability == "flash-fire"){
+                multiplier = 0.0;
+            }else if (defender_ability == "fluffy" || defender_ability == "dry-skin"){
+                multiplier = 2.0;
+            }else if (defender_ability == "thick-fat" || defender_ability == "heatproof"){
+                multiplier = 0.5;
+            }
+            break;
+        case Type::grass:
+            if (defender_ability == "sap-sipper"){
+                multiplier = 0.0;
+            }
+            break;
+        case Type::electric:
+            if (defender_ability == "lightning-rod" || defender_ability == "motor-drive" || defender_ability == "volt-absorb"){
+                multiplier = 0.0;
+            }
+            break;
+        case Type::ice:
+            if (defender_ability == "thick-fat"){
+                multiplier = 0.5;
+            }
+            break;
+        default:;
+        }
+    }while (false);
+
+    if (attacker_ability == "iron-fist"){
+        static const std::set<std::string> MOVES{
+            "bullet-punch", "comet-punch", "dizzy-punch", "double-iron-bash",
+            "drain-punch", "dynamic-punch", "fire-punch", "focus-punch",
+            "hammer-arm", "ice-hammer", "ice-punch", "mach-punch",
+            "mega-punch", "meteor-mash", "plasma-fists", "power-up-punch",
+            "shadow-punch", "sky-uppercut", "surging-strikes", "thunder-punch",
+            "wicked-blow",
+        };
+        if (MOVES.find(move.name()) != MOVES.end()){
+            multiplier *= 1.2;
+        }
+    }else if (attacker_ability == "strong-jaw"){
+        static const std::set<std::string> MOVES{
+            "bite", "crunch", "fire-fang", "fishious-rend", "hyper-fang",
+            "ice-fang", "jaw-lock", "poison-fang", "psychic-fangs", "thunder-fang",
+        };
+        if (MOVES.find(move.name()) != MOVES.end()){
+            multiplier *= 1.5;
+        }
+    }else if (attacker_ability == "adaptability"){
+        if (move_type == attacker.type1() || move_type == attacker.type2()){
+            multiplier *= (4.0 / 3.0);
+        }
+    }
+    return multiplier;
+}
+double reference_weather_multiplier(Move& move, const Field& field){
+    double modifier = 1.0;
+    Type move_type = move.type();
+    switch (field.weather()){
+    case Weather::CLEAR:
+        if (move == "weather-ball"){
+            move.set_type(Type::normal);
+        }
+        break;
+    case Weather::SUN:
+        if (move == "solar-beam"){
+            modifier *= 2.0;
+        }else if (move == "thunder" || move == "hurricane"){
+            modifier *= (0.5 / 0.7);
+        }else if (move == "weather-ball"){
+            move.set_type(Type::fire);
+            modifier *= 2.0;
+        }
+        if (move_type == Type::fire){
+            modifier *= 1.5;
+        }else if (move_type == Type::water){
+            modifier *= 0.5;
+        }
+        break;
+    case Weather::RAIN:
+        if (move == "solar-beam"){
+            modifier *= 0.5;
+        }else if (move == "thunder" || move == "hurricane"){
+            modifier *= (1.0 / 0.7);
+        }else if (move == "weather-ball"){
+            move.set_type(Type::water);
+            modifier *= 2.0;
+        }
+        if (move_type == Type::fire){
+            modifier *= 0.5;
+        }else if (move_type == Type::water){
+            modifier *= 1.5;
+        }
+        break;
+    case Weather::HAIL:
+        if (move == "solar-beam"){
+            modifier *= 0.5;
+        }else if (move == "blizzard"){
+            modifier *= (1.0 / 0.7);
+        }else if (move == "weather-ball"){
+            modifier *= 2.0;
+            move.set_type(Type::ice);
+        }
+        break;
+    case Weather::SANDSTORM:
+        if (move == "solar-beam"){
+            modifier *= 0.5;
+        }else if (move == "weather-ball"){
+            modifier *= 2.0;
+            move.set_type(Type::rock);
+        }
+        break;
+    }
+    return modifier;
+}
+double reference_terrain_multiplier(const Pokemon& attacker, const Pokemon& defender, Move& move, const Field& field){
+    double modifier = 1.0;
+    if (field.is_none_terrain()){
+        return modifier;
+    }
+    Type move_type = move.type();
+
+    bool is_flying = (attacker.type1() == Type::flying) || (attacker.type2() == Type::flying);
+    bool is_levitate = attacker.ability() == "levitate";
+    if (!is_flying || !is_levitate){
+        switch (field.terrain()){
+        case Terrain::NONE:
+            break;
+        case Terrain::ELECTRIC:
+            if (move == "terrain-pulse"){
+                move.set_type(Type::electric);
+                modifier *= 1.5;
+            }
+            if (move_type == Type::electric){
+                modifier *= 1.3;
+            }
+            break;
+        case Terrain::GRASSY:
+            if (move == "terrain-pulse"){
+                move.set_type(Type::grass);
+                modifier *= 1.5;
+            }
+            if (move_type == Type::grass){
+                modifier *= 1.3;
+            }
+            break;
+        case Terrain::PSYCHIC:
+            if (move == "terrain-pulse"){
+                move.set_type(Type::psychic);
+                modifier *= 1.5;
+            }else if (move == "expanding-force"){
+                modifier *= 1.5;
+            }
+            if (move_type == Type::psychic){
+                modifier *= 1.3;
+            }
+            break;
+        case Terrain::MISTY:
+            if (move == "terrain-pulse"){
+                move.set_type(Type::fairy);
+            }
+            if (move_type == Type::dragon){
+                modifier *= 0.5;
+            }
+            break;
+        }
+    }
+
+    is_flying = (defender.type1() == Type::flying) || (defender.type2() == Type::flying);
+    is_levitate = defender.ability() == "levitate";
+    if (!is_flying || !is_levitate){
+        if (field.is_electric() && move == "rising-voltage"){
+            modifier *= 2.0;
+        }
+    }
+    return modifier;
+}
+double reference_damage_score(
+    const Pokemon& attacker, const Pokemon& defender,
+    size_t moveIdx, const Field& field, bool multipleTargets
+){
+    Move move = attacker.is_dynamax() ? attacker.max_move(moveIdx) : attacker.move(moveIdx);
+
+    double modifier = move.correction_factor();
+    if (multipleTargets && move.is_spread()){
+        modifier *= 0.75;
+    }
+    modifier *= reference_weather_multiplier(move, field);
+    modifier *= reference_terrain_multiplier(attacker, defender, move, field);
+    if (move.type() == Type::normal){
+        if (attacker.ability() == "refrigerate"){
+            move.set_type(Type::ice);
+            modifier *= 1.2;
+        }else if (attacker.ability() == "aerilate"){
+            move.set_type(Type::flying);
+            modifier *= 1.2;
+        }else if (attacker.ability() == "galvanize"){
+            move.set_type(Type::electric);
+            modifier *= 1.2;
+        }else if (attacker.ability() == "pixilate"){
+            move.set_type(Type::fairy);
+            modifier *= 1.2;
+        }
+    }else if (attacker.ability() == "normalize"){
+        move.set_type(Type::normal);
+        modifier *= 1.2;
+    }
+    if (attacker.is_stab(move.type())){
+        modifier *= 1.5;
+    }
+    if (!(move == "thousand-arrows" && defender.has_type(Type::flying))){
+        modifier *= damage_multiplier(move.type(), defender.type1(), defender.type2());
+    }
+    if (move.category() == MoveCategory::PHYSICAL && attacker.non_volatile_status_effect() == NonVolatileStatusEffects::BURN){
+        modifier *= 0.5;
+    }
+    modifier *= reference_ability_multiplier(attacker, defender, move);
+    if (move.type() == Type::fairy && (attacker.ability() == "fairy-aura" || defender.ability() == "fairy-aura")){
+        modifier *= 1.33;
+    }
+    if (move.type() == Type::dark && (attacker.ability() == "dark-aura" || defender.ability() == "dark-aura")){
+        modifier *= 1.33;
+    }
+
+    uint16_t attack, defense;
+    if (move.category() == MoveCategory::PHYSICAL){
+        if (move == "body-press"){
+            attack = attacker.defense();
+        }else if (move == "foul-play"){
+            attack = defender.attack();
+        }else{
+            attack = attacker.attack();
+        }
+        defense = defender.defense();
+    }else{
+        attack = attacker.special_attack();
+        defense = (move == "psystrike" || move == "psyshock") ? defender.defense() : defender.special_defense();
+    }
+
+    uint16_t low, high;
+    calc_damage_range(move.base_power(), attacker.level(), attack, defense, modifier, low, high);
+    return (low + high) * move.accuracy() / 2;
+}
+
+}
+}
+}
+}
+
+
+//  The batch, the memo and damage_score() against the old damage_score()
+//  on the real move and Pokemon tables. They must agree exactly.
+int test_pokemonSwSh_PkmnLib_DamageEngine(){
+    using namespace papkmnlib;
+
+    std::vector<const papkmnlib::Pokemon*> rentals;
+    std::vector<const papkmnlib::Pokemon*> bosses;
+    for (const auto& item : all_rental_pokemon()){
+        rentals.emplace_back(&item.second);
+    }
+    for (const auto& item : all_boss_pokemon()){
+        bosses.emplace_back(&item.second);
+    }
+
+    std::mt19937 rng(0);
+    auto random_field = [&]{
+        return Field((Weather)(rng() % 5), (Terrain)(rng() % 5));
+    };
+    auto random_mon = [&]{
+        const papkmnlib::Pokemon* mon = rng() % 4 == 0
+            ? bosses[rng() % bosses.size()]
+            : rentals[rng() % rentals.size()];
+        papkmnlib::Pokemon ret = *mon;
+        ret.set_is_dynamax(rng() % 2);
+        if (rng() % 4 == 0){
+            ret.set_non_volatile_status_effect(NonVolatileStatusEffects::BURN);
+        }
+        return ret;
+    };
+
+    //  Every Pokemon against every boss, with and without dynamax.
+    for (const auto* mons : {&rentals, &bosses}){
+        for (const papkmnlib::Pokemon* mon : *mons){
+            papkmnlib::Pokemon attacker = *mon;
+            for (const papkmnlib::Pokemon* defender : bosses){
+                for (int dmax = 0; dmax < 2; dmax++){
+                    attacker.set_is_dynamax(dmax);
+                    Field field;
+                    field.set_default_field(defender->name());
+                    DamageScores scores = cached_damage_scores(attacker, *defender, field, false);
+                    TEST_RESULT_EQUAL(scores.count, attacker.num_moves());
+                    for (size_t m = 0; m < scores.count; m++){
+                        double expected = reference_damage_score(attacker, *defender, m, field, false);
+                        TEST_RESULT_EQUAL(scores.score[m], expected);
+                        TEST_RESULT_EQUAL(damage_score(attacker, *defender, m, field, false), expected);
+                    }
+                }
+            }
+        }
+    }
+
+    //  Random battles, fields and burns. Every move of every matchup.
+    for (size_t c = 0; c < 20000; c++){
+        papkmnlib::Pokemon attacker = random_mon();
+        papkmnlib::Pokemon defender = random_mon();
+        Field field = random_field();
+        bool multiple_targets = rng() % 2;
+
+        DamageBatch batch;
+        prepare_damage_batch(batch, attacker, defender, field, multiple_targets);
+        TEST_RESULT_EQUAL(batch.count, attacker.num_moves());
+
+        uint16_t rolls[DamageBatch::MAX_MOVES][16];
+        calc_damage_rolls(batch, rolls);
+        double scores[DamageBatch::MAX_MOVES];
+        calc_damage_scores(batch, scores);
+        DamageScores cached = cached_damage_scores(attacker, defender, field, multiple_targets);
+        TEST_RESULT_EQUAL(cached.count, batch.count);
+
+        for (size_t m = 0; m < batch.count; m++){
+            uint16_t lower, upper;
+            calc_damage_range(
+                batch.power[m], batch.level, batch.attack[m], batch.defense[m], batch.modifier[m],
+                lower, upper
+            );
+            TEST_RESULT_EQUAL(rolls[m][0], lower);
+            TEST_RESULT_EQUAL(rolls[m][15], upper);
+            for (size_t r = 1; r < 16; r++){
+                TEST_RESULT_EQUAL(rolls[m][r - 1] <= rolls[m][r], true);
+            }
+
+            double expected = reference_damage_score(attacker, defender, m, field, multiple_targets);
+            TEST_RESULT_EQUAL(scores[m], expected);
+            TEST_RESULT_EQUAL(cached.score[m], expected);
+        }
+    }
+
+    //  The matchup functions as they were before the cache.
+    auto reference_average_damage = [](
+        const std::vector<const papkmnlib::Pokemon*>& attackers,
+        const std::vector<const papkmnlib::Pokemon*>& defenders,
+        const Field& field, bool multiple_targets
+    ){
+        if (attackers.empty() || defenders.empty()){
+            return 0.0;
+        }
+        double total = 0;
+        size_t count = 0;
+        for (const papkmnlib::Pokemon* attacker : attackers){
+            for (const papkmnlib::Pokemon* defender : defenders){
+                double best = 0;
+                for (size_t m = 0; m < attacker->num_moves(); m++){
+                    best = std::max(best, reference_damage_score(*attacker, *defender, m, field, multiple_targets));
+                }
+                total += best;
+                count++;
+            }
+        }
+        return total / count;
+    };
+    auto reference_move_score = [&](
+        const papkmnlib::Pokemon& attacker, papkmnlib::Pokemon defender,
+        const std::vector<const papkmnlib::Pokemon*>& teammates,
+        size_t move, const Field& field
+    ){
+        double dealt = reference_damage_score(attacker, defender, move, field, false) / 2.0;
+        std::vector<const papkmnlib::Pokemon*> defenders{&defender};
+        dealt += (1.5 * 1.5) * reference_average_damage(teammates, defenders, field, false);
+
+        size_t moves = defender.num_moves();
+        bool dmax = defender.is_dynamax();
+        double regular = 0;
+        defender.set_is_dynamax(false);
+        for (size_t m = 0; m < moves; m++){
+            if (defender.move(m).is_spread()){
+                if (attacker.move(move) != "wide-guard" || attacker.is_dynamax()){
+                    regular += reference_damage_score(defender, attacker, m, field, true) / moves;
+                    regular += 3 * reference_average_damage(defenders, teammates, field, true) / moves;
+                }
+            }else{
+                regular += 0.25 * reference_damage_score(defender, attacker, m, field, false) / 1.0 / moves;
+                regular += 0.75 * reference_average_damage(defenders, teammates, field, false) / moves;
+            }
+        }
+        double max_move = 0;
+        defender.set_is_dynamax(true);
+        for (size_t m = 0; m < moves; m++){
+            max_move += 0.25 * reference_damage_score(defender, attacker, m, field, false) / 1.0 / moves;
+            max_move += 0.75 * reference_average_damage(defenders, teammates, field, false) / moves;
+        }
+        defender.set_is_dynamax(dmax);
+
+        double received = regular * (1 - 0.3) + max_move * 0.3;
+        return received < 0.0001 ? 1.0 : dealt / received;
+    };
+    auto reference_evaluate_matchup = [&](
+        papkmnlib::Pokemon attacker, const papkmnlib::Pokemon& boss,
+        const std::vector<const papkmnlib::Pokemon*>& teammates,
+        uint8_t lives
+    ){
+        Field field;
+        field.set_default_field(boss.name());
+        if (attacker.name() == "ditto"){
+            attacker = boss;
+        }
+        double best[2] = {0, 0};
+        for (int dmax = 0; dmax < 2; dmax++){
+            attacker.set_is_dynamax(dmax);
+            for (size_t m = 0; m < attacker.num_moves(); m++){
+                if (attacker.pp(m) > 0){
+                    best[dmax] = std::max(best[dmax], reference_move_score(attacker, boss, teammates, m, field));
+                }
+            }
+        }
+        double score = std::max(best[0], (best[0] + best[1]) / 2.0);
+        double hp_correction = (double)((5 - lives) * attacker.current_hp() + lives - 1) / 4.0;
+        return score * hp_correction;
+    };
+
+    //  Single moves, as when picking a move in battle.
+    for (size_t c = 0; c < 2000; c++){
+        papkmnlib::Pokemon attacker = random_mon();
+        papkmnlib::Pokemon boss = *bosses[rng() % bosses.size()];
+        boss.set_is_dynamax(rng() % 2);
+        boss.set_hp_ratio((rng() % 100 + 1) / 100.);
+        std::vector<papkmnlib::Pokemon> teammate_storage;
+        for (size_t t = rng() % 4; t > 0; t--){
+            teammate_storage.emplace_back(random_mon());
+        }
+        std::vector<const papkmnlib::Pokemon*> teammates;
+        for (const papkmnlib::Pokemon& mon : teammate_storage){
+            teammates.emplace_back(&mon);
+        }
+        Field field = random_field();
+        for (size_t m = 0; m < attacker.num_moves(); m++){
+            double score = calc_move_score(attacker, boss, teammates, m, field);
+            TEST_RESULT_EQUAL(score, reference_move_score(attacker, boss, teammates, m, field));
+        }
+    }
+
+    //  Rental scoring, as when picking rentals. The second time around is
+    //  from the cache.
+    std::vector<const papkmnlib::Pokemon*> teammates;
+    for (size_t c = 0; c < 3; c++){
+        teammates.emplace_back(rentals[rng() % rentals.size()]);
+    }
+    std::vector<double> expected;
+    for (const papkmnlib::Pokemon* rental : rentals){
+        double total = 0;
+        for (const papkmnlib::Pokemon* boss : bosses){
+            total += reference_evaluate_matchup(*rental, *boss, teammates, 4);
+        }
+        expected.emplace_back(total / bosses.size());
+    }
+    for (size_t pass = 0; pass < 2; pass++){
+        for (size_t c = 0; c < rentals.size(); c++){
+            double result = evaluate_average_matchup(*rentals[c], bosses, teammates, 4);
+            TEST_RESULT_EQUAL(result, expected[c]);
+        }
+    }
+
+    return 0;
+}
+
+
+//  jump(N) must land where N calls to next() do. The lanes must give the same
+//  outputs as a scalar generator per lane.
+int test_pokemonSwSh_Xoroshiro128Plus_Jump(){
+    std::mt19937_64 random(0);
+
+    for (size_t c = 0; c < 100; c++){
+        Xoroshiro128PlusState state(random(), random());
+        uint64_t advances = c < 50 ? random() % 300 : random() % 200000;
+
+        Xoroshiro128Plus expected(state);
+        for (uint64_t i = 0; i < advances; i++){
+            expected.next();
+        }
+        Xoroshiro128Plus rng(state);
+        rng.jump(advances);
+        TEST_RESULT_EQUAL(rng.state.s0, expected.state.s0);
+        TEST_RESULT_EQUAL(rng.state.s1, expected.state.s1);
+    }
+
+    //  Powers of two, including ones too large to step through.
+    for (size_t power = 0; power < 130; power++){
+        Xoroshiro128PlusState state(random(), random());
+        Xoroshiro128Plus rng(state);
+        rng.jump_power_of_two(power);
+
+        Xoroshiro128Plus expected(state);
+        if (power < 64){
+            expected.jump((uint64_t)1 << power);
+        }else{
+            expected.jump_power_of_two(power - 1);
+            expected.jump_power_of_two(power - 1);
+        }
+        TEST_RESULT_EQUAL(rng.state.s0, expected.state.s0);
+        TEST_RESULT_EQUAL(rng.state.s1, expected.state.s1);
+    }
+    {
+        //  The period is 2^128 - 1.
+        Xoroshiro128PlusState state(random(), random());
+        Xoroshiro128Plus rng(state);
+        rng.jump_power_of_two(128);
+        Xoroshiro128Plus expected(state);
+        expected.next();
+        TEST_RESULT_EQUAL(rng.state.s0, expected.state.s0);
+        TEST_RESULT_EQUAL(rng.state.s1, expected.state.s1);
+    }
+
+    for (size_t lanes = 1; lanes <= Xoroshiro128PlusLanes::MAX_LANES; lanes++){
+        Xoroshiro128PlusState state(random(), random());
+        uint64_t stride = random() % 1000;
+        size_t advances = 1 + random() % 1000;
+
+        Xoroshiro128PlusLanes batch(state, lanes, stride);
+        std::vector<uint64_t> results(advances * lanes);
+        batch.next(results.data(), advances);
+        batch.next(nullptr, 10);
+
+        Xoroshiro128Plus rng(state);
+        for (size_t l = 0; l < lanes; l++){
+            Xoroshiro128Plus lane(rng.state);
+            for (size_t i = 0; i < advances; i++){
+                TEST_RESULT_EQUAL(results[i * lanes + l], lane.next());
+            }
+            lane.jump(10);
+            TEST_RESULT_EQUAL(batch.get_state(l).s0, lane.state.s0);
+            TEST_RESULT_EQUAL(batch.get_state(l).s1, lane.state.s1);
+            rng.jump(stride);
+        }
+    }
+
+    return 0;
+}
+
+
+//  refind_rng_state() matching with packed words must find the same offsets as
+//  the old std::search() over a std::vector<bool>.
+int test_pokemonSwSh_RNG_LastBitSearch(){
+    using namespace NintendoSwitch::PokemonSwSh;
+
+    //  The old search.
+    auto reference_search = [](const std::vector<bool>& last_bits, const std::vector<bool>& sequence){
+        LastBitMatches ret;
+        auto iter = std::search(last_bits.begin(), last_bits.end(), sequence.begin(), sequence.end());
+        while (iter != last_bits.end()){
+            ret.count++;
+            ret.last_offset = std::distance(last_bits.begin(), iter);
+            iter++;
+            iter = std::search(iter, last_bits.end(), sequence.begin(), sequence.end());
+        }
+        return ret;
+    };
+
+    std::mt19937_64 random(0);
+
+    for (size_t c = 0; c < 400; c++){
+        Xoroshiro128Plus rng(random(), random());
+        size_t length = c < 300 ? c : random() % 5000;
+        std::vector<bool> expected = rng.generate_last_bit_sequence(length);
+        std::vector<uint64_t> words = rng.generate_last_bit_words(length);
+        TEST_RESULT_EQUAL(words.size(), (length + 63) / 64);
+        for (size_t i = 0; i < words.size() * 64; i++){
+            bool bit = (words[i / 64] >> (i % 64)) & 1;
+            TEST_RESULT_EQUAL(bit, i < length && expected[i]);
+        }
+    }
+
+    //  Observe one more bit at a time until the position is unique, like
+    //  refind_rng_state() does. Also try sequences that aren't there.
+    for (size_t c = 0; c < 200; c++){
+        Xoroshiro128Plus rng(random(), random());
+        size_t length = 1 + random() % 20000;
+        std::vector<bool> last_bits = rng.generate_last_bit_sequence(length);
+        std::vector<uint64_t> words = rng.generate_last_bit_words(length);
+
+        size_t offset = random() % length;
+        std::vector<bool> sequence;
+        while (true){
+            if (c % 4 == 0 || offset + sequence.size() >= length){
+                sequence.emplace_back(random() & 1);
+            }else{
+                sequence.emplace_back(last_bits[offset + sequence.size()]);
+            }
+            LastBitMatches expected = reference_search(last_bits, sequence);
+            LastBitMatches matches = find_last_bit_sequence(words, length, sequence);
+            TEST_RESULT_EQUAL(matches.count, expected.count);
+            TEST_RESULT_EQUAL(matches.last_offset, expected.last_offset);
+            if (expected.count <= 1 && sequence.size() > 70){
+                break;
+            }
+        }
+    }
+
+    //  A long window, as with the default settings.
+    {
+        const size_t length = 100000;
+        Xoroshiro128Plus rng(random(), random());
+        size_t offset = random() % (length - 100);
+
+        std::vector<bool> last_bits = rng.generate_last_bit_sequence(length);
+        std::vector<bool> sequence;
+        LastBitMatches expected;
+        do{
+            sequence.emplace_back(last_bits[offset + sequence.size()]);
+            expected = reference_search(last_bits, sequence);
+        }while (expected.count > 1);
+        std::vector<uint64_t> words = rng.generate_last_bit_words(length);
+        LastBitMatches matches = find_last_bit_sequence(words, length, sequence);
+
+        TEST_RESULT_EQUAL(matches.count, expected.count);
+        TEST_RESULT_EQUAL(matches.last_offset, expected.last_offset);
+    }
+
+    return 0;
+}
+
+
+//  The batched Cram-o-matic search must pick the same targets as the old one
+//  advance at a time.
+int test_pokemonSwSh_CramomaticRNG_Target(){
+    using namespace NintendoSwitch::PokemonSwSh;
+
+    //  The outcome of a single state, as the old calculate_target() did it.
+    auto reference_outcome = [](Xoroshiro128PlusState state, size_t num_npcs){
+        Xoroshiro128Plus temp_rng(state);
+        for (size_t i = 0; i < num_npcs; i++){
+            temp_rng.nextInt(91);
+        }
+        temp_rng.next();
+        temp_rng.nextInt(60);
+
+        /*uint64_t item_roll =*/ temp_rng.nextInt(4);
+        uint64_t ball_roll = temp_rng.nextInt(100);
+        bool is_safari_sport = temp_rng.nextInt(1000) == 0;
+        bool is_bonus = false;
+
+        if (is_safari_sport || ball_roll == 99){
+            is_bonus = temp_rng.nextInt(1000) == 0;
+        }else{
+            is_bonus = temp_rng.nextInt(100) == 0;
+        }
+
+        CramomaticOutcome outcome;
+        outcome.is_safari_sport = is_safari_sport;
+        outcome.is_bonus = is_bonus;
+        if (is_safari_sport){
+            outcome.type = CramomaticBallType::Safari;
+        }else if (ball_roll < 25){
+            outcome.type = CramomaticBallType::Poke;
+        }else if (ball_roll < 50){
+            outcome.type = CramomaticBallType::Great;
+        }else if (ball_roll < 75){
+            outcome.type = CramomaticBallType::Shop1;
+        }else if (ball_roll < 99){
+            outcome.type = CramomaticBallType::Shop2;
+        }else{
+            outcome.type = CramomaticBallType::Apricorn;
+        }
+        return outcome;
+    };
+
+    //  The old calculate_target().
+    auto reference_target = [&](
+        Xoroshiro128PlusState state, std::vector<CramomaticSelection> selected_balls,
+        size_t num_npcs, size_t max_priority_advances
+    ){
+        Xoroshiro128Plus rng(state);
+        size_t advances = 0;
+        size_t priority_advances = 0;
+        std::vector<CramomaticTarget> possible_targets;
+
+        std::sort(selected_balls.begin(), selected_balls.end(), [](CramomaticSelection sel1, CramomaticSelection sel2) { return sel1.priority > sel2.priority; });
+        while (priority_advances <= max_priority_advances){
+            CramomaticOutcome outcome = reference_outcome(rng.get_state(), num_npcs);
+            CramomaticBallType type = outcome.type;
+            for (size_t i = 0; i < selected_balls.size(); i++){
+                CramomaticSelection selection = selected_balls[i];
+                if (!selection.is_bonus || outcome.is_bonus){
+                    if (outcome.is_safari_sport){
+                        if (selection.ball_type == CramomaticBallType::Safari || selection.ball_type == CramomaticBallType::Sport){
+                            type = selection.ball_type;
+                        }
+                    }
+                    if (selection.ball_type == type){
+                        possible_targets.emplace_back(CramomaticTarget{type, outcome.is_bonus, advances});
+                        priority_advances = 0;
+                        uint16_t priority = selection.priority;
+                        selected_balls.erase(
+                            std::remove_if(selected_balls.begin(), selected_balls.end()
+                                , [priority](CramomaticSelection sel) { return sel.priority <= priority; })
+                            , selected_balls.end());
+                        break;
+                    }
+                }
+            }
+            if (possible_targets.size() > 0){
+                if (selected_balls.empty()){
+                    break;
+                }
+                priority_advances++;
+            }
+            rng.next();
+            advances++;
+        }
+        while (possible_targets.size() > 1){
+            auto last_target = possible_targets.end() - 1;
+            auto second_to_last_target = possible_targets.end() - 2;
+            if ((*last_target).needed_advances - (*second_to_last_target).needed_advances > max_priority_advances){
+                possible_targets.erase(last_target);
+            }else{
+                possible_targets.erase(second_to_last_target);
+            }
+        }
+        return possible_targets[0];
+    };
+
+    WorkStealingPool pool(nullptr, 0);
+    std::mt19937_64 random(0);
+
+    //  Outcomes at every count around the chunk and lane boundaries.
+    for (size_t count = 0; count < 1200; count += 1 + random() % 50){
+        Xoroshiro128PlusState state(random(), random());
+        size_t num_npcs = random() % 30;
+        std::vector<CramomaticOutcome> outcomes(count);
+        calculate_cramomatic_outcomes(outcomes.data(), count, state, num_npcs, count % 2 ? &pool : nullptr);
+
+        Xoroshiro128Plus rng(state);
+        for (size_t c = 0; c < count; c++){
+            CramomaticOutcome expected = reference_outcome(rng.state, num_npcs);
+            TEST_RESULT_EQUAL((int)outcomes[c].type, (int)expected.type);
+            TEST_RESULT_EQUAL(outcomes[c].is_safari_sport, expected.is_safari_sport);
+            TEST_RESULT_EQUAL(outcomes[c].is_bonus, expected.is_bonus);
+            rng.next();
+        }
+    }
+
+    //  Random seeds against random ball tables. There is always something
+    //  common in the table so the old search finishes in reasonable time.
+    const CramomaticBallType TYPES[] = {
+        CramomaticBallType::Poke,
+        CramomaticBallType::Great,
+        CramomaticBallType::Shop1,
+        CramomaticBallType::Shop2,
+        CramomaticBallType::Apricorn,
+        CramomaticBallType::Safari,
+        CramomaticBallType::Sport,
+    };
+    auto random_table = [&](){
+        std::vector<CramomaticSelection> table;
+        table.emplace_back(CramomaticSelection{TYPES[random() % 4], false, (uint16_t)(random() % 3)});
+        size_t extra = random() % 4;
+        for (size_t c = 0; c < extra; c++){
+            table.emplace_back(CramomaticSelection{TYPES[random() % 7], random() % 2 == 0, (uint16_t)(random() % 10)});
+        }
+        return table;
+    };
+
+    struct Search{
+        Xoroshiro128PlusState state;
+        std::vector<CramomaticSelection> table;
+        size_t num_npcs;
+        size_t max_priority_advances;
+    };
+    std::vector<Search> searches;
+    for (size_t c = 0; c < 200; c++){
+        searches.emplace_back(Search{
+            Xoroshiro128PlusState(random(), random()), random_table(),
+            random() % 30, c < 100 ? random() % 2000 : 300
+        });
+    }
+
+    std::vector<CramomaticTarget> expected;
+    for (const Search& search : searches){
+        expected.emplace_back(reference_target(search.state, search.table, search.num_npcs, search.max_priority_advances));
+    }
+    std::vector<CramomaticTarget> results;
+    for (const Search& search : searches){
+        results.emplace_back(calculate_cramomatic_target(search.state, search.table, search.num_npcs, search.max_priority_advances, &pool));
+    }
+
+    for (size_t c = 0; c < searches.size(); c++){
+        TEST_RESULT_EQUAL((int)results[c].ball_type, (int)expected[c].ball_type);
+        TEST_RESULT_EQUAL(results[c].is_bonus, expected[c].is_bonus);
+        TEST_RESULT_EQUAL(results[c].needed_advances, expected[c].needed_advances);
+    }
+
+    //  The default settings (21 NPCs, 300 priority advances) with tables of
+    //  increasingly rare balls.
+    const std::vector<std::pair<std::string, std::vector<CramomaticSelection>>> TABLES{
+        {"Apricorn", {{CramomaticBallType::Apricorn, false, 0}}},
+        {"Apricorn bonus", {{CramomaticBallType::Apricorn, true, 0}}},
+        {"Sport", {{CramomaticBallType::Sport, false, 0}}},
+    };
+    for (const auto& table : TABLES){
+        Xoroshiro128PlusState state(random(), random());
+        CramomaticTarget target = reference_target(state, table.second, 21, 300);
+        CramomaticTarget batched_target = calculate_cramomatic_target(state, table.second, 21, 300, nullptr);
+        CramomaticTarget pooled_target = calculate_cramomatic_target(state, table.second, 21, 300, &pool);
+        cout << table.first << ": " << target.needed_advances << " advances" << endl;
+
+        TEST_RESULT_EQUAL(batched_target.needed_advances, target.needed_advances);
+        TEST_RESULT_EQUAL(pooled_target.needed_advances, target.needed_advances);
+    }
+
+    return 0;
+}
+
 }
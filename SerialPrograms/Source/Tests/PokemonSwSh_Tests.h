@@ -38,6 +38,18 @@ int test_pokemonSwSh_BoxShinySymbolDetector(const ImageViewRGB32& image, bool ta
 
 int test_pokemonSwSh_BoxGenderDetector(const ImageViewRGB32& image, int target);
 
+int test_pokemonSwSh_MaxLair_SelectPath();
+
+int test_pokemonSwSh_MaxLair_PathEnumeration();
+
+int test_pokemonSwSh_PkmnLib_DamageEngine();
+
+int test_pokemonSwSh_Xoroshiro128Plus_Jump();
+
+int test_pokemonSwSh_RNG_LastBitSearch();
+
+int test_pokemonSwSh_CramomaticRNG_Target();
+
 }
 
 #endif
@@ -6,6 +6,7 @@
 
 
 #include "Common/Cpp/Containers/AlignedVector.tpp"
+#include "Common_Tests.h"
 #include "CommonFramework_Tests.h"
 #include "Kernels_Tests.h"
 #include "NintendoSwitch_Tests.h"
@@ -48,6 +49,8 @@ using ImageVoidDetectorFunction = std::function<int(const ImageViewRGB32& image)
 
 using SoundBoolDetectorFunction = std::function<int(const std::vector<AudioSpectrum>& spectrums, bool target)>;
 
+using VoidTestFunction = std::function<int()>;
+
 // Basic check on whether an image can be loaded.
 // Also strip the image format suffix (.png and so on)
 
@@ -218,8 +221,25 @@ int sound_bool_detector_helper(SoundBoolDetectorFunction test_func, const std::s
 
 
 
+// Helper for tests that generate their own data, like tests of thread pools or checksums.
+// The test file is not read. Any file in the test object folder (e.g. CommandLineTests/Common/WorkStealingPool/run.txt)
+// runs the test once.
+int void_test_helper(VoidTestFunction test_func, const std::string& test_path){
+    cout << "Run test triggered by " << test_path << endl;
+    return test_func();
+}
+
+
+
+
 const std::map<std::string, TestFunction> TEST_MAP = {
+    {"Common_CRC32", std::bind(void_test_helper, test_Common_CRC32, _1)},
+    {"Common_PABotBase", std::bind(void_test_helper, test_Common_PABotBase, _1)},
+    {"Common_PABotBaseConnection", std::bind(void_test_helper, test_Common_PABotBaseConnection, _1)},
+    {"Common_TimerWheel", std::bind(void_test_helper, test_Common_TimerWheel, _1)},
+    {"Common_WorkStealingPool", std::bind(void_test_helper, test_Common_WorkStealingPool, _1)},
     {"Kernels_ImageScaleBrightness", std::bind(image_void_detector_helper, test_kernels_ImageScaleBrightness, _1)},
+    {"Kernels_ImageResample", std::bind(image_void_detector_helper, test_kernels_ImageResample, _1)},
     {"Kernels_BinaryMatrix", std::bind(image_void_detector_helper, test_kernels_BinaryMatrix, _1)},
     {"Kernels_FilterRGB32Range", std::bind(image_void_detector_helper, test_kernels_FilterRGB32Range, _1)},
     {"Kernels_FilterRGB32Euclidean", std::bind(image_void_detector_helper, test_kernels_FilterRGB32Euclidean, _1)},
@@ -227,7 +247,18 @@ const std::map<std::string, TestFunction> TEST_MAP = {
     {"Kernels_FilterByMask", std::bind(image_void_detector_helper, test_kernels_FilterByMask, _1)},
     {"Kernels_CompressRGB32ToBinaryEuclidean", std::bind(image_void_detector_helper, test_kernels_CompressRGB32ToBinaryEuclidean, _1)},
     {"Kernels_Waterfill", std::bind(image_void_detector_helper, test_kernels_Waterfill, _1)},
+    {"Kernels_ScaleInvariantMatrixMatch", std::bind(void_test_helper, test_kernels_ScaleInvariantMatrixMatch, _1)},
+    {"Kernels_SpikeConvolution", std::bind(void_test_helper, test_kernels_SpikeConvolution, _1)},
     {"CommonFramework_BlackBorderDetector", std::bind(image_bool_detector_helper, test_CommonFramework_BlackBorderDetector, _1)},
+    {"CommonFramework_VisualInferencePivot", std::bind(image_void_detector_helper, test_CommonFramework_VisualInferencePivot, _1)},
+    {"CommonFramework_ExactImageMatcher", std::bind(void_test_helper, test_CommonFramework_ExactImageMatcher, _1)},
+    {"CommonFramework_ExactImageDictionaryMatcher", std::bind(image_void_detector_helper, test_CommonFramework_ExactImageDictionaryMatcher, _1)},
+    {"CommonFramework_Levenshtein", std::bind(void_test_helper, test_CommonFramework_Levenshtein, _1)},
+    {"CommonFramework_DictionaryQGramIndex", std::bind(void_test_helper, test_CommonFramework_DictionaryQGramIndex, _1)},
+    {"CommonFramework_SpectrogramMatcher", std::bind(void_test_helper, test_CommonFramework_SpectrogramMatcher, _1)},
+    {"CommonFramework_AsyncLogWriter", std::bind(void_test_helper, test_CommonFramework_AsyncLogWriter, _1)},
+    {"CommonFramework_ImageEncodeService", std::bind(void_test_helper, test_CommonFramework_ImageEncodeService, _1)},
+    {"CommonFramework_SpritePack", std::bind(void_test_helper, test_CommonFramework_SpritePack, _1)},
     {"NintendoSwitch_UpdateMenuDetector", std::bind(image_bool_detector_helper, test_NintendoSwitch_UpdateMenuDetector, _1)},
     {"PokemonSwSh_YCommMenuDetector", std::bind(image_bool_detector_helper, test_pokemonSwSh_YCommMenuDetector, _1)},
     {"PokemonSwSh_MaxLair_BattleMenuDetector", std::bind(image_bool_detector_helper, test_pokemonSwSh_MaxLair_BattleMenuDetector, _1)},
@@ -240,6 +271,12 @@ const std::map<std::string, TestFunction> TEST_MAP = {
     {"PokemonSwSh_BlackDialogBoxDetector", std::bind(image_bool_detector_helper, test_pokemonSwSh_BlackDialogBoxDetector, _1)},
     {"PokemonSwSh_BoxShinySymbolDetector", std::bind(image_bool_detector_helper, test_pokemonSwSh_BoxShinySymbolDetector, _1)},
     {"PokemonSwSh_BoxGenderDetector", std::bind(image_int_detector_helper, test_pokemonSwSh_BoxGenderDetector, _1)},
+    {"PokemonSwSh_MaxLair_SelectPath", std::bind(void_test_helper, test_pokemonSwSh_MaxLair_SelectPath, _1)},
+    {"PokemonSwSh_MaxLair_PathEnumeration", std::bind(void_test_helper, test_pokemonSwSh_MaxLair_PathEnumeration, _1)},
+    {"PokemonSwSh_PkmnLib_DamageEngine", std::bind(void_test_helper, test_pokemonSwSh_PkmnLib_DamageEngine, _1)},
+    {"PokemonSwSh_Xoroshiro128Plus_Jump", std::bind(void_test_helper, test_pokemonSwSh_Xoroshiro128Plus_Jump, _1)},
+    {"PokemonSwSh_RNG_LastBitSearch", std::bind(void_test_helper, test_pokemonSwSh_RNG_LastBitSearch, _1)},
+    {"PokemonSwSh_CramomaticRNG_Target", std::bind(void_test_helper, test_pokemonSwSh_CramomaticRNG_Target, _1)},
     {"PokemonLA_BattleMenuDetector", std::bind(image_bool_detector_helper, test_pokemonLA_BattleMenuDetector, _1)},
     {"PokemonLA_BattlePokemonSwitchDetector", std::bind(image_bool_detector_helper, test_pokemonLA_BattlePokemonSwitchDetector, _1)},
     {"PokemonLA_TransparentDialogueDetector", std::bind(image_bool_detector_helper, test_pokemonLA_TransparentDialogueDetector, _1)},
@@ -277,6 +314,7 @@ const std::map<std::string, TestFunction> TEST_MAP = {
     {"PokemonSV_BoxBottomButtonDetector", std::bind(image_words_detector_helper, test_pokemonSV_BoxBottomButtonDetector, _1)},
     {"PokemonSV_SandwichIngredientsDetector", std::bind(image_words_detector_helper, test_pokemonSV_SandwichIngredientsDetector, _1)},
     {"PokemonSV_SandwichIngredientReader", std::bind(image_words_detector_helper, test_pokemonSV_SandwichIngredientReader, _1)},
+    {"PokemonSV_SandwichIngredientOCRThreads", std::bind(image_words_detector_helper, test_pokemonSV_SandwichIngredientOCRThreads, _1)},
     {"PokemonSV_AdvanceDialogDetector", std::bind(image_bool_detector_helper, test_pokemonSV_AdvanceDialogDetector, _1)},
     {"PokemonSV_SwapMenuDetector", std::bind(image_bool_detector_helper, test_pokemonSV_SwapMenuDetector, _1)},
     {"PokemonSV_DialogBoxDetector", std::bind(image_bool_detector_helper, test_pokemonSV_DialogBoxDetector, _1)},